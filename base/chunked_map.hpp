@@ -0,0 +1,172 @@
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace principia {
+namespace base {
+namespace internal_chunked_map {
+
+// An ordered associative container with unique keys, for use when the elements
+// are mostly inserted and removed at the ends, as is the case for the timeline
+// of a trajectory.  The elements are stored in contiguous chunks of
+// |chunk_capacity| elements, which saves the per-node allocation of |std::map|
+// and makes iteration cache-friendly.
+//
+// The interface is a subset of that of |std::map|, with the following
+// differences:
+// 1. The elements cannot be modified through the iterators, and |iterator| is
+//    the same type as |const_iterator|.
+// 2. Insertions must happen at either end of the map; inserting in the middle
+//    is an error.  The hint of |emplace_hint| is ignored.
+// 3. Insertions and erasures at the ends do not invalidate the iterators to
+//    the other elements or the |end()| iterator, as for |std::map|.  Erasing a
+//    range that touches neither end invalidates all the iterators to the
+//    elements that follow the range.
+// 4. The map is neither copyable nor movable, because |end()| refers to it.
+template<typename Key, typename Value, int chunk_capacity = 64>
+class ChunkedMap final {
+  static_assert(chunk_capacity > 0, "Chunks cannot be empty");
+
+  struct Chunk;
+
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<Key const, Value>;
+  using size_type = std::int64_t;
+
+  class const_iterator final {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename ChunkedMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = value_type const*;
+    using reference = value_type const&;
+
+    const_iterator() = default;
+
+    reference operator*() const;
+    pointer operator->() const;
+
+    const_iterator& operator++();
+    const_iterator& operator--();
+    const_iterator operator++(int);
+    const_iterator operator--(int);
+
+    bool operator==(const_iterator const& right) const;
+    bool operator!=(const_iterator const& right) const;
+
+   private:
+    const_iterator(ChunkedMap const* map, Chunk const* chunk, int index);
+
+    ChunkedMap const* map_ = nullptr;
+    // Null for |end()|.
+    Chunk const* chunk_ = nullptr;
+    int index_ = 0;
+
+    friend class ChunkedMap;
+  };
+  using iterator = const_iterator;
+
+  ChunkedMap() = default;
+  ChunkedMap(ChunkedMap const&) = delete;
+  ChunkedMap(ChunkedMap&&) = delete;
+  ChunkedMap& operator=(ChunkedMap const&) = delete;
+  ChunkedMap& operator=(ChunkedMap&&) = delete;
+
+  const_iterator begin() const;
+  const_iterator end() const;
+  const_iterator cbegin() const;
+  const_iterator cend() const;
+
+  bool empty() const;
+  size_type size() const;
+
+  const_iterator find(Key const& key) const;
+  const_iterator lower_bound(Key const& key) const;
+  const_iterator upper_bound(Key const& key) const;
+
+  // If an element with key |key| already exists, returns an iterator to it and
+  // doesn't insert anything.  Otherwise |key| must be less than the first key
+  // or greater than the last key of this map.
+  template<typename... Args>
+  const_iterator emplace_hint(const_iterator hint, Key const& key,
+                              Args&&... args);
+
+  // Inserts the elements of the ordered range [first, last).  Each element is
+  // subject to the restrictions of |emplace_hint|.
+  template<typename InputIterator>
+  void insert(InputIterator first, InputIterator last);
+
+  // Returns an iterator to the element that followed the last erased element.
+  const_iterator erase(const_iterator position);
+  const_iterator erase(const_iterator first, const_iterator last);
+
+  // Also releases the chunks allocated by |reserve|.
+  void clear();
+
+  // Ensures that the map may hold |size| elements without allocating, provided
+  // that the elements are inserted at the end.
+  void reserve(size_type size);
+
+  // The number of chunks currently allocated, including those allocated by
+  // |reserve|, for measuring the memory usage of the map.
+  std::int64_t number_of_chunks() const;
+  static constexpr std::int64_t chunk_size_in_bytes();
+
+ private:
+  struct Chunk final {
+    Chunk(int begin, int end);
+    ~Chunk();
+
+    value_type& slot(int index);
+    value_type const& slot(int index) const;
+
+    Key const& first_key() const;
+    Key const& last_key() const;
+
+    Chunk* previous = nullptr;
+    Chunk* next = nullptr;
+
+    // The constructed elements are those in [begin, end).  A chunk in
+    // |chunks_| is never empty.
+    int begin;
+    int end;
+
+    std::aligned_storage_t<sizeof(value_type), alignof(value_type)>
+        slots[chunk_capacity];
+  };
+
+  template<typename... Args>
+  const_iterator EmplaceFront(Key const& key, Args&&... args);
+  template<typename... Args>
+  const_iterator EmplaceBack(Key const& key, Args&&... args);
+
+  // Erase the elements before |last| and the elements at or after |first|,
+  // respectively.  The iterators to the other elements remain valid.
+  void EraseFront(const_iterator last);
+  void EraseBack(const_iterator first);
+
+  // |chunks_[i]->next == chunks_[i + 1]|.
+  std::deque<std::unique_ptr<Chunk>> chunks_;
+  // Empty chunks allocated by |reserve| and used by |EmplaceBack| before
+  // allocating.
+  std::vector<std::unique_ptr<Chunk>> spare_chunks_;
+  size_type size_ = 0;
+};
+
+}  // namespace internal_chunked_map
+
+using internal_chunked_map::ChunkedMap;
+
+}  // namespace base
+}  // namespace principia
+
+#include "base/chunked_map_body.hpp"
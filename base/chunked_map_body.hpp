@@ -0,0 +1,405 @@
+
+#pragma once
+
+#include "base/chunked_map.hpp"
+
+#include <algorithm>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace base {
+namespace internal_chunked_map {
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::const_iterator::operator*() const
+    -> reference {
+  DCHECK(chunk_ != nullptr);
+  return chunk_->slot(index_);
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::const_iterator::operator->() const
+    -> pointer {
+  DCHECK(chunk_ != nullptr);
+  return &chunk_->slot(index_);
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::const_iterator::operator++()
+    -> const_iterator& {
+  DCHECK(chunk_ != nullptr);
+  if (++index_ == chunk_->end) {
+    chunk_ = chunk_->next;
+    index_ = chunk_ == nullptr ? 0 : chunk_->begin;
+  }
+  return *this;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::const_iterator::operator--()
+    -> const_iterator& {
+  if (chunk_ == nullptr) {
+    DCHECK(!map_->chunks_.empty());
+    chunk_ = map_->chunks_.back().get();
+    index_ = chunk_->end - 1;
+  } else if (index_ == chunk_->begin) {
+    chunk_ = chunk_->previous;
+    DCHECK(chunk_ != nullptr);
+    index_ = chunk_->end - 1;
+  } else {
+    --index_;
+  }
+  return *this;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::const_iterator::operator++(int)
+    -> const_iterator {
+  const_iterator const initial = *this;
+  ++*this;
+  return initial;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::const_iterator::operator--(int)
+    -> const_iterator {
+  const_iterator const initial = *this;
+  --*this;
+  return initial;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+bool ChunkedMap<Key, Value, chunk_capacity>::const_iterator::operator==(
+    const_iterator const& right) const {
+  DCHECK_EQ(map_, right.map_);
+  return chunk_ == right.chunk_ && index_ == right.index_;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+bool ChunkedMap<Key, Value, chunk_capacity>::const_iterator::operator!=(
+    const_iterator const& right) const {
+  return !(*this == right);
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+ChunkedMap<Key, Value, chunk_capacity>::const_iterator::const_iterator(
+    ChunkedMap const* const map,
+    Chunk const* const chunk,
+    int const index)
+    : map_(map), chunk_(chunk), index_(index) {}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::begin() const -> const_iterator {
+  if (chunks_.empty()) {
+    return end();
+  }
+  Chunk const* const front = chunks_.front().get();
+  return const_iterator(this, front, front->begin);
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::end() const -> const_iterator {
+  return const_iterator(this, /*chunk=*/nullptr, /*index=*/0);
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::cbegin() const -> const_iterator {
+  return begin();
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::cend() const -> const_iterator {
+  return end();
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+bool ChunkedMap<Key, Value, chunk_capacity>::empty() const {
+  return size_ == 0;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::size() const -> size_type {
+  return size_;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::find(Key const& key) const
+    -> const_iterator {
+  const_iterator const it = lower_bound(key);
+  if (it == end() || key < it->first) {
+    return end();
+  }
+  return it;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::lower_bound(Key const& key) const
+    -> const_iterator {
+  // Find the first chunk that has an element not less than |key|, and then the
+  // first such element in that chunk.
+  auto const chunk_it = std::partition_point(
+      chunks_.begin(),
+      chunks_.end(),
+      [&key](std::unique_ptr<Chunk> const& chunk) {
+        return chunk->last_key() < key;
+      });
+  if (chunk_it == chunks_.end()) {
+    return end();
+  }
+  Chunk const& chunk = **chunk_it;
+  int lower = chunk.begin;
+  int upper = chunk.end;
+  while (lower < upper) {
+    int const middle = lower + (upper - lower) / 2;
+    if (chunk.slot(middle).first < key) {
+      lower = middle + 1;
+    } else {
+      upper = middle;
+    }
+  }
+  return const_iterator(this, &chunk, lower);
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::upper_bound(Key const& key) const
+    -> const_iterator {
+  const_iterator it = lower_bound(key);
+  if (it != end() && !(key < it->first)) {
+    ++it;
+  }
+  return it;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+template<typename... Args>
+auto ChunkedMap<Key, Value, chunk_capacity>::emplace_hint(
+    const_iterator const hint,
+    Key const& key,
+    Args&&... args) -> const_iterator {
+  if (empty() || chunks_.back()->last_key() < key) {
+    return EmplaceBack(key, std::forward<Args>(args)...);
+  }
+  if (key < chunks_.front()->first_key()) {
+    return EmplaceFront(key, std::forward<Args>(args)...);
+  }
+  const_iterator const it = find(key);
+  CHECK(it != end()) << "Insertion in the middle of a ChunkedMap at " << key;
+  return it;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+template<typename InputIterator>
+void ChunkedMap<Key, Value, chunk_capacity>::insert(InputIterator first,
+                                                    InputIterator const last) {
+  for (; first != last; ++first) {
+    emplace_hint(end(), first->first, first->second);
+  }
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::erase(
+    const_iterator const position) -> const_iterator {
+  DCHECK(position != end());
+  return erase(position, std::next(position));
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::erase(
+    const_iterator const first,
+    const_iterator const last) -> const_iterator {
+  if (first == last) {
+    return last;
+  } else if (first == begin()) {
+    EraseFront(last);
+    return last;
+  } else if (last == end()) {
+    EraseBack(first);
+    return end();
+  } else {
+    // Erasing in the middle.  Move the elements that follow the range out of
+    // the way, erase the end of the map and reinsert them.  This is linear in
+    // the number of elements after |first|.
+    std::vector<std::pair<Key, Value>> tail;
+    for (const_iterator it = last; it != end(); ++it) {
+      auto& element = const_cast<value_type&>(*it);
+      tail.emplace_back(element.first, std::move(element.second));
+    }
+    EraseBack(first);
+    const_iterator result = end();
+    for (auto& element : tail) {
+      const_iterator const it =
+          EmplaceBack(element.first, std::move(element.second));
+      if (result == end()) {
+        result = it;
+      }
+    }
+    return result;
+  }
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+void ChunkedMap<Key, Value, chunk_capacity>::clear() {
+  chunks_.clear();
+  spare_chunks_.clear();
+  size_ = 0;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+void ChunkedMap<Key, Value, chunk_capacity>::reserve(size_type const size) {
+  // The room left at the end of the last chunk, plus the spare chunks.
+  size_type capacity = size_ + spare_chunks_.size() * chunk_capacity;
+  if (!chunks_.empty()) {
+    capacity += chunk_capacity - chunks_.back()->end;
+  }
+  for (; capacity < size; capacity += chunk_capacity) {
+    spare_chunks_.push_back(std::make_unique<Chunk>(/*begin=*/0, /*end=*/0));
+  }
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+std::int64_t ChunkedMap<Key, Value, chunk_capacity>::number_of_chunks() const {
+  return chunks_.size() + spare_chunks_.size();
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+constexpr std::int64_t
+ChunkedMap<Key, Value, chunk_capacity>::chunk_size_in_bytes() {
+  return sizeof(Chunk);
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+ChunkedMap<Key, Value, chunk_capacity>::Chunk::Chunk(int const begin,
+                                                     int const end)
+    : begin(begin), end(end) {}
+
+template<typename Key, typename Value, int chunk_capacity>
+ChunkedMap<Key, Value, chunk_capacity>::Chunk::~Chunk() {
+  for (int i = begin; i < end; ++i) {
+    slot(i).~value_type();
+  }
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::Chunk::slot(int const index)
+    -> value_type& {
+  return *std::launder(reinterpret_cast<value_type*>(&slots[index]));
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+auto ChunkedMap<Key, Value, chunk_capacity>::Chunk::slot(int const index) const
+    -> value_type const& {
+  return *std::launder(reinterpret_cast<value_type const*>(&slots[index]));
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+Key const& ChunkedMap<Key, Value, chunk_capacity>::Chunk::first_key() const {
+  return slot(begin).first;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+Key const& ChunkedMap<Key, Value, chunk_capacity>::Chunk::last_key() const {
+  return slot(end - 1).first;
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+template<typename... Args>
+auto ChunkedMap<Key, Value, chunk_capacity>::EmplaceFront(Key const& key,
+                                                          Args&&... args)
+    -> const_iterator {
+  if (chunks_.empty() || chunks_.front()->begin == 0) {
+    // Leave room for more elements to be inserted before this one.
+    auto chunk = std::make_unique<Chunk>(/*begin=*/chunk_capacity,
+                                         /*end=*/chunk_capacity);
+    if (!chunks_.empty()) {
+      chunk->next = chunks_.front().get();
+      chunks_.front()->previous = chunk.get();
+    }
+    chunks_.push_front(std::move(chunk));
+  }
+  Chunk& front = *chunks_.front();
+  new (&front.slots[front.begin - 1])
+      value_type(std::piecewise_construct,
+                 std::forward_as_tuple(key),
+                 std::forward_as_tuple(std::forward<Args>(args)...));
+  --front.begin;
+  ++size_;
+  return const_iterator(this, &front, front.begin);
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+template<typename... Args>
+auto ChunkedMap<Key, Value, chunk_capacity>::EmplaceBack(Key const& key,
+                                                         Args&&... args)
+    -> const_iterator {
+  if (chunks_.empty() || chunks_.back()->end == chunk_capacity) {
+    std::unique_ptr<Chunk> chunk;
+    if (spare_chunks_.empty()) {
+      chunk = std::make_unique<Chunk>(/*begin=*/0, /*end=*/0);
+    } else {
+      chunk = std::move(spare_chunks_.back());
+      spare_chunks_.pop_back();
+    }
+    if (!chunks_.empty()) {
+      chunk->previous = chunks_.back().get();
+      chunks_.back()->next = chunk.get();
+    }
+    chunks_.push_back(std::move(chunk));
+  }
+  Chunk& back = *chunks_.back();
+  new (&back.slots[back.end])
+      value_type(std::piecewise_construct,
+                 std::forward_as_tuple(key),
+                 std::forward_as_tuple(std::forward<Args>(args)...));
+  ++back.end;
+  ++size_;
+  return const_iterator(this, &back, back.end - 1);
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+void ChunkedMap<Key, Value, chunk_capacity>::EraseFront(
+    const_iterator const last) {
+  while (!chunks_.empty() && chunks_.front().get() != last.chunk_) {
+    size_ -= chunks_.front()->end - chunks_.front()->begin;
+    chunks_.pop_front();
+  }
+  if (chunks_.empty()) {
+    return;
+  }
+  Chunk& front = *chunks_.front();
+  front.previous = nullptr;
+  for (; front.begin < last.index_; ++front.begin) {
+    front.slot(front.begin).~value_type();
+    --size_;
+  }
+}
+
+template<typename Key, typename Value, int chunk_capacity>
+void ChunkedMap<Key, Value, chunk_capacity>::EraseBack(
+    const_iterator const first) {
+  while (chunks_.back().get() != first.chunk_) {
+    size_ -= chunks_.back()->end - chunks_.back()->begin;
+    chunks_.pop_back();
+  }
+  Chunk& back = *chunks_.back();
+  back.next = nullptr;
+  while (back.end > first.index_) {
+    --back.end;
+    back.slot(back.end).~value_type();
+    --size_;
+  }
+  if (back.begin == back.end) {
+    chunks_.pop_back();
+    if (!chunks_.empty()) {
+      chunks_.back()->next = nullptr;
+    }
+  }
+}
+
+}  // namespace internal_chunked_map
+}  // namespace base
+}  // namespace principia
@@ -0,0 +1,185 @@
+
+#include "base/chunked_map.hpp"
+
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace principia {
+namespace base {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+class ChunkedMapTest : public ::testing::Test {
+ protected:
+  // A small capacity to exercise the transitions between chunks.
+  using Map = ChunkedMap<int, std::string, /*chunk_capacity=*/3>;
+
+  static std::vector<std::pair<int, std::string>> Elements(Map const& map) {
+    std::vector<std::pair<int, std::string>> elements;
+    for (auto const& pair : map) {
+      elements.emplace_back(pair.first, pair.second);
+    }
+    return elements;
+  }
+
+  void Fill(int const first, int const last) {
+    for (int i = first; i < last; ++i) {
+      map_.emplace_hint(map_.end(), i, std::to_string(i));
+    }
+  }
+
+  Map map_;
+};
+
+TEST_F(ChunkedMapTest, Empty) {
+  EXPECT_TRUE(map_.empty());
+  EXPECT_EQ(0, map_.size());
+  EXPECT_TRUE(map_.begin() == map_.end());
+  EXPECT_TRUE(map_.find(1) == map_.end());
+  EXPECT_TRUE(map_.lower_bound(1) == map_.end());
+  EXPECT_EQ(0, map_.number_of_chunks());
+}
+
+TEST_F(ChunkedMapTest, EmplaceAtBothEnds) {
+  Fill(3, 8);
+  for (int i = 2; i >= 0; --i) {
+    map_.emplace_hint(map_.begin(), i, std::to_string(i));
+  }
+  EXPECT_EQ(8, map_.size());
+  EXPECT_THAT(Elements(map_),
+              ElementsAre(Pair(0, "0"), Pair(1, "1"), Pair(2, "2"),
+                          Pair(3, "3"), Pair(4, "4"), Pair(5, "5"),
+                          Pair(6, "6"), Pair(7, "7")));
+  EXPECT_EQ(8, std::distance(map_.begin(), map_.end()));
+
+  // Existing keys are not reinserted.
+  auto const it = map_.emplace_hint(map_.end(), 4, "four");
+  EXPECT_EQ(4, it->first);
+  EXPECT_EQ("4", it->second);
+  EXPECT_EQ(8, map_.size());
+}
+
+TEST_F(ChunkedMapTest, Iterators) {
+  Fill(0, 7);
+  auto it = map_.end();
+  for (int i = 6; i >= 0; --i) {
+    --it;
+    EXPECT_EQ(i, it->first);
+  }
+  EXPECT_TRUE(it == map_.begin());
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_EQ(i, (it++)->first);
+  }
+  EXPECT_TRUE(it == map_.end());
+}
+
+TEST_F(ChunkedMapTest, Search) {
+  for (int i = 0; i < 20; i += 2) {
+    map_.emplace_hint(map_.end(), i, std::to_string(i));
+  }
+  std::map<int, std::string> reference;
+  for (auto const& pair : map_) {
+    reference.insert(pair);
+  }
+  for (int i = -1; i < 21; ++i) {
+    auto const find = map_.find(i);
+    auto const lower_bound = map_.lower_bound(i);
+    auto const upper_bound = map_.upper_bound(i);
+    auto const reference_find = reference.find(i);
+    auto const reference_lower_bound = reference.lower_bound(i);
+    auto const reference_upper_bound = reference.upper_bound(i);
+    EXPECT_EQ(std::distance(reference.begin(), reference_find),
+              std::distance(map_.begin(), find)) << i;
+    EXPECT_EQ(std::distance(reference.begin(), reference_lower_bound),
+              std::distance(map_.begin(), lower_bound)) << i;
+    EXPECT_EQ(std::distance(reference.begin(), reference_upper_bound),
+              std::distance(map_.begin(), upper_bound)) << i;
+  }
+}
+
+TEST_F(ChunkedMapTest, StableIterators) {
+  Fill(0, 10);
+  auto const end = map_.end();
+  auto const four = map_.find(4);
+  auto const six = map_.find(6);
+
+  // Erase at both ends and insert at both ends.
+  map_.erase(map_.begin(), map_.find(2));
+  map_.erase(map_.find(8), map_.end());
+  map_.emplace_hint(map_.begin(), -1, "-1");
+  Fill(20, 30);
+  map_.erase(map_.begin());
+
+  EXPECT_EQ(4, four->first);
+  EXPECT_EQ(6, six->first);
+  EXPECT_EQ(2, std::distance(four, six));
+  EXPECT_TRUE(map_.end() == end);
+  EXPECT_EQ(29, std::prev(end)->first);
+  EXPECT_EQ(16, map_.size());
+}
+
+TEST_F(ChunkedMapTest, Erase) {
+  Fill(0, 10);
+  map_.erase(map_.begin(), map_.end());
+  EXPECT_TRUE(map_.empty());
+  EXPECT_EQ(0, map_.number_of_chunks());
+
+  Fill(0, 10);
+  auto const it = map_.erase(map_.find(2), map_.find(7));
+  EXPECT_EQ(7, it->first);
+  EXPECT_THAT(Elements(map_),
+              ElementsAre(Pair(0, "0"), Pair(1, "1"), Pair(7, "7"),
+                          Pair(8, "8"), Pair(9, "9")));
+  EXPECT_EQ(5, map_.size());
+  EXPECT_EQ(2, map_.number_of_chunks());
+
+  map_.erase(map_.find(8));
+  map_.erase(map_.begin());
+  EXPECT_THAT(Elements(map_),
+              ElementsAre(Pair(1, "1"), Pair(7, "7"), Pair(9, "9")));
+}
+
+TEST_F(ChunkedMapTest, Insert) {
+  std::map<int, std::string> const source = {{1, "one"}, {2, "two"}};
+  map_.insert(source.begin(), source.end());
+  EXPECT_THAT(Elements(map_), ElementsAre(Pair(1, "one"), Pair(2, "two")));
+}
+
+TEST_F(ChunkedMapTest, Reserve) {
+  Fill(0, 2);
+  EXPECT_EQ(1, map_.number_of_chunks());
+
+  // The last chunk has room for one element, two more chunks are needed.
+  map_.reserve(8);
+  EXPECT_EQ(3, map_.number_of_chunks());
+  map_.reserve(5);
+  EXPECT_EQ(3, map_.number_of_chunks());
+
+  // The reserved chunks are used by the insertions at the end.
+  Fill(2, 8);
+  EXPECT_EQ(3, map_.number_of_chunks());
+  EXPECT_EQ(8, map_.size());
+  EXPECT_THAT(Elements(map_),
+              ElementsAre(Pair(0, "0"), Pair(1, "1"), Pair(2, "2"),
+                          Pair(3, "3"), Pair(4, "4"), Pair(5, "5"),
+                          Pair(6, "6"), Pair(7, "7")));
+  EXPECT_EQ(7, std::prev(map_.end())->first);
+  EXPECT_EQ(6, std::prev(std::prev(map_.end()))->first);
+  Fill(8, 9);
+  EXPECT_EQ(3, map_.number_of_chunks());
+  Fill(9, 10);
+  EXPECT_EQ(4, map_.number_of_chunks());
+
+  map_.reserve(20);
+  map_.clear();
+  EXPECT_EQ(0, map_.number_of_chunks());
+}
+
+}  // namespace base
+}  // namespace principia
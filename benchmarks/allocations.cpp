@@ -0,0 +1,47 @@
+﻿
+#include "benchmarks/allocations.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace principia {
+namespace benchmarks {
+
+namespace {
+thread_local std::int64_t allocation_count = 0;
+}  // namespace
+
+std::int64_t AllocationCount() {
+  return allocation_count;
+}
+
+bool AllocationsAreCounted(benchmark::State& state) {
+  if (!PRINCIPIA_COUNT_ALLOCATIONS) {
+    state.SkipWithError(
+        "Define PRINCIPIA_COUNT_ALLOCATIONS to 1 to count the allocations");
+  }
+  return PRINCIPIA_COUNT_ALLOCATIONS;
+}
+
+}  // namespace benchmarks
+}  // namespace principia
+
+#if PRINCIPIA_COUNT_ALLOCATIONS
+
+// Replacements for the global allocation and deallocation functions.  The
+// default array, sized and non-throwing forms call these.
+
+void* operator new(std::size_t const size) {
+  ++principia::benchmarks::allocation_count;
+  void* const pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void operator delete(void* const pointer) noexcept {
+  std::free(pointer);
+}
+
+#endif
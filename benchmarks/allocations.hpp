@@ -0,0 +1,30 @@
+﻿
+#pragma once
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+
+// Define this macro to 1 to replace the global |operator new| with a function
+// that counts the allocations.  The replacement applies to all the benchmarks
+// of the executable, so it is off by default.
+#if !defined(PRINCIPIA_COUNT_ALLOCATIONS)
+#define PRINCIPIA_COUNT_ALLOCATIONS 0
+#endif
+
+namespace principia {
+namespace benchmarks {
+
+// The number of calls to the global |operator new| made by the current thread
+// since it started.  If |PRINCIPIA_COUNT_ALLOCATIONS| is 1, |operator new| is
+// replaced with a function that maintains this count, so the number of heap
+// allocations done by some code is the difference between the counts after and
+// before it.  Otherwise the count is always 0.
+std::int64_t AllocationCount();
+
+// Returns true if the allocations are counted.  Otherwise, reports an error for
+// |state|, which must then be skipped.
+bool AllocationsAreCounted(benchmark::State& state);
+
+}  // namespace benchmarks
+}  // namespace principia
@@ -0,0 +1,161 @@
+﻿
+// .\Release\x64\benchmarks.exe --benchmark_repetitions=3 --benchmark_filter=ContinuousTrajectory  // NOLINT(whitespace/line_length)
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "astronomy/frames.hpp"
+#include "benchmark/benchmark.h"
+#include "geometry/named_quantities.hpp"
+#include "physics/continuous_trajectory.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "quantities/numbers.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+
+namespace principia {
+
+using astronomy::ICRS;
+using geometry::Displacement;
+using geometry::Instant;
+using geometry::Velocity;
+using quantities::Angle;
+using quantities::AngularFrequency;
+using quantities::Cos;
+using quantities::Length;
+using quantities::Sin;
+using quantities::Time;
+using quantities::si::Kilo;
+using quantities::si::Metre;
+using quantities::si::Milli;
+using quantities::si::Radian;
+using quantities::si::Second;
+
+namespace physics {
+
+namespace {
+
+Instant const t0;
+Length const distance = 1 * Kilo(Metre);
+Time const period = 100 * Second;
+Time const step = 10 * Milli(Second);
+int const initial_number_of_steps = 100000;
+
+DegreesOfFreedom<ICRS> CircularMotion(Instant const& t) {
+  AngularFrequency const ω = 2 * π * Radian / period;
+  Angle const angle = ω * (t - t0);
+  return DegreesOfFreedom<ICRS>(
+      ICRS::origin + Displacement<ICRS>({distance * Cos(angle),
+                                         distance * Sin(angle),
+                                         0 * Metre}),
+      Velocity<ICRS>({-ω * distance * Sin(angle) / Radian,
+                      ω * distance * Cos(angle) / Radian,
+                      0 * Metre / Second}));
+}
+
+// Shared by the threads of a run of the benchmark.  Set up and torn down by
+// thread 0.
+std::unique_ptr<ContinuousTrajectory<ICRS>> trajectory;
+std::unique_ptr<std::thread> appender;
+std::atomic<bool> appender_done;
+
+}  // namespace
+
+// Evaluates the trajectory from |state.threads| reader threads.  If
+// |state.range(0)| is nonzero, the trajectory is appended to by another thread
+// while it is being read.  Each reader walks through the initial range of the
+// trajectory in small increments, the way an integrator would.
+void BM_ContinuousTrajectoryEvaluateDegreesOfFreedom(benchmark::State& state) {
+  bool const concurrent_append = state.range(0) != 0;
+  if (state.thread_index == 0) {
+    trajectory = std::make_unique<ContinuousTrajectory<ICRS>>(
+        step, /*tolerance=*/1 * Milli(Metre));
+    for (int i = 1; i <= initial_number_of_steps; ++i) {
+      Instant const ti = t0 + i * step;
+      trajectory->Append(ti, CircularMotion(ti));
+    }
+    if (concurrent_append) {
+      appender_done = false;
+      appender = std::make_unique<std::thread>([]() {
+        for (int i = initial_number_of_steps + 1; !appender_done; ++i) {
+          Instant const ti = t0 + i * step;
+          trajectory->Append(ti, CircularMotion(ti));
+        }
+      });
+    }
+  }
+
+  // The barrier in |KeepRunning| ensures that the other threads don't see the
+  // trajectory before it is set up.
+  Time const reader_step = step / 3 + state.thread_index * Milli(Second);
+  Instant t_min;
+  Instant t_max;
+  Instant t;
+  bool first = true;
+  while (state.KeepRunning()) {
+    if (first) {
+      t_min = trajectory->t_min();
+      // The last points appended are not yet covered by a polynomial.
+      t_max = trajectory->t_max();
+      t = t_min;
+      first = false;
+    }
+    benchmark::DoNotOptimize(trajectory->EvaluateDegreesOfFreedom(t));
+    t += reader_step;
+    if (t > t_max) {
+      t = t_min;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index == 0) {
+    if (concurrent_append) {
+      appender_done = true;
+      appender->join();
+      appender.reset();
+    }
+    trajectory.reset();
+  }
+}
+
+// Evaluates the trajectory at random times, so that most evaluations use a
+// polynomial that is not in the cache.  The label gives the average degree of
+// the polynomials.
+void BM_ContinuousTrajectoryEvaluatePositionRandomly(benchmark::State& state) {
+  ContinuousTrajectory<ICRS> trajectory(step, /*tolerance=*/1 * Milli(Metre));
+  for (int i = 1; i <= initial_number_of_steps; ++i) {
+    Instant const ti = t0 + i * step;
+    trajectory.Append(ti, CircularMotion(ti));
+  }
+
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<> distribution(
+      0, (trajectory.t_max() - trajectory.t_min()) / Second);
+  std::vector<Instant> times;
+  for (int i = 0; i < 1000; ++i) {
+    times.push_back(trajectory.t_min() + distribution(random) * Second);
+  }
+
+  while (state.KeepRunning()) {
+    for (Instant const& t : times) {
+      benchmark::DoNotOptimize(trajectory.EvaluatePosition(t));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * times.size());
+  state.SetLabel(std::to_string(trajectory.average_degree()));
+}
+
+BENCHMARK(BM_ContinuousTrajectoryEvaluateDegreesOfFreedom)
+    ->Arg(0)
+    ->Arg(1)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+BENCHMARK(BM_ContinuousTrajectoryEvaluatePositionRandomly);
+
+}  // namespace physics
+}  // namespace principia
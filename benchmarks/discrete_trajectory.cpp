@@ -0,0 +1,309 @@
+﻿
+// .\Release\x64\benchmarks.exe --benchmark_repetitions=3 --benchmark_filter=DiscreteTrajectory  // NOLINT(whitespace/line_length)
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "astronomy/frames.hpp"
+#include "base/chunked_map.hpp"
+#include "benchmark/benchmark.h"
+#include "geometry/named_quantities.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "physics/discrete_trajectory.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/numbers.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+
+namespace principia {
+
+using astronomy::ICRS;
+using base::ChunkedMap;
+using geometry::Displacement;
+using geometry::Instant;
+using geometry::Velocity;
+using quantities::Angle;
+using quantities::AngularFrequency;
+using quantities::Cos;
+using quantities::Length;
+using quantities::Sin;
+using quantities::Time;
+using quantities::si::Kilo;
+using quantities::si::Metre;
+using quantities::si::Radian;
+using quantities::si::Second;
+
+namespace physics {
+
+namespace {
+
+using StdMapTimeline = std::map<Instant, DegreesOfFreedom<ICRS>>;
+using ChunkedTimeline = ChunkedMap<Instant, DegreesOfFreedom<ICRS>>;
+
+DegreesOfFreedom<ICRS> DegreesOfFreedomAt(int const i) {
+  return DegreesOfFreedom<ICRS>(
+      ICRS::origin + Displacement<ICRS>({i * Metre, 0 * Metre, 0 * Metre}),
+      Velocity<ICRS>({1 * Metre / Second, 0 * Metre / Second,
+                      0 * Metre / Second}));
+}
+
+// A low circular orbit.
+DegreesOfFreedom<ICRS> CircularMotion(Instant const& t) {
+  Instant const t0;
+  Length const r = 7000 * Kilo(Metre);
+  AngularFrequency const ω = 2 * π * Radian / (5800 * Second);
+  Angle const angle = ω * (t - t0);
+  return DegreesOfFreedom<ICRS>(
+      ICRS::origin + Displacement<ICRS>({r * Cos(angle),
+                                         r * Sin(angle),
+                                         0 * Metre}),
+      Velocity<ICRS>({-ω * r * Sin(angle) / Radian,
+                      ω * r * Cos(angle) / Radian,
+                      0 * Metre / Second}));
+}
+
+// The memory used by the nodes of a |std::map|, assuming that they hold three
+// pointers and two flags besides the value, as in the usual red-black trees.
+std::int64_t BytesPerPoint(StdMapTimeline const& timeline) {
+  using Value = StdMapTimeline::value_type;
+  std::int64_t const header = 3 * sizeof(void*) + 2;
+  std::int64_t const alignment = alignof(Value);
+  return (header + alignment - 1) / alignment * alignment + sizeof(Value);
+}
+
+std::int64_t BytesPerPoint(ChunkedTimeline const& timeline) {
+  return timeline.number_of_chunks() * ChunkedTimeline::chunk_size_in_bytes() /
+         timeline.size();
+}
+
+}  // namespace
+
+// Iterates over a timeline of |state.range(0)| points, the way plotting,
+// apsides computation or serialization do.  The label gives the memory used per
+// point, ignoring the overhead of the allocator.
+template<typename Timeline>
+void BM_DiscreteTrajectoryTimelineIteration(benchmark::State& state) {
+  Timeline timeline;
+  Instant const t0;
+  for (int i = 0; i < state.range(0); ++i) {
+    timeline.emplace_hint(
+        timeline.end(), t0 + i * Second, DegreesOfFreedomAt(i));
+  }
+
+  while (state.KeepRunning()) {
+    Instant last;
+    for (auto const& pair : timeline) {
+      last = pair.first;
+      benchmark::DoNotOptimize(pair.second);
+    }
+    benchmark::DoNotOptimize(last);
+  }
+  state.SetItemsProcessed(state.iterations() * timeline.size());
+  state.SetLabel(std::to_string(BytesPerPoint(timeline)) + " bytes/point");
+}
+
+// Iterates over a |DiscreteTrajectory| with whichever timeline was selected at
+// compile time.
+void BM_DiscreteTrajectoryIteration(benchmark::State& state) {
+  DiscreteTrajectory<ICRS> trajectory;
+  Instant const t0;
+  for (int i = 0; i < state.range(0); ++i) {
+    trajectory.Append(t0 + i * Second, DegreesOfFreedomAt(i));
+  }
+
+  while (state.KeepRunning()) {
+    for (auto it = trajectory.Begin(); it != trajectory.End(); ++it) {
+      benchmark::DoNotOptimize(it.degrees_of_freedom());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Forks a trajectory of 100 000 points with a copy of its last |state.range(0)|
+// points and appends a few points to the fork and to the trajectory, the way
+// the predictions and flight plans are recomputed.
+void BM_DiscreteTrajectoryForkWithCopyAndAppend(benchmark::State& state) {
+  int const size = 100'000;
+  int const appended_points = 10;
+  DiscreteTrajectory<ICRS> trajectory;
+  Instant const t0;
+  for (int i = 0; i < size; ++i) {
+    trajectory.Append(t0 + i * Second, DegreesOfFreedomAt(i));
+  }
+  Instant const fork_time = t0 + (size - 1 - state.range(0)) * Second;
+  Instant const last_time = t0 + (size - 1) * Second;
+
+  while (state.KeepRunning()) {
+    DiscreteTrajectory<ICRS>* fork = trajectory.NewForkWithCopy(fork_time);
+    for (int i = size; i < size + appended_points; ++i) {
+      fork->Append(t0 + i * Second, DegreesOfFreedomAt(-i));
+      trajectory.Append(t0 + i * Second, DegreesOfFreedomAt(i));
+    }
+    trajectory.DeleteFork(fork);
+    trajectory.ForgetAfter(last_time);
+  }
+}
+
+// Appends 1000 points to a fork of a trajectory, in batches of |state.range(0)|
+// points, or one at a time if |state.range(0)| is 0, the way the integrators
+// do.
+void BM_DiscreteTrajectoryAppend(benchmark::State& state) {
+  int const size = 1000;
+  std::size_t const batch_size = state.range(0);
+  DiscreteTrajectory<ICRS> trajectory;
+  Instant const t0;
+  trajectory.Append(t0, DegreesOfFreedomAt(0));
+  std::vector<std::pair<Instant, DegreesOfFreedom<ICRS>>> batch;
+  batch.reserve(batch_size);
+
+  while (state.KeepRunning()) {
+    DiscreteTrajectory<ICRS>* fork = trajectory.NewForkAtLast();
+    for (int i = 1; i <= size; ++i) {
+      if (batch_size == 0) {
+        fork->Append(t0 + i * Second, DegreesOfFreedomAt(i));
+      } else {
+        batch.emplace_back(t0 + i * Second, DegreesOfFreedomAt(i));
+        if (batch.size() == batch_size || i == size) {
+          fork->Append(batch);
+          batch.clear();
+        }
+      }
+    }
+    trajectory.DeleteFork(fork);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+// Appends 1 000 000 points of a circular orbit to a trajectory downsampled with
+// the parameters of the vessel histories and |max_dense_intervals =
+// state.range(0)|.  The label gives the largest number of points held by the
+// trajectory.
+void BM_DiscreteTrajectoryDownsampling(benchmark::State& state) {
+  int const size = 1'000'000;
+  Time const step = 10 * Second;
+  Instant const t0;
+  std::int64_t peak_size = 0;
+  std::int64_t final_size = 0;
+
+  while (state.KeepRunning()) {
+    DiscreteTrajectory<ICRS> trajectory;
+    trajectory.SetDownsampling(/*max_dense_intervals=*/state.range(0),
+                               /*tolerance=*/10 * Metre);
+    for (int i = 0; i < size; ++i) {
+      Instant const t = t0 + i * step;
+      trajectory.Append(t, CircularMotion(t));
+      peak_size = std::max(peak_size, trajectory.Size());
+    }
+    final_size = trajectory.Size();
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+  state.SetLabel(std::to_string(peak_size) + " peak points, " +
+                 std::to_string(final_size) + " final points");
+}
+
+// Appends 100 000 points of a circular orbit, with irregular steps, to a
+// trajectory with a memory budget of |state.range(0)| points, or without a
+// budget if |state.range(0)| is 0.  The label gives the memory used per sealed
+// point.
+void BM_DiscreteTrajectorySealing(benchmark::State& state) {
+  int const size = 100'000;
+  Instant const t0;
+  std::int64_t sealed_points = 0;
+  std::int64_t sealed_size_in_bytes = 0;
+
+  while (state.KeepRunning()) {
+    DiscreteTrajectory<ICRS> trajectory;
+    if (state.range(0) > 0) {
+      trajectory.SetMemoryBudget(state.range(0));
+    }
+    Instant t = t0;
+    for (int i = 0; i < size; ++i) {
+      t += (10 + i % 7) * Second;
+      trajectory.Append(t, CircularMotion(t));
+    }
+    sealed_points = trajectory.number_of_sealed_points();
+    sealed_size_in_bytes = trajectory.sealed_size_in_bytes();
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+  if (sealed_points > 0) {
+    state.SetLabel(std::to_string(sealed_size_in_bytes / sealed_points) +
+                   " bytes/sealed point");
+  }
+}
+
+// Evaluates the position of a trajectory of 100 000 points of a circular orbit.
+// If |state.range(0)| is 0, the evaluations walk through the trajectory in
+// steps of a third of the spacing of the points, the way the renderer or the
+// computation of apsides would, using a cursor.  Otherwise they are at random
+// times, without a cursor.  If |state.range(1)| is nonzero, it is the memory
+// budget of the trajectory, so most evaluations are in sealed blocks.
+void BM_DiscreteTrajectoryEvaluatePosition(benchmark::State& state) {
+  int const size = 100'000;
+  Time const step = 10 * Second;
+  Instant const t0;
+  DiscreteTrajectory<ICRS> trajectory;
+  if (state.range(1) > 0) {
+    trajectory.SetMemoryBudget(state.range(1));
+  }
+  for (int i = 0; i < size; ++i) {
+    Instant const t = t0 + i * step;
+    trajectory.Append(t, CircularMotion(t));
+  }
+
+  std::vector<Instant> times;
+  if (state.range(0) == 0) {
+    for (Instant t = t0; t <= trajectory.t_max(); t += step / 3) {
+      times.push_back(t);
+    }
+  } else {
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<> distribution(
+        0, (trajectory.t_max() - t0) / Second);
+    for (int i = 0; i < 3 * size; ++i) {
+      times.push_back(t0 + distribution(random) * Second);
+    }
+  }
+
+  while (state.KeepRunning()) {
+    if (state.range(0) == 0) {
+      DiscreteTrajectory<ICRS>::Cursor cursor;
+      for (Instant const& t : times) {
+        benchmark::DoNotOptimize(trajectory.EvaluatePosition(t, cursor));
+      }
+    } else {
+      for (Instant const& t : times) {
+        benchmark::DoNotOptimize(trajectory.EvaluatePosition(t));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * times.size());
+}
+
+BENCHMARK_TEMPLATE(BM_DiscreteTrajectoryTimelineIteration, StdMapTimeline)
+    ->Arg(1000)
+    ->Arg(1000000);
+BENCHMARK_TEMPLATE(BM_DiscreteTrajectoryTimelineIteration, ChunkedTimeline)
+    ->Arg(1000)
+    ->Arg(1000000);
+BENCHMARK(BM_DiscreteTrajectoryIteration)->Arg(1000)->Arg(1000000);
+BENCHMARK(BM_DiscreteTrajectoryAppend)->Arg(0)->Arg(1)->Arg(10)->Arg(100);
+BENCHMARK(BM_DiscreteTrajectoryDownsampling)
+    ->Arg(100)
+    ->Arg(10'000);
+BENCHMARK(BM_DiscreteTrajectoryEvaluatePosition)
+    ->Args({0, 0})
+    ->Args({1, 0})
+    ->Args({0, 20'000})
+    ->Args({1, 20'000});
+BENCHMARK(BM_DiscreteTrajectorySealing)->Arg(0)->Arg(10'000);
+BENCHMARK(BM_DiscreteTrajectoryForkWithCopyAndAppend)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(99999);
+
+}  // namespace physics
+}  // namespace principia
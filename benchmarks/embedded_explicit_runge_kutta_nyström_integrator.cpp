@@ -1,21 +1,27 @@
 ﻿
 // .\Release\x64\benchmarks.exe --benchmark_repetitions=5 --benchmark_min_time=5 --benchmark_filter=EmbeddedExplicitRungeKuttaNyströmIntegratorSolveHarmonicOscillator                                                                                                                 // NOLINT(whitespace/line_length)
+// .\Release\x64\benchmarks.exe --benchmark_repetitions=5 --benchmark_min_time=5 --benchmark_filter=EmbeddedExplicitRungeKuttaNyströmIntegratorDenseOutput                                                                                                                        // NOLINT(whitespace/line_length)
+// .\Release\x64\benchmarks.exe --benchmark_filter=Allocations                                                                                                                                                                                                                   // NOLINT(whitespace/line_length)
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <type_traits>
 #include <vector>
 
 #include "base/not_null.hpp"
 #include "benchmark/benchmark.h"
+#include "benchmarks/allocations.hpp"
 #include "geometry/frame.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/named_quantities.hpp"
 #include "integrators/methods.hpp"
 #include "integrators/ordinary_differential_equations.hpp"
 #include "integrators/symplectic_runge_kutta_nyström_integrator.hpp"
+#include "numerics/double_precision.hpp"
 #include "glog/logging.h"
 #include "quantities/elementary_functions.hpp"
 #include "quantities/named_quantities.hpp"
@@ -25,6 +31,8 @@
 
 namespace principia {
 
+using benchmarks::AllocationCount;
+using benchmarks::AllocationsAreCounted;
 using geometry::Displacement;
 using geometry::Frame;
 using geometry::Instant;
@@ -33,6 +41,7 @@ using geometry::Vector;
 using geometry::Velocity;
 using integrators::EmbeddedExplicitRungeKuttaNyströmIntegrator;
 using integrators::methods::DormandالمكاوىPrince1986RKN434FM;
+using numerics::DoublePrecision;
 using quantities::Abs;
 using quantities::Acceleration;
 using quantities::AngularFrequency;
@@ -232,6 +241,136 @@ void BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveHarmonicOscillator3D(
   state.SetLabel(ss.str());
 }
 
+// Measures the cost of the dense output: |state.range(0)| states are evaluated
+// within each step, and the dense output is not requested if it is 0.  The
+// items are the steps, so that the throughput is comparable to that of the
+// integration alone.
+template<typename Method>
+void BM_EmbeddedExplicitRungeKuttaNyströmIntegratorDenseOutput(
+    benchmark::State& state) {
+  using ODE = SpecialSecondOrderDifferentialEquation<Position<World>>;
+  using DenseOutput = AdaptiveStepSizeIntegrator<ODE>::DenseOutput;
+  auto const& integrator =
+      EmbeddedExplicitRungeKuttaNyströmIntegrator<Method, Position<World>>();
+  int const samples_per_step = state.range(0);
+
+  Displacement<World> const q_initial({1 * Metre, 0 * Metre, 0 * Metre});
+  Velocity<World> const v_initial;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 1000 * Second;
+  Length const length_tolerance = 1e-6 * Metre;
+  Speed const speed_tolerance = 1e-6 * Metre / Second;
+  IntegrationProblem<ODE> problem;
+  problem.equation.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration3D<World>,
+                _1, _2, _3, /*evaluations=*/nullptr);
+  problem.initial_state = {{World::origin + q_initial}, {v_initial}, t_initial};
+  AdaptiveStepSizeIntegrator<ODE>::Parameters const parameters(
+      /*first_time_step=*/t_final - t_initial,
+      /*safety_factor=*/0.9);
+
+  std::int64_t steps = 0;
+  ODE::SystemState last_state;
+  std::vector<Position<World>> positions(1);
+  std::vector<Velocity<World>> velocities(1);
+  Length q_error;
+  while (state.KeepRunning()) {
+    auto const instance = integrator.NewInstance(
+        problem,
+        [&last_state, &steps](ODE::SystemState const& state) {
+          last_state = state;
+          ++steps;
+        },
+        std::bind(HarmonicOscillatorToleranceRatio3D<ODE>,
+                  _1, _2, length_tolerance, speed_tolerance),
+        parameters);
+    if (samples_per_step > 0) {
+      dynamic_cast<AdaptiveStepSizeIntegrator<ODE>::Instance&>(*instance)
+          .SetDenseOutput([&](DenseOutput const& dense_output) {
+            Time const h = dense_output.t_end() - dense_output.t_begin();
+            for (int i = 1; i <= samples_per_step; ++i) {
+              Instant const t = dense_output.t_begin() +
+                                i * h / (samples_per_step + 1);
+              dense_output.Evaluate(t, positions, velocities);
+              q_error = std::max(
+                  q_error,
+                  ((positions[0] - World::origin) -
+                   q_initial * Cos((t - t_initial) * (Radian / Second)))
+                      .Norm());
+            }
+          });
+    }
+    instance->Solve(t_final);
+  }
+  state.SetItemsProcessed(steps);
+  std::stringstream ss;
+  ss << samples_per_step << " samples per step, " << q_error;
+  state.SetLabel(ss.str());
+}
+
+// Counts the heap allocations done by the steps of the integrator.  |Solve| is
+// called repeatedly for an interval of |state.range(0)| seconds for a system of
+// 10 harmonic oscillators.  The label gives the number of allocations per step,
+// which must be 0.
+template<typename Method>
+void BM_EmbeddedExplicitRungeKuttaNyströmIntegratorAllocations(
+    benchmark::State& state) {
+  if (!AllocationsAreCounted(state)) {
+    return;
+  }
+  using ODE = SpecialSecondOrderDifferentialEquation<Position<World>>;
+  auto const& integrator =
+      EmbeddedExplicitRungeKuttaNyströmIntegrator<Method, Position<World>>();
+  Time const interval = state.range(0) * Second;
+  Length const length_tolerance = 1e-6 * Metre;
+  Speed const speed_tolerance = 1e-6 * Metre / Second;
+
+  IntegrationProblem<ODE> problem;
+  problem.equation.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration3D<World>,
+                _1, _2, _3, /*evaluations=*/nullptr);
+  problem.initial_state.time = DoublePrecision<Instant>(Instant());
+  for (int i = 0; i < 10; ++i) {
+    problem.initial_state.positions.emplace_back(
+        World::origin + Displacement<World>({(1 + i) * Metre,
+                                             0 * Metre,
+                                             0 * Metre}));
+    problem.initial_state.velocities.emplace_back(Velocity<World>());
+  }
+  std::int64_t steps = 0;
+  ODE::SystemState last_state = problem.initial_state;
+  AdaptiveStepSizeIntegrator<ODE>::Parameters const parameters(
+      /*first_time_step=*/interval,
+      /*safety_factor=*/0.9,
+      /*max_steps=*/std::numeric_limits<std::int64_t>::max(),
+      /*last_step_is_exact=*/false);
+  auto const instance = integrator.NewInstance(
+      problem,
+      [&last_state, &steps](ODE::SystemState const& state) {
+        last_state = state;
+        ++steps;
+      },
+      std::bind(HarmonicOscillatorToleranceRatio3D<ODE>,
+                _1, _2, length_tolerance, speed_tolerance),
+      parameters);
+
+  Instant t_final = Instant() + interval;
+  instance->Solve(t_final);
+
+  steps = 0;
+  std::int64_t allocations = 0;
+  while (state.KeepRunning()) {
+    t_final += interval;
+    std::int64_t const allocations_before = AllocationCount();
+    instance->Solve(t_final);
+    allocations += AllocationCount() - allocations_before;
+  }
+  state.SetItemsProcessed(steps);
+  std::stringstream ss;
+  ss << static_cast<double>(allocations) / steps << " allocations per step";
+  state.SetLabel(ss.str());
+}
+
 // Keep each argument on a single line below, lest it breaks benchmark parsing.
 
 BENCHMARK_TEMPLATE2(
@@ -242,5 +381,13 @@ BENCHMARK_TEMPLATE2(
     BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveHarmonicOscillator3D,
     methods::DormandالمكاوىPrince1986RKN434FM, Position<World>);
 
+BENCHMARK_TEMPLATE1(
+    BM_EmbeddedExplicitRungeKuttaNyströmIntegratorDenseOutput,
+    methods::DormandالمكاوىPrince1986RKN434FM)->Arg(0)->Arg(1)->Arg(10);
+
+BENCHMARK_TEMPLATE1(
+    BM_EmbeddedExplicitRungeKuttaNyströmIntegratorAllocations,
+    methods::DormandالمكاوىPrince1986RKN434FM)->Arg(1)->Arg(10);
+
 }  // namespace integrators
 }  // namespace principia
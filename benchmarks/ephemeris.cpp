@@ -5,6 +5,7 @@
 #include <limits>
 #include <list>
 #include <memory>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -22,9 +23,11 @@
 #include "integrators/symmetric_linear_multistep_integrator.hpp"
 #include "integrators/symplectic_runge_kutta_nyström_integrator.hpp"
 #include "ksp_plugin/frames.hpp"
+#include "physics/continuous_trajectory.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "physics/discrete_trajectory.hpp"
 #include "physics/ephemeris.hpp"
+#include "physics/massive_body.hpp"
 #include "physics/massless_body.hpp"
 #include "quantities/astronomy.hpp"
 #include "quantities/bipm.hpp"
@@ -59,19 +62,26 @@ using integrators::methods::McLachlanAtela1992Order5Optimal;
 using integrators::methods::Quinlan1999Order8A;
 using integrators::methods::QuinlanTremaine1990Order12;
 using ksp_plugin::Barycentric;
+using quantities::Angle;
+using quantities::Cos;
 using quantities::DebugString;
 using quantities::Frequency;
+using quantities::GravitationalParameter;
 using quantities::Length;
+using quantities::Sin;
 using quantities::Speed;
 using quantities::Sqrt;
 using quantities::Time;
 using quantities::astronomy::AstronomicalUnit;
 using quantities::astronomy::JulianYear;
+using quantities::astronomy::SolarGravitationalParameter;
 using quantities::bipm::NauticalMile;
 using quantities::si::ArcMinute;
 using quantities::si::ArcSecond;
+using quantities::si::Day;
 using quantities::si::Degree;
 using quantities::si::Hertz;
+using quantities::si::Hour;
 using quantities::si::Kilo;
 using quantities::si::Metre;
 using quantities::si::Milli;
@@ -92,6 +102,11 @@ Length FittingTolerance(int const scale) {
   return 5 * std::pow(10.0, scale) * Metre;
 }
 
+// A |scale| of 0 disables the hierarchical approximation.
+double HierarchicalApproximationTolerance(int const scale) {
+  return scale == 0 ? 0 : std::pow(10.0, scale);
+}
+
 Ephemeris<Barycentric>::FixedStepParameters EphemerisParameters() {
   return Ephemeris<Barycentric>::FixedStepParameters(
       SymmetricLinearMultistepIntegrator<QuinlanTremaine1990Order12,
@@ -179,6 +194,89 @@ void BM_EphemerisSolarSystem(benchmark::State& state) {
   state.SetLabel(quantities::DebugString(error / AstronomicalUnit) + " ua");
 }
 
+// Same as above, but the accelerations between the massive bodies are computed
+// using |state.range(1)| threads.
+template<SolarSystemFactory::Accuracy accuracy>
+void BM_EphemerisSolarSystemParallel(benchmark::State& state) {
+  Length error;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+
+    auto const at_спутник_1_launch = SolarSystemAtСпутник1Launch(accuracy);
+    Instant const final_time = at_спутник_1_launch->epoch() + 100 * JulianYear;
+    auto const ephemeris =
+        at_спутник_1_launch->MakeEphemeris(
+            SolarSystemFactory::MakeAccuracyParameters<Barycentric>(
+                FittingTolerance(state.range(0)),
+                accuracy),
+            EphemerisParameters());
+    ephemeris->SetMassiveBodiesParallelism(state.range(1));
+
+    state.ResumeTiming();
+    ephemeris->Prolong(final_time);
+    state.PauseTiming();
+    error = (at_спутник_1_launch->trajectory(
+                 *ephemeris,
+                 SolarSystemFactory::name(SolarSystemFactory::Sun)).
+                     EvaluatePosition(final_time) -
+             at_спутник_1_launch->trajectory(
+                 *ephemeris,
+                 SolarSystemFactory::name(SolarSystemFactory::Earth)).
+                     EvaluatePosition(final_time)).
+                 Norm();
+    state.ResumeTiming();
+  }
+  state.SetLabel(std::to_string(state.range(1)) + " threads, " +
+                 quantities::DebugString(error / AstronomicalUnit) + " ua");
+}
+
+// A synthetic system of a star and |state.range(0) - 1| planets on circular
+// orbits, prolonged for 10 years using |state.range(1)| threads.  With many
+// bodies, the fits of the trajectories matter as much as the accelerations.
+void BM_EphemerisSyntheticSystemParallel(benchmark::State& state) {
+  int const number_of_bodies = state.range(0);
+  GravitationalParameter const star_gravitational_parameter =
+      SolarGravitationalParameter;
+  GravitationalParameter const planet_gravitational_parameter =
+      1e-6 * SolarGravitationalParameter;
+  Instant const epoch;
+  Instant const final_time = epoch + 10 * JulianYear;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+
+    std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+    std::vector<DegreesOfFreedom<Barycentric>> initial_state;
+    bodies.push_back(
+        make_not_null_unique<MassiveBody>(star_gravitational_parameter));
+    initial_state.emplace_back(Barycentric::origin, Velocity<Barycentric>());
+    for (int i = 1; i < number_of_bodies; ++i) {
+      bodies.push_back(
+          make_not_null_unique<MassiveBody>(planet_gravitational_parameter));
+      Length const r = (0.5 + 0.5 * i) * AstronomicalUnit;
+      Speed const v = Sqrt(star_gravitational_parameter / r);
+      Angle const φ = i * Radian;
+      initial_state.emplace_back(
+          Barycentric::origin +
+              Displacement<Barycentric>({r * Cos(φ), r * Sin(φ), 0 * Metre}),
+          Velocity<Barycentric>({-v * Sin(φ), v * Cos(φ), 0 * Metre / Second}));
+    }
+    auto const ephemeris = std::make_unique<Ephemeris<Barycentric>>(
+        std::move(bodies),
+        initial_state,
+        epoch,
+        Ephemeris<Barycentric>::AccuracyParameters(
+            FittingTolerance(state.range(2)),
+            /*geopotential_tolerance=*/0x1p-24),
+        EphemerisParameters());
+    ephemeris->SetMassiveBodiesParallelism(state.range(1));
+
+    state.ResumeTiming();
+    ephemeris->Prolong(final_time);
+  }
+  state.SetLabel(std::to_string(number_of_bodies) + " bodies, " +
+                 std::to_string(state.range(1)) + " threads");
+}
+
 template<SolarSystemFactory::Accuracy accuracy, Flow* flow>
 void BM_EphemerisLEOProbe(benchmark::State& state) {
   Length sun_error;
@@ -192,7 +290,8 @@ void BM_EphemerisLEOProbe(benchmark::State& state) {
       at_спутник_1_launch->MakeEphemeris(
           SolarSystemFactory::MakeAccuracyParameters<Barycentric>(
               FittingTolerance(state.range(0)),
-              accuracy),
+              accuracy,
+              HierarchicalApproximationTolerance(state.range(1))),
           EphemerisParameters());
 
   ephemeris->Prolong(final_time);
@@ -262,7 +361,8 @@ void BM_EphemerisTranslunarSpaceProbe(benchmark::State& state) {
       at_спутник_1_launch->MakeEphemeris(
           SolarSystemFactory::MakeAccuracyParameters<Barycentric>(
               FittingTolerance(state.range(0)),
-              accuracy),
+              accuracy,
+              HierarchicalApproximationTolerance(state.range(1))),
           EphemerisParameters());
 
   ephemeris->Prolong(final_time);
@@ -581,13 +681,434 @@ void FlowEphemerisWithFixedStepSRKN(
   ephemeris.FlowWithFixedStep(t, *instance);
 }
 
+// Integrates concurrently |state.range(0)| copies of the same low Earth orbit
+// using a pool of |state.range(1)| threads, as happens when several
+// trajectories of vessels are computed at the same time.  If |state.range(2)|
+// is 0 the integrations use an adaptive step for a day and don't use the cache
+// of the positions of the massive bodies.  Otherwise they use a fixed step for
+// an hour, evaluate the massive bodies at the same instants, and the label
+// gives the hit rate of the cache.
+void BM_EphemerisConcurrentFlow(benchmark::State& state) {
+  auto const at_спутник_1_launch =
+      SolarSystemAtСпутник1Launch(
+          SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness);
+  Instant const epoch = at_спутник_1_launch->epoch();
+  auto const ephemeris =
+      at_спутник_1_launch->MakeEphemeris(
+          /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Milli(Metre),
+                                   /*geopotential_tolerance=*/0x1p-24},
+          EphemerisParameters());
+  std::string const& earth_name =
+      SolarSystemFactory::name(SolarSystemFactory::Earth);
+  auto const earth_massive_body =
+      at_спутник_1_launch->massive_body(*ephemeris, earth_name);
+  auto const earth_degrees_of_freedom =
+      at_спутник_1_launch->degrees_of_freedom(earth_name);
+
+  MasslessBody probe;
+  KeplerianElements<Barycentric> elements;
+  elements.eccentricity = 0;
+  elements.semimajor_axis = 7'000 * Kilo(Metre);
+  elements.inclination = 0 * Radian;
+  elements.longitude_of_ascending_node = 0 * Radian;
+  elements.argument_of_periapsis = 0 * Radian;
+  elements.true_anomaly = 0 * Radian;
+  KeplerOrbit<Barycentric> const orbit(
+      *earth_massive_body, probe, elements, epoch);
+  DegreesOfFreedom<Barycentric> const probe_degrees_of_freedom =
+      earth_degrees_of_freedom + orbit.StateVectors(epoch);
+
+  Instant const final_time = epoch + 1 * Day;
+  ephemeris->Prolong(final_time);
+
+  ThreadPool<void> pool(/*pool_size=*/state.range(1));
+  auto const initial_statistics = ephemeris->body_positions_cache_statistics();
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    std::list<DiscreteTrajectory<Barycentric>> trajectories;
+    for (int i = 0; i < state.range(0); ++i) {
+      trajectories.emplace_back();
+      trajectories.back().Append(epoch, probe_degrees_of_freedom);
+    }
+    state.ResumeTiming();
+
+    if (state.range(2) == 0) {
+      std::vector<std::future<void>> futures;
+      for (auto& trajectory : trajectories) {
+        futures.push_back(pool.Add([&ephemeris, &trajectory, final_time]() {
+          FlowEphemerisWithAdaptiveStep(&trajectory, final_time, *ephemeris);
+        }));
+      }
+      for (auto const& future : futures) {
+        future.wait();
+      }
+    } else {
+      // Like the histories of the vessels, all the trajectories are advanced by
+      // one step before any of them goes further.
+      Time const step = 10 * Second;
+      std::vector<not_null<std::unique_ptr<
+          Integrator<Ephemeris<Barycentric>::NewtonianMotionEquation>::
+              Instance>>> instances;
+      for (auto& trajectory : trajectories) {
+        instances.push_back(ephemeris->NewInstance(
+            {&trajectory},
+            Ephemeris<Barycentric>::NoIntrinsicAccelerations,
+            Ephemeris<Barycentric>::FixedStepParameters(
+                SymplecticRungeKuttaNyströmIntegrator<BlanesMoan2002SRKN14A,
+                                                      Position<Barycentric>>(),
+                step)));
+      }
+      for (Instant t = epoch + step; t <= epoch + 1 * Hour; t += step) {
+        std::vector<std::future<void>> futures;
+        for (auto const& instance : instances) {
+          futures.push_back(pool.Add([&ephemeris, &instance, t]() {
+            ephemeris->FlowWithFixedStep(t, *instance);
+          }));
+        }
+        for (auto const& future : futures) {
+          future.wait();
+        }
+      }
+    }
+  }
+
+  auto const final_statistics = ephemeris->body_positions_cache_statistics();
+  std::int64_t const hits = final_statistics.hits - initial_statistics.hits;
+  std::int64_t const misses =
+      final_statistics.misses - initial_statistics.misses;
+  state.SetLabel(std::to_string(hits) + " hits, " + std::to_string(misses) +
+                 " misses");
+}
+
+// Integrates with an adaptive step |state.range(0)| probes on different low
+// Earth orbits.  If |state.range(1)| is 0, the probes are integrated by
+// independent calls to |FlowWithAdaptiveStep|, otherwise they are integrated as
+// an ensemble on a pool of |state.range(1)| threads.
+void BM_EphemerisAdaptiveStepEnsemble(benchmark::State& state) {
+  auto const at_спутник_1_launch =
+      SolarSystemAtСпутник1Launch(
+          SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness);
+  Instant const epoch = at_спутник_1_launch->epoch();
+  auto const ephemeris =
+      at_спутник_1_launch->MakeEphemeris(
+          /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Milli(Metre),
+                                   /*geopotential_tolerance=*/0x1p-24},
+          EphemerisParameters());
+  std::string const& earth_name =
+      SolarSystemFactory::name(SolarSystemFactory::Earth);
+  auto const earth_massive_body =
+      at_спутник_1_launch->massive_body(*ephemeris, earth_name);
+  auto const earth_degrees_of_freedom =
+      at_спутник_1_launch->degrees_of_freedom(earth_name);
+
+  MasslessBody probe;
+  std::vector<DegreesOfFreedom<Barycentric>> probe_degrees_of_freedom;
+  for (int i = 0; i < state.range(0); ++i) {
+    KeplerianElements<Barycentric> elements;
+    elements.eccentricity = 0;
+    elements.semimajor_axis = 7'000 * Kilo(Metre) + i * 100 * Kilo(Metre);
+    elements.inclination = 0 * Radian;
+    elements.longitude_of_ascending_node = 0 * Radian;
+    elements.argument_of_periapsis = 0 * Radian;
+    elements.true_anomaly = 0 * Radian;
+    KeplerOrbit<Barycentric> const orbit(
+        *earth_massive_body, probe, elements, epoch);
+    probe_degrees_of_freedom.push_back(earth_degrees_of_freedom +
+                                       orbit.StateVectors(epoch));
+  }
+
+  Instant const final_time = epoch + 1 * Day;
+  ephemeris->Prolong(final_time);
+  Ephemeris<Barycentric>::AdaptiveStepParameters const parameters(
+      EmbeddedExplicitRungeKuttaNyströmIntegrator<
+          DormandالمكاوىPrince1986RKN434FM,
+          Position<Barycentric>>(),
+      /*max_steps=*/std::numeric_limits<std::int64_t>::max(),
+      /*length_integration_tolerance=*/1 * Metre,
+      /*speed_integration_tolerance=*/1 * Metre / Second);
+  Ephemeris<Barycentric>::IntrinsicAccelerations const intrinsic_accelerations(
+      state.range(0), Ephemeris<Barycentric>::NoIntrinsicAcceleration);
+
+  std::unique_ptr<ThreadPool<void>> pool;
+  if (state.range(1) > 0) {
+    pool = std::make_unique<ThreadPool<void>>(state.range(1));
+  }
+  auto const initial_statistics = ephemeris->body_positions_cache_statistics();
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    std::list<DiscreteTrajectory<Barycentric>> trajectories;
+    std::vector<not_null<DiscreteTrajectory<Barycentric>*>> ensemble;
+    for (auto const& degrees_of_freedom : probe_degrees_of_freedom) {
+      trajectories.emplace_back();
+      trajectories.back().Append(epoch, degrees_of_freedom);
+      ensemble.push_back(&trajectories.back());
+    }
+    state.ResumeTiming();
+
+    if (pool == nullptr) {
+      for (auto const trajectory : ensemble) {
+        CHECK_OK(ephemeris->FlowWithAdaptiveStep(
+            trajectory,
+            Ephemeris<Barycentric>::NoIntrinsicAcceleration,
+            final_time,
+            parameters,
+            Ephemeris<Barycentric>::unlimited_max_ephemeris_steps,
+            /*last_point_only=*/false));
+      }
+    } else {
+      for (auto const& status : ephemeris->FlowEnsembleWithAdaptiveStep(
+               ensemble,
+               intrinsic_accelerations,
+               final_time,
+               parameters,
+               Ephemeris<Barycentric>::unlimited_max_ephemeris_steps,
+               /*last_point_only=*/false,
+               /*lockstep=*/false,
+               pool.get())) {
+        CHECK_OK(status);
+      }
+    }
+  }
+
+  // Adaptive-step flows don't use the cache of the positions of the massive
+  // bodies, so the label should show neither hits nor misses.
+  auto const final_statistics = ephemeris->body_positions_cache_statistics();
+  std::int64_t const hits = final_statistics.hits - initial_statistics.hits;
+  std::int64_t const misses =
+      final_statistics.misses - initial_statistics.misses;
+  state.SetLabel(std::to_string(hits) + " hits, " + std::to_string(misses) +
+                 " misses");
+}
+
+// Integrates with an adaptive step a dispersion of |state.range(0)| probes
+// around a low Earth orbit, as for a Monte Carlo analysis of the errors of a
+// manœuvre.  If |state.range(1)| is 0, the probes are integrated by independent
+// calls to |FlowWithAdaptiveStep|, otherwise they are integrated in lockstep by
+// |FlowEnsembleWithAdaptiveStep|.
+void BM_EphemerisDispersion(benchmark::State& state) {
+  auto const at_спутник_1_launch =
+      SolarSystemAtСпутник1Launch(
+          SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness);
+  Instant const epoch = at_спутник_1_launch->epoch();
+  auto const ephemeris =
+      at_спутник_1_launch->MakeEphemeris(
+          /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Milli(Metre),
+                                   /*geopotential_tolerance=*/0x1p-24},
+          EphemerisParameters());
+  std::string const& earth_name =
+      SolarSystemFactory::name(SolarSystemFactory::Earth);
+  auto const earth_massive_body =
+      at_спутник_1_launch->massive_body(*ephemeris, earth_name);
+  auto const earth_degrees_of_freedom =
+      at_спутник_1_launch->degrees_of_freedom(earth_name);
+
+  MasslessBody probe;
+  KeplerianElements<Barycentric> elements;
+  elements.eccentricity = 0;
+  elements.semimajor_axis = 7'000 * Kilo(Metre);
+  elements.inclination = 0 * Radian;
+  elements.longitude_of_ascending_node = 0 * Radian;
+  elements.argument_of_periapsis = 0 * Radian;
+  elements.true_anomaly = 0 * Radian;
+  KeplerOrbit<Barycentric> const orbit(
+      *earth_massive_body, probe, elements, epoch);
+  DegreesOfFreedom<Barycentric> const nominal_degrees_of_freedom =
+      earth_degrees_of_freedom + orbit.StateVectors(epoch);
+
+  // Perturb the velocity of the nominal orbit by a few metres per second in
+  // each direction.
+  std::mt19937_64 random(42);
+  std::normal_distribution<double> velocity_distribution(0, 1);
+  std::vector<DegreesOfFreedom<Barycentric>> probe_degrees_of_freedom;
+  for (int i = 0; i < state.range(0); ++i) {
+    Velocity<Barycentric> const δv(
+        {velocity_distribution(random) * Metre / Second,
+         velocity_distribution(random) * Metre / Second,
+         velocity_distribution(random) * Metre / Second});
+    probe_degrees_of_freedom.emplace_back(
+        nominal_degrees_of_freedom.position(),
+        nominal_degrees_of_freedom.velocity() + δv);
+  }
+
+  Instant const final_time = epoch + 1 * Day;
+  ephemeris->Prolong(final_time);
+  Ephemeris<Barycentric>::AdaptiveStepParameters const parameters(
+      EmbeddedExplicitRungeKuttaNyströmIntegrator<
+          DormandالمكاوىPrince1986RKN434FM,
+          Position<Barycentric>>(),
+      /*max_steps=*/std::numeric_limits<std::int64_t>::max(),
+      /*length_integration_tolerance=*/1 * Metre,
+      /*speed_integration_tolerance=*/1 * Metre / Second);
+  Ephemeris<Barycentric>::IntrinsicAccelerations const intrinsic_accelerations(
+      state.range(0), Ephemeris<Barycentric>::NoIntrinsicAcceleration);
+
+  std::int64_t points = 0;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    std::list<DiscreteTrajectory<Barycentric>> trajectories;
+    std::vector<not_null<DiscreteTrajectory<Barycentric>*>> ensemble;
+    for (auto const& degrees_of_freedom : probe_degrees_of_freedom) {
+      trajectories.emplace_back();
+      trajectories.back().Append(epoch, degrees_of_freedom);
+      ensemble.push_back(&trajectories.back());
+    }
+    state.ResumeTiming();
+
+    if (state.range(1) == 0) {
+      for (auto const trajectory : ensemble) {
+        CHECK_OK(ephemeris->FlowWithAdaptiveStep(
+            trajectory,
+            Ephemeris<Barycentric>::NoIntrinsicAcceleration,
+            final_time,
+            parameters,
+            Ephemeris<Barycentric>::unlimited_max_ephemeris_steps,
+            /*last_point_only=*/false));
+      }
+    } else {
+      for (auto const& status : ephemeris->FlowEnsembleWithAdaptiveStep(
+               ensemble,
+               intrinsic_accelerations,
+               final_time,
+               parameters,
+               Ephemeris<Barycentric>::unlimited_max_ephemeris_steps,
+               /*last_point_only=*/false,
+               /*lockstep=*/true,
+               /*thread_pool=*/nullptr)) {
+        CHECK_OK(status);
+      }
+    }
+
+    state.PauseTiming();
+    points = 0;
+    for (auto const& trajectory : trajectories) {
+      points += trajectory.Size();
+    }
+    state.ResumeTiming();
+  }
+  state.SetLabel(std::to_string(points) + " points");
+}
+
+// Evaluates the positions of all the bodies of the solar system concurrently on
+// a pool of |state.range(0)| threads.  Each task walks through one day at a
+// different place of the year, as prognosticators or plotting would.  The
+// evaluations use the hint shared by all callers if |state.range(1)| is 0, a
+// cursor per task and body if it is 1, and the batched evaluation if it is 2.
+void BM_EphemerisConcurrentEvaluation(benchmark::State& state) {
+  int const number_of_tasks = 64;
+  int const evaluations_per_task = 1'000;
+  Time const evaluation_step = 1 * Day / evaluations_per_task;
+  auto const at_спутник_1_launch =
+      SolarSystemAtСпутник1Launch(
+          SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness);
+  Instant const epoch = at_спутник_1_launch->epoch();
+  auto const ephemeris =
+      at_спутник_1_launch->MakeEphemeris(
+          /*accuracy_parameters=*/{/*fitting_tolerance=*/1 * Milli(Metre),
+                                   /*geopotential_tolerance=*/0x1p-24},
+          EphemerisParameters());
+  ephemeris->Prolong(epoch + 1 * JulianYear + 1 * Day);
+  std::vector<not_null<ContinuousTrajectory<Barycentric> const*>> trajectories;
+  for (auto const body : ephemeris->bodies()) {
+    trajectories.push_back(ephemeris->trajectory(body));
+  }
+
+  std::vector<std::vector<Instant>> task_times(number_of_tasks);
+  for (int i = 0; i < number_of_tasks; ++i) {
+    Instant const t_start = epoch + i * (1 * JulianYear / number_of_tasks);
+    for (int j = 0; j < evaluations_per_task; ++j) {
+      task_times[i].push_back(t_start + j * evaluation_step);
+    }
+  }
+
+  ThreadPool<void> pool(/*pool_size=*/state.range(0));
+  int const mode = state.range(1);
+  while (state.KeepRunning()) {
+    std::vector<std::future<void>> futures;
+    for (auto const& times : task_times) {
+      futures.push_back(pool.Add([&times, &trajectories, mode]() {
+        switch (mode) {
+          case 0:
+            for (Instant const& t : times) {
+              for (auto const trajectory : trajectories) {
+                benchmark::DoNotOptimize(trajectory->EvaluatePosition(t));
+              }
+            }
+            break;
+          case 1: {
+            std::vector<ContinuousTrajectory<Barycentric>::Cursor> cursors(
+                trajectories.size());
+            for (Instant const& t : times) {
+              for (int b = 0; b < trajectories.size(); ++b) {
+                benchmark::DoNotOptimize(
+                    trajectories[b]->EvaluatePosition(t, cursors[b]));
+              }
+            }
+            break;
+          }
+          case 2: {
+            std::vector<Position<Barycentric>> positions;
+            for (auto const trajectory : trajectories) {
+              trajectory->EvaluatePositions(times, positions);
+              benchmark::DoNotOptimize(positions.data());
+            }
+            break;
+          }
+          default:
+            LOG(FATAL) << "Unexpected mode " << mode;
+        }
+      }));
+    }
+    for (auto const& future : futures) {
+      future.wait();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * number_of_tasks *
+                          evaluations_per_task * trajectories.size());
+}
+
 BENCHMARK(BM_EphemerisMultithreadingBenchmark)
     ->ArgPair(3, 1)
     ->ArgPair(3, 2)
     ->ArgPair(3, 3)
     ->ArgPair(3, 4)
     ->ArgPair(3, 5);
+BENCHMARK(BM_EphemerisConcurrentFlow)
+    ->Args({1, 1, 0})
+    ->Args({8, 1, 0})
+    ->Args({8, 4, 0})
+    ->Args({32, 4, 0})
+    ->Args({1, 1, 1})
+    ->Args({8, 1, 1})
+    ->Args({8, 4, 1})
+    ->Args({32, 4, 1});
+BENCHMARK(BM_EphemerisConcurrentEvaluation)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(1, 2)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 1)
+    ->ArgPair(8, 2)
+    ->ArgPair(32, 0)
+    ->ArgPair(32, 1)
+    ->ArgPair(32, 2)
+    ->UseRealTime();
+BENCHMARK(BM_EphemerisAdaptiveStepEnsemble)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 1)
+    ->ArgPair(8, 4)
+    ->ArgPair(32, 0)
+    ->ArgPair(32, 4);
+BENCHMARK(BM_EphemerisDispersion)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 1)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 1);
 BENCHMARK(BM_EphemerisKSPSystem)->Arg(-3);
+BENCHMARK(BM_EphemerisSyntheticSystemParallel)
+    ->Args({100, 1, -3})
+    ->Args({100, 2, -3})
+    ->Args({100, 4, -3})
+    ->Args({100, 8, -3});
 BENCHMARK_TEMPLATE(BM_EphemerisSolarSystem,
                    SolarSystemFactory::Accuracy::MajorBodiesOnly)
     ->Arg(-3);
@@ -597,6 +1118,18 @@ BENCHMARK_TEMPLATE(BM_EphemerisSolarSystem,
 BENCHMARK_TEMPLATE(BM_EphemerisSolarSystem,
                    SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness)
     ->Arg(-3);
+BENCHMARK_TEMPLATE(BM_EphemerisSolarSystemParallel,
+                   SolarSystemFactory::Accuracy::MinorAndMajorBodies)
+    ->ArgPair(-3, 1)
+    ->ArgPair(-3, 2)
+    ->ArgPair(-3, 4)
+    ->ArgPair(-3, 8);
+BENCHMARK_TEMPLATE(BM_EphemerisSolarSystemParallel,
+                   SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness)
+    ->ArgPair(-3, 1)
+    ->ArgPair(-3, 2)
+    ->ArgPair(-3, 4)
+    ->ArgPair(-3, 8);
 BENCHMARK_TEMPLATE(BM_EphemerisL4Probe,
                    SolarSystemFactory::Accuracy::MajorBodiesOnly,
                    &FlowEphemerisWithAdaptiveStep)
@@ -612,51 +1145,55 @@ BENCHMARK_TEMPLATE(BM_EphemerisL4Probe,
 BENCHMARK_TEMPLATE(BM_EphemerisLEOProbe,
                    SolarSystemFactory::Accuracy::MajorBodiesOnly,
                    &FlowEphemerisWithAdaptiveStep)
-    ->Arg(-3);
+    ->ArgPair(-3, 0);
 BENCHMARK_TEMPLATE(BM_EphemerisLEOProbe,
                    SolarSystemFactory::Accuracy::MajorBodiesOnly,
                    &FlowEphemerisWithFixedStepSLMS)
-    ->Arg(-3);
+    ->ArgPair(-3, 0);
 BENCHMARK_TEMPLATE(BM_EphemerisLEOProbe,
                    SolarSystemFactory::Accuracy::MajorBodiesOnly,
                    &FlowEphemerisWithFixedStepSRKN)
-    ->Arg(-3);
+    ->ArgPair(-3, 0);
 BENCHMARK_TEMPLATE(BM_EphemerisLEOProbe,
                    SolarSystemFactory::Accuracy::MinorAndMajorBodies,
                    &FlowEphemerisWithAdaptiveStep)
-    ->Arg(-3);
+    ->ArgPair(-3, 0);
 BENCHMARK_TEMPLATE(BM_EphemerisLEOProbe,
                    SolarSystemFactory::Accuracy::MinorAndMajorBodies,
                    &FlowEphemerisWithFixedStepSLMS)
-    ->Arg(-3);
+    ->ArgPair(-3, 0);
 BENCHMARK_TEMPLATE(BM_EphemerisLEOProbe,
                    SolarSystemFactory::Accuracy::MinorAndMajorBodies,
                    &FlowEphemerisWithFixedStepSRKN)
-    ->Arg(-3);
+    ->ArgPair(-3, 0);
 BENCHMARK_TEMPLATE(BM_EphemerisLEOProbe,
                    SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness,
                    &FlowEphemerisWithAdaptiveStep)
-    ->Arg(-3);
+    ->ArgPair(-3, 0)
+    ->ArgPair(-3, -1)
+    ->ArgPair(-3, -2);
 BENCHMARK_TEMPLATE(BM_EphemerisLEOProbe,
                    SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness,
                    &FlowEphemerisWithFixedStepSLMS)
-    ->Arg(-3);
+    ->ArgPair(-3, 0);
 BENCHMARK_TEMPLATE(BM_EphemerisLEOProbe,
                    SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness,
                    &FlowEphemerisWithFixedStepSRKN)
-    ->Arg(-3);
+    ->ArgPair(-3, 0);
 BENCHMARK_TEMPLATE(BM_EphemerisTranslunarSpaceProbe,
                    SolarSystemFactory::Accuracy::MajorBodiesOnly,
                    &FlowEphemerisWithFixedStepSLMS)
-    ->Arg(-3);
+    ->ArgPair(-3, 0);
 BENCHMARK_TEMPLATE(BM_EphemerisTranslunarSpaceProbe,
                    SolarSystemFactory::Accuracy::MinorAndMajorBodies,
                    &FlowEphemerisWithFixedStepSLMS)
-    ->Arg(-3);
+    ->ArgPair(-3, 0);
 BENCHMARK_TEMPLATE(BM_EphemerisTranslunarSpaceProbe,
                    SolarSystemFactory::Accuracy::AllBodiesAndDampedOblateness,
                    &FlowEphemerisWithFixedStepSLMS)
-    ->Arg(-3);
+    ->ArgPair(-3, 0)
+    ->ArgPair(-3, -1)
+    ->ArgPair(-3, -2);
 BENCHMARK_TEMPLATE(BM_EphemerisL4Probe1Year,
                    SolarSystemFactory::Accuracy::MajorBodiesOnly,
                    &FlowEphemerisWithFixedStepSLMS)
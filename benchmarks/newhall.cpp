@@ -9,6 +9,7 @@
 #include "base/not_null.hpp"
 #include "benchmark/benchmark.h"
 #include "geometry/named_quantities.hpp"
+#include "numerics/fixed_arrays.hpp"
 #include "numerics/newhall.hpp"
 #include "numerics/polynomial.hpp"
 #include "numerics/polynomial_evaluators.hpp"
@@ -92,6 +93,29 @@ void BM_NewhallApproximationDisplacement(benchmark::State& state) {
   }
 }
 
+// Benchmarks the computation of the homogeneous coefficients of a Newhall
+// approximation of the given |degree|, i.e., the products by the matrices,
+// using the given |Kernel|.
+template<typename Kernel, int degree>
+void BM_NewhallHomogeneousCoefficientsDisplacement(benchmark::State& state) {
+  using Approximator = internal_newhall::
+      NewhallAppromixator<Displacement<ICRS>, degree, EstrinEvaluator, Kernel>;
+  std::mt19937_64 random(42);
+  FixedVector<Displacement<ICRS>, 2 * 8 + 2> qv;
+  for (int i = 0; i < qv.size; ++i) {
+    qv[i] = Displacement<ICRS>({static_cast<double>(random()) * Metre,
+                                static_cast<double>(random()) * Metre,
+                                static_cast<double>(random()) * Metre});
+  }
+
+  Displacement<ICRS> error_estimate;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        Approximator::HomogeneousCoefficients(qv, error_estimate));
+    benchmark::DoNotOptimize(error_estimate);
+  }
+}
+
 using ResultЧебышёвDouble = ЧебышёвSeries<double>;
 using ResultЧебышёвDisplacement = ЧебышёвSeries<Displacement<ICRS>>;
 using ResultMonomialDouble =
@@ -121,5 +145,35 @@ BENCHMARK_TEMPLATE(
                                           EstrinEvaluator>))
     ->Arg(4)->Arg(8)->Arg(16);
 
+using GenericKernel =
+    internal_newhall::GenericNewhallKernel<Displacement<ICRS>>;
+using SpecializedKernel = internal_newhall::NewhallKernel<Displacement<ICRS>>;
+
+#define PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(degree)        \
+  BENCHMARK_TEMPLATE2(BM_NewhallHomogeneousCoefficientsDisplacement,         \
+                      GenericKernel,                                         \
+                      (degree));                                             \
+  BENCHMARK_TEMPLATE2(BM_NewhallHomogeneousCoefficientsDisplacement,         \
+                      SpecializedKernel,                                     \
+                      (degree))
+
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(3);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(4);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(5);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(6);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(7);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(8);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(9);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(10);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(11);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(12);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(13);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(14);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(15);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(16);
+PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS(17);
+
+#undef PRINCIPIA_NEWHALL_HOMOGENEOUS_COEFFICIENTS_BENCHMARKS
+
 }  // namespace numerics
 }  // namespace principia
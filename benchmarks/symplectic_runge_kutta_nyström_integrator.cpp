@@ -1,22 +1,28 @@
 ﻿
 // .\Release\x64\benchmarks.exe --benchmark_repetitions=5 --benchmark_min_time=5 --benchmark_filter=SymplecticRungeKuttaNyströmIntegratorSolveHarmonicOscillator                                                                                                                 // NOLINT(whitespace/line_length)
+// .\Release\x64\benchmarks.exe --benchmark_filter=Allocations                                                                                                                                                                                                                   // NOLINT(whitespace/line_length)
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 
 #include <algorithm>
 #include <functional>
+#include <random>
 #include <type_traits>
 #include <vector>
 
 #include "base/not_null.hpp"
 #include "base/status.hpp"
 #include "benchmark/benchmark.h"
+#include "benchmarks/allocations.hpp"
 #include "geometry/frame.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/named_quantities.hpp"
+#include "integrators/ensemble.hpp"
 #include "integrators/methods.hpp"
 #include "integrators/ordinary_differential_equations.hpp"
+#include "integrators/symmetric_linear_multistep_integrator.hpp"
 #include "integrators/symplectic_runge_kutta_nyström_integrator.hpp"
+#include "numerics/double_precision.hpp"
 #include "glog/logging.h"
 #include "quantities/elementary_functions.hpp"
 #include "quantities/named_quantities.hpp"
@@ -27,12 +33,15 @@
 namespace principia {
 
 using base::Status;
+using benchmarks::AllocationCount;
+using benchmarks::AllocationsAreCounted;
 using geometry::Displacement;
 using geometry::Frame;
 using geometry::Instant;
 using geometry::Position;
 using geometry::Vector;
 using geometry::Velocity;
+using numerics::DoublePrecision;
 using quantities::Abs;
 using quantities::Acceleration;
 using quantities::AngularFrequency;
@@ -204,6 +213,169 @@ void BM_SymplecticRungeKuttaNyströmIntegratorSolveHarmonicOscillator3D(
   state.SetLabel(ss.str());
 }
 
+// Integrates for 10 s a dispersion of |state.range(0)| 3D harmonic oscillators
+// with random initial conditions, without storing the intermediate states.  If
+// |state.range(1)| is 0, the oscillators are integrated by independent
+// instances, otherwise they are integrated in lockstep by an ensemble instance.
+template<typename Method, typename Position>
+void BM_SymplecticRungeKuttaNyströmIntegratorSolveHarmonicOscillatorDispersion(
+    benchmark::State& state) {
+  using ODE = SpecialSecondOrderDifferentialEquation<Position>;
+  int const number_of_members = state.range(0);
+  Instant const t_initial;
+  Instant const t_final = t_initial + 10 * Second;
+  Time const step = 1.0e-3 * Second;
+
+  auto const compute_acceleration = [](std::vector<Position> const& q,
+                                       std::vector<typename ODE::Acceleration>&
+                                           result) {
+    for (int i = 0; i < q.size(); ++i) {
+      result[i] = (World::origin - q[i]) *
+                  (SIUnit<Stiffness>() / SIUnit<Mass>());
+    }
+    return Status::OK;
+  };
+
+  std::mt19937_64 random(42);
+  std::normal_distribution<double> distribution(0, 1);
+  EnsembleProblem<ODE> ensemble_problem;
+  ensemble_problem.compute_acceleration =
+      [&compute_acceleration](
+          Instant const& t,
+          std::vector<int> const& members,
+          std::vector<Position> const& q,
+          std::vector<typename ODE::Acceleration>& result) {
+        return compute_acceleration(q, result);
+      };
+  for (int m = 0; m < number_of_members; ++m) {
+    typename ODE::SystemState initial_state;
+    initial_state.positions.emplace_back(
+        World::origin +
+        Displacement<World>({(1 + 0.1 * distribution(random)) * Metre,
+                             0.1 * distribution(random) * Metre,
+                             0.1 * distribution(random) * Metre}));
+    initial_state.velocities.emplace_back(
+        Velocity<World>({0.1 * distribution(random) * Metre / Second,
+                         (1 + 0.1 * distribution(random)) * Metre / Second,
+                         0.1 * distribution(random) * Metre / Second}));
+    initial_state.time = DoublePrecision<Instant>(t_initial);
+    ensemble_problem.initial_states.push_back(initial_state);
+  }
+
+  auto const& integrator =
+      SymplecticRungeKuttaNyströmIntegrator<Method, Position>();
+  Length q_norm;
+  while (state.KeepRunning()) {
+    if (state.range(1) == 0) {
+      for (auto const& initial_state : ensemble_problem.initial_states) {
+        IntegrationProblem<ODE> problem;
+        problem.equation.compute_acceleration =
+            [&compute_acceleration](
+                Instant const& t,
+                std::vector<Position> const& q,
+                std::vector<typename ODE::Acceleration>& result) {
+              return compute_acceleration(q, result);
+            };
+        problem.initial_state = initial_state;
+        auto const instance = integrator.NewInstance(
+            problem,
+            [&q_norm](typename ODE::SystemState const& state) {
+              q_norm = (state.positions[0].value - World::origin).Norm();
+            },
+            step);
+        instance->Solve(t_final);
+      }
+    } else {
+      auto const instance = integrator.NewEnsembleInstance(
+          ensemble_problem,
+          [&q_norm](int const member, typename ODE::SystemState const& state) {
+            q_norm = (state.positions[0].value - World::origin).Norm();
+          },
+          step);
+      instance->Solve(t_final);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * number_of_members *
+                          static_cast<int>((t_final - t_initial) / step));
+  std::stringstream ss;
+  ss << q_norm;
+  state.SetLabel(ss.str());
+}
+
+// Counts the heap allocations done by the steps of |integrator| once it is past
+// its startup.  |Solve| is called repeatedly for |state.range(0)| steps of a
+// system of 10 harmonic oscillators, the way |Ephemeris::FlowWithFixedStep|
+// integrates short intervals.  The label gives the number of allocations per
+// step, which must be 0.
+template<typename Position>
+void SolveHarmonicOscillatorsCountingAllocations(
+    benchmark::State& state,
+    FixedStepSizeIntegrator<
+        SpecialSecondOrderDifferentialEquation<Position>> const& integrator) {
+  if (!AllocationsAreCounted(state)) {
+    return;
+  }
+  using ODE = SpecialSecondOrderDifferentialEquation<Position>;
+  int const steps_per_solve = state.range(0);
+  Time const step = 1.0e-2 * Second;
+
+  IntegrationProblem<ODE> problem;
+  problem.equation.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration3D<World>,
+                _1, _2, _3, /*evaluations=*/nullptr);
+  problem.initial_state.time = DoublePrecision<Instant>(Instant());
+  for (int i = 0; i < 10; ++i) {
+    problem.initial_state.positions.emplace_back(
+        World::origin + Displacement<World>({(1 + i) * Metre,
+                                             0 * Metre,
+                                             0 * Metre}));
+    problem.initial_state.velocities.emplace_back(Velocity<World>());
+  }
+  std::int64_t steps = 0;
+  typename ODE::SystemState last_state = problem.initial_state;
+  auto const instance = integrator.NewInstance(
+      problem,
+      [&last_state, &steps](typename ODE::SystemState const& state) {
+        last_state = state;
+        ++steps;
+      },
+      step);
+
+  // Get past the startup, and offset the final times by half a step so that
+  // each call to |Solve| does exactly |steps_per_solve| steps.
+  Instant t_final = Instant() + 100.5 * step;
+  instance->Solve(t_final);
+
+  steps = 0;
+  std::int64_t allocations = 0;
+  while (state.KeepRunning()) {
+    t_final += steps_per_solve * step;
+    std::int64_t const allocations_before = AllocationCount();
+    instance->Solve(t_final);
+    allocations += AllocationCount() - allocations_before;
+  }
+  state.SetItemsProcessed(steps);
+  std::stringstream ss;
+  ss << static_cast<double>(allocations) / steps << " allocations per step";
+  state.SetLabel(ss.str());
+}
+
+template<typename Method>
+void BM_SymplecticRungeKuttaNyströmIntegratorAllocations(
+    benchmark::State& state) {
+  SolveHarmonicOscillatorsCountingAllocations(
+      state,
+      SymplecticRungeKuttaNyströmIntegrator<Method, Position<World>>());
+}
+
+template<typename Method>
+void BM_SymmetricLinearMultistepIntegratorAllocations(
+    benchmark::State& state) {
+  SolveHarmonicOscillatorsCountingAllocations(
+      state,
+      SymmetricLinearMultistepIntegrator<Method, Position<World>>());
+}
+
 BENCHMARK_TEMPLATE2(
     BM_SymplecticRungeKuttaNyströmIntegratorSolveHarmonicOscillator1D,
     methods::McLachlanAtela1992Order4Optimal, Length);
@@ -254,5 +426,32 @@ BENCHMARK_TEMPLATE2(
     BM_SymplecticRungeKuttaNyströmIntegratorSolveHarmonicOscillator3D,
     methods::BlanesMoan2002SRKN14A, Position<World>);
 
+BENCHMARK_TEMPLATE2(
+    BM_SymplecticRungeKuttaNyströmIntegratorSolveHarmonicOscillatorDispersion,
+    methods::BlanesMoan2002SRKN14A, Position<World>)
+    ->ArgPair(10, 0)
+    ->ArgPair(10, 1)
+    ->ArgPair(100, 0)
+    ->ArgPair(100, 1)
+    ->ArgPair(1000, 0)
+    ->ArgPair(1000, 1);
+
+BENCHMARK_TEMPLATE1(
+    BM_SymplecticRungeKuttaNyströmIntegratorAllocations,
+    methods::BlanesMoan2002SRKN14A)
+    ->Arg(1)
+    ->Arg(10);
+BENCHMARK_TEMPLATE1(
+    BM_SymmetricLinearMultistepIntegratorAllocations,
+    methods::Quinlan1999Order8A)
+    ->Arg(1)
+    ->Arg(10);
+BENCHMARK_TEMPLATE1(
+    BM_SymmetricLinearMultistepIntegratorAllocations,
+    methods::QuinlanTremaine1990Order12)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(1000);
+
 }  // namespace integrators
 }  // namespace principia
@@ -244,6 +244,16 @@ Status EmbeddedExplicitGeneralizedRungeKuttaNyströmIntegrator<
       q̂[k].Increment(Δq̂[k]);
       v̂[k].Increment(Δv̂[k]);
     }
+    // The accelerations at the beginning of the step are those of the first
+    // stage.  With FSAL, those at the end are those of the last stage, which
+    // were swapped above.
+    if (first_same_as_last) {
+      this->FinishStep(/*accelerations_begin=*/g.back(),
+                       /*accelerations_end=*/&g.front());
+    } else {
+      this->FinishStep(/*accelerations_begin=*/g.front(),
+                       /*accelerations_end=*/nullptr);
+    }
     append_state(current_state);
     ++step_count;
     if (step_count == parameters.max_steps && !at_end) {
@@ -148,6 +148,170 @@ TEST_F(EmbeddedExplicitGeneralizedRungeKuttaNyströmIntegratorTest, Legendre) {
   EXPECT_THAT(max_derivative_error, IsNear(4.54e-3 / Second));
 }
 
+// The method is not first-same-as-last, so the continuous extension is quartic.
+// Its error between the steps is of the same order as that of the steps.
+TEST_F(EmbeddedExplicitGeneralizedRungeKuttaNyströmIntegratorTest,
+       DenseOutput) {
+  using DenseOutput = AdaptiveStepSizeIntegrator<ODE>::DenseOutput;
+  AdaptiveStepSizeIntegrator<ODE> const& integrator =
+      EmbeddedExplicitGeneralizedRungeKuttaNyströmIntegrator<
+          methods::Fine1987RKNG34,
+          double>();
+  constexpr int degree = 3;
+  double const x_initial = 0;
+  Variation<double> const v_initial = -3 / (2 * Second);
+  Instant const t_initial;
+  Instant const t_final = t_initial + 0.99 * Second;
+  double const tolerance = 1e-6;
+  Variation<double> const derivative_tolerance = 1e-6 / Second;
+  int const samples_per_step = 10;
+
+  ODE legendre_equation;
+  legendre_equation.compute_acceleration =
+      std::bind(ComputeLegendrePolynomialSecondDerivative<degree>,
+                _1, _2, _3, _4, /*evaluations=*/nullptr);
+  IntegrationProblem<ODE> problem;
+  problem.equation = legendre_equation;
+  problem.initial_state = {{x_initial}, {v_initial}, t_initial};
+  AdaptiveStepSizeIntegrator<ODE>::Parameters const parameters(
+      /*first_time_step=*/t_final - t_initial,
+      /*safety_factor=*/0.9);
+  auto const tolerance_to_error_ratio = std::bind(ToleranceToErrorRatio,
+                                                  _1,
+                                                  _2,
+                                                  tolerance,
+                                                  derivative_tolerance,
+                                                  [](bool tolerable) {});
+
+  auto const error = [t_initial](Instant const& t, double const p) {
+    double const x = (t - t_initial) / (1 * Second);
+    return AbsoluteError(
+        LegendrePolynomial<degree, EstrinEvaluator>().Evaluate(x), p);
+  };
+  auto const derivative_error = [t_initial](Instant const& t,
+                                            Variation<double> const& pʹ) {
+    double const x = (t - t_initial) / (1 * Second);
+    return AbsoluteError(
+        LegendrePolynomial<degree, EstrinEvaluator>().Derivative().Evaluate(x) /
+            (1 * Second),
+        pʹ);
+  };
+
+  double max_step_error{};
+  Variation<double> max_step_derivative_error{};
+  double max_dense_error{};
+  Variation<double> max_dense_derivative_error{};
+  int steps = 0;
+  std::vector<double> positions(1);
+  std::vector<Variation<double>> velocities(1);
+  auto instance = integrator.NewInstance(
+      problem,
+      [&](ODE::SystemState const& state) {
+        ++steps;
+        Instant const& t = state.time.value;
+        max_step_error =
+            std::max(max_step_error, error(t, state.positions[0].value));
+        max_step_derivative_error =
+            std::max(max_step_derivative_error,
+                     derivative_error(t, state.velocities[0].value));
+      },
+      tolerance_to_error_ratio,
+      parameters);
+  dynamic_cast<AdaptiveStepSizeIntegrator<ODE>::Instance&>(*instance)
+      .SetDenseOutput([&](DenseOutput const& dense_output) {
+        Time const h = dense_output.t_end() - dense_output.t_begin();
+        for (int i = 1; i < samples_per_step; ++i) {
+          Instant const t = dense_output.t_begin() + i * h / samples_per_step;
+          dense_output.Evaluate(t, positions, velocities);
+          max_dense_error = std::max(max_dense_error, error(t, positions[0]));
+          max_dense_derivative_error =
+              std::max(max_dense_derivative_error,
+                       derivative_error(t, velocities[0]));
+        }
+      });
+  EXPECT_OK(instance->Solve(t_final));
+
+  EXPECT_EQ(340, steps);
+  EXPECT_THAT(max_step_error, IsNear(172e-6));
+  EXPECT_THAT(max_step_derivative_error, IsNear(4.54e-3 / Second));
+  EXPECT_THAT(max_dense_error, IsNear(172e-6));
+  EXPECT_THAT(max_dense_derivative_error, IsNear(4.53e-3 / Second));
+}
+
+// On the quartic path of a method that is not first-same-as-last the
+// continuous extension must interpolate the steps.  This does not depend on the
+// accuracy of the method, so it is a tight check of the coefficients in
+// optimized builds.
+TEST_F(EmbeddedExplicitGeneralizedRungeKuttaNyströmIntegratorTest,
+       DenseOutputInterpolatesSteps) {
+  using DenseOutput = AdaptiveStepSizeIntegrator<ODE>::DenseOutput;
+  AdaptiveStepSizeIntegrator<ODE> const& integrator =
+      EmbeddedExplicitGeneralizedRungeKuttaNyströmIntegrator<
+          methods::Fine1987RKNG34,
+          double>();
+  static_assert(!methods::Fine1987RKNG34::first_same_as_last);
+  constexpr int degree = 3;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 0.99 * Second;
+
+  ODE legendre_equation;
+  legendre_equation.compute_acceleration =
+      std::bind(ComputeLegendrePolynomialSecondDerivative<degree>,
+                _1, _2, _3, _4, /*evaluations=*/nullptr);
+  IntegrationProblem<ODE> problem;
+  problem.equation = legendre_equation;
+  problem.initial_state = {{0}, {-3 / (2 * Second)}, t_initial};
+  AdaptiveStepSizeIntegrator<ODE>::Parameters const parameters(
+      /*first_time_step=*/t_final - t_initial,
+      /*safety_factor=*/0.9);
+  auto const tolerance_to_error_ratio = std::bind(ToleranceToErrorRatio,
+                                                  _1,
+                                                  _2,
+                                                  /*tolerance=*/1e-6,
+                                                  1e-6 / Second,
+                                                  [](bool tolerable) {});
+
+  std::vector<ODE::SystemState> solution = {problem.initial_state};
+  std::vector<double> begin_positions;
+  std::vector<Variation<double>> begin_velocities;
+  std::vector<double> end_positions;
+  std::vector<Variation<double>> end_velocities;
+  std::vector<double> positions(1);
+  std::vector<Variation<double>> velocities(1);
+  auto instance = integrator.NewInstance(
+      problem,
+      [&solution](ODE::SystemState const& state) {
+        solution.push_back(state);
+      },
+      tolerance_to_error_ratio,
+      parameters);
+  dynamic_cast<AdaptiveStepSizeIntegrator<ODE>::Instance&>(*instance)
+      .SetDenseOutput([&](DenseOutput const& dense_output) {
+        dense_output.Evaluate(dense_output.t_begin(), positions, velocities);
+        begin_positions.push_back(positions[0]);
+        begin_velocities.push_back(velocities[0]);
+        dense_output.Evaluate(dense_output.t_end(), positions, velocities);
+        end_positions.push_back(positions[0]);
+        end_velocities.push_back(velocities[0]);
+      });
+  EXPECT_OK(instance->Solve(t_final));
+
+  ASSERT_EQ(solution.size() - 1, end_positions.size());
+  for (int s = 1; s < solution.size(); ++s) {
+    auto const& begin = solution[s - 1];
+    auto const& end = solution[s];
+    EXPECT_EQ(begin.positions[0].value, begin_positions[s - 1]);
+    EXPECT_THAT(
+        AbsoluteError(begin.velocities[0].value, begin_velocities[s - 1]),
+        Lt(1e-15 / Second));
+    EXPECT_THAT(AbsoluteError(end.positions[0].value, end_positions[s - 1]),
+                Lt(1e-14));
+    EXPECT_THAT(
+        AbsoluteError(end.velocities[0].value, end_velocities[s - 1]),
+        Lt(1e-13 / Second));
+  }
+}
+
 }  // namespace internal_embedded_explicit_generalized_runge_kutta_nyström_integrator  // NOLINT
 }  // namespace integrators
 }  // namespace principia
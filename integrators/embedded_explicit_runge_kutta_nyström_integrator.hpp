@@ -108,6 +108,16 @@ class EmbeddedExplicitRungeKuttaNyströmIntegrator
              EmbeddedExplicitRungeKuttaNyströmIntegrator const& integrator);
 
     EmbeddedExplicitRungeKuttaNyströmIntegrator const& integrator_;
+
+    // Scratch storage for |Solve|, sized at construction so that the steps do
+    // not allocate.
+    std::vector<typename ODE::Displacement> Δq̂_;
+    std::vector<typename ODE::Velocity> Δv̂_;
+    typename ODE::SystemStateError error_estimate_;
+    std::vector<Position> q_stage_;
+    std::vector<std::vector<typename ODE::Acceleration>> g_;
+    typename ODE::SystemState final_state_;
+
     friend class EmbeddedExplicitRungeKuttaNyströmIntegrator;
   };
 
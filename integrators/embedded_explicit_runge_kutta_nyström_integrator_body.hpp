@@ -6,7 +6,6 @@
 #include <algorithm>
 #include <cmath>
 #include <ctime>
-#include <optional>
 #include <vector>
 
 #include "geometry/sign.hpp"
@@ -64,8 +63,10 @@ Instance::Solve(Instant const& t_final) {
   // |current_state| gets updated as the integration progresses to allow
   // restartability.
 
-  // State before the last, truncated step.
-  std::optional<typename ODE::SystemState> final_state;
+  // State before the last, truncated step.  It is stored in |final_state_| to
+  // reuse its storage.
+  typename ODE::SystemState& final_state = final_state_;
+  bool has_final_state = false;
 
   // Argument checks.
   int const dimension = current_state.positions.size();
@@ -88,9 +89,9 @@ Instance::Solve(Instant const& t_final) {
   DoublePrecision<Instant>& t = current_state.time;
 
   // Position increment (high-order).
-  std::vector<Displacement> Δq̂(dimension);
+  std::vector<Displacement>& Δq̂ = Δq̂_;
   // Velocity increment (high-order).
-  std::vector<Velocity> Δv̂(dimension);
+  std::vector<Velocity>& Δv̂ = Δv̂_;
   // Current position.  This is a non-const reference whose purpose is to make
   // the equations more readable.
   std::vector<DoublePrecision<Position>>& q̂ = current_state.positions;
@@ -99,18 +100,13 @@ Instance::Solve(Instant const& t_final) {
   std::vector<DoublePrecision<Velocity>>& v̂ = current_state.velocities;
 
   // Difference between the low- and high-order approximations.
-  typename ODE::SystemStateError error_estimate;
-  error_estimate.position_error.resize(dimension);
-  error_estimate.velocity_error.resize(dimension);
+  typename ODE::SystemStateError& error_estimate = error_estimate_;
 
   // Current Runge-Kutta-Nyström stage.
-  std::vector<Position> q_stage(dimension);
+  std::vector<Position>& q_stage = q_stage_;
   // Accelerations at each stage.
   // TODO(egg): this is a rectangular container, use something more appropriate.
-  std::vector<std::vector<Acceleration>> g(stages_);
-  for (auto& g_stage : g) {
-    g_stage.resize(dimension);
-  }
+  std::vector<std::vector<Acceleration>>& g = g_;
 
   bool at_end = false;
   double tolerance_to_error_ratio;
@@ -169,6 +165,7 @@ Instance::Solve(Instant const& t_final) {
           // last stage below.
           h = time_to_end;
           final_state = current_state;
+          has_final_state = true;
         }
       }
 
@@ -223,6 +220,7 @@ Instance::Solve(Instant const& t_final) {
     if (!parameters.last_step_is_exact && t.value + (t.error + h) > t_final) {
       // We did overshoot.  Drop the point that we just computed and exit.
       final_state = current_state;
+      has_final_state = true;
       break;
     }
 
@@ -238,6 +236,16 @@ Instance::Solve(Instant const& t_final) {
       q̂[k].Increment(Δq̂[k]);
       v̂[k].Increment(Δv̂[k]);
     }
+    // The accelerations at the beginning of the step are those of the first
+    // stage.  With FSAL, those at the end are those of the last stage, which
+    // were swapped above.
+    if (first_same_as_last) {
+      this->FinishStep(/*accelerations_begin=*/g.back(),
+                       /*accelerations_end=*/&g.front());
+    } else {
+      this->FinishStep(/*accelerations_begin=*/g.front(),
+                       /*accelerations_end=*/nullptr);
+    }
     append_state(current_state);
     ++step_count;
     if (step_count == parameters.max_steps && !at_end) {
@@ -250,8 +258,8 @@ Instance::Solve(Instant const& t_final) {
     }
   }
   // The resolution is restartable from the last non-truncated state.
-  CHECK(final_state);
-  current_state = *final_state;
+  CHECK(has_final_state);
+  current_state = final_state;
   return status;
 }
 
@@ -295,7 +303,17 @@ Instance::Instance(
     EmbeddedExplicitRungeKuttaNyströmIntegrator const& integrator)
     : AdaptiveStepSizeIntegrator<ODE>::Instance(
           problem, append_state, tolerance_to_error_ratio, parameters),
-      integrator_(integrator) {}
+      integrator_(integrator),
+      Δq̂_(problem.initial_state.positions.size()),
+      Δv̂_(problem.initial_state.positions.size()),
+      q_stage_(problem.initial_state.positions.size()),
+      g_(stages_,
+         std::vector<typename ODE::Acceleration>(
+             problem.initial_state.positions.size())),
+      final_state_(problem.initial_state) {
+  error_estimate_.position_error.resize(problem.initial_state.positions.size());
+  error_estimate_.velocity_error.resize(problem.initial_state.positions.size());
+}
 
 template<typename Method, typename Position>
 not_null<std::unique_ptr<typename Integrator<
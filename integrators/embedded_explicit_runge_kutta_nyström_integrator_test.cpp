@@ -6,9 +6,11 @@
 #include <vector>
 
 #include "base/macros.hpp"
+#include "geometry/sign.hpp"
 #include "glog/logging.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "numerics/hermite3.hpp"
 #include "quantities/si.hpp"
 #include "testing_utilities/almost_equals.hpp"
 #include "testing_utilities/integration.hpp"
@@ -20,6 +22,8 @@ namespace principia {
 namespace integrators {
 namespace internal_embedded_explicit_runge_kutta_nyström_integrator {
 
+using geometry::Sign;
+using numerics::Hermite3;
 using quantities::Abs;
 using quantities::Acceleration;
 using quantities::AngularFrequency;
@@ -489,6 +493,358 @@ TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, Serialization) {
   EXPECT_THAT(message1, EqualsProto(message2));
 }
 
+// The continuous extension is as accurate between the steps as the steps
+// themselves, and more accurate than the cubic Hermite interpolation of the
+// steps which is done on trajectories.
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, DenseOutput) {
+  using DenseOutput = AdaptiveStepSizeIntegrator<ODE>::DenseOutput;
+  auto const& integrator = EmbeddedExplicitRungeKuttaNyströmIntegrator<
+      methods::DormandالمكاوىPrince1986RKN434FM,
+      Length>();
+  Length const x_initial = 1 * Metre;
+  Speed const v_initial = 0 * Metre / Second;
+  Time const period = 2 * π * Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 10 * period;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+  int const samples_per_step = 10;
+
+  IntegrationProblem<ODE> problem;
+  problem.equation.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration1D,
+                _1, _2, _3, /*evaluations=*/nullptr);
+  problem.initial_state = {{x_initial}, {v_initial}, t_initial};
+  AdaptiveStepSizeIntegrator<ODE>::Parameters const parameters(
+      /*first_time_step=*/t_final - t_initial,
+      /*safety_factor=*/0.9);
+  auto const tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorToleranceRatio,
+                _1, _2,
+                length_tolerance,
+                speed_tolerance,
+                [](bool tolerable) {});
+
+  auto const position_error = [t_initial](Instant const& t, Length const& x) {
+    return Abs(x - Cos((t - t_initial) * Radian / Second) * Metre);
+  };
+  auto const speed_error = [t_initial](Instant const& t, Speed const& v) {
+    return Abs(v + Sin((t - t_initial) * Radian / Second) * Metre / Second);
+  };
+  auto const sample_time = [samples_per_step](Instant const& t_begin,
+                                              Instant const& t_end,
+                                              int const i) {
+    return t_begin + i * (t_end - t_begin) / samples_per_step;
+  };
+
+  std::vector<ODE::SystemState> solution = {problem.initial_state};
+  Length max_dense_position_error;
+  Speed max_dense_speed_error;
+  std::vector<Length> positions(1);
+  std::vector<Speed> velocities(1);
+  auto const instance = integrator.NewInstance(
+      problem,
+      [&solution](ODE::SystemState const& state) {
+        solution.push_back(state);
+      },
+      tolerance_to_error_ratio,
+      parameters);
+  dynamic_cast<AdaptiveStepSizeIntegrator<ODE>::Instance&>(*instance)
+      .SetDenseOutput([&](DenseOutput const& dense_output) {
+        EXPECT_EQ(solution.back().time.value, dense_output.t_begin());
+        for (int i = 1; i < samples_per_step; ++i) {
+          Instant const t =
+              sample_time(dense_output.t_begin(), dense_output.t_end(), i);
+          dense_output.Evaluate(t, positions, velocities);
+          max_dense_position_error =
+              std::max(max_dense_position_error,
+                       position_error(t, positions[0]));
+          max_dense_speed_error =
+              std::max(max_dense_speed_error, speed_error(t, velocities[0]));
+        }
+      });
+  EXPECT_OK(instance->Solve(t_final));
+
+  Length max_step_position_error;
+  Speed max_step_speed_error;
+  Length max_hermite3_position_error;
+  Speed max_hermite3_speed_error;
+  for (int s = 1; s < solution.size(); ++s) {
+    auto const& begin = solution[s - 1];
+    auto const& end = solution[s];
+    Instant const& t_begin = begin.time.value;
+    Instant const& t_end = end.time.value;
+    max_step_position_error =
+        std::max(max_step_position_error,
+                 position_error(t_end, end.positions[0].value));
+    max_step_speed_error = std::max(
+        max_step_speed_error, speed_error(t_end, end.velocities[0].value));
+    Hermite3<Instant, Length> const hermite3(
+        {t_begin, t_end},
+        {begin.positions[0].value, end.positions[0].value},
+        {begin.velocities[0].value, end.velocities[0].value});
+    for (int i = 1; i < samples_per_step; ++i) {
+      Instant const t = sample_time(t_begin, t_end, i);
+      max_hermite3_position_error =
+          std::max(max_hermite3_position_error,
+                   position_error(t, hermite3.Evaluate(t)));
+      max_hermite3_speed_error =
+          std::max(max_hermite3_speed_error,
+                   speed_error(t, hermite3.EvaluateDerivative(t)));
+    }
+  }
+  EXPECT_THAT(max_step_position_error, IsNear(2.7 * Milli(Metre)));
+  EXPECT_THAT(max_step_speed_error, IsNear(2.8 * Milli(Metre) / Second));
+  EXPECT_THAT(max_dense_position_error, IsNear(2.75 * Milli(Metre)));
+  EXPECT_THAT(max_dense_speed_error, IsNear(2.8 * Milli(Metre) / Second));
+  EXPECT_THAT(max_hermite3_position_error, IsNear(2.78 * Milli(Metre)));
+  EXPECT_THAT(max_hermite3_speed_error, IsNear(3.6 * Milli(Metre) / Second));
+}
+
+// The sign changes of the event functions are located during the integration,
+// and reported in chronological order before the end of their step.
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, Events) {
+  auto const& integrator = EmbeddedExplicitRungeKuttaNyströmIntegrator<
+      methods::DormandالمكاوىPrince1986RKN434FM,
+      Length>();
+  // The solution is x(t) = √2 sin(t + π/4).
+  Length const x_initial = 1 * Metre;
+  Speed const v_initial = 1 * Metre / Second;
+  Time const period = 2 * π * Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 10 * period;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+
+  IntegrationProblem<ODE> problem;
+  problem.equation.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration1D,
+                _1, _2, _3, /*evaluations=*/nullptr);
+  problem.initial_state = {{x_initial}, {v_initial}, t_initial};
+  AdaptiveStepSizeIntegrator<ODE>::Parameters const parameters(
+      /*first_time_step=*/t_final - t_initial,
+      /*safety_factor=*/0.9);
+  auto const tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorToleranceRatio,
+                _1, _2,
+                length_tolerance,
+                speed_tolerance,
+                [](bool tolerable) {});
+
+  // The extrema, the zeros, and the passages below -1 m of the position.
+  std::vector<AdaptiveStepSizeIntegrator<ODE>::EventFunction> const
+      event_functions = {
+          [](Instant const& t,
+             std::vector<Length> const& q,
+             std::vector<Speed> const& v) {
+            return v[0] / (Metre / Second);
+          },
+          [](Instant const& t,
+             std::vector<Length> const& q,
+             std::vector<Speed> const& v) {
+            return q[0] / Metre;
+          },
+          [](Instant const& t,
+             std::vector<Length> const& q,
+             std::vector<Speed> const& v) {
+            return (q[0] + 1 * Metre) / Metre;
+          }};
+
+  std::vector<ODE::SystemState> solution;
+  std::vector<std::pair<int, ODE::SystemState>> events;
+  // The number of states appended before each event.
+  std::vector<int> states_before_events;
+  auto const instance = integrator.NewInstance(
+      problem,
+      [&solution](ODE::SystemState const& state) {
+        solution.push_back(state);
+      },
+      tolerance_to_error_ratio,
+      parameters);
+  dynamic_cast<AdaptiveStepSizeIntegrator<ODE>::Instance&>(*instance)
+      .SetEventFunctions(
+          event_functions,
+          [&events, &solution, &states_before_events](
+              int const event, ODE::SystemState const& state) {
+            events.emplace_back(event, state);
+            states_before_events.push_back(solution.size());
+          });
+  EXPECT_OK(instance->Solve(t_final));
+
+  // The exact events, in chronological order.  The extrema are at π/4 + nπ,
+  // the zeros at 3π/4 + nπ, and the passages below -1 m at π + 2nπ and
+  // 3π/2 + 2nπ.
+  std::vector<std::pair<Instant, int>> expected_events;
+  for (int n = 0; n < 10; ++n) {
+    Instant const t_n = t_initial + n * period;
+    expected_events.emplace_back(t_n + π / 4 * Second, 0);
+    expected_events.emplace_back(t_n + 3 * π / 4 * Second, 1);
+    expected_events.emplace_back(t_n + π * Second, 2);
+    expected_events.emplace_back(t_n + 5 * π / 4 * Second, 0);
+    expected_events.emplace_back(t_n + 3 * π / 2 * Second, 2);
+    expected_events.emplace_back(t_n + 7 * π / 4 * Second, 1);
+  }
+
+  ASSERT_EQ(expected_events.size(), events.size());
+  Time max_time_error;
+  Length max_position_error;
+  Speed max_speed_error;
+  for (int e = 0; e < events.size(); ++e) {
+    auto const& [event, state] = events[e];
+    Instant const& t = state.time.value;
+    EXPECT_EQ(expected_events[e].second, event) << e;
+    max_time_error =
+        std::max(max_time_error, Abs(t - expected_events[e].first));
+
+    // The event lies within the step whose end was appended after it.
+    int const step = states_before_events[e];
+    ASSERT_LT(step, solution.size());
+    EXPECT_LE(t, solution[step].time.value);
+    if (step > 0) {
+      EXPECT_GE(t, solution[step - 1].time.value);
+    }
+
+    // The interpolated state is close to the exact solution.
+    auto const ωt = (t - t_initial) * Radian / Second;
+    max_position_error = std::max(
+        max_position_error,
+        Abs(state.positions[0].value -
+            std::sqrt(2.0) * Sin(ωt + π / 4 * Radian) * Metre));
+    max_speed_error = std::max(
+        max_speed_error,
+        Abs(state.velocities[0].value -
+            std::sqrt(2.0) * Cos(ωt + π / 4 * Radian) * Metre / Second));
+  }
+  EXPECT_THAT(max_time_error, IsNear(2.1 * Milli(Second)));
+  EXPECT_THAT(max_position_error, IsNear(2.7 * Milli(Metre)));
+  EXPECT_THAT(max_speed_error, IsNear(2.7 * Milli(Metre) / Second));
+}
+
+// The changes of sign that occur at, or within a few ULPs of, the end of a step
+// are reported exactly once, in the step that contains them.  Two changes of
+// sign within a step are not reported.
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, EventsNearStepEnd) {
+  auto const& integrator = EmbeddedExplicitRungeKuttaNyströmIntegrator<
+      methods::DormandالمكاوىPrince1986RKN434FM,
+      Length>();
+  Length const x_initial = 1 * Metre;
+  Speed const v_initial = 1 * Metre / Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 2 * π * Second;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+
+  IntegrationProblem<ODE> problem;
+  problem.equation.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration1D,
+                _1, _2, _3, /*evaluations=*/nullptr);
+  problem.initial_state = {{x_initial}, {v_initial}, t_initial};
+  AdaptiveStepSizeIntegrator<ODE>::Parameters const parameters(
+      /*first_time_step=*/t_final - t_initial,
+      /*safety_factor=*/0.9);
+  auto const tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorToleranceRatio,
+                _1, _2,
+                length_tolerance,
+                speed_tolerance,
+                [](bool tolerable) {});
+
+  // The event functions don't change the steps, so a first integration gives
+  // their ends.
+  std::vector<ODE::SystemState> steps;
+  auto const append_step = [&steps](ODE::SystemState const& state) {
+    steps.push_back(state);
+  };
+  EXPECT_OK(integrator
+                .NewInstance(problem,
+                             append_step,
+                             tolerance_to_error_ratio,
+                             parameters)
+                ->Solve(t_final));
+  ASSERT_GE(steps.size(), 4);
+  int const j = steps.size() / 2;
+  Instant const t_j = steps[j].time.value;
+  Time const δt =
+      4 * std::numeric_limits<double>::epsilon() * (t_j - t_initial);
+  Time const next_step = steps[j + 1].time.value - t_j;
+
+  // The change of sign is exactly at the end of step |j|, a few ULPs before,
+  // a few ULPs after, and twice within step |j + 1|.  The first one depends on
+  // the state, so its value at the end of the step is that of the actual
+  // state, not of the interpolant.
+  Length const x_j = steps[j].positions[0].value;
+  Sign const direction = Sign(steps[j].velocities[0].value);
+  std::vector<AdaptiveStepSizeIntegrator<ODE>::EventFunction> const
+      event_functions = {
+          [x_j, direction](Instant const& t,
+                           std::vector<Length> const& q,
+                           std::vector<Speed> const& v) {
+            return direction * (q[0] - x_j) / Metre;
+          },
+          [t_j, δt](Instant const& t,
+                    std::vector<Length> const& q,
+                    std::vector<Speed> const& v) {
+            return (t - (t_j - δt)) / Second;
+          },
+          [t_j, δt](Instant const& t,
+                    std::vector<Length> const& q,
+                    std::vector<Speed> const& v) {
+            return (t - (t_j + δt)) / Second;
+          },
+          [t_j, next_step](Instant const& t,
+                           std::vector<Length> const& q,
+                           std::vector<Speed> const& v) {
+            return (t - (t_j + next_step / 3)) *
+                   (t - (t_j + 2 * next_step / 3)) / (Second * Second);
+          }};
+
+  std::vector<ODE::SystemState> solution;
+  std::vector<std::pair<int, ODE::SystemState>> events;
+  std::vector<int> states_before_events;
+  auto const instance = integrator.NewInstance(
+      problem,
+      [&solution](ODE::SystemState const& state) {
+        solution.push_back(state);
+      },
+      tolerance_to_error_ratio,
+      parameters);
+  dynamic_cast<AdaptiveStepSizeIntegrator<ODE>::Instance&>(*instance)
+      .SetEventFunctions(
+          event_functions,
+          [&events, &solution, &states_before_events](
+              int const event, ODE::SystemState const& state) {
+            events.emplace_back(event, state);
+            states_before_events.push_back(solution.size());
+          });
+  EXPECT_OK(instance->Solve(t_final));
+  ASSERT_EQ(steps.size(), solution.size());
+
+  // The position passes |x_j| again later in the period, those events are
+  // ignored.
+  std::vector<std::pair<int, ODE::SystemState>> events_near_t_j;
+  std::vector<int> steps_of_events_near_t_j;
+  for (int e = 0; e < events.size(); ++e) {
+    if (events[e].first != 0 ||
+        Abs(events[e].second.time.value - t_j) < 1 * Milli(Second)) {
+      events_near_t_j.push_back(events[e]);
+      steps_of_events_near_t_j.push_back(states_before_events[e]);
+    }
+  }
+  ASSERT_EQ(3, events_near_t_j.size());
+  // The event 1 is bisected within step |j| and comes out first.
+  EXPECT_EQ(1, events_near_t_j[0].first);
+  EXPECT_EQ(j, steps_of_events_near_t_j[0]);
+  EXPECT_THAT(events_near_t_j[0].second.time.value,
+              AlmostEquals(t_j - δt, 0, 1));
+  EXPECT_EQ(0, events_near_t_j[1].first);
+  EXPECT_EQ(j, steps_of_events_near_t_j[1]);
+  EXPECT_EQ(t_j, events_near_t_j[1].second.time.value);
+  EXPECT_EQ(2, events_near_t_j[2].first);
+  EXPECT_EQ(j + 1, steps_of_events_near_t_j[2]);
+  EXPECT_THAT(events_near_t_j[2].second.time.value,
+              AlmostEquals(t_j + δt, 0, 1));
+}
+
 }  // namespace internal_embedded_explicit_runge_kutta_nyström_integrator
 
 // Reopen this namespace to allow printing out the system state.
@@ -0,0 +1,182 @@
+﻿
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "base/not_null.hpp"
+#include "base/status.hpp"
+#include "geometry/named_quantities.hpp"
+#include "integrators/integrators.hpp"
+#include "integrators/ordinary_differential_equations.hpp"
+#include "numerics/double_precision.hpp"
+#include "quantities/quantities.hpp"
+
+namespace principia {
+namespace integrators {
+namespace internal_ensemble {
+
+using base::not_null;
+using base::Status;
+using geometry::Instant;
+using numerics::DoublePrecision;
+using quantities::Time;
+
+// An ensemble of initial value problems for the same |ODE|, e.g., perturbed
+// copies of a trajectory, whose right-hand sides are computed together.  Only
+// |SpecialSecondOrderDifferentialEquation| is supported.
+template<typename ODE>
+struct EnsembleProblem final {
+  // A functor that computes the accelerations of the given |members| of the
+  // ensemble at time |t|.  |positions| is the concatenation of the positions of
+  // these members, in the order of |members|, and |accelerations| has the same
+  // size.  The accelerations of a member must only depend on its own
+  // positions.  A member for which the computation fails must cause the
+  // functor to return an error when it is called with that member alone.
+  using RightHandSideComputation =
+      std::function<Status(
+          Instant const& t,
+          std::vector<int> const& members,
+          std::vector<typename ODE::Position> const& positions,
+          std::vector<typename ODE::Acceleration>& accelerations)>;
+
+  RightHandSideComputation compute_acceleration;
+  // The initial states of the members, which must all have the same time.
+  std::vector<typename ODE::SystemState> initial_states;
+};
+
+// An object for integrating the members of an |EnsembleProblem| in lockstep.
+// Their states are concatenated in a single |SystemState| which is advanced by
+// an ordinary instance of the integrator, so that each stage evaluates the
+// right-hand side once for the entire ensemble and the loops of the integrator
+// run over all the members.  With an adaptive step size, the members share the
+// step size and the step is accepted if it is acceptable for each of them.
+// A member terminates early, and is masked out of the ensemble, if the
+// computation of its accelerations fails (e.g., because of a collision) or if
+// it causes the step size to vanish.  The step during which this happens is not
+// passed to |append_state| for that member, its accelerations are no longer
+// computed and it no longer participates in step size control.
+// Ensemble instances cannot be cloned or serialized.
+template<typename ODE>
+class EnsembleInstance final {
+  static_assert(
+      std::is_same_v<
+          ODE,
+          SpecialSecondOrderDifferentialEquation<typename ODE::Position>>,
+      "Only special second order equations are supported");
+
+ public:
+  using AppendState = typename Integrator<ODE>::EnsembleAppendState;
+  using ToleranceToErrorRatio =
+      typename AdaptiveStepSizeIntegrator<ODE>::ToleranceToErrorRatio;
+
+  // Use |FixedStepSizeIntegrator::NewEnsembleInstance| and
+  // |AdaptiveStepSizeIntegrator::NewEnsembleInstance| instead of these
+  // constructors.  With an adaptive step size, |tolerance_to_error_ratio| is
+  // called with the error estimate of a single member.
+  EnsembleInstance(FixedStepSizeIntegrator<ODE> const& integrator,
+                   EnsembleProblem<ODE> const& problem,
+                   AppendState const& append_state,
+                   Time const& step);
+  EnsembleInstance(
+      AdaptiveStepSizeIntegrator<ODE> const& integrator,
+      EnsembleProblem<ODE> const& problem,
+      AppendState const& append_state,
+      ToleranceToErrorRatio const& tolerance_to_error_ratio,
+      typename AdaptiveStepSizeIntegrator<ODE>::Parameters const& parameters);
+
+  EnsembleInstance(EnsembleInstance const&) = delete;
+  EnsembleInstance(EnsembleInstance&&) = delete;
+  EnsembleInstance& operator=(EnsembleInstance const&) = delete;
+  EnsembleInstance& operator=(EnsembleInstance&&) = delete;
+
+  // Integrates the members that have not terminated until |t_final|, with the
+  // same semantics as the |Solve| of the underlying integrator.  The early
+  // termination of a member is not an error of the ensemble: it is reported by
+  // |status|.
+  Status Solve(Instant const& t_final);
+
+  // The last instant integrated by this instance.
+  DoublePrecision<Instant> const& time() const;
+
+  int number_of_members() const;
+
+  // Returns false if the given |member| has terminated early.
+  bool active(int member) const;
+
+  // The reason why the given |member| terminated early, or OK if it didn't.
+  Status const& status(int member) const;
+
+ private:
+  using Position = typename ODE::Position;
+  using Acceleration = typename ODE::Acceleration;
+  using SystemState = typename ODE::SystemState;
+  using SystemStateError = typename ODE::SystemStateError;
+  using NewInstance = std::function<
+      not_null<std::unique_ptr<typename Integrator<ODE>::Instance>>(
+          IntegrationProblem<ODE> const& problem)>;
+
+  EnsembleInstance(EnsembleProblem<ODE> const& problem,
+                   AppendState const& append_state,
+                   ToleranceToErrorRatio const& tolerance_to_error_ratio);
+
+  static SystemState Concatenate(std::vector<SystemState> const& states);
+
+  // The problem solved by the underlying instance, starting from
+  // |initial_state|.
+  IntegrationProblem<ODE> ConcatenatedProblem(
+      SystemState const& initial_state);
+
+  // The functors given to the underlying instance.
+  Status ComputeAccelerations(Instant const& t,
+                              std::vector<Position> const& positions,
+                              std::vector<Acceleration>& accelerations);
+  double ComputeToleranceToErrorRatio(Time const& current_step_size,
+                                      SystemStateError const& error);
+  void AppendConcatenatedState(SystemState const& state);
+
+  // Recomputes |active_members_| after a change to |statuses_| or
+  // |pending_statuses_|.
+  void UpdateActiveMembers();
+
+  typename EnsembleProblem<ODE>::RightHandSideComputation const
+      compute_acceleration_;
+  AppendState const append_state_;
+  ToleranceToErrorRatio const tolerance_to_error_ratio_;
+
+  // The positions of member |m| have the indices
+  // [offsets_[m], offsets_[m + 1][ in the concatenated state.
+  std::vector<int> offsets_;
+  std::vector<Status> statuses_;
+  // The failures that occurred during the current step.  They only become
+  // final if the step is accepted.
+  std::vector<Status> pending_statuses_;
+  // The members whose accelerations are computed, in increasing order.
+  std::vector<int> active_members_;
+  // The member that had the smallest tolerance-to-error ratio during the last
+  // attempted step, or -1.
+  int limiting_member_ = -1;
+
+  // Scratch storage for computing the accelerations and the errors of subsets
+  // of the members, and for extracting their states.
+  std::vector<int> single_member_;
+  std::vector<Position> member_positions_;
+  std::vector<Acceleration> member_accelerations_;
+  SystemStateError member_error_;
+  SystemState member_state_;
+
+  NewInstance new_instance_;
+  std::unique_ptr<typename Integrator<ODE>::Instance> instance_;
+};
+
+}  // namespace internal_ensemble
+
+using internal_ensemble::EnsembleInstance;
+using internal_ensemble::EnsembleProblem;
+
+}  // namespace integrators
+}  // namespace principia
+
+#include "integrators/ensemble_body.hpp"
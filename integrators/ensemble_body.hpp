@@ -0,0 +1,286 @@
+﻿
+#pragma once
+
+#include "integrators/ensemble.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace integrators {
+namespace internal_ensemble {
+
+template<typename ODE>
+EnsembleInstance<ODE>::EnsembleInstance(
+    FixedStepSizeIntegrator<ODE> const& integrator,
+    EnsembleProblem<ODE> const& problem,
+    AppendState const& append_state,
+    Time const& step)
+    : EnsembleInstance(problem,
+                       append_state,
+                       /*tolerance_to_error_ratio=*/nullptr) {
+  new_instance_ = [this, &integrator, step](
+                      IntegrationProblem<ODE> const& concatenated_problem) {
+    return integrator.NewInstance(
+        concatenated_problem,
+        [this](SystemState const& state) { AppendConcatenatedState(state); },
+        step);
+  };
+  instance_ = new_instance_(
+      ConcatenatedProblem(Concatenate(problem.initial_states)));
+}
+
+template<typename ODE>
+EnsembleInstance<ODE>::EnsembleInstance(
+    AdaptiveStepSizeIntegrator<ODE> const& integrator,
+    EnsembleProblem<ODE> const& problem,
+    AppendState const& append_state,
+    ToleranceToErrorRatio const& tolerance_to_error_ratio,
+    typename AdaptiveStepSizeIntegrator<ODE>::Parameters const& parameters)
+    : EnsembleInstance(problem, append_state, tolerance_to_error_ratio) {
+  new_instance_ = [this, &integrator, parameters](
+                      IntegrationProblem<ODE> const& concatenated_problem) {
+    return integrator.NewInstance(
+        concatenated_problem,
+        [this](SystemState const& state) { AppendConcatenatedState(state); },
+        [this](Time const& current_step_size, SystemStateError const& error) {
+          return ComputeToleranceToErrorRatio(current_step_size, error);
+        },
+        parameters);
+  };
+  instance_ = new_instance_(
+      ConcatenatedProblem(Concatenate(problem.initial_states)));
+}
+
+template<typename ODE>
+Status EnsembleInstance<ODE>::Solve(Instant const& t_final) {
+  // A step may have been computed and dropped at the end of the last call.
+  std::fill(pending_statuses_.begin(), pending_statuses_.end(), Status::OK);
+  UpdateActiveMembers();
+
+  for (;;) {
+    if (active_members_.empty()) {
+      return Status::OK;
+    }
+    Status const status = instance_->Solve(t_final);
+    if (status.error() != termination_condition::VanishingStepSize ||
+        limiting_member_ < 0) {
+      return status;
+    }
+    // The step size was driven to zero by the member which had the smallest
+    // tolerance-to-error ratio.  Mask it and restart the integration of the
+    // other members from the last step.
+    statuses_[limiting_member_] = status;
+    UpdateActiveMembers();
+    instance_ = new_instance_(ConcatenatedProblem(instance_->state()));
+  }
+}
+
+template<typename ODE>
+DoublePrecision<Instant> const& EnsembleInstance<ODE>::time() const {
+  return instance_->time();
+}
+
+template<typename ODE>
+int EnsembleInstance<ODE>::number_of_members() const {
+  return statuses_.size();
+}
+
+template<typename ODE>
+bool EnsembleInstance<ODE>::active(int const member) const {
+  return statuses_[member].ok();
+}
+
+template<typename ODE>
+Status const& EnsembleInstance<ODE>::status(int const member) const {
+  return statuses_[member];
+}
+
+template<typename ODE>
+EnsembleInstance<ODE>::EnsembleInstance(
+    EnsembleProblem<ODE> const& problem,
+    AppendState const& append_state,
+    ToleranceToErrorRatio const& tolerance_to_error_ratio)
+    : compute_acceleration_(problem.compute_acceleration),
+      append_state_(append_state),
+      tolerance_to_error_ratio_(tolerance_to_error_ratio),
+      statuses_(problem.initial_states.size()),
+      pending_statuses_(problem.initial_states.size()),
+      single_member_(1) {
+  CHECK(!problem.initial_states.empty());
+  offsets_.push_back(0);
+  for (auto const& initial_state : problem.initial_states) {
+    offsets_.push_back(offsets_.back() + initial_state.positions.size());
+  }
+  UpdateActiveMembers();
+}
+
+template<typename ODE>
+auto EnsembleInstance<ODE>::Concatenate(
+    std::vector<SystemState> const& states) -> SystemState {
+  SystemState result;
+  result.time = states.front().time;
+  for (auto const& state : states) {
+    CHECK_EQ(result.time.value, state.time.value);
+    CHECK_EQ(state.positions.size(), state.velocities.size());
+    for (auto const& position : state.positions) {
+      result.positions.push_back(position);
+    }
+    for (auto const& velocity : state.velocities) {
+      result.velocities.push_back(velocity);
+    }
+  }
+  return result;
+}
+
+template<typename ODE>
+IntegrationProblem<ODE> EnsembleInstance<ODE>::ConcatenatedProblem(
+    SystemState const& initial_state) {
+  IntegrationProblem<ODE> problem;
+  problem.equation.compute_acceleration =
+      [this](Instant const& t,
+             std::vector<Position> const& positions,
+             std::vector<Acceleration>& accelerations) {
+        return ComputeAccelerations(t, positions, accelerations);
+      };
+  problem.initial_state = initial_state;
+  return problem;
+}
+
+template<typename ODE>
+Status EnsembleInstance<ODE>::ComputeAccelerations(
+    Instant const& t,
+    std::vector<Position> const& positions,
+    std::vector<Acceleration>& accelerations) {
+  Status status;
+  if (active_members_.size() == number_of_members()) {
+    status = compute_acceleration_(t, active_members_, positions, accelerations);
+  } else {
+    // Only pass the positions of the active members.  The masked members have
+    // no acceleration.
+    member_positions_.clear();
+    for (int const m : active_members_) {
+      member_positions_.insert(member_positions_.end(),
+                               positions.begin() + offsets_[m],
+                               positions.begin() + offsets_[m + 1]);
+    }
+    member_accelerations_.resize(member_positions_.size());
+    status = compute_acceleration_(
+        t, active_members_, member_positions_, member_accelerations_);
+    std::fill(accelerations.begin(), accelerations.end(), Acceleration{});
+    auto member_accelerations = member_accelerations_.cbegin();
+    for (int const m : active_members_) {
+      int const dimension = offsets_[m + 1] - offsets_[m];
+      std::copy(member_accelerations,
+                member_accelerations + dimension,
+                accelerations.begin() + offsets_[m]);
+      member_accelerations += dimension;
+    }
+  }
+  if (status.ok()) {
+    return status;
+  }
+
+  // The computation failed for some members.  Find them by computing the
+  // accelerations of the active members one at a time.  This is expensive, but
+  // it only happens when a member fails.
+  bool member_failed = false;
+  for (int const m : active_members_) {
+    single_member_[0] = m;
+    member_positions_.assign(positions.begin() + offsets_[m],
+                             positions.begin() + offsets_[m + 1]);
+    member_accelerations_.resize(member_positions_.size());
+    Status const member_status = compute_acceleration_(
+        t, single_member_, member_positions_, member_accelerations_);
+    if (member_status.ok()) {
+      std::copy(member_accelerations_.cbegin(),
+                member_accelerations_.cend(),
+                accelerations.begin() + offsets_[m]);
+    } else {
+      member_failed = true;
+      pending_statuses_[m] = member_status;
+      std::fill(accelerations.begin() + offsets_[m],
+                accelerations.begin() + offsets_[m + 1],
+                Acceleration{});
+    }
+  }
+  if (!member_failed) {
+    // The failure cannot be attributed to a member, e.g., the computation was
+    // cancelled.  Let the integrator report it.
+    return status;
+  }
+  UpdateActiveMembers();
+  return Status::OK;
+}
+
+template<typename ODE>
+double EnsembleInstance<ODE>::ComputeToleranceToErrorRatio(
+    Time const& current_step_size,
+    SystemStateError const& error) {
+  double min_tolerance_to_error_ratio =
+      std::numeric_limits<double>::infinity();
+  limiting_member_ = -1;
+  for (int const m : active_members_) {
+    member_error_.position_error.assign(
+        error.position_error.begin() + offsets_[m],
+        error.position_error.begin() + offsets_[m + 1]);
+    member_error_.velocity_error.assign(
+        error.velocity_error.begin() + offsets_[m],
+        error.velocity_error.begin() + offsets_[m + 1]);
+    double const tolerance_to_error_ratio =
+        tolerance_to_error_ratio_(current_step_size, member_error_);
+    if (tolerance_to_error_ratio < min_tolerance_to_error_ratio) {
+      min_tolerance_to_error_ratio = tolerance_to_error_ratio;
+      limiting_member_ = m;
+    }
+  }
+  if (min_tolerance_to_error_ratio < 1.0) {
+    // The step will be recomputed, so the failures that happened during it are
+    // moot.
+    std::fill(pending_statuses_.begin(), pending_statuses_.end(), Status::OK);
+    UpdateActiveMembers();
+  }
+  return min_tolerance_to_error_ratio;
+}
+
+template<typename ODE>
+void EnsembleInstance<ODE>::AppendConcatenatedState(SystemState const& state) {
+  // The step is accepted, so the failures that happened during it are final.
+  for (int m = 0; m < number_of_members(); ++m) {
+    if (!pending_statuses_[m].ok()) {
+      statuses_[m] = pending_statuses_[m];
+      pending_statuses_[m] = Status::OK;
+    }
+  }
+
+  member_state_.time = state.time;
+  for (int const m : active_members_) {
+    int const dimension = offsets_[m + 1] - offsets_[m];
+    member_state_.positions.resize(dimension);
+    member_state_.velocities.resize(dimension);
+    std::copy(state.positions.cbegin() + offsets_[m],
+              state.positions.cbegin() + offsets_[m + 1],
+              member_state_.positions.begin());
+    std::copy(state.velocities.cbegin() + offsets_[m],
+              state.velocities.cbegin() + offsets_[m + 1],
+              member_state_.velocities.begin());
+    append_state_(m, member_state_);
+  }
+}
+
+template<typename ODE>
+void EnsembleInstance<ODE>::UpdateActiveMembers() {
+  active_members_.clear();
+  for (int m = 0; m < number_of_members(); ++m) {
+    if (statuses_[m].ok() && pending_statuses_[m].ok()) {
+      active_members_.push_back(m);
+    }
+  }
+}
+
+}  // namespace internal_ensemble
+}  // namespace integrators
+}  // namespace principia
@@ -0,0 +1,235 @@
+﻿
+#include "integrators/ensemble.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "geometry/named_quantities.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
+#include "integrators/methods.hpp"
+#include "integrators/symplectic_runge_kutta_nyström_integrator.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+#include "testing_utilities/matchers.hpp"
+
+namespace principia {
+namespace integrators {
+namespace internal_ensemble {
+
+using base::Error;
+using geometry::Instant;
+using quantities::Abs;
+using quantities::Acceleration;
+using quantities::Cos;
+using quantities::Length;
+using quantities::Sin;
+using quantities::Speed;
+using quantities::Time;
+using quantities::si::Metre;
+using quantities::si::Radian;
+using quantities::si::Second;
+using ::testing::Lt;
+
+using ODE = SpecialSecondOrderDifferentialEquation<Length>;
+
+class EnsembleTest : public ::testing::Test {
+ protected:
+  EnsembleTest() {
+    // Harmonic oscillators with different amplitudes.
+    for (Length const& q : {1 * Metre, 0.4 * Metre, 0.3 * Metre}) {
+      initial_states_.emplace_back(std::vector<Length>{q},
+                                   std::vector<Speed>{0 * Metre / Second},
+                                   t0_);
+    }
+    problem_.initial_states = initial_states_;
+    problem_.compute_acceleration = [this](
+        Instant const& t,
+        std::vector<int> const& members,
+        std::vector<Length> const& q,
+        std::vector<Acceleration>& a) {
+      ++evaluations_;
+      return ComputeAccelerations(t, members, q, a);
+    };
+  }
+
+  // Unit harmonic oscillators.  The member |colliding_member_|, if any, fails
+  // when it goes below |collision_position_|.  The member |stiff_member_|, if
+  // any, is subject to a huge and rapidly oscillating acceleration after
+  // |stiff_time_|.
+  Status ComputeAccelerations(Instant const& t,
+                              std::vector<int> const& members,
+                              std::vector<Length> const& q,
+                              std::vector<Acceleration>& a) const {
+    Status status;
+    CHECK_EQ(members.size(), q.size());
+    for (int i = 0; i < q.size(); ++i) {
+      a[i] = -q[i] / (Second * Second);
+      if (members[i] == stiff_member_ && t > stiff_time_) {
+        a[i] += 1e40 * Metre / (Second * Second) *
+                Sin((t - stiff_time_) * Radian / (1e-12 * Second));
+      }
+      if (members[i] == colliding_member_ && q[i] < collision_position_) {
+        status = Status(Error::OUT_OF_RANGE, "Collision");
+      }
+    }
+    return status;
+  }
+
+  // The states obtained by integrating each member independently.
+  std::vector<std::vector<ODE::SystemState>> IndependentSolutions(
+      FixedStepSizeIntegrator<ODE> const& integrator,
+      Time const& step,
+      Instant const& t_final) {
+    std::vector<std::vector<ODE::SystemState>> solutions;
+    for (int m = 0; m < initial_states_.size(); ++m) {
+      std::vector<ODE::SystemState> solution;
+      IntegrationProblem<ODE> problem;
+      problem.initial_state = initial_states_[m];
+      problem.equation.compute_acceleration =
+          [this, m](Instant const& t,
+                    std::vector<Length> const& q,
+                    std::vector<Acceleration>& a) {
+            return ComputeAccelerations(t, {m}, q, a);
+          };
+      auto const instance = integrator.NewInstance(
+          problem,
+          [&solution](ODE::SystemState const& state) {
+            solution.push_back(state);
+          },
+          step);
+      instance->Solve(t_final);
+      solutions.push_back(solution);
+    }
+    return solutions;
+  }
+
+  Instant const t0_;
+  std::vector<ODE::SystemState> initial_states_;
+  EnsembleProblem<ODE> problem_;
+  int colliding_member_ = -1;
+  Length collision_position_;
+  int stiff_member_ = -1;
+  Instant stiff_time_;
+  int evaluations_ = 0;
+};
+
+// The members of an ensemble integrated with a fixed step get exactly the same
+// states as when they are integrated independently, with one evaluation of the
+// right-hand side per stage for the entire ensemble.
+TEST_F(EnsembleTest, FixedStep) {
+  auto const& integrator = SymplecticRungeKuttaNyströmIntegrator<
+      methods::McLachlanAtela1992Order5Optimal, Length>();
+  Time const step = 0.125 * Second;
+  Instant const t_final = t0_ + 10 * Second;
+
+  std::vector<std::vector<ODE::SystemState>> solutions(
+      initial_states_.size());
+  auto const instance = integrator.NewEnsembleInstance(
+      problem_,
+      [&solutions](int const member, ODE::SystemState const& state) {
+        solutions[member].push_back(state);
+      },
+      step);
+  EXPECT_OK(instance->Solve(t_final));
+  EXPECT_EQ(t_final, instance->time().value);
+  EXPECT_EQ(3, instance->number_of_members());
+  for (int m = 0; m < instance->number_of_members(); ++m) {
+    EXPECT_TRUE(instance->active(m));
+  }
+  // Six stages for each of the 80 steps.
+  EXPECT_EQ(80 * 6, evaluations_);
+
+  EXPECT_EQ(IndependentSolutions(integrator, step, t_final), solutions);
+}
+
+// A member which collides is masked out, and the other members are unaffected.
+TEST_F(EnsembleTest, Collision) {
+  auto const& integrator = SymplecticRungeKuttaNyströmIntegrator<
+      methods::McLachlanAtela1992Order5Optimal, Length>();
+  Time const step = 0.125 * Second;
+  Instant const t_final = t0_ + 10 * Second;
+  colliding_member_ = 0;
+  collision_position_ = -0.5 * Metre;
+  // The first member goes below |collision_position_| at this time.
+  Instant const t_collision = t0_ + 2 * π / 3 * Second;
+
+  std::vector<std::vector<ODE::SystemState>> solutions(
+      initial_states_.size());
+  auto const instance = integrator.NewEnsembleInstance(
+      problem_,
+      [&solutions](int const member, ODE::SystemState const& state) {
+        solutions[member].push_back(state);
+      },
+      step);
+  EXPECT_OK(instance->Solve(t_final));
+  EXPECT_FALSE(instance->active(0));
+  EXPECT_EQ(Error::OUT_OF_RANGE, instance->status(0).error());
+  EXPECT_TRUE(instance->active(1));
+  EXPECT_TRUE(instance->active(2));
+
+  // The collision is detected during the step that follows the last state of
+  // the first member.
+  Instant const last_time = solutions[0].back().time.value;
+  EXPECT_THAT(Abs(t_collision - last_time), Lt(step));
+
+  auto const independent_solutions =
+      IndependentSolutions(integrator, step, t_final);
+  EXPECT_EQ(independent_solutions[1], solutions[1]);
+  EXPECT_EQ(independent_solutions[2], solutions[2]);
+  EXPECT_TRUE(std::equal(solutions[0].begin(),
+                         solutions[0].end(),
+                         independent_solutions[0].begin()));
+}
+
+// A member which makes the step size vanish is masked out, and the other
+// members are integrated to the end.
+TEST_F(EnsembleTest, AdaptiveStep) {
+  auto const& integrator = EmbeddedExplicitRungeKuttaNyströmIntegrator<
+      methods::DormandالمكاوىPrince1986RKN434FM, Length>();
+  Instant const t_final = t0_ + 10 * Second;
+  Length const length_tolerance = 1e-9 * Metre;
+  Speed const speed_tolerance = 1e-9 * Metre / Second;
+  stiff_member_ = 1;
+  stiff_time_ = t0_ + 3 * Second;
+
+  std::vector<std::vector<ODE::SystemState>> solutions(
+      initial_states_.size());
+  auto const instance = integrator.NewEnsembleInstance(
+      problem_,
+      [&solutions](int const member, ODE::SystemState const& state) {
+        solutions[member].push_back(state);
+      },
+      [length_tolerance, speed_tolerance](
+          Time const& h, ODE::SystemStateError const& error) {
+        CHECK_EQ(1, error.position_error.size());
+        return std::min(length_tolerance / Abs(error.position_error[0]),
+                        speed_tolerance / Abs(error.velocity_error[0]));
+      },
+      AdaptiveStepSizeIntegrator<ODE>::Parameters(
+          /*first_time_step=*/t_final - t0_,
+          /*safety_factor=*/0.9));
+  EXPECT_OK(instance->Solve(t_final));
+  EXPECT_TRUE(instance->active(0));
+  EXPECT_FALSE(instance->active(1));
+  EXPECT_EQ(termination_condition::VanishingStepSize,
+            instance->status(1).error());
+  EXPECT_TRUE(instance->active(2));
+
+  EXPECT_THAT(Abs(solutions[1].back().time.value - stiff_time_),
+              Lt(1e-5 * Second));
+  for (int const m : {0, 2}) {
+    auto const& last_state = solutions[m].back();
+    EXPECT_EQ(t_final, last_state.time.value);
+    Length const amplitude = initial_states_[m].positions[0].value;
+    EXPECT_THAT(Abs(last_state.positions[0].value -
+                    amplitude * Cos((t_final - t0_) * Radian / Second)),
+                Lt(1e-7 * Metre));
+  }
+}
+
+}  // namespace internal_ensemble
+}  // namespace integrators
+}  // namespace principia
@@ -3,6 +3,8 @@
 
 #include <functional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/not_null.hpp"
 #include "base/status.hpp"
@@ -14,12 +16,23 @@
 
 namespace principia {
 namespace integrators {
+namespace internal_ensemble {
+
+template<typename ODE>
+class EnsembleInstance;
+template<typename ODE>
+struct EnsembleProblem;
+
+}  // namespace internal_ensemble
+
 namespace internal_integrators {
 
 using base::Error;
 using base::not_null;
 using base::Status;
 using geometry::Instant;
+using internal_ensemble::EnsembleInstance;
+using internal_ensemble::EnsembleProblem;
 using numerics::DoublePrecision;
 using quantities::Time;
 
@@ -30,6 +43,10 @@ class Integrator {
   using ODE = ODE_;
   using AppendState =
       std::function<void(typename ODE::SystemState const& state)>;
+  // Called with the state of the given |member| of an ensemble, see
+  // |EnsembleInstance|.
+  using EnsembleAppendState =
+      std::function<void(int member, typename ODE::SystemState const& state)>;
 
   // An object for holding the integrator state during the integration of a
   // problem.
@@ -108,6 +125,13 @@ class FixedStepSizeIntegrator : public Integrator<ODE_> {
               AppendState const& append_state,
               Time const& step) const = 0;
 
+  // Returns an instance that integrates the members of the |problem| in
+  // lockstep with this integrator.
+  not_null<std::unique_ptr<EnsembleInstance<ODE>>> NewEnsembleInstance(
+      EnsembleProblem<ODE> const& problem,
+      typename Integrator<ODE>::EnsembleAppendState const& append_state,
+      Time const& step) const;
+
   virtual void WriteToMessage(
       not_null<serialization::FixedStepSizeIntegrator*> message) const = 0;
   static FixedStepSizeIntegrator const& ReadFromMessage(
@@ -149,6 +173,66 @@ class AdaptiveStepSizeIntegrator : public Integrator<ODE_> {
       std::function<double(Time const& current_step_size,
                            typename ODE::SystemStateError const& error)>;
 
+  // A function of the state of the system whose changes of sign mark events,
+  // e.g., the radial velocity with respect to a body for the apsides, a
+  // coordinate for the nodes, or the distance to the surface of a body for a
+  // collision.  Only the sign and the zeros of the result matter, so it may be
+  // expressed in any unit.
+  using EventFunction = std::function<double(
+      Instant const& t,
+      std::vector<typename ODE::Position> const& positions,
+      std::vector<typename ODE::Velocity> const& velocities)>;
+  // Called with the index of the event function that changed sign and with the
+  // interpolated state of the system at the time of the event.
+  using AppendEvent =
+      std::function<void(int event, typename ODE::SystemState const& state)>;
+
+  class Instance;
+
+  // The continuous extension of a step accepted by an |Instance|, which
+  // approximates the solution at any time between the beginning and the end
+  // of the step.  It is the Hermite interpolant of the positions, velocities
+  // and accelerations at the ends of the step, which the embedded methods
+  // compute anyway.  The interpolant is quintic if the method is
+  // first-same-as-last.  Otherwise the acceleration at the end of the step is
+  // not known and it is quartic.  Its error is O(h⁶), respectively O(h⁵), so
+  // it is commensurate with the local error of a method of order 4.
+  class DenseOutput final {
+   public:
+    using Position = typename ODE::Position;
+    using Velocity = typename ODE::Velocity;
+    using Acceleration = typename ODE::Acceleration;
+
+    // The bounds of the step.  |t_end| is before |t_begin| when integrating
+    // backward.
+    Instant const& t_begin() const;
+    Instant const& t_end() const;
+
+    // Sets |positions| and |velocities|, which must have the dimension of the
+    // system, to the approximate solution at |t|, which must be between
+    // |t_begin()| and |t_end()|.  Does not allocate.
+    void Evaluate(Instant const& t,
+                  std::vector<Position>& positions,
+                  std::vector<Velocity>& velocities) const;
+
+   private:
+    Instant t_begin_;
+    Instant t_end_;
+    std::vector<Position> positions_begin_;
+    std::vector<Velocity> velocities_begin_;
+    std::vector<Acceleration> accelerations_begin_;
+    std::vector<Position> positions_end_;
+    std::vector<Velocity> velocities_end_;
+    std::vector<Acceleration> accelerations_end_;
+    bool has_accelerations_end_ = false;
+
+    friend class Instance;
+  };
+  // Called with the continuous extension of each accepted step.  The argument
+  // is only valid during the call.
+  using AppendDenseOutput =
+      std::function<void(DenseOutput const& dense_output)>;
+
   struct Parameters final {
     Parameters(Time first_time_step,
                double safety_factor,
@@ -195,16 +279,71 @@ class AdaptiveStepSizeIntegrator : public Integrator<ODE_> {
                     AppendState const& append_state,
                     ToleranceToErrorRatio const& tolerance_to_error_ratio);
 
+    // Locates the changes of sign of the |event_functions| during the steps
+    // accepted by the subsequent calls to |Solve|, in the same pass as the
+    // integration.  The events of a step are found on its |DenseOutput|, so an
+    // event function that changes sign twice within a step has no events
+    // there.  |append_event| is called for the events of a step in
+    // chronological order, before |append_state| is called for the end of the
+    // step.  The event functions are not serialized.
+    void SetEventFunctions(std::vector<EventFunction> const& event_functions,
+                           AppendEvent const& append_event);
+
+    // Passes the |DenseOutput| of each step accepted by the subsequent calls
+    // to |Solve| to |append_dense_output|, before the events of the step and
+    // the call to |append_state| for its end.  The functor is not serialized.
+    void SetDenseOutput(AppendDenseOutput const& append_dense_output);
+
    protected:
     Instance(IntegrationProblem<ODE> const& problem,
              AppendState const& append_state,
              ToleranceToErrorRatio const& tolerance_to_error_ratio,
              Parameters const& parameters);
 
+    // Must be called by |Solve| after each accepted step, once
+    // |current_state_| is at the end of the step but before it is appended.
+    // |accelerations_begin| are the accelerations at the beginning of the
+    // step, and |accelerations_end| those at its end, or null if the method
+    // did not compute them.  Does nothing unless there are event functions or
+    // a dense output functor.
+    void FinishStep(
+        std::vector<typename ODE::Acceleration> const& accelerations_begin,
+        std::vector<typename ODE::Acceleration> const* accelerations_end);
+
     ToleranceToErrorRatio const tolerance_to_error_ratio_;
     Parameters const parameters_;
     Time time_step_;
     bool first_use_ = true;
+
+   private:
+    using Position = typename ODE::Position;
+    using Velocity = typename ODE::Velocity;
+
+    // Records |current_state_| as the beginning of the next step in
+    // |dense_output_|.
+    void RecordStepBegin();
+
+    void DetectEvents();
+
+    std::vector<EventFunction> event_functions_;
+    AppendEvent append_event_;
+    AppendDenseOutput append_dense_output_;
+
+    // The continuous extension of the current step.  Only its beginning is
+    // meaningful between the steps.
+    DenseOutput dense_output_;
+
+    // The values of the event functions at the beginning and at the end of the
+    // current step.
+    std::vector<double> event_values_begin_;
+    std::vector<double> event_values_end_;
+
+    // Scratch storage for locating the events, so that the steps without
+    // events do not allocate.
+    std::vector<Position> event_positions_;
+    std::vector<Velocity> event_velocities_;
+    std::vector<std::pair<Instant, int>> located_events_;
+    typename ODE::SystemState event_state_;
   };
 
   // The factory function for |Instance|, above.  It ensures that the instance
@@ -215,6 +354,16 @@ class AdaptiveStepSizeIntegrator : public Integrator<ODE_> {
               ToleranceToErrorRatio const& tolerance_to_error_ratio,
               Parameters const& parameters) const = 0;
 
+  // Returns an instance that integrates the members of the |problem| in
+  // lockstep with this integrator.  |tolerance_to_error_ratio| is applied to
+  // each member, and a step is accepted if it is acceptable for all the members
+  // that have not terminated.
+  not_null<std::unique_ptr<EnsembleInstance<ODE>>> NewEnsembleInstance(
+      EnsembleProblem<ODE> const& problem,
+      typename Integrator<ODE>::EnsembleAppendState const& append_state,
+      ToleranceToErrorRatio const& tolerance_to_error_ratio,
+      Parameters const& parameters) const;
+
   virtual void WriteToMessage(
       not_null<serialization::AdaptiveStepSizeIntegrator*> message) const = 0;
   static AdaptiveStepSizeIntegrator const& ReadFromMessage(
@@ -3,16 +3,20 @@
 
 #include "integrators/integrators.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 #include <string>
 
 #include "base/macros.hpp"
+#include "geometry/sign.hpp"
 #include "integrators/embedded_explicit_generalized_runge_kutta_nyström_integrator.hpp"
 #include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
+#include "integrators/ensemble.hpp"
 #include "integrators/methods.hpp"
 #include "integrators/symmetric_linear_multistep_integrator.hpp"
 #include "integrators/symplectic_runge_kutta_nyström_integrator.hpp"
+#include "numerics/root_finders.hpp"
 
 #define PRINCIPIA_CASE_SLMS(kind, method)                      \
   case serialization::FixedStepSizeIntegrator::kind:           \
@@ -42,6 +46,10 @@ namespace principia {
 namespace integrators {
 namespace internal_integrators {
 
+using base::make_not_null_unique;
+using geometry::Sign;
+using numerics::Bisect;
+
 template<typename ODE, typename Method, bool first_same_as_last>
 struct SprkAsSrknDeserializer;
 
@@ -233,6 +241,16 @@ FixedStepSizeIntegrator<ODE_>::Instance::Instance(
   CHECK_NE(Time(), step_);
 }
 
+template<typename ODE_>
+not_null<std::unique_ptr<EnsembleInstance<ODE_>>>
+FixedStepSizeIntegrator<ODE_>::NewEnsembleInstance(
+    EnsembleProblem<ODE> const& problem,
+    typename Integrator<ODE>::EnsembleAppendState const& append_state,
+    Time const& step) const {
+  return make_not_null_unique<EnsembleInstance<ODE>>(
+      *this, problem, append_state, step);
+}
+
 template<typename ODE_>
 FixedStepSizeIntegrator<ODE_> const&
 FixedStepSizeIntegrator<ODE_>::ReadFromMessage(
@@ -374,6 +392,61 @@ AdaptiveStepSizeIntegrator<ODE_>::Parameters::ReadFromMessage(
   return result;
 }
 
+template<typename ODE_>
+Instant const& AdaptiveStepSizeIntegrator<ODE_>::DenseOutput::t_begin() const {
+  return t_begin_;
+}
+
+template<typename ODE_>
+Instant const& AdaptiveStepSizeIntegrator<ODE_>::DenseOutput::t_end() const {
+  return t_end_;
+}
+
+template<typename ODE_>
+void AdaptiveStepSizeIntegrator<ODE_>::DenseOutput::Evaluate(
+    Instant const& t,
+    std::vector<Position>& positions,
+    std::vector<Velocity>& velocities) const {
+  using Displacement = typename ODE::Displacement;
+  int const dimension = positions_begin_.size();
+  CHECK_EQ(dimension, positions.size());
+  CHECK_EQ(dimension, velocities.size());
+  Time const h = t_end_ - t_begin_;
+  double const θ = (t - t_begin_) / h;
+  for (int k = 0; k < dimension; ++k) {
+    Position const& q0 = positions_begin_[k];
+    // The interpolant is
+    //   q0 + h v0 θ + h² a0 / 2 θ² + c3 θ³ + c4 θ⁴ + c5 θ⁵,
+    // where the last three coefficients are determined by the position, the
+    // velocity and, if available, the acceleration at the end of the step.
+    // They solve a linear system whose right-hand sides are r, s and u.
+    Displacement const h_v0 = h * velocities_begin_[k];
+    Displacement const h²_a0_over_2 = 0.5 * h * h * accelerations_begin_[k];
+    Displacement const r = positions_end_[k] - q0 - h_v0 - h²_a0_over_2;
+    Displacement const s = h * velocities_end_[k] - h_v0 - 2.0 * h²_a0_over_2;
+    // On the quartic path |c5| must be zero, so value-initialize the
+    // coefficients: |Displacement| may be a built-in type.
+    Displacement c3{};
+    Displacement c4{};
+    Displacement c5{};
+    if (has_accelerations_end_) {
+      Displacement const u =
+          h * h * accelerations_end_[k] - 2.0 * h²_a0_over_2;
+      c5 = 0.5 * u + 6.0 * r - 3.0 * s;
+      c4 = 7.0 * s - 15.0 * r - u;
+      c3 = r - c4 - c5;
+    } else {
+      c4 = s - 3.0 * r;
+      c3 = 4.0 * r - s;
+    }
+    positions[k] =
+        q0 + ((((c5 * θ + c4) * θ + c3) * θ + h²_a0_over_2) * θ + h_v0) * θ;
+    velocities[k] = ((((5.0 * c5 * θ + 4.0 * c4) * θ + 3.0 * c3) * θ +
+                      2.0 * h²_a0_over_2) * θ +
+                     h_v0) / h;
+  }
+}
+
 template<typename ODE_>
 void AdaptiveStepSizeIntegrator<ODE_>::Instance::WriteToMessage(
     not_null<serialization::IntegratorInstance*> message) const {
@@ -427,6 +500,30 @@ AdaptiveStepSizeIntegrator<ODE_>::Instance::ReadFromMessage(
   return instance;
 }
 
+template<typename ODE_>
+void AdaptiveStepSizeIntegrator<ODE_>::Instance::SetEventFunctions(
+    std::vector<EventFunction> const& event_functions,
+    AppendEvent const& append_event) {
+  event_functions_ = event_functions;
+  append_event_ = append_event;
+  RecordStepBegin();
+  event_values_begin_.clear();
+  for (auto const& event_function : event_functions_) {
+    event_values_begin_.push_back(
+        event_function(dense_output_.t_begin_,
+                       dense_output_.positions_begin_,
+                       dense_output_.velocities_begin_));
+  }
+  event_values_end_.resize(event_functions_.size());
+}
+
+template<typename ODE_>
+void AdaptiveStepSizeIntegrator<ODE_>::Instance::SetDenseOutput(
+    AppendDenseOutput const& append_dense_output) {
+  append_dense_output_ = append_dense_output;
+  RecordStepBegin();
+}
+
 template<typename ODE_>
 AdaptiveStepSizeIntegrator<ODE_>::Instance::Instance(
     IntegrationProblem<ODE> const& problem,
@@ -442,6 +539,134 @@ AdaptiveStepSizeIntegrator<ODE_>::Instance::Instance(
   CHECK_LT(parameters.safety_factor, 1);
 }
 
+template<typename ODE_>
+void AdaptiveStepSizeIntegrator<ODE_>::Instance::FinishStep(
+    std::vector<typename ODE::Acceleration> const& accelerations_begin,
+    std::vector<typename ODE::Acceleration> const* const accelerations_end) {
+  if (event_functions_.empty() && append_dense_output_ == nullptr) {
+    return;
+  }
+  auto const& current_state = this->current_state_;
+  int const dimension = current_state.positions.size();
+  dense_output_.t_end_ = current_state.time.value;
+  dense_output_.positions_end_.resize(dimension);
+  dense_output_.velocities_end_.resize(dimension);
+  for (int k = 0; k < dimension; ++k) {
+    dense_output_.positions_end_[k] = current_state.positions[k].value;
+    dense_output_.velocities_end_[k] = current_state.velocities[k].value;
+  }
+  dense_output_.accelerations_begin_ = accelerations_begin;
+  dense_output_.has_accelerations_end_ = accelerations_end != nullptr;
+  if (accelerations_end != nullptr) {
+    dense_output_.accelerations_end_ = *accelerations_end;
+  }
+
+  if (append_dense_output_ != nullptr) {
+    append_dense_output_(dense_output_);
+  }
+  if (!event_functions_.empty()) {
+    DetectEvents();
+  }
+
+  // The end of this step is the beginning of the next one.
+  using std::swap;
+  dense_output_.t_begin_ = dense_output_.t_end_;
+  swap(dense_output_.positions_begin_, dense_output_.positions_end_);
+  swap(dense_output_.velocities_begin_, dense_output_.velocities_end_);
+}
+
+template<typename ODE_>
+void AdaptiveStepSizeIntegrator<ODE_>::Instance::RecordStepBegin() {
+  auto const& current_state = this->current_state_;
+  int const dimension = current_state.positions.size();
+  dense_output_.t_begin_ = current_state.time.value;
+  dense_output_.positions_begin_.resize(dimension);
+  dense_output_.velocities_begin_.resize(dimension);
+  for (int k = 0; k < dimension; ++k) {
+    dense_output_.positions_begin_[k] = current_state.positions[k].value;
+    dense_output_.velocities_begin_[k] = current_state.velocities[k].value;
+  }
+}
+
+template<typename ODE_>
+void AdaptiveStepSizeIntegrator<ODE_>::Instance::DetectEvents() {
+  Instant const& t_begin = dense_output_.t_begin();
+  Instant const& t_end = dense_output_.t_end();
+
+  // An event occurred during the step if the sign of its function differs at
+  // the ends of the step.
+  located_events_.clear();
+  for (int i = 0; i < event_functions_.size(); ++i) {
+    event_values_end_[i] = event_functions_[i](t_end,
+                                               dense_output_.positions_end_,
+                                               dense_output_.velocities_end_);
+    if (Sign(event_values_end_[i]) != Sign(event_values_begin_[i])) {
+      located_events_.emplace_back(t_begin, i);
+    }
+  }
+
+  if (!located_events_.empty()) {
+    int const dimension = dense_output_.positions_end_.size();
+    event_positions_.resize(dimension);
+    event_velocities_.resize(dimension);
+
+    // Find the zero of each event function that changed sign.  The values at
+    // the ends of the step are those of the actual states, so that the
+    // bisection sees the same change of sign.
+    for (auto& located_event : located_events_) {
+      int const i = located_event.second;
+      located_event.first = Bisect(
+          [this, i, &t_begin, &t_end](Instant const& t) {
+            if (t == t_begin) {
+              return event_values_begin_[i];
+            } else if (t == t_end) {
+              return event_values_end_[i];
+            }
+            dense_output_.Evaluate(t, event_positions_, event_velocities_);
+            return event_functions_[i](t, event_positions_, event_velocities_);
+          },
+          t_begin,
+          t_end);
+    }
+    Sign const integration_direction = Sign(t_end - t_begin);
+    std::stable_sort(
+        located_events_.begin(),
+        located_events_.end(),
+        [integration_direction](std::pair<Instant, int> const& left,
+                                std::pair<Instant, int> const& right) {
+          return integration_direction * (left.first - right.first) < Time();
+        });
+
+    event_state_.positions.resize(dimension);
+    event_state_.velocities.resize(dimension);
+    for (auto const& [event_time, i] : located_events_) {
+      dense_output_.Evaluate(event_time, event_positions_, event_velocities_);
+      event_state_.time = DoublePrecision<Instant>(event_time);
+      for (int k = 0; k < dimension; ++k) {
+        event_state_.positions[k] =
+            DoublePrecision<Position>(event_positions_[k]);
+        event_state_.velocities[k] =
+            DoublePrecision<Velocity>(event_velocities_[k]);
+      }
+      append_event_(i, event_state_);
+    }
+  }
+
+  using std::swap;
+  swap(event_values_begin_, event_values_end_);
+}
+
+template<typename ODE_>
+not_null<std::unique_ptr<EnsembleInstance<ODE_>>>
+AdaptiveStepSizeIntegrator<ODE_>::NewEnsembleInstance(
+    EnsembleProblem<ODE> const& problem,
+    typename Integrator<ODE>::EnsembleAppendState const& append_state,
+    ToleranceToErrorRatio const& tolerance_to_error_ratio,
+    Parameters const& parameters) const {
+  return make_not_null_unique<EnsembleInstance<ODE>>(
+      *this, problem, append_state, tolerance_to_error_ratio, parameters);
+}
+
 template<typename ODE_>
 AdaptiveStepSizeIntegrator<ODE_> const&
 AdaptiveStepSizeIntegrator<ODE_>::ReadFromMessage(
@@ -9,7 +9,7 @@
 #ifndef PRINCIPIA_INTEGRATORS_SYMMETRIC_LINEAR_MULTISTEP_INTEGRATOR_HPP_
 #define PRINCIPIA_INTEGRATORS_SYMMETRIC_LINEAR_MULTISTEP_INTEGRATOR_HPP_
 
-#include <list>
+#include <array>
 #include <vector>
 
 #include "base/status.hpp"
@@ -50,20 +50,57 @@ class SymmetricLinearMultistepIntegrator
         not_null<serialization::IntegratorInstance*> message) const override;
 
    private:
-    // The data for a previous step of the integration.  The |Displacement|s
-    // here are really |Position|s, but we do complex computations on them and
-    // it would be very inconvenient to cast these computations as barycentres.
-    struct Step final {
-      std::vector<DoublePrecision<typename ODE::Displacement>> displacements;
-      std::vector<typename ODE::Acceleration> accelerations;
-      DoublePrecision<Instant> time;
+    // The data for the previous steps of the integration, at most |order| of
+    // them, in a ring buffer.  The |Displacement|s here are really |Position|s,
+    // but we do complex computations on them and it would be very inconvenient
+    // to cast these computations as barycentres.  The displacements of all the
+    // steps are stored in a single array, one step after the other, and so are
+    // the accelerations, so that the sums over the steps in |Solve| are strided
+    // loops over contiguous memory.  A step is designated by its index, from 0
+    // for the oldest to |size() - 1| for the most recent.
+    class PreviousSteps final {
+     public:
+      using Displacement = typename ODE::Displacement;
+      using Acceleration = typename ODE::Acceleration;
+
+      explicit PreviousSteps(int dimension);
+
+      int dimension() const;
+      int size() const;
+
+      // Adds a step at the given |time| after the most recent one, discarding
+      // the oldest step if there are already |order| of them.  The
+      // displacements and the accelerations of the new step must be set by the
+      // caller.
+      void Push(DoublePrecision<Instant> const& time);
+
+      DoublePrecision<Instant> const& time(int step) const;
+      // The |dimension()| displacements of the given |step|.
+      DoublePrecision<Displacement>* displacements(int step);
+      DoublePrecision<Displacement> const* displacements(int step) const;
+      // The |dimension()| accelerations of the given |step|.
+      Acceleration* accelerations(int step);
+      Acceleration const* accelerations(int step) const;
 
       void WriteToMessage(
-          not_null<serialization::SymmetricLinearMultistepIntegratorInstance::
-                       Step*> const message) const;
-      static Step ReadFromMessage(
-          serialization::SymmetricLinearMultistepIntegratorInstance::Step const&
-              message);
+          not_null<serialization::SymmetricLinearMultistepIntegratorInstance*>
+              message) const;
+      static PreviousSteps ReadFromMessage(
+          serialization::SymmetricLinearMultistepIntegratorInstance const&
+              message,
+          int dimension);
+
+     private:
+      // The index in the arrays of the storage for the given |step|.
+      int Slot(int step) const;
+
+      int dimension_;
+      int size_ = 0;
+      // The slot of the oldest step.
+      int first_ = 0;
+      std::array<DoublePrecision<Instant>, order> times_;
+      std::vector<DoublePrecision<Displacement>> displacements_;
+      std::vector<Acceleration> accelerations_;
     };
 
     Instance(IntegrationProblem<ODE> const& problem,
@@ -76,7 +113,7 @@ class SymmetricLinearMultistepIntegrator
              AppendState const& append_state,
              Time const& step,
              int startup_step_index,
-             std::list<Step> const& previous_steps,
+             PreviousSteps const& previous_steps,
              SymmetricLinearMultistepIntegrator const& integrator);
 
     // Performs the startup integration, i.e., computes enough states to either
@@ -89,13 +126,22 @@ class SymmetricLinearMultistepIntegrator
     // method based on the accelerations computed by the main integrator.
     void ComputeVelocityUsingCohenHubbardOesterwinter();
 
+    // Adds to |previous_steps| a step for the given |state|.
     static void FillStepFromSystemState(ODE const& equation,
                                         typename ODE::SystemState const& state,
-                                        Step& step);
+                                        PreviousSteps& previous_steps);
 
     int startup_step_index_ = 0;
-    std::list<Step> previous_steps_;  // At most |order_| elements.
+    PreviousSteps previous_steps_;
     SymmetricLinearMultistepIntegrator const& integrator_;
+
+    // Scratch storage for |Solve|, sized at construction so that the steps do
+    // not allocate.
+    std::vector<Position> positions_;
+    std::vector<typename ODE::Acceleration> accelerations_;
+    std::vector<DoublePrecision<typename ODE::Displacement>> Σj_minus_ɑj_qj_;
+    std::vector<typename ODE::Acceleration> Σj_βj_numerator_aj_;
+
     friend class SymmetricLinearMultistepIntegrator;
   };
 
@@ -4,7 +4,6 @@
 #include "integrators/symmetric_linear_multistep_integrator.hpp"
 
 #include <algorithm>
-#include <list>
 #include <vector>
 
 #include "geometry/serialization.hpp"
@@ -28,6 +27,7 @@ Status SymmetricLinearMultistepIntegrator<Method, Position>::Instance::Solve(
   using DoubleDisplacement = DoublePrecision<Displacement>;
   using DoubleDisplacements = std::vector<DoubleDisplacement>;
   using DoublePosition = DoublePrecision<Position>;
+  auto& previous_steps = previous_steps_;
 
   auto const& ɑ = integrator_.ɑ_;
   auto const& β_numerator = integrator_.β_numerator_;
@@ -38,57 +38,58 @@ Status SymmetricLinearMultistepIntegrator<Method, Position>::Instance::Solve(
   auto const& step = this->step_;
   auto const& equation = this->equation_;
 
-  if (previous_steps_.size() < order) {
+  if (previous_steps.size() < order) {
     StartupSolve(t_final);
 
     // If |t_final| is not large enough, we may not have generated enough
     // points.  Bail out, we'll continue the next time |Solve| is called.
-    if (previous_steps_.size() < order) {
+    if (previous_steps.size() < order) {
       return Status::OK;
     }
   }
-  CHECK_EQ(previous_steps_.size(), order);
+  CHECK_EQ(previous_steps.size(), order);
 
   // Argument checks.
-  int const dimension = previous_steps_.back().displacements.size();
+  int const dimension = previous_steps.dimension();
 
   // Time step.
   CHECK_LT(Time(), step);
   Time const& h = step;
-  // Current time.
-  DoublePrecision<Instant> t = previous_steps_.back().time;
   // Order.
   int const k = order;
+  // Current time.
+  DoublePrecision<Instant> t = previous_steps.time(k - 1);
 
   Status status;
-  std::vector<Position> positions(dimension);
+  std::vector<Position>& positions = positions_;
+
+  std::vector<Acceleration>& accelerations = accelerations_;
 
-  DoubleDisplacements Σj_minus_ɑj_qj(dimension);
-  std::vector<Acceleration> Σj_βj_numerator_aj(dimension);
+  DoubleDisplacements& Σj_minus_ɑj_qj = Σj_minus_ɑj_qj_;
+  std::vector<Acceleration>& Σj_βj_numerator_aj = Σj_βj_numerator_aj_;
   while (h <= (t_final - t.value) - t.error) {
-    // We take advantage of the symmetry to iterate on the list of previous
-    // steps from both ends.
-    auto front_it = previous_steps_.begin();
-    auto back_it = previous_steps_.rbegin();
+    // We take advantage of the symmetry to iterate on the previous steps from
+    // both ends.  The step j is the (j + 1)-th oldest.
 
     // This block corresponds to j = 0.  We must not pair it with j = k.
     {
-      DoubleDisplacements const& qj = front_it->displacements;
-      std::vector<Acceleration> const& aj = front_it->accelerations;
+      DoubleDisplacement const* const qj = previous_steps.displacements(0);
+      Acceleration const* const aj = previous_steps.accelerations(0);
       double const ɑj = ɑ[0];
       double const βj_numerator = β_numerator[0];
       for (int d = 0; d < dimension; ++d) {
         Σj_minus_ɑj_qj[d] = Scale(-ɑj, qj[d]);
         Σj_βj_numerator_aj[d] = βj_numerator * aj[d];
       }
-      ++front_it;
     }
     // The generic value of j, paired with k - j.
     for (int j = 1; j < k / 2; ++j) {
-      DoubleDisplacements const& qj = front_it->displacements;
-      DoubleDisplacements const& qk_minus_j = back_it->displacements;
-      std::vector<Acceleration> const& aj = front_it->accelerations;
-      std::vector<Acceleration> const& ak_minus_j = back_it->accelerations;
+      DoubleDisplacement const* const qj = previous_steps.displacements(j);
+      DoubleDisplacement const* const qk_minus_j =
+          previous_steps.displacements(k - j);
+      Acceleration const* const aj = previous_steps.accelerations(j);
+      Acceleration const* const ak_minus_j =
+          previous_steps.accelerations(k - j);
       double const ɑj = ɑ[j];
       double const βj_numerator = β_numerator[j];
       for (int d = 0; d < dimension; ++d) {
@@ -96,13 +97,11 @@ Status SymmetricLinearMultistepIntegrator<Method, Position>::Instance::Solve(
         Σj_minus_ɑj_qj[d] -= Scale(ɑj, qk_minus_j[d]);
         Σj_βj_numerator_aj[d] += βj_numerator * (aj[d] + ak_minus_j[d]);
       }
-      ++front_it;
-      ++back_it;
     }
     // This block corresponds to j = k / 2.  We must not pair it with j = k / 2.
     {
-      DoubleDisplacements const& qj = front_it->displacements;
-      std::vector<Acceleration> const& aj = front_it->accelerations;
+      DoubleDisplacement const* const qj = previous_steps.displacements(k / 2);
+      Acceleration const* const aj = previous_steps.accelerations(k / 2);
       double const ɑj = ɑ[k / 2];
       double const βj_numerator = β_numerator[k / 2];
       for (int d = 0; d < dimension; ++d) {
@@ -111,13 +110,12 @@ Status SymmetricLinearMultistepIntegrator<Method, Position>::Instance::Solve(
       }
     }
 
-    // Create a new step in the instance.
+    // Create a new step in the instance.  It overwrites the oldest step,
+    // which is no longer needed.
     t.Increment(h);
-    previous_steps_.emplace_back();
-    Step& current_step = previous_steps_.back();
-    current_step.time = t;
-    current_step.accelerations.resize(dimension);
-    current_step.displacements.reserve(dimension);
+    previous_steps.Push(t);
+    DoubleDisplacement* const current_displacements =
+        previous_steps.displacements(k - 1);
 
     // Fill the new step.  We skip the division by ɑk as it is equal to 1.0.
     double const ɑk = ɑ[0];
@@ -126,16 +124,17 @@ Status SymmetricLinearMultistepIntegrator<Method, Position>::Instance::Solve(
       DoubleDisplacement& current_displacement = Σj_minus_ɑj_qj[d];
       current_displacement.Increment(h * h *
                                      Σj_βj_numerator_aj[d] / β_denominator);
-      current_step.displacements.push_back(current_displacement);
+      current_displacements[d] = current_displacement;
       DoublePosition const current_position =
           DoublePosition() + current_displacement;
       positions[d] = current_position.value;
       current_state.positions[d] = current_position;
     }
-    status.Update(equation.compute_acceleration(t.value,
-                                                positions,
-                                                current_step.accelerations));
-    previous_steps_.pop_front();
+    status.Update(
+        equation.compute_acceleration(t.value, positions, accelerations));
+    std::copy(accelerations.cbegin(),
+              accelerations.cend(),
+              previous_steps.accelerations(k - 1));
 
     ComputeVelocityUsingCohenHubbardOesterwinter();
 
@@ -173,53 +172,135 @@ Instance::WriteToMessage(
           ->MutableExtension(
               serialization::SymmetricLinearMultistepIntegratorInstance::
                   extension);
-  for (auto const& previous_step : previous_steps_) {
-    previous_step.WriteToMessage(extension->add_previous_steps());
-  }
+  previous_steps_.WriteToMessage(extension);
   extension->set_startup_step_index(startup_step_index_);
 }
 
 template<typename Method, typename Position>
-void SymmetricLinearMultistepIntegrator<Method, Position>::Instance::Step::
-    WriteToMessage(
-        not_null<serialization::SymmetricLinearMultistepIntegratorInstance::
-                     Step*> const message) const {
+SymmetricLinearMultistepIntegrator<Method, Position>::Instance::PreviousSteps::
+PreviousSteps(int const dimension)
+    : dimension_(dimension),
+      displacements_(order * dimension),
+      accelerations_(order * dimension) {}
+
+template<typename Method, typename Position>
+int SymmetricLinearMultistepIntegrator<Method, Position>::Instance::
+PreviousSteps::dimension() const {
+  return dimension_;
+}
+
+template<typename Method, typename Position>
+int SymmetricLinearMultistepIntegrator<Method, Position>::Instance::
+PreviousSteps::size() const {
+  return size_;
+}
+
+template<typename Method, typename Position>
+void SymmetricLinearMultistepIntegrator<Method, Position>::Instance::
+PreviousSteps::Push(DoublePrecision<Instant> const& time) {
+  if (size_ < order) {
+    ++size_;
+  } else {
+    first_ = Slot(1);
+  }
+  times_[Slot(size_ - 1)] = time;
+}
+
+template<typename Method, typename Position>
+DoublePrecision<Instant> const&
+SymmetricLinearMultistepIntegrator<Method, Position>::Instance::PreviousSteps::
+time(int const step) const {
+  return times_[Slot(step)];
+}
+
+template<typename Method, typename Position>
+auto SymmetricLinearMultistepIntegrator<Method, Position>::Instance::
+PreviousSteps::displacements(int const step) -> DoublePrecision<Displacement>* {
+  return &displacements_[Slot(step) * dimension_];
+}
+
+template<typename Method, typename Position>
+auto SymmetricLinearMultistepIntegrator<Method, Position>::Instance::
+PreviousSteps::displacements(int const step) const
+    -> DoublePrecision<Displacement> const* {
+  return &displacements_[Slot(step) * dimension_];
+}
+
+template<typename Method, typename Position>
+auto SymmetricLinearMultistepIntegrator<Method, Position>::Instance::
+PreviousSteps::accelerations(int const step) -> Acceleration* {
+  return &accelerations_[Slot(step) * dimension_];
+}
+
+template<typename Method, typename Position>
+auto SymmetricLinearMultistepIntegrator<Method, Position>::Instance::
+PreviousSteps::accelerations(int const step) const -> Acceleration const* {
+  return &accelerations_[Slot(step) * dimension_];
+}
+
+template<typename Method, typename Position>
+void SymmetricLinearMultistepIntegrator<Method, Position>::Instance::
+PreviousSteps::WriteToMessage(
+    not_null<serialization::SymmetricLinearMultistepIntegratorInstance*> const
+        message) const {
   using AccelerationSerializer = QuantityOrMultivectorSerializer<
-      typename ODE::Acceleration,
+      Acceleration,
       serialization::SymmetricLinearMultistepIntegratorInstance::Step::
           Acceleration>;
-  for (auto const& displacement : displacements) {
-    displacement.WriteToMessage(message->add_displacements());
-  }
-  for (auto const& acceleration : accelerations) {
-    AccelerationSerializer::WriteToMessage(acceleration,
-                                           message->add_accelerations());
+  for (int step = 0; step < size_; ++step) {
+    auto* const previous_step = message->add_previous_steps();
+    DoublePrecision<Displacement> const* const step_displacements =
+        displacements(step);
+    Acceleration const* const step_accelerations = accelerations(step);
+    for (int d = 0; d < dimension_; ++d) {
+      step_displacements[d].WriteToMessage(
+          previous_step->add_displacements());
+    }
+    for (int d = 0; d < dimension_; ++d) {
+      AccelerationSerializer::WriteToMessage(
+          step_accelerations[d], previous_step->add_accelerations());
+    }
+    time(step).WriteToMessage(previous_step->mutable_time());
   }
-  time.WriteToMessage(message->mutable_time());
 }
 
 template<typename Method, typename Position>
-typename SymmetricLinearMultistepIntegrator<Method, Position>::Instance::Step
-SymmetricLinearMultistepIntegrator<Method, Position>::Instance::Step::
-    ReadFromMessage(
-        serialization::SymmetricLinearMultistepIntegratorInstance::Step const&
-            message) {
+auto SymmetricLinearMultistepIntegrator<Method, Position>::Instance::
+PreviousSteps::ReadFromMessage(
+    serialization::SymmetricLinearMultistepIntegratorInstance const& message,
+    int const dimension) -> PreviousSteps {
   using AccelerationSerializer = QuantityOrMultivectorSerializer<
-      typename ODE::Acceleration,
+      Acceleration,
       serialization::SymmetricLinearMultistepIntegratorInstance::Step::
           Acceleration>;
-  Step step;
-  for (auto const& displacement : message.displacements()) {
-    step.displacements.push_back(
-        DoublePrecision<typename ODE::Displacement>::ReadFromMessage(
-            displacement));
-  }
-  for (auto const& acceleration : message.accelerations()) {
-    step.accelerations.push_back(
-        AccelerationSerializer::ReadFromMessage(acceleration));
+  PreviousSteps previous_steps(dimension);
+  CHECK_LE(message.previous_steps_size(), order);
+  for (auto const& previous_step : message.previous_steps()) {
+    CHECK_EQ(dimension, previous_step.displacements_size());
+    CHECK_EQ(dimension, previous_step.accelerations_size());
+    previous_steps.Push(
+        DoublePrecision<Instant>::ReadFromMessage(previous_step.time()));
+    int const step = previous_steps.size() - 1;
+    DoublePrecision<Displacement>* const step_displacements =
+        previous_steps.displacements(step);
+    Acceleration* const step_accelerations =
+        previous_steps.accelerations(step);
+    for (int d = 0; d < dimension; ++d) {
+      step_displacements[d] =
+          DoublePrecision<Displacement>::ReadFromMessage(
+              previous_step.displacements(d));
+      step_accelerations[d] = AccelerationSerializer::ReadFromMessage(
+          previous_step.accelerations(d));
+    }
   }
-  step.time = DoublePrecision<Instant>::ReadFromMessage(message.time());
-  return step;
+  return previous_steps;
+}
+
+template<typename Method, typename Position>
+int SymmetricLinearMultistepIntegrator<Method, Position>::Instance::
+PreviousSteps::Slot(int const step) const {
+  int const slot = first_ + step;
+  return slot < order ? slot : slot - order;
 }
 
 template<typename Method, typename Position>
@@ -229,11 +310,15 @@ SymmetricLinearMultistepIntegrator<Method, Position>::Instance::Instance(
     Time const& step,
     SymmetricLinearMultistepIntegrator const& integrator)
     : FixedStepSizeIntegrator<ODE>::Instance(problem, append_state, step),
-      integrator_(integrator) {
-  previous_steps_.emplace_back();
+      previous_steps_(problem.initial_state.positions.size()),
+      integrator_(integrator),
+      positions_(problem.initial_state.positions.size()),
+      accelerations_(problem.initial_state.positions.size()),
+      Σj_minus_ɑj_qj_(problem.initial_state.positions.size()),
+      Σj_βj_numerator_aj_(problem.initial_state.positions.size()) {
   FillStepFromSystemState(this->equation_,
                           this->current_state_,
-                          this->previous_steps_.back());
+                          previous_steps_);
 }
 
 template<typename Method, typename Position>
@@ -242,12 +327,16 @@ SymmetricLinearMultistepIntegrator<Method, Position>::Instance::Instance(
     AppendState const& append_state,
     Time const& step,
     int const startup_step_index,
-    std::list<Step> const& previous_steps,
+    PreviousSteps const& previous_steps,
     SymmetricLinearMultistepIntegrator const& integrator)
     : FixedStepSizeIntegrator<ODE>::Instance(problem, append_state, step),
       startup_step_index_(startup_step_index),
       previous_steps_(previous_steps),
-      integrator_(integrator) {}
+      integrator_(integrator),
+      positions_(problem.initial_state.positions.size()),
+      accelerations_(problem.initial_state.positions.size()),
+      Σj_minus_ɑj_qj_(problem.initial_state.positions.size()),
+      Σj_βj_numerator_aj_(problem.initial_state.positions.size()) {}
 
 template<typename Method, typename Position>
 void SymmetricLinearMultistepIntegrator<Method, Position>::
@@ -258,7 +347,7 @@ Instance::StartupSolve(Instant const& t_final) {
 
   Time const startup_step = step / startup_step_divisor;
 
-  CHECK(!previous_steps_.empty());
+  CHECK_LT(0, previous_steps_.size());
   CHECK_LT(previous_steps_.size(), order);
 
   auto const startup_append_state =
@@ -272,10 +361,9 @@ Instance::StartupSolve(Instant const& t_final) {
           // main integrator step.
           if (++startup_step_index_ % startup_step_divisor == 0) {
             CHECK_LT(previous_steps_.size(), order);
-            previous_steps_.emplace_back();
             FillStepFromSystemState(this->equation_,
                                     this->current_state_,
-                                    previous_steps_.back());
+                                    previous_steps_);
             // This call must happen last for a subtle reason: the callback may
             // want to |Clone| this instance (see |Ephemeris::Checkpoint|) in
             // which cases it is necessary that all the member variables be
@@ -313,25 +401,26 @@ Instance::ComputeVelocityUsingCohenHubbardOesterwinter() {
   auto const& cohen_hubbard_oesterwinter =
       integrator_.cohen_hubbard_oesterwinter_;
 
-  int const dimension = previous_steps_.back().displacements.size();
+  int const dimension = previous_steps_.dimension();
+  int const last = previous_steps_.size() - 1;
   auto& current_state = this->current_state_;
   auto const& step = this->step_;
 
   current_state.velocities.reserve(dimension);
   for (int d = 0; d < dimension; ++d) {
     DoublePrecision<Velocity>& velocity = current_state.velocities[d];
-    auto it = previous_steps_.rbegin();
 
     // Compute the displacement difference using double precision.
     DoublePrecision<Displacement> displacement_change =
-        it->displacements[d] - std::next(it)->displacements[d];
+        previous_steps_.displacements(last)[d] -
+        previous_steps_.displacements(last - 1)[d];
     velocity = DoublePrecision<Velocity>(
         (displacement_change.value + displacement_change.error) / step);
 
     Acceleration weighted_accelerations;
-    for (int i = 0; i < cohen_hubbard_oesterwinter.numerators.size; ++i, ++it) {
-      weighted_accelerations +=
-          cohen_hubbard_oesterwinter.numerators[i] * it->accelerations[d];
+    for (int i = 0; i < cohen_hubbard_oesterwinter.numerators.size; ++i) {
+      weighted_accelerations += cohen_hubbard_oesterwinter.numerators[i] *
+                                previous_steps_.accelerations(last - i)[d];
     }
 
     velocity.value +=
@@ -343,19 +432,26 @@ template<typename Method, typename Position>
 void SymmetricLinearMultistepIntegrator<Method, Position>::
 Instance::FillStepFromSystemState(ODE const& equation,
                                   typename ODE::SystemState const& state,
-                                  Step& step) {
-  std::vector<typename ODE::Position> positions;
-  step.time = state.time;
-  for (auto const& position : state.positions) {
-    step.displacements.push_back(position - DoublePrecision<Position>());
-    positions.push_back(position.value);
+                                  PreviousSteps& previous_steps) {
+  int const dimension = previous_steps.dimension();
+  CHECK_EQ(dimension, state.positions.size());
+  previous_steps.Push(state.time);
+  int const step = previous_steps.size() - 1;
+  DoublePrecision<typename ODE::Displacement>* const displacements =
+      previous_steps.displacements(step);
+  std::vector<typename ODE::Position> positions(dimension);
+  std::vector<typename ODE::Acceleration> accelerations(dimension);
+  for (int d = 0; d < dimension; ++d) {
+    DoublePrecision<Position> const& position = state.positions[d];
+    displacements[d] = position - DoublePrecision<Position>();
+    positions[d] = position.value;
   }
-  step.accelerations.resize(step.displacements.size());
   // Ignore the status here.  We are merely computing the acceleration to store
   // it, not to advance an integrator.
-  equation.compute_acceleration(step.time.value,
-                                positions,
-                                step.accelerations);
+  equation.compute_acceleration(state.time.value, positions, accelerations);
+  std::copy(accelerations.cbegin(),
+            accelerations.cend(),
+            previous_steps.accelerations(step));
 }
 
 template<typename Method, typename Position>
@@ -402,16 +498,13 @@ SymmetricLinearMultistepIntegrator<Method, Position>::ReadFromMessage(
   auto const& extension = message.GetExtension(
       serialization::SymmetricLinearMultistepIntegratorInstance::extension);
 
-  std::list<typename Instance::Step> previous_steps;
-  for (auto const& previous_step : extension.previous_steps()) {
-    previous_steps.push_back(Instance::Step::ReadFromMessage(previous_step));
-  }
   return std::unique_ptr<typename Integrator<ODE>::Instance>(
       new Instance(problem,
                    append_state,
                    step,
                    extension.startup_step_index(),
-                   previous_steps,
+                   Instance::PreviousSteps::ReadFromMessage(
+                       extension, problem.initial_state.positions.size()),
                    *this));
 }
 
@@ -9,6 +9,8 @@
 #ifndef PRINCIPIA_INTEGRATORS_SYMPLECTIC_RUNGE_KUTTA_NYSTRÖM_INTEGRATOR_HPP_
 #define PRINCIPIA_INTEGRATORS_SYMPLECTIC_RUNGE_KUTTA_NYSTRÖM_INTEGRATOR_HPP_
 
+#include <vector>
+
 #include "base/status.hpp"
 #include "integrators/methods.hpp"
 #include "integrators/ordinary_differential_equations.hpp"
@@ -96,6 +98,14 @@ class SymplecticRungeKuttaNyströmIntegrator
              SymplecticRungeKuttaNyströmIntegrator const& integrator);
 
     SymplecticRungeKuttaNyströmIntegrator const& integrator_;
+
+    // Scratch storage for |Solve|, sized at construction so that the steps do
+    // not allocate.
+    std::vector<typename ODE::Displacement> Δq_;
+    std::vector<typename ODE::Velocity> Δv_;
+    std::vector<Position> q_stage_;
+    std::vector<typename ODE::Acceleration> g_;
+
     friend class SymplecticRungeKuttaNyströmIntegrator;
   };
 
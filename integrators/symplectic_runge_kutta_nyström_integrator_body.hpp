@@ -59,9 +59,9 @@ Instance::Solve(Instant const& t_final) {
   DoublePrecision<Instant>& t = current_state.time;
 
   // Position increment.
-  std::vector<Displacement> Δq(dimension);
+  std::vector<Displacement>& Δq = Δq_;
   // Velocity increment.
-  std::vector<Velocity> Δv(dimension);
+  std::vector<Velocity>& Δv = Δv_;
   // Current position.  This is a non-const reference whose purpose is to make
   // the equations more readable.
   std::vector<DoublePrecision<Position>>& q = current_state.positions;
@@ -70,9 +70,9 @@ Instance::Solve(Instant const& t_final) {
   std::vector<DoublePrecision<Velocity>>& v = current_state.velocities;
 
   // Current Runge-Kutta-Nyström stage.
-  std::vector<Position> q_stage(dimension);
+  std::vector<Position>& q_stage = q_stage_;
   // Accelerations at the current stage.
-  std::vector<Acceleration> g(dimension);
+  std::vector<Acceleration>& g = g_;
 
   // The first full stage of the step, i.e. the first stage where
   // exp(bᵢ h B) exp(aᵢ h A) must be entirely computed.
@@ -174,7 +174,11 @@ Instance::Instance(IntegrationProblem<ODE> const& problem,
     : FixedStepSizeIntegrator<ODE>::Instance(problem,
                                              std::move(append_state),
                                              step),
-      integrator_(integrator) {}
+      integrator_(integrator),
+      Δq_(problem.initial_state.positions.size()),
+      Δv_(problem.initial_state.positions.size()),
+      q_stage_(problem.initial_state.positions.size()),
+      g_(problem.initial_state.positions.size()) {}
 
 template<typename Method, typename Position>
 SymplecticRungeKuttaNyströmIntegrator<Method, Position>::
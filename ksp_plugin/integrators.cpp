@@ -23,6 +23,7 @@ using integrators::methods::BlanesMoan2002SRKN14A;
 using integrators::methods::Fine1987RKNG34;
 using integrators::methods::DormandالمكاوىPrince1986RKN434FM;
 using integrators::methods::Quinlan1999Order8A;
+using quantities::si::Day;
 using quantities::si::Minute;
 using quantities::si::Second;
 
@@ -41,6 +42,10 @@ DefaultEphemerisFixedStepParameters() {
       /*step=*/35 * Minute);
 }
 
+Time DefaultEphemerisBackgroundProlongationHorizon() {
+  return 1 * Day;
+}
+
 Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters
 DefaultBurnParameters() {
   return Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters(
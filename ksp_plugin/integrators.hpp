@@ -11,6 +11,7 @@ namespace internal_integrators {
 
 using physics::Ephemeris;
 using quantities::Length;
+using quantities::Time;
 using quantities::si::Metre;
 using quantities::si::Milli;
 
@@ -19,6 +20,9 @@ Ephemeris<Barycentric>::AccuracyParameters
 DefaultEphemerisAccuracyParameters();
 Ephemeris<Barycentric>::FixedStepParameters
 DefaultEphemerisFixedStepParameters();
+// How far ahead of the current time the ephemeris is prolonged in the
+// background.
+Time DefaultEphemerisBackgroundProlongationHorizon();
 Ephemeris<Barycentric>::GeneralizedAdaptiveStepParameters
 DefaultBurnParameters();
 Ephemeris<Barycentric>::FixedStepParameters DefaultHistoryParameters();
@@ -29,6 +33,7 @@ Ephemeris<Barycentric>::AdaptiveStepParameters DefaultPsychohistoryParameters();
 
 using internal_integrators::DefaultBurnParameters;
 using internal_integrators::DefaultEphemerisAccuracyParameters;
+using internal_integrators::DefaultEphemerisBackgroundProlongationHorizon;
 using internal_integrators::DefaultEphemerisFixedStepParameters;
 using internal_integrators::DefaultHistoryParameters;
 using internal_integrators::DefaultPredictionParameters;
@@ -123,6 +123,24 @@ void Part::AppendToPsychohistory(
   psychohistory_->Append(time, degrees_of_freedom);
 }
 
+void Part::AppendToHistory(
+    std::vector<std::pair<Instant, DegreesOfFreedom<Barycentric>>> const&
+        points) {
+  if (psychohistory_ != nullptr) {
+    history_->DeleteFork(psychohistory_);
+  }
+  history_->Append(points);
+}
+
+void Part::AppendToPsychohistory(
+    std::vector<std::pair<Instant, DegreesOfFreedom<Barycentric>>> const&
+        points) {
+  if (psychohistory_ == nullptr) {
+    psychohistory_ = history_->NewForkAtLast();
+  }
+  psychohistory_->Append(points);
+}
+
 void Part::ClearHistory() {
   if (psychohistory_ != nullptr) {
     history_->DeleteFork(psychohistory_);
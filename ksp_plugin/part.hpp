@@ -6,6 +6,8 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/disjoint_sets.hpp"
 #include "ksp_plugin/frames.hpp"
@@ -89,6 +91,14 @@ class Part final {
       Instant const& time,
       DegreesOfFreedom<Barycentric> const& degrees_of_freedom);
 
+  // Same as above, for points in increasing order of time.
+  void AppendToHistory(
+      std::vector<std::pair<Instant, DegreesOfFreedom<Barycentric>>> const&
+          points);
+  void AppendToPsychohistory(
+      std::vector<std::pair<Instant, DegreesOfFreedom<Barycentric>>> const&
+          points);
+
   // Clears the history and psychohistory.
   void ClearHistory();
 
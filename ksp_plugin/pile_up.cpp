@@ -4,6 +4,8 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "base/map_util.hpp"
 #include "geometry/identity.hpp"
@@ -384,37 +386,48 @@ Status PileUp::AdvanceTime(Instant const& t) {
 
   // Append the |history_| authoritatively to the parts' tails and the
   // |psychohistory_| non-authoritatively.
-  auto const history_end = history_->End();
-  auto const psychohistory_end = psychohistory_->End();
-  auto it = history_last;
-  for (++it; it != history_end; ++it) {
-    AppendToPart<&Part::AppendToHistory>(it);
-  }
-  it = psychohistory_->Fork();
-  for (++it; it != psychohistory_end; ++it) {
-    AppendToPart<&Part::AppendToPsychohistory>(it);
-  }
+  auto history_begin = history_last;
+  ++history_begin;
+  AppendToParts<&Part::AppendToHistory>(history_begin, history_->End());
+  auto psychohistory_begin = psychohistory_->Fork();
+  ++psychohistory_begin;
+  AppendToParts<&Part::AppendToPsychohistory>(psychohistory_begin,
+                                              psychohistory_->End());
   history_->ForgetBefore(psychohistory_->Fork().time());
 
   return status;
 }
 
 template<PileUp::AppendToPartTrajectory append_to_part_trajectory>
-void PileUp::AppendToPart(DiscreteTrajectory<Barycentric>::Iterator it) const {
-  auto const& pile_up_dof = it.degrees_of_freedom();
-  RigidMotion<Barycentric, RigidPileUp> const barycentric_to_pile_up(
-      RigidTransformation<Barycentric, RigidPileUp>(
-          pile_up_dof.position(),
-          RigidPileUp::origin,
-          Identity<Barycentric, RigidPileUp>().Forget()),
-      AngularVelocity<Barycentric>{},
-      pile_up_dof.velocity());
-  auto const pile_up_to_barycentric = barycentric_to_pile_up.Inverse();
+void PileUp::AppendToParts(
+    DiscreteTrajectory<Barycentric>::Iterator const begin,
+    DiscreteTrajectory<Barycentric>::Iterator const end) const {
+  if (begin == end) {
+    return;
+  }
+  std::vector<std::pair<Instant, RigidMotion<RigidPileUp, Barycentric>>>
+      pile_up_to_barycentric;
+  for (auto it = begin; it != end; ++it) {
+    auto const& pile_up_dof = it.degrees_of_freedom();
+    RigidMotion<Barycentric, RigidPileUp> const barycentric_to_pile_up(
+        RigidTransformation<Barycentric, RigidPileUp>(
+            pile_up_dof.position(),
+            RigidPileUp::origin,
+            Identity<Barycentric, RigidPileUp>().Forget()),
+        AngularVelocity<Barycentric>{},
+        pile_up_dof.velocity());
+    pile_up_to_barycentric.emplace_back(it.time(),
+                                        barycentric_to_pile_up.Inverse());
+  }
+  std::vector<std::pair<Instant, DegreesOfFreedom<Barycentric>>> points;
+  points.reserve(pile_up_to_barycentric.size());
   for (not_null<Part*> const part : parts_) {
-    (static_cast<Part*>(part)->*append_to_part_trajectory)(
-        it.time(),
-        pile_up_to_barycentric(
-            FindOrDie(actual_part_degrees_of_freedom_, part)));
+    auto const& part_dof = FindOrDie(actual_part_degrees_of_freedom_, part);
+    points.clear();
+    for (auto const& pair : pile_up_to_barycentric) {
+      points.emplace_back(pair.first, pair.second(part_dof));
+    }
+    (static_cast<Part*>(part)->*append_to_part_trajectory)(points);
   }
 }
 
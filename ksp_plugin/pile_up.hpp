@@ -5,6 +5,8 @@
 #include <future>
 #include <list>
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
 #include "base/not_null.hpp"
@@ -94,10 +96,10 @@ class PileUp {
       std::function<void()> deletion_callback);
 
  private:
-  // A pointer to a member function of |Part| used to append a point to either
+  // A pointer to a member function of |Part| used to append points to either
   // trajectory (history or psychohistory).
-  using AppendToPartTrajectory =
-      void (Part::*)(Instant const&, DegreesOfFreedom<Barycentric> const&);
+  using AppendToPartTrajectory = void (Part::*)(
+      std::vector<std::pair<Instant, DegreesOfFreedom<Barycentric>>> const&);
 
   // For deserialization.
   PileUp(std::list<not_null<Part*>>&& parts,
@@ -133,8 +135,11 @@ class PileUp {
   // |DeformPileUpIfNeeded|.
   void NudgeParts() const;
 
+  // Appends to the trajectories of the parts the points of the pile-up in
+  // [begin, end), one batch per part.
   template<AppendToPartTrajectory append_to_part_trajectory>
-  void AppendToPart(DiscreteTrajectory<Barycentric>::Iterator it) const;
+  void AppendToParts(DiscreteTrajectory<Barycentric>::Iterator begin,
+                     DiscreteTrajectory<Barycentric>::Iterator end) const;
 
   // Wrapped in a |unique_ptr| to be moveable.
   not_null<std::unique_ptr<absl::Mutex>> lock_;
@@ -149,6 +149,7 @@ RP2Lines<Length, Camera> Planetarium::PlotMethod2(
       Pow<2>(parameters_.tan_angular_resolution_);
   auto const plottable_spheres = ComputePlottableSpheres(now);
   auto const& trajectory = *begin.trajectory();
+  DiscreteTrajectory<Barycentric>::Cursor cursor;
   auto const begin_time = std::max(begin.time(), plotting_frame_->t_min());
   auto const last_time = std::min(last.time(), plotting_frame_->t_max());
   auto const final_time = reverse ? begin_time : last_time;
@@ -161,7 +162,7 @@ RP2Lines<Length, Camera> Planetarium::PlotMethod2(
       plotting_frame_->ToThisFrameAtTime(previous_time);
   DegreesOfFreedom<Navigation> const initial_degrees_of_freedom =
       to_plotting_frame_at_t(
-          trajectory.EvaluateDegreesOfFreedom(previous_time));
+          trajectory.EvaluateDegreesOfFreedom(previous_time, cursor));
   Position<Navigation> previous_position =
       initial_degrees_of_freedom.position();
   Velocity<Navigation> previous_velocity =
@@ -198,7 +199,7 @@ RP2Lines<Length, Camera> Planetarium::PlotMethod2(
           previous_position + previous_velocity * Δt;
       to_plotting_frame_at_t = plotting_frame_->ToThisFrameAtTime(t);
       degrees_of_freedom_in_barycentric =
-          trajectory.EvaluateDegreesOfFreedom(t);
+          trajectory.EvaluateDegreesOfFreedom(t, cursor);
       position = to_plotting_frame_at_t.rigid_transformation()(
                      degrees_of_freedom_in_barycentric->position());
 
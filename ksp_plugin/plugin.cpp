@@ -2,6 +2,7 @@
 #include "ksp_plugin/plugin.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
@@ -125,6 +126,14 @@ Plugin::~Plugin() {
   // destroyed, and therefore to destroy the pile-ups, which want to remove
   // themselves from |pile_up_|, which also exists.
   vessels_.clear();
+  if (ephemeris_ != nullptr) {
+    auto const statistics = ephemeris_->prolongation_statistics();
+    LOG(INFO) << "Ephemeris prolongations: " << statistics.immediate
+              << " immediate, " << statistics.blocking << " blocking for "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     statistics.blocking_time).count()
+              << " ms";
+  }
 }
 
 void Plugin::InsertCelestialAbsoluteCartesian(
@@ -223,6 +232,8 @@ void Plugin::EndInitialization() {
                                      DefaultEphemerisAccuracyParameters()),
                                  ephemeris_fixed_step_parameters_.value_or(
                                      DefaultEphemerisFixedStepParameters()));
+  ephemeris_->SetBackgroundProlongationHorizon(
+      DefaultEphemerisBackgroundProlongationHorizon());
 
   // Construct the celestials using the bodies from the ephemeris.
   for (std::string const& name : solar_system.names()) {
@@ -1291,6 +1302,8 @@ not_null<std::unique_ptr<Plugin>> Plugin::ReadFromMessage(
       Ephemeris<Barycentric>::ReadFromMessage(message.ephemeris());
   plugin->ephemeris_->Prolong(plugin->game_epoch_);
   plugin->ephemeris_->Prolong(plugin->current_time_);
+  plugin->ephemeris_->SetBackgroundProlongationHorizon(
+      DefaultEphemerisBackgroundProlongationHorizon());
 
   ReadCelestialsFromMessages(*plugin->ephemeris_,
                              message.celestial(),
@@ -32,6 +32,9 @@ using quantities::si::Metre;
 
 constexpr std::int64_t max_dense_intervals = 10'000;
 constexpr Length downsampling_tolerance = 10 * Metre;
+// The older points of the history are kept compressed.  This is larger than
+// |max_dense_intervals| because the dense points are never compressed.
+constexpr std::int64_t max_uncompressed_history_points = 20'000;
 
 bool operator!=(Vessel::PrognosticatorParameters const& left,
                 Vessel::PrognosticatorParameters const& right) {
@@ -168,6 +171,7 @@ void Vessel::PrepareHistory(Instant const& t) {
     });
     CHECK(psychohistory_ == nullptr);
     history_->SetDownsampling(max_dense_intervals, downsampling_tolerance);
+    history_->SetMemoryBudget(max_uncompressed_history_points);
     history_->Append(t, calculator.Get());
     psychohistory_ = history_->NewForkAtLast();
     prediction_ = psychohistory_->NewForkAtLast();
@@ -395,6 +399,7 @@ not_null<std::unique_ptr<Vessel>> Vessel::ReadFromMessage(
     vessel->history_->SetDownsampling(max_dense_intervals,
                                       downsampling_tolerance);
   }
+  vessel->history_->SetMemoryBudget(max_uncompressed_history_points);
 
   if (message.has_flight_plan()) {
     vessel->flight_plan_ = FlightPlan::ReadFromMessage(message.flight_plan(),
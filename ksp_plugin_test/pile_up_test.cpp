@@ -681,6 +681,80 @@ TEST_F(PileUpTest, SerializationCompatibility) {
   p->DeformAndAdvanceTime(astronomy::J2000 + 1 * Second);
 }
 
+// A pre-Cesàro history with a non-authoritative point is split into a history
+// and a psychohistory forked with a copy.  The psychohistory must behave as if
+// it was forked at the first point, so that its point is made authoritative.
+TEST_F(PileUpTest, SerializationCompatibilityWithNonAuthoritativePoint) {
+  MockEphemeris<Barycentric> ephemeris;
+  p1_.increment_intrinsic_force(
+      Vector<Force, Barycentric>({1 * Newton, 2 * Newton, 3 * Newton}));
+  p2_.increment_intrinsic_force(
+      Vector<Force, Barycentric>({11 * Newton, 21 * Newton, 31 * Newton}));
+  EXPECT_CALL(deletion_callback_, Call()).Times(2);
+  TestablePileUp pile_up({&p1_, &p2_},
+                         astronomy::J2000,
+                         DefaultPsychohistoryParameters(),
+                         DefaultHistoryParameters(),
+                         &ephemeris,
+                         deletion_callback_.AsStdFunction());
+
+  serialization::PileUp message;
+  pile_up.WriteToMessage(&message);
+
+  // Clear the children and append a non-authoritative point to simulate
+  // pre-Cesàro serialization.
+  message.mutable_history()->clear_children();
+  ASSERT_EQ(1, message.history().timeline_size());
+  auto const first_point = message.history().timeline(0);
+  auto* const non_authoritative_point =
+      message.mutable_history()->add_timeline();
+  *non_authoritative_point = first_point;
+  (astronomy::J2000 + 0.5 * Second).WriteToMessage(
+      non_authoritative_point->mutable_instant());
+
+  auto const part_id_to_part = [this](PartId const part_id) {
+    if (part_id == part_id1_) {
+      return &p1_;
+    }
+    if (part_id == part_id2_) {
+      return &p2_;
+    }
+    LOG(FATAL) << "Unexpected part id " << part_id;
+    base::noreturn();
+  };
+  auto const p = PileUp::ReadFromMessage(message,
+                                         part_id_to_part,
+                                         &ephemeris,
+                                         deletion_callback_.AsStdFunction());
+
+  // The integration must start from the non-authoritative point.
+  EXPECT_CALL(ephemeris, FlowWithAdaptiveStep(_, _, _, _, _, _))
+      .WillOnce(DoAll(
+          [](not_null<DiscreteTrajectory<Barycentric>*> const trajectory,
+             auto&&...) {
+            EXPECT_EQ(astronomy::J2000 + 0.5 * Second,
+                      trajectory->last().time());
+          },
+          AppendToDiscreteTrajectory(DegreesOfFreedom<Barycentric>(
+              Barycentric::origin +
+                  Displacement<Barycentric>({1.0 * Metre,
+                                             14.0 * Metre,
+                                             31.0 / 3.0 * Metre}),
+              Velocity<Barycentric>({10.0 * Metre / Second,
+                                     140.0 * Metre / Second,
+                                     310.0 / 3.0 * Metre / Second}))),
+          Return(Status::OK)));
+  p->DeformAndAdvanceTime(astronomy::J2000 + 1 * Second);
+
+  std::vector<Instant> history_times;
+  for (auto it = p1_.history_begin(); it != p1_.history_end(); ++it) {
+    history_times.push_back(it.time());
+  }
+  EXPECT_THAT(history_times,
+              ElementsAre(astronomy::J2000 + 0.5 * Second,
+                          astronomy::J2000 + 1 * Second));
+}
+
 }  // namespace internal_pile_up
 }  // namespace ksp_plugin
 }  // namespace principia
@@ -4,7 +4,10 @@
 
 #include <vector>
 
+#include "base/macros.hpp"
 #include "geometry/barycentre_calculator.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/r3_element.hpp"
 #include "glog/logging.h"
 #include "numerics/fixed_arrays.hpp"
 #include "quantities/elementary_functions.hpp"
@@ -16,9 +19,12 @@ namespace internal_newhall {
 
 using base::make_not_null_unique;
 using geometry::Barycentre;
+using geometry::Multivector;
+using geometry::R3Element;
 using quantities::Exponentiation;
 using quantities::Frequency;
 using quantities::Time;
+using quantities::ToM128D;
 
 // Only supports 8 divisions for now.
 constexpr int divisions = 8;
@@ -93,26 +99,150 @@ Convert(FixedVector<Vector, degree + 1> const& homogeneous_coefficients,
       homogeneous_coefficients[degree] * scale_degree;
 }
 
+// The kernels compute the homogeneous coefficients of the Newhall
+// approximation and the error estimate from the |monomial| and |чебышёв|
+// matrices of a given degree.  This one uses the generic products of
+// |FixedMatrix| by |FixedVector|.
+template<typename Vector>
+struct GenericNewhallKernel {
+  template<int rows>
+  static FixedVector<Vector, rows> HomogeneousCoefficients(
+      FixedMatrix<double, rows, 2 * divisions + 2> const& monomial,
+      FixedMatrix<double, rows, 2 * divisions + 2> const& чебышёв,
+      FixedVector<Vector, 2 * divisions + 2> const& qv,
+      Vector& error_estimate);
+
+  template<int rows>
+  static FixedVector<Vector, rows> Multiply(
+      FixedMatrix<double, rows, 2 * divisions + 2> const& matrix,
+      FixedVector<Vector, 2 * divisions + 2> const& qv);
+};
+
+// The kernel used by the approximations.  Only vectors have a specialized
+// implementation.
+template<typename Vector>
+struct NewhallKernel : GenericNewhallKernel<Vector> {};
+
+#if PRINCIPIA_USE_SSE3_INTRINSICS
+// Fits the three coordinates together: x and y are in one |__m128d|, z in the
+// low half of another, as in |R3Element|, and the products by the entries of
+// the matrices are accumulated in registers without constructing intermediate
+// vectors.  The size of the matrices is known at compile time so the loops are
+// fully unrolled for each degree.  The summation order is that of
+// |DotProduct|, so the results are bitwise identical to those of
+// |GenericNewhallKernel|.
+template<typename Scalar, typename Frame>
+struct NewhallKernel<Multivector<Scalar, Frame, 1>> {
+  using Vector = Multivector<Scalar, Frame, 1>;
+
+  template<int rows>
+  static FixedVector<Vector, rows> HomogeneousCoefficients(
+      FixedMatrix<double, rows, 2 * divisions + 2> const& monomial,
+      FixedMatrix<double, rows, 2 * divisions + 2> const& чебышёв,
+      FixedVector<Vector, 2 * divisions + 2> const& qv,
+      Vector& error_estimate);
+
+  template<int rows>
+  static FixedVector<Vector, rows> Multiply(
+      FixedMatrix<double, rows, 2 * divisions + 2> const& matrix,
+      FixedVector<Vector, 2 * divisions + 2> const& qv);
+
+ private:
+  // Returns the product of the |row| of a matrix by |qv|.
+  static Vector MultiplyRow(double const* row,
+                            FixedVector<Vector, 2 * divisions + 2> const& qv);
+};
+#endif
+
+template<typename Vector>
+template<int rows>
+FixedVector<Vector, rows> GenericNewhallKernel<Vector>::HomogeneousCoefficients(
+    FixedMatrix<double, rows, 2 * divisions + 2> const& monomial,
+    FixedMatrix<double, rows, 2 * divisions + 2> const& чебышёв,
+    FixedVector<Vector, 2 * divisions + 2> const& qv,
+    Vector& error_estimate) {
+  error_estimate = чебышёв.template row<rows - 1>() * qv;
+  return monomial * qv;
+}
+
+template<typename Vector>
+template<int rows>
+FixedVector<Vector, rows> GenericNewhallKernel<Vector>::Multiply(
+    FixedMatrix<double, rows, 2 * divisions + 2> const& matrix,
+    FixedVector<Vector, 2 * divisions + 2> const& qv) {
+  return matrix * qv;
+}
+
+#if PRINCIPIA_USE_SSE3_INTRINSICS
+template<typename Scalar, typename Frame>
+template<int rows>
+FixedVector<Multivector<Scalar, Frame, 1>, rows>
+NewhallKernel<Multivector<Scalar, Frame, 1>>::HomogeneousCoefficients(
+    FixedMatrix<double, rows, 2 * divisions + 2> const& monomial,
+    FixedMatrix<double, rows, 2 * divisions + 2> const& чебышёв,
+    FixedVector<Vector, 2 * divisions + 2> const& qv,
+    Vector& error_estimate) {
+  error_estimate = MultiplyRow(чебышёв[rows - 1], qv);
+  return Multiply(monomial, qv);
+}
+
+template<typename Scalar, typename Frame>
+template<int rows>
+FixedVector<Multivector<Scalar, Frame, 1>, rows>
+NewhallKernel<Multivector<Scalar, Frame, 1>>::Multiply(
+    FixedMatrix<double, rows, 2 * divisions + 2> const& matrix,
+    FixedVector<Vector, 2 * divisions + 2> const& qv) {
+  FixedVector<Vector, rows> result(uninitialized);
+  for (int i = 0; i < rows; ++i) {
+    result[i] = MultiplyRow(matrix[i], qv);
+  }
+  return result;
+}
+
+template<typename Scalar, typename Frame>
+Multivector<Scalar, Frame, 1>
+NewhallKernel<Multivector<Scalar, Frame, 1>>::MultiplyRow(
+    double const* const row,
+    FixedVector<Vector, 2 * divisions + 2> const& qv) {
+  // |DotProduct| adds the product for column i to the sum of the products for
+  // columns 0 to i - 1.  Addition is commutative so accumulating from column 0
+  // onwards yields the same bits.
+  __m128d m = ToM128D(row[0]);
+  __m128d xy = _mm_mul_pd(qv[0].coordinates().xy, m);
+  __m128d zt = _mm_mul_sd(qv[0].coordinates().zt, m);
+  for (int j = 1; j < 2 * divisions + 2; ++j) {
+    m = ToM128D(row[j]);
+    R3Element<Scalar> const& qv_j = qv[j].coordinates();
+    xy = _mm_add_pd(_mm_mul_pd(qv_j.xy, m), xy);
+    zt = _mm_add_sd(_mm_mul_sd(qv_j.zt, m), zt);
+  }
+  return Vector(R3Element<Scalar>(xy, zt));
+}
+#endif
+
 template<typename Vector, int degree,
-         template<typename, typename, int> class Evaluator>
+         template<typename, typename, int> class Evaluator,
+         typename Kernel = NewhallKernel<Vector>>
 struct NewhallAppromixator {
   static FixedVector<Vector, degree + 1> HomogeneousCoefficients(
       FixedVector<Vector, 2 * divisions + 2> const& qv,
       Vector& error_estimate);
 };
 
-#define PRINCIPIA_NEWHALL_APPROXIMATOR_SPECIALIZATION(degree)                  \
-  template<typename Vector,                                                    \
-           template<typename, typename, int> class Evaluator>                  \
-  struct NewhallAppromixator<Vector, (degree), Evaluator> {                    \
-    static FixedVector<Vector, ((degree) + 1)> HomogeneousCoefficients(        \
-        FixedVector<Vector, 2 * divisions + 2> const& qv,                      \
-        Vector& error_estimate) {                                              \
-      error_estimate =                                                         \
-          newhall_c_matrix_чебышёв_degree_##degree##_divisions_8_w04.row<      \
-              (degree)>() * qv;                                                \
-      return newhall_c_matrix_monomial_degree_##degree##_divisions_8_w04 * qv; \
-    }                                                                          \
+#define PRINCIPIA_NEWHALL_APPROXIMATOR_SPECIALIZATION(degree)                \
+  template<typename Vector,                                                  \
+           template<typename, typename, int> class Evaluator,                \
+           typename Kernel>                                                  \
+  struct NewhallAppromixator<Vector, (degree), Evaluator, Kernel> {          \
+    static FixedVector<Vector, ((degree) + 1)> HomogeneousCoefficients(      \
+        FixedVector<Vector, 2 * divisions + 2> const& qv,                    \
+        Vector& error_estimate) {                                            \
+      return Kernel::HomogeneousCoefficients(                                \
+          newhall_c_matrix_monomial_degree_##degree##_divisions_8_w04,       \
+          newhall_c_matrix_чебышёв_degree_##degree##_divisions_8_w04,        \
+          qv,                                                                \
+          error_estimate);                                                   \
+    }                                                                        \
   }
 
 PRINCIPIA_NEWHALL_APPROXIMATOR_SPECIALIZATION(3);
@@ -137,7 +267,9 @@ PRINCIPIA_NEWHALL_APPROXIMATOR_SPECIALIZATION(17);
   case (degree):                                                              \
     coefficients =                                                            \
         std::vector<Vector>(                                                  \
-            newhall_c_matrix_чебышёв_degree_##degree##_divisions_8_w04 * qv); \
+            NewhallKernel<Vector>::Multiply(                                  \
+                newhall_c_matrix_чебышёв_degree_##degree##_divisions_8_w04,   \
+                qv));                                                         \
     break
 
 template<typename Vector>
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <vector>
 
+#include "geometry/frame.hpp"
 #include "geometry/named_quantities.hpp"
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
@@ -20,6 +21,8 @@
 namespace principia {
 namespace numerics {
 
+using geometry::Displacement;
+using geometry::Frame;
 using geometry::Instant;
 using quantities::Abs;
 using quantities::Length;
@@ -74,6 +77,9 @@ class MonomialAdapter {
 
 class NewhallTest : public ::testing::Test {
  protected:
+  using World = Frame<serialization::Frame::TestTag,
+                      serialization::Frame::TEST, true>;
+
   NewhallTest()
       : t_min_(t0_ - 1 * Second),
         t_max_(t0_ + 3 * Second),
@@ -768,5 +774,29 @@ TEST_F(NewhallTest, NonConstantDegree) {
                               length_function_1_(t_min_)), IsNear(9e-13));
 }
 
+// The specialized kernel for vectors must give exactly the same results as the
+// generic one.
+TEST_F(NewhallTest, SpecializedKernel) {
+  using Vector = Displacement<World>;
+  FixedVector<Vector, 2 * 8 + 2> qv;
+  for (int i = 0; i < qv.size; ++i) {
+    qv[i] = Vector({(i + 1) * 1.1 * Metre,
+                    (i - 7) * 2.3 * Metre,
+                    1 / (i + 0.5) * Metre});
+  }
+
+  Vector generic_error_estimate;
+  Vector specialized_error_estimate;
+  auto const generic_coefficients = internal_newhall::NewhallAppromixator<
+      Vector, 10, EstrinEvaluator,
+      internal_newhall::GenericNewhallKernel<Vector>>::
+      HomogeneousCoefficients(qv, generic_error_estimate);
+  auto const specialized_coefficients = internal_newhall::NewhallAppromixator<
+      Vector, 10, EstrinEvaluator>::
+      HomogeneousCoefficients(qv, specialized_error_estimate);
+  EXPECT_EQ(generic_coefficients, specialized_coefficients);
+  EXPECT_EQ(generic_error_estimate, specialized_error_estimate);
+}
+
 }  // namespace numerics
 }  // namespace principia
@@ -0,0 +1,322 @@
+
+#include "numerics/pairwise_gravitation.hpp"
+
+#include <immintrin.h>
+
+#include <cmath>
+
+#include "base/macros.hpp"
+#include "glog/logging.h"
+
+#if OS_WIN
+#include <intrin.h>
+#endif
+
+// This translation unit must not be compiled with floating-point contraction,
+// as fused multiply-adds would break the equivalence with |R3Element|, e.g., in
+// the scalar tails inlined in the vectorized functions.
+#if PRINCIPIA_COMPILER_CLANG || PRINCIPIA_COMPILER_CLANG_CL
+#pragma clang fp contract(off)
+#elif PRINCIPIA_COMPILER_MSVC
+#pragma fp_contract(off)
+#elif PRINCIPIA_COMPILER_GCC
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace principia {
+namespace numerics {
+namespace internal_pairwise_gravitation {
+
+// MSVC lets any function use the intrinsics of any instruction set, Clang and
+// G++ require the function to be compiled for that instruction set.
+#if PRINCIPIA_COMPILER_MSVC
+#define PRINCIPIA_TARGET(instruction_sets)
+#else
+#define PRINCIPIA_TARGET(instruction_sets) \
+    __attribute__((target(instruction_sets)))
+#endif
+
+namespace {
+
+// Processes the pairs (b1, b2) for b2 in [b2_begin, end[.  The acceleration of
+// |b1| is accumulated in |ax1|, |ay1| and |az1|.
+void AddRowScalar(std::int64_t const b1,
+                  std::int64_t const b2_begin,
+                  std::int64_t const end,
+                  double const* const μ,
+                  double const* const x,
+                  double const* const y,
+                  double const* const z,
+                  double* const ax,
+                  double* const ay,
+                  double* const az,
+                  double& ax1,
+                  double& ay1,
+                  double& az1) {
+  double const μ1 = μ[b1];
+  double const x1 = x[b1];
+  double const y1 = y[b1];
+  double const z1 = z[b1];
+  for (std::int64_t b2 = b2_begin; b2 < end; ++b2) {
+    // A vector from the center of |b2| to the center of |b1|.
+    double const Δqx = x1 - x[b2];
+    double const Δqy = y1 - y[b2];
+    double const Δqz = z1 - z[b2];
+
+    double const Δq² = Δqx * Δqx + Δqy * Δqy + Δqz * Δqz;
+    double const Δq_norm = std::sqrt(Δq²);
+    double const one_over_Δq³ = Δq_norm / (Δq² * Δq²);
+
+    double const μ1_over_Δq³ = μ1 * one_over_Δq³;
+    ax[b2] += Δqx * μ1_over_Δq³;
+    ay[b2] += Δqy * μ1_over_Δq³;
+    az[b2] += Δqz * μ1_over_Δq³;
+
+    double const μ2_over_Δq³ = μ[b2] * one_over_Δq³;
+    ax1 -= Δqx * μ2_over_Δq³;
+    ay1 -= Δqy * μ2_over_Δq³;
+    az1 -= Δqz * μ2_over_Δq³;
+  }
+}
+
+void AddMutualGravitationalAccelerationsScalar(std::int64_t const begin,
+                                               std::int64_t const end,
+                                               double const* const μ,
+                                               double const* const x,
+                                               double const* const y,
+                                               double const* const z,
+                                               double* const ax,
+                                               double* const ay,
+                                               double* const az) {
+  for (std::int64_t b1 = begin; b1 < end; ++b1) {
+    double ax1 = ax[b1];
+    double ay1 = ay[b1];
+    double az1 = az[b1];
+    AddRowScalar(b1, b1 + 1, end, μ, x, y, z, ax, ay, az, ax1, ay1, az1);
+    ax[b1] = ax1;
+    ay[b1] = ay1;
+    az[b1] = az1;
+  }
+}
+
+// The vectorized implementations process 4 or 8 consecutive values of |b2| at
+// a time.  The accelerations of these bodies are independent, but their
+// reactions on |b1| are subtracted sequentially, in increasing order of |b2|,
+// to preserve the order of the operations.
+
+PRINCIPIA_TARGET("avx2")
+void AddMutualGravitationalAccelerationsAVX2(std::int64_t const begin,
+                                             std::int64_t const end,
+                                             double const* const μ,
+                                             double const* const x,
+                                             double const* const y,
+                                             double const* const z,
+                                             double* const ax,
+                                             double* const ay,
+                                             double* const az) {
+  constexpr std::int64_t lanes = 4;
+  alignas(32) double reaction_x[lanes];
+  alignas(32) double reaction_y[lanes];
+  alignas(32) double reaction_z[lanes];
+  for (std::int64_t b1 = begin; b1 < end; ++b1) {
+    __m256d const μ1 = _mm256_set1_pd(μ[b1]);
+    __m256d const x1 = _mm256_set1_pd(x[b1]);
+    __m256d const y1 = _mm256_set1_pd(y[b1]);
+    __m256d const z1 = _mm256_set1_pd(z[b1]);
+    double ax1 = ax[b1];
+    double ay1 = ay[b1];
+    double az1 = az[b1];
+    std::int64_t b2 = b1 + 1;
+    for (; b2 + lanes <= end; b2 += lanes) {
+      __m256d const Δqx = _mm256_sub_pd(x1, _mm256_loadu_pd(x + b2));
+      __m256d const Δqy = _mm256_sub_pd(y1, _mm256_loadu_pd(y + b2));
+      __m256d const Δqz = _mm256_sub_pd(z1, _mm256_loadu_pd(z + b2));
+
+      __m256d const Δq² = _mm256_add_pd(
+          _mm256_add_pd(_mm256_mul_pd(Δqx, Δqx), _mm256_mul_pd(Δqy, Δqy)),
+          _mm256_mul_pd(Δqz, Δqz));
+      __m256d const Δq_norm = _mm256_sqrt_pd(Δq²);
+      __m256d const one_over_Δq³ =
+          _mm256_div_pd(Δq_norm, _mm256_mul_pd(Δq², Δq²));
+
+      __m256d const μ1_over_Δq³ = _mm256_mul_pd(μ1, one_over_Δq³);
+      _mm256_storeu_pd(ax + b2,
+                       _mm256_add_pd(_mm256_loadu_pd(ax + b2),
+                                     _mm256_mul_pd(Δqx, μ1_over_Δq³)));
+      _mm256_storeu_pd(ay + b2,
+                       _mm256_add_pd(_mm256_loadu_pd(ay + b2),
+                                     _mm256_mul_pd(Δqy, μ1_over_Δq³)));
+      _mm256_storeu_pd(az + b2,
+                       _mm256_add_pd(_mm256_loadu_pd(az + b2),
+                                     _mm256_mul_pd(Δqz, μ1_over_Δq³)));
+
+      __m256d const μ2_over_Δq³ =
+          _mm256_mul_pd(_mm256_loadu_pd(μ + b2), one_over_Δq³);
+      _mm256_store_pd(reaction_x, _mm256_mul_pd(Δqx, μ2_over_Δq³));
+      _mm256_store_pd(reaction_y, _mm256_mul_pd(Δqy, μ2_over_Δq³));
+      _mm256_store_pd(reaction_z, _mm256_mul_pd(Δqz, μ2_over_Δq³));
+      for (std::int64_t i = 0; i < lanes; ++i) {
+        ax1 -= reaction_x[i];
+        ay1 -= reaction_y[i];
+        az1 -= reaction_z[i];
+      }
+    }
+    AddRowScalar(b1, b2, end, μ, x, y, z, ax, ay, az, ax1, ay1, az1);
+    ax[b1] = ax1;
+    ay[b1] = ay1;
+    az[b1] = az1;
+  }
+}
+
+PRINCIPIA_TARGET("avx512f")
+void AddMutualGravitationalAccelerationsAVX512F(std::int64_t const begin,
+                                                std::int64_t const end,
+                                                double const* const μ,
+                                                double const* const x,
+                                                double const* const y,
+                                                double const* const z,
+                                                double* const ax,
+                                                double* const ay,
+                                                double* const az) {
+  constexpr std::int64_t lanes = 8;
+  alignas(64) double reaction_x[lanes];
+  alignas(64) double reaction_y[lanes];
+  alignas(64) double reaction_z[lanes];
+  for (std::int64_t b1 = begin; b1 < end; ++b1) {
+    __m512d const μ1 = _mm512_set1_pd(μ[b1]);
+    __m512d const x1 = _mm512_set1_pd(x[b1]);
+    __m512d const y1 = _mm512_set1_pd(y[b1]);
+    __m512d const z1 = _mm512_set1_pd(z[b1]);
+    double ax1 = ax[b1];
+    double ay1 = ay[b1];
+    double az1 = az[b1];
+    std::int64_t b2 = b1 + 1;
+    for (; b2 + lanes <= end; b2 += lanes) {
+      __m512d const Δqx = _mm512_sub_pd(x1, _mm512_loadu_pd(x + b2));
+      __m512d const Δqy = _mm512_sub_pd(y1, _mm512_loadu_pd(y + b2));
+      __m512d const Δqz = _mm512_sub_pd(z1, _mm512_loadu_pd(z + b2));
+
+      __m512d const Δq² = _mm512_add_pd(
+          _mm512_add_pd(_mm512_mul_pd(Δqx, Δqx), _mm512_mul_pd(Δqy, Δqy)),
+          _mm512_mul_pd(Δqz, Δqz));
+      __m512d const Δq_norm = _mm512_sqrt_pd(Δq²);
+      __m512d const one_over_Δq³ =
+          _mm512_div_pd(Δq_norm, _mm512_mul_pd(Δq², Δq²));
+
+      __m512d const μ1_over_Δq³ = _mm512_mul_pd(μ1, one_over_Δq³);
+      _mm512_storeu_pd(ax + b2,
+                       _mm512_add_pd(_mm512_loadu_pd(ax + b2),
+                                     _mm512_mul_pd(Δqx, μ1_over_Δq³)));
+      _mm512_storeu_pd(ay + b2,
+                       _mm512_add_pd(_mm512_loadu_pd(ay + b2),
+                                     _mm512_mul_pd(Δqy, μ1_over_Δq³)));
+      _mm512_storeu_pd(az + b2,
+                       _mm512_add_pd(_mm512_loadu_pd(az + b2),
+                                     _mm512_mul_pd(Δqz, μ1_over_Δq³)));
+
+      __m512d const μ2_over_Δq³ =
+          _mm512_mul_pd(_mm512_loadu_pd(μ + b2), one_over_Δq³);
+      _mm512_store_pd(reaction_x, _mm512_mul_pd(Δqx, μ2_over_Δq³));
+      _mm512_store_pd(reaction_y, _mm512_mul_pd(Δqy, μ2_over_Δq³));
+      _mm512_store_pd(reaction_z, _mm512_mul_pd(Δqz, μ2_over_Δq³));
+      for (std::int64_t i = 0; i < lanes; ++i) {
+        ax1 -= reaction_x[i];
+        ay1 -= reaction_y[i];
+        az1 -= reaction_z[i];
+      }
+    }
+    AddRowScalar(b1, b2, end, μ, x, y, z, ax, ay, az, ax1, ay1, az1);
+    ax[b1] = ax1;
+    ay[b1] = ay1;
+    az[b1] = az1;
+  }
+}
+
+}  // namespace
+
+#if OS_WIN
+PRINCIPIA_TARGET("xsave")
+InstructionSet BestInstructionSet() {
+  int registers[4];  // EAX, EBX, ECX, EDX.
+  __cpuid(registers, 0);
+  int const max_leaf = registers[0];
+  __cpuid(registers, 1);
+  bool const osxsave = registers[2] & (1 << 27);
+  if (max_leaf < 7 || !osxsave) {
+    return InstructionSet::Scalar;
+  }
+  // Check that the operating system saves the YMM and ZMM registers.
+  std::uint64_t const xcr0 = _xgetbv(0);
+  bool const saves_ymm = (xcr0 & 0x06) == 0x06;
+  bool const saves_zmm = (xcr0 & 0xE6) == 0xE6;
+  __cpuidex(registers, 7, 0);
+  bool const avx2 = registers[1] & (1 << 5);
+  bool const avx512f = registers[1] & (1 << 16);
+  if (avx512f && saves_zmm) {
+    return InstructionSet::AVX512F;
+  } else if (avx2 && saves_ymm) {
+    return InstructionSet::AVX2;
+  } else {
+    return InstructionSet::Scalar;
+  }
+}
+#else
+InstructionSet BestInstructionSet() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return InstructionSet::AVX512F;
+  } else if (__builtin_cpu_supports("avx2")) {
+    return InstructionSet::AVX2;
+  } else {
+    return InstructionSet::Scalar;
+  }
+}
+#endif
+
+void AddMutualGravitationalAccelerations(std::int64_t const begin,
+                                         std::int64_t const end,
+                                         double const* const μ,
+                                         double const* const x,
+                                         double const* const y,
+                                         double const* const z,
+                                         double* const ax,
+                                         double* const ay,
+                                         double* const az) {
+  static InstructionSet const instruction_set = BestInstructionSet();
+  AddMutualGravitationalAccelerations(
+      instruction_set, begin, end, μ, x, y, z, ax, ay, az);
+}
+
+void AddMutualGravitationalAccelerations(InstructionSet const instruction_set,
+                                         std::int64_t const begin,
+                                         std::int64_t const end,
+                                         double const* const μ,
+                                         double const* const x,
+                                         double const* const y,
+                                         double const* const z,
+                                         double* const ax,
+                                         double* const ay,
+                                         double* const az) {
+  switch (instruction_set) {
+    case InstructionSet::Scalar:
+      AddMutualGravitationalAccelerationsScalar(
+          begin, end, μ, x, y, z, ax, ay, az);
+      return;
+    case InstructionSet::AVX2:
+      AddMutualGravitationalAccelerationsAVX2(
+          begin, end, μ, x, y, z, ax, ay, az);
+      return;
+    case InstructionSet::AVX512F:
+      AddMutualGravitationalAccelerationsAVX512F(
+          begin, end, μ, x, y, z, ax, ay, az);
+      return;
+  }
+  LOG(FATAL) << "Unexpected instruction set "
+             << static_cast<int>(instruction_set);
+}
+
+#undef PRINCIPIA_TARGET
+
+}  // namespace internal_pairwise_gravitation
+}  // namespace numerics
+}  // namespace principia
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+namespace principia {
+namespace numerics {
+namespace internal_pairwise_gravitation {
+
+// The instruction sets for which |AddMutualGravitationalAccelerations| has an
+// implementation.
+enum class InstructionSet {
+  Scalar,
+  AVX2,
+  AVX512F,
+};
+
+// The most capable instruction set supported by this processor and operating
+// system.
+InstructionSet BestInstructionSet();
+
+// Adds to the accelerations of the point masses with indices in [begin, end[
+// the accelerations resulting from their mutual gravitational attraction.  The
+// point masses are described as a structure of arrays: |μ| holds the
+// gravitational parameters, |x|, |y| and |z| the coordinates of the positions,
+// and |ax|, |ay| and |az| the coordinates of the accelerations, all in SI
+// units.
+// The pairs are processed in lexicographic order of their indices, and each
+// pair performs the same IEEE 754 operations, in the same order, as the
+// |R3Element| computation in |Ephemeris|.  The results are therefore bitwise
+// identical to those of that computation, irrespective of the instruction set.
+void AddMutualGravitationalAccelerations(std::int64_t begin,
+                                         std::int64_t end,
+                                         double const* μ,
+                                         double const* x,
+                                         double const* y,
+                                         double const* z,
+                                         double* ax,
+                                         double* ay,
+                                         double* az);
+
+// Same as above, but uses the given |instruction_set|, which must be supported
+// by this processor.  Exposed for testing and benchmarking.
+void AddMutualGravitationalAccelerations(InstructionSet instruction_set,
+                                         std::int64_t begin,
+                                         std::int64_t end,
+                                         double const* μ,
+                                         double const* x,
+                                         double const* y,
+                                         double const* z,
+                                         double* ax,
+                                         double* ay,
+                                         double* az);
+
+}  // namespace internal_pairwise_gravitation
+
+using internal_pairwise_gravitation::AddMutualGravitationalAccelerations;
+using internal_pairwise_gravitation::BestInstructionSet;
+using internal_pairwise_gravitation::InstructionSet;
+
+}  // namespace numerics
+}  // namespace principia
@@ -0,0 +1,109 @@
+
+#include "numerics/pairwise_gravitation.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace principia {
+namespace numerics {
+
+class PairwiseGravitationTest : public ::testing::Test {
+ protected:
+  struct System {
+    std::vector<double> μ;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+    std::vector<double> ax;
+    std::vector<double> ay;
+    std::vector<double> az;
+  };
+
+  // A system of |size| bodies with planetary masses at random positions within
+  // a few astronomical units of the origin, with nonzero initial accelerations.
+  static System RandomSystem(int const size) {
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<> position_distribution(-1e12, 1e12);
+    std::uniform_real_distribution<> μ_distribution(1e9, 1e20);
+    std::uniform_real_distribution<> acceleration_distribution(-1e-3, 1e-3);
+    System system;
+    for (int i = 0; i < size; ++i) {
+      system.μ.push_back(μ_distribution(random));
+      system.x.push_back(position_distribution(random));
+      system.y.push_back(position_distribution(random));
+      system.z.push_back(position_distribution(random));
+      system.ax.push_back(acceleration_distribution(random));
+      system.ay.push_back(acceleration_distribution(random));
+      system.az.push_back(acceleration_distribution(random));
+    }
+    return system;
+  }
+
+  static void Add(InstructionSet const instruction_set,
+                  std::int64_t const begin,
+                  System& system) {
+    AddMutualGravitationalAccelerations(instruction_set,
+                                        begin,
+                                        system.μ.size(),
+                                        system.μ.data(),
+                                        system.x.data(),
+                                        system.y.data(),
+                                        system.z.data(),
+                                        system.ax.data(),
+                                        system.ay.data(),
+                                        system.az.data());
+  }
+};
+
+// The vectorized implementations must give the same results as the scalar one,
+// bit for bit, including for the bodies handled by the scalar remainder loops.
+TEST_F(PairwiseGravitationTest, InstructionSets) {
+  std::vector<InstructionSet> instruction_sets;
+  switch (BestInstructionSet()) {
+    case InstructionSet::AVX512F:
+      instruction_sets.push_back(InstructionSet::AVX512F);
+      [[fallthrough]];
+    case InstructionSet::AVX2:
+      instruction_sets.push_back(InstructionSet::AVX2);
+      [[fallthrough]];
+    case InstructionSet::Scalar:
+      break;
+  }
+  for (int const size : {0, 1, 2, 3, 4, 5, 8, 9, 17, 40}) {
+    for (std::int64_t const begin : {0, 1}) {
+      System expected = RandomSystem(size);
+      Add(InstructionSet::Scalar, std::min<std::int64_t>(begin, size), expected);
+      for (InstructionSet const instruction_set : instruction_sets) {
+        System actual = RandomSystem(size);
+        Add(instruction_set, std::min<std::int64_t>(begin, size), actual);
+        EXPECT_EQ(expected.ax, actual.ax) << size;
+        EXPECT_EQ(expected.ay, actual.ay) << size;
+        EXPECT_EQ(expected.az, actual.az) << size;
+      }
+    }
+  }
+}
+
+// Two bodies on the x axis attract each other with opposite forces.
+TEST_F(PairwiseGravitationTest, TwoBodies) {
+  std::vector<double> μ = {1, 4};
+  std::vector<double> x = {0, 2};
+  std::vector<double> y = {0, 0};
+  std::vector<double> z = {0, 0};
+  std::vector<double> ax = {0, 0};
+  std::vector<double> ay = {0, 0};
+  std::vector<double> az = {0, 0};
+  AddMutualGravitationalAccelerations(/*begin=*/0, /*end=*/2,
+                                      μ.data(), x.data(), y.data(), z.data(),
+                                      ax.data(), ay.data(), az.data());
+  EXPECT_EQ(1, ax[0]);
+  EXPECT_EQ(-0.25, ax[1]);
+  EXPECT_EQ(0, ay[0]);
+  EXPECT_EQ(0, az[1]);
+}
+
+}  // namespace numerics
+}  // namespace principia
@@ -0,0 +1,87 @@
+﻿
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "geometry/named_quantities.hpp"
+#include "physics/degrees_of_freedom.hpp"
+
+namespace principia {
+namespace physics {
+namespace internal_compressed_timeline_block {
+
+using geometry::Instant;
+
+// An immutable sequence of points of a trajectory, ordered by increasing time
+// and stored losslessly in a compact form.  Each time and coordinate is
+// predicted from the preceding points (linearly for the times, by a Taylor
+// expansion for the degrees of freedom), and only the bytes in which it
+// differs from its prediction are stored.  Smooth trajectories sampled often
+// thus take much less memory than in a |std::map|.
+template<typename Frame>
+class CompressedTimelineBlock final {
+ public:
+  // [begin, end[ must be nonempty and strictly ordered by time.  The iterators
+  // must designate pairs of |Instant| and |DegreesOfFreedom<Frame>|.
+  template<typename Iterator>
+  CompressedTimelineBlock(Iterator begin, Iterator end);
+
+  Instant const& first_time() const;
+  Instant const& last_time() const;
+
+  // The number of points in this block.
+  std::int64_t size() const;
+  // The memory used by the compressed representation of the points.
+  std::int64_t size_in_bytes() const;
+
+  // Calls |action| with each point of this block, in increasing time.
+  void ForEach(std::function<void(
+                   Instant const& time,
+                   DegreesOfFreedom<Frame> const& degrees_of_freedom)> const&
+                   action) const;
+
+ private:
+  // The time, position and velocity of a point, in SI units with respect to
+  // J2000 and the origin of |Frame|.
+  using Coordinates = std::array<double, 7>;
+
+  static Coordinates ToCoordinates(
+      Instant const& time,
+      DegreesOfFreedom<Frame> const& degrees_of_freedom);
+  static Instant ToTime(Coordinates const& coordinates);
+  static DegreesOfFreedom<Frame> ToDegreesOfFreedom(
+      Coordinates const& coordinates);
+
+  // Predicts the time of the point that follows |previous|, which follows
+  // |before_previous|.  |index| is the index of the predicted point, and the
+  // arguments are only used if they exist.
+  static double PredictTime(std::int64_t index,
+                            Coordinates const& previous,
+                            Coordinates const& before_previous);
+  // Predicts the other coordinates of the point that follows |previous|, once
+  // its time is known.
+  static void PredictDegreesOfFreedom(std::int64_t index,
+                                      Coordinates const& previous,
+                                      Coordinates const& before_previous,
+                                      Coordinates& predicted);
+
+  Instant first_time_;
+  Instant last_time_;
+  std::int64_t size_ = 0;
+  // For each point, 4 bytes whose nibbles give the number of significant bytes
+  // of the exclusive or of each coordinate with its prediction, followed by
+  // these significant bytes, least significant first.
+  std::vector<std::uint8_t> bytes_;
+};
+
+}  // namespace internal_compressed_timeline_block
+
+using internal_compressed_timeline_block::CompressedTimelineBlock;
+
+}  // namespace physics
+}  // namespace principia
+
+#include "physics/compressed_timeline_block_body.hpp"
@@ -0,0 +1,202 @@
+﻿
+#pragma once
+
+#include "physics/compressed_timeline_block.hpp"
+
+#include <cstring>
+
+#include "geometry/grassmann.hpp"
+#include "glog/logging.h"
+#include "quantities/si.hpp"
+
+namespace principia {
+namespace physics {
+namespace internal_compressed_timeline_block {
+
+using geometry::Displacement;
+using geometry::Velocity;
+using quantities::si::Metre;
+using quantities::si::Second;
+
+constexpr int header_bytes = 4;
+
+inline std::uint64_t ToBits(double const x) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return bits;
+}
+
+inline double FromBits(std::uint64_t const bits) {
+  double x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+template<typename Frame>
+template<typename Iterator>
+CompressedTimelineBlock<Frame>::CompressedTimelineBlock(Iterator const begin,
+                                                        Iterator const end) {
+  CHECK(begin != end);
+  first_time_ = begin->first;
+  Coordinates previous{};
+  Coordinates before_previous{};
+  for (Iterator it = begin; it != end; ++it) {
+    Coordinates const actual = ToCoordinates(it->first, it->second);
+
+    // The degrees of freedom are predicted from the actual time, which is
+    // decoded first.
+    Coordinates predicted;
+    predicted[0] = actual[0];
+    PredictDegreesOfFreedom(size_, previous, before_previous, predicted);
+    predicted[0] = PredictTime(size_, previous, before_previous);
+
+    std::size_t const header = bytes_.size();
+    bytes_.resize(header + header_bytes, 0);
+    for (std::size_t i = 0; i < actual.size(); ++i) {
+      std::uint64_t residual = ToBits(actual[i]) ^ ToBits(predicted[i]);
+      int significant_bytes = 0;
+      for (; residual != 0; residual >>= 8) {
+        bytes_.push_back(static_cast<std::uint8_t>(residual & 0xFF));
+        ++significant_bytes;
+      }
+      bytes_[header + i / 2] |= significant_bytes << (4 * (i % 2));
+    }
+
+    before_previous = previous;
+    previous = actual;
+    last_time_ = it->first;
+    ++size_;
+  }
+  bytes_.shrink_to_fit();
+}
+
+template<typename Frame>
+Instant const& CompressedTimelineBlock<Frame>::first_time() const {
+  return first_time_;
+}
+
+template<typename Frame>
+Instant const& CompressedTimelineBlock<Frame>::last_time() const {
+  return last_time_;
+}
+
+template<typename Frame>
+std::int64_t CompressedTimelineBlock<Frame>::size() const {
+  return size_;
+}
+
+template<typename Frame>
+std::int64_t CompressedTimelineBlock<Frame>::size_in_bytes() const {
+  return sizeof(*this) + bytes_.capacity();
+}
+
+template<typename Frame>
+void CompressedTimelineBlock<Frame>::ForEach(
+    std::function<void(
+        Instant const& time,
+        DegreesOfFreedom<Frame> const& degrees_of_freedom)> const& action)
+    const {
+  std::size_t position = 0;
+  Coordinates previous{};
+  Coordinates before_previous{};
+  for (std::int64_t index = 0; index < size_; ++index) {
+    std::size_t const header = position;
+    position += header_bytes;
+    auto const decode = [this, header, &position](std::size_t const i,
+                                                  double const predicted) {
+      int const significant_bytes =
+          (bytes_[header + i / 2] >> (4 * (i % 2))) & 0xF;
+      std::uint64_t residual = 0;
+      for (int j = 0; j < significant_bytes; ++j) {
+        residual |= std::uint64_t{bytes_[position++]} << (8 * j);
+      }
+      return FromBits(ToBits(predicted) ^ residual);
+    };
+
+    Coordinates actual;
+    actual[0] = decode(0, PredictTime(index, previous, before_previous));
+    Coordinates predicted;
+    predicted[0] = actual[0];
+    PredictDegreesOfFreedom(index, previous, before_previous, predicted);
+    for (std::size_t i = 1; i < actual.size(); ++i) {
+      actual[i] = decode(i, predicted[i]);
+    }
+    action(ToTime(actual), ToDegreesOfFreedom(actual));
+
+    before_previous = previous;
+    previous = actual;
+  }
+  DCHECK_EQ(position, bytes_.size());
+}
+
+template<typename Frame>
+typename CompressedTimelineBlock<Frame>::Coordinates
+CompressedTimelineBlock<Frame>::ToCoordinates(
+    Instant const& time,
+    DegreesOfFreedom<Frame> const& degrees_of_freedom) {
+  auto const q = (degrees_of_freedom.position() - Frame::origin).coordinates();
+  auto const v = degrees_of_freedom.velocity().coordinates();
+  return {(time - Instant()) / Second,
+          q.x / Metre, q.y / Metre, q.z / Metre,
+          v.x / (Metre / Second), v.y / (Metre / Second),
+          v.z / (Metre / Second)};
+}
+
+template<typename Frame>
+Instant CompressedTimelineBlock<Frame>::ToTime(
+    Coordinates const& coordinates) {
+  return Instant() + coordinates[0] * Second;
+}
+
+template<typename Frame>
+DegreesOfFreedom<Frame> CompressedTimelineBlock<Frame>::ToDegreesOfFreedom(
+    Coordinates const& coordinates) {
+  return DegreesOfFreedom<Frame>(
+      Frame::origin + Displacement<Frame>({coordinates[1] * Metre,
+                                           coordinates[2] * Metre,
+                                           coordinates[3] * Metre}),
+      Velocity<Frame>({coordinates[4] * (Metre / Second),
+                       coordinates[5] * (Metre / Second),
+                       coordinates[6] * (Metre / Second)}));
+}
+
+template<typename Frame>
+double CompressedTimelineBlock<Frame>::PredictTime(
+    std::int64_t const index,
+    Coordinates const& previous,
+    Coordinates const& before_previous) {
+  if (index == 0) {
+    return 0;
+  } else if (index == 1) {
+    return previous[0];
+  } else {
+    return 2 * previous[0] - before_previous[0];
+  }
+}
+
+template<typename Frame>
+void CompressedTimelineBlock<Frame>::PredictDegreesOfFreedom(
+    std::int64_t const index,
+    Coordinates const& previous,
+    Coordinates const& before_previous,
+    Coordinates& predicted) {
+  if (index == 0) {
+    for (std::size_t i = 1; i < predicted.size(); ++i) {
+      predicted[i] = 0;
+    }
+    return;
+  }
+  double const Δt = predicted[0] - previous[0];
+  for (int i = 1; i <= 3; ++i) {
+    // The acceleration is estimated from the last two velocities.
+    double const a = index == 1 ? 0
+                                : (previous[i + 3] - before_previous[i + 3]) /
+                                      (previous[0] - before_previous[0]);
+    predicted[i] = previous[i] + (previous[i + 3] + 0.5 * a * Δt) * Δt;
+    predicted[i + 3] = previous[i + 3] + a * Δt;
+  }
+}
+
+}  // namespace internal_compressed_timeline_block
+}  // namespace physics
+}  // namespace principia
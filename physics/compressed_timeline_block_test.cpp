@@ -0,0 +1,104 @@
+﻿
+#include "physics/compressed_timeline_block.hpp"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "geometry/frame.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+
+namespace principia {
+namespace physics {
+namespace internal_compressed_timeline_block {
+
+using geometry::Displacement;
+using geometry::Frame;
+using geometry::Velocity;
+using quantities::AngularFrequency;
+using quantities::Cos;
+using quantities::Length;
+using quantities::Sin;
+using quantities::Speed;
+using quantities::si::Kilo;
+using quantities::si::Metre;
+using quantities::si::Radian;
+using quantities::si::Second;
+using ::testing::ElementsAreArray;
+using ::testing::Lt;
+
+class CompressedTimelineBlockTest : public ::testing::Test {
+ protected:
+  using World = Frame<serialization::Frame::TestTag,
+                      serialization::Frame::TEST, true>;
+  using Points = std::vector<std::pair<Instant, DegreesOfFreedom<World>>>;
+
+  static Points Decompress(CompressedTimelineBlock<World> const& block) {
+    Points points;
+    block.ForEach([&points](Instant const& time,
+                            DegreesOfFreedom<World> const& degrees_of_freedom) {
+      points.emplace_back(time, degrees_of_freedom);
+    });
+    return points;
+  }
+
+  Instant const t0_ = Instant() + 123.456 * Second;
+};
+
+TEST_F(CompressedTimelineBlockTest, SinglePoint) {
+  std::map<Instant, DegreesOfFreedom<World>> const timeline = {
+      {t0_,
+       DegreesOfFreedom<World>(
+           World::origin +
+               Displacement<World>({1 * Metre, -2 * Metre, 3e-300 * Metre}),
+           Velocity<World>({4 * Metre / Second,
+                            -5 * Metre / Second,
+                            6e300 * Metre / Second}))}};
+  CompressedTimelineBlock<World> const block(timeline.begin(), timeline.end());
+  EXPECT_EQ(1, block.size());
+  EXPECT_EQ(t0_, block.first_time());
+  EXPECT_EQ(t0_, block.last_time());
+  EXPECT_THAT(Decompress(block),
+              ElementsAreArray(timeline.begin(), timeline.end()));
+}
+
+TEST_F(CompressedTimelineBlockTest, Orbit) {
+  Length const r = 7000 * Kilo(Metre);
+  AngularFrequency const ω = 2 * π * Radian / (5800 * Second);
+  Speed const v = ω * r / Radian;
+  std::map<Instant, DegreesOfFreedom<World>> timeline;
+  // Irregular steps, as produced by an adaptive integrator.
+  Instant t = t0_;
+  for (int i = 0; i < 1000; ++i) {
+    t += (10 + (i % 7)) * Second;
+    timeline.emplace_hint(
+        timeline.end(),
+        t,
+        DegreesOfFreedom<World>(
+            World::origin + Displacement<World>({r * Cos(ω * (t - t0_)),
+                                                 r * Sin(ω * (t - t0_)),
+                                                 0 * Metre}),
+            Velocity<World>({-v * Sin(ω * (t - t0_)),
+                             v * Cos(ω * (t - t0_)),
+                             0 * Metre / Second})));
+  }
+  CompressedTimelineBlock<World> const block(timeline.begin(), timeline.end());
+  EXPECT_EQ(1000, block.size());
+  EXPECT_EQ(timeline.begin()->first, block.first_time());
+  EXPECT_EQ(timeline.rbegin()->first, block.last_time());
+  // The decompression is exact.
+  EXPECT_THAT(Decompress(block),
+              ElementsAreArray(timeline.begin(), timeline.end()));
+  // The uncompressed points take 56 bytes each.
+  EXPECT_THAT(block.size_in_bytes(), Lt(1000 * 40));
+}
+
+}  // namespace internal_compressed_timeline_block
+}  // namespace physics
+}  // namespace principia
@@ -1,7 +1,10 @@
 ﻿
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <deque>
+#include <memory>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -11,6 +14,7 @@
 #include "base/status.hpp"
 #include "geometry/named_quantities.hpp"
 #include "numerics/polynomial.hpp"
+#include "numerics/polynomial_evaluators.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "physics/trajectory.hpp"
 #include "quantities/quantities.hpp"
@@ -28,14 +32,20 @@ using geometry::Position;
 using geometry::Velocity;
 using quantities::Length;
 using quantities::Time;
+using numerics::EstrinEvaluator;
 using numerics::Polynomial;
+using numerics::PolynomialInMonomialBasis;
 
 template<typename Frame>
 class TestableContinuousTrajectory;
 
 // This class is thread-safe, but the client must be aware that if, for
 // instance, the trajectory is appended to asynchronously, successive calls to
-// |t_max()| may return different values.
+// |t_max()| may return different values.  The evaluation functions and the
+// functions returning the bounds of the trajectory never lock: they read the
+// polynomials published by |Append|, which are immutable.  The polynomials
+// removed by |ForgetBefore| are only destroyed once the evaluations that may be
+// using them have completed.
 template<typename Frame>
 class ContinuousTrajectory : public Trajectory<Frame> {
  public:
@@ -75,7 +85,13 @@ class ContinuousTrajectory : public Trajectory<Frame> {
                 DegreesOfFreedom<Frame> const& degrees_of_freedom)
       EXCLUDES(lock_);
 
-  // Removes all data for times strictly less than |time|.
+  // Returns true iff the next call to |Append| will compute a polynomial, as
+  // opposed to just recording a point.  Does not lock.
+  bool next_append_computes_polynomial() const;
+
+  // Removes all data for times strictly less than |time|.  Waits for the
+  // concurrent evaluations that started before the removal to complete, and
+  // then reclaims the memory.
   void ForgetBefore(Instant const& time) EXCLUDES(lock_);
 
   // Implementation of the interface |Trajectory|.
@@ -94,6 +110,35 @@ class ContinuousTrajectory : public Trajectory<Frame> {
 
   // End of the implementation of the interface.
 
+  // A |Cursor| remembers the polynomial last used by a caller, so that
+  // successive evaluations at nearby times don't search through the
+  // polynomials.  Contrary to the hint shared by all the callers of the above
+  // functions, it is not disturbed by the evaluations of other callers.  A
+  // cursor must only be used by one thread at a time and with one trajectory.
+  class Cursor final {
+   public:
+    Cursor() = default;
+
+   private:
+    std::int64_t index_ = 0;
+    friend class ContinuousTrajectory<Frame>;
+  };
+
+  // Same as the above, but use and update |cursor|.
+  Position<Frame> EvaluatePosition(Instant const& time,
+                                   Cursor& cursor) const;
+  Velocity<Frame> EvaluateVelocity(Instant const& time,
+                                   Cursor& cursor) const;
+  DegreesOfFreedom<Frame> EvaluateDegreesOfFreedom(Instant const& time,
+                                                   Cursor& cursor) const;
+
+  // Evaluates the trajectory at each of the |times|, which must be in
+  // increasing order and within the bounds of the trajectory.  The polynomials
+  // are walked linearly, so this is faster than separate calls to
+  // |EvaluatePosition| when the |times| are close to each other.
+  void EvaluatePositions(std::vector<Instant> const& times,
+                         std::vector<Position<Frame>>& positions) const;
+
   // Returns a checkpoint for the current state of this object.
   Checkpoint GetCheckpoint() const EXCLUDES(lock_);
 
@@ -148,17 +193,143 @@ class ContinuousTrajectory : public Trajectory<Frame> {
   // never need to extract their |t_min|.  Logically, the |t_min| for a
   // polynomial is the |t_max| of the previous one.  The first polynomial has a
   // |t_min| which is |*first_time_|.
+  // The polynomials are owned by |arena_|.
   struct InstantPolynomialPair {
     InstantPolynomialPair(
         Instant t_max,
-        not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
-            polynomial);
+        not_null<Polynomial<Displacement<Frame>, Instant> const*> polynomial,
+        int arena_degree);
     Instant t_max;
-    not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
-        polynomial;
+    not_null<Polynomial<Displacement<Frame>, Instant> const*> polynomial;
+    // The degree of |*polynomial| if it is a |NewhallPolynomial|, 0 otherwise.
+    int arena_degree;
   };
   using InstantPolynomialPairs = std::vector<InstantPolynomialPair>;
 
+  // The type of the polynomials produced by
+  // |NewhallApproximationInMonomialBasis|.
+  template<int degree>
+  using NewhallPolynomial = PolynomialInMonomialBasis<Displacement<Frame>,
+                                                      Instant,
+                                                      degree,
+                                                      EstrinEvaluator>;
+
+  // The storage for the polynomials.  The |NewhallPolynomial|s are copied by
+  // value into chunks that each hold polynomials of a single degree, so that
+  // they are contiguous in memory, don't cost an allocation each, and may be
+  // evaluated without virtual calls.  Other polynomials (e.g., those produced
+  // by mocks) are kept on the heap.  For each degree, the polynomials are
+  // forgotten in the order in which they were inserted, so the oldest chunks
+  // are the first to become unused.
+  class PolynomialArena final {
+   public:
+    PolynomialArena();
+
+    // Takes ownership of |polynomial| and returns a pointer to it, which
+    // remains valid until the call to |ReleaseRetired| that follows the call
+    // to |ForgetOldest| for it.  Sets |arena_degree| as documented in
+    // |InstantPolynomialPair|.
+    not_null<Polynomial<Displacement<Frame>, Instant> const*> Insert(
+        not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
+            polynomial,
+        int& arena_degree);
+
+    // Forgets the oldest polynomial inserted with the given |arena_degree|.
+    // The memory that becomes unused is retired, not released.
+    void ForgetOldest(int arena_degree);
+
+    // Releases the memory retired by |ForgetOldest|.
+    void ReleaseRetired();
+
+   private:
+    struct Chunk {
+      virtual ~Chunk() = default;
+      virtual std::int64_t size() const = 0;
+    };
+    template<int degree>
+    struct NewhallPolynomialChunk;
+
+    struct Shelf {
+      std::deque<std::unique_ptr<Chunk>> chunks;
+      // The number of forgotten polynomials in |chunks.front()|.
+      std::int64_t forgotten = 0;
+      std::int64_t next_chunk_capacity;
+    };
+
+    // If |polynomial| is a |NewhallPolynomial<degree>|, copies it into the
+    // shelf for |degree| and returns the copy.  Otherwise returns null.
+    template<int degree>
+    Polynomial<Displacement<Frame>, Instant> const* InsertInShelf(
+        Polynomial<Displacement<Frame>, Instant> const& polynomial);
+
+    using ShelfInserter =
+        Polynomial<Displacement<Frame>, Instant> const* (PolynomialArena::*)(
+            Polynomial<Displacement<Frame>, Instant> const& polynomial);
+
+    // Returns the table of the |InsertInShelf<min_degree + index>|, used to
+    // dispatch on the degree of a polynomial.
+    template<std::size_t... indices>
+    static constexpr std::array<ShelfInserter, sizeof...(indices)>
+    ShelfInserters(std::index_sequence<indices...>);
+
+    // Indexed by degree.
+    std::vector<Shelf> shelves_;
+    std::deque<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
+        heap_polynomials_;
+
+    std::vector<std::unique_ptr<Chunk>> retired_chunks_;
+    std::vector<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
+        retired_heap_polynomials_;
+  };
+
+  // The polynomials as seen by the evaluation functions.  The |entries| below
+  // |size| never change.  When an entry must be added beyond the |capacity|,
+  // the entries are copied to a new object with twice the capacity, which is
+  // then published.  The old object is retired but kept alive, as readers may
+  // still be using it; the total size of the retired objects is less than that
+  // of the published one.
+  struct PublishedPolynomial final {
+    Instant t_max;
+    Polynomial<Displacement<Frame>, Instant> const* polynomial;
+    int arena_degree;
+  };
+  struct PublishedPolynomials final {
+    PublishedPolynomials(Instant const& t_min, std::int64_t capacity);
+    Instant const t_min;
+    std::int64_t const capacity;
+    std::unique_ptr<PublishedPolynomial[]> const entries;
+    std::atomic<std::int64_t> size = 0;
+  };
+
+  // An evaluation holds a |ReaderGuard| while it uses the published objects.
+  // The guard registers the evaluation in the |reader_counts_| of the current
+  // |reader_epoch_|.
+  class ReaderGuard final {
+   public:
+    explicit ReaderGuard(ContinuousTrajectory const& trajectory);
+    ~ReaderGuard();
+
+   private:
+    std::atomic<std::int64_t>& count_;
+  };
+
+  // The number of evaluations in progress.  Each thread increments the counts
+  // of one stripe, so that concurrent evaluations don't fight for the same
+  // cache line.
+  struct alignas(64) ReaderCount final {
+    std::atomic<std::int64_t> count = 0;
+  };
+  static constexpr int reader_count_stripes = 8;
+
+  // The stripe of |reader_counts_| used by the current thread.
+  static int ReaderCountStripe();
+
+  // Returns once the evaluations that started before the call have completed,
+  // so that the objects unpublished before the call may be destroyed.  The
+  // |reader_epoch_| is flipped twice, so that the evaluations that start during
+  // the call don't delay it indefinitely.
+  void WaitForReaders() REQUIRES(lock_);
+
   Instant t_min_locked() const REQUIRES_SHARED(lock_);
   Instant t_max_locked() const REQUIRES_SHARED(lock_);
 
@@ -181,12 +352,46 @@ class ContinuousTrajectory : public Trajectory<Frame> {
       std::vector<Displacement<Frame>> const& q,
       std::vector<Velocity<Frame>> const& v) REQUIRES(lock_);
 
+  // Stores |polynomial| in |arena_| and appends it to |polynomials_|.
+  void AddPolynomial(
+      Instant const& t_max,
+      not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
+          polynomial) REQUIRES(lock_);
+
   // Returns an iterator to the polynomial applicable for the given |time|, or
   // |begin()| if |time| is before the first polynomial or |end()| if |time| is
   // after the last polynomial.  Time complexity is O(N Log N).
   typename InstantPolynomialPairs::const_iterator
   FindPolynomialForInstant(Instant const& time) const REQUIRES_SHARED(lock_);
 
+  // Returns the published polynomial applicable for the given |time|, which
+  // must be within the bounds of the trajectory.  |index| is a hint for the
+  // position of the polynomial in the published polynomials, and is updated to
+  // its actual position.  Does not lock.
+  PublishedPolynomial const& PublishedPolynomialForInstant(
+      Instant const& time,
+      std::int64_t& index) const;
+
+  // Same as above, using |last_accessed_polynomial_| as the hint.
+  PublishedPolynomial const& PublishedPolynomialForInstant(
+      Instant const& time) const;
+
+  // Evaluate the polynomial of |published| without a virtual call if it is a
+  // |NewhallPolynomial|.
+  static Displacement<Frame> EvaluatePublished(
+      PublishedPolynomial const& published,
+      Instant const& time);
+  static Velocity<Frame> EvaluatePublishedDerivative(
+      PublishedPolynomial const& published,
+      Instant const& time);
+
+  // Makes the last element of |polynomials_| visible to the readers.
+  void PublishLastPolynomial() REQUIRES(lock_);
+
+  // Publishes all of |polynomials_| anew and retires all the objects published
+  // so far to |retired_published_polynomials_|.
+  void RepublishPolynomials() REQUIRES(lock_);
+
   mutable absl::Mutex lock_;
 
   // Construction parameters;
@@ -203,9 +408,31 @@ class ContinuousTrajectory : public Trajectory<Frame> {
   int degree_ GUARDED_BY(lock_);
   int degree_age_ GUARDED_BY(lock_);
 
+  PolynomialArena arena_ GUARDED_BY(lock_);
+
   // The polynomials are in increasing time order.
   InstantPolynomialPairs polynomials_ GUARDED_BY(lock_);
 
+  // Null iff there are no published polynomials.  Points to the last element of
+  // |all_published_polynomials_|, which owns the published and the retired
+  // objects.
+  std::atomic<PublishedPolynomials*> published_polynomials_ = nullptr;
+  std::vector<std::unique_ptr<PublishedPolynomials>> all_published_polynomials_
+      GUARDED_BY(lock_);
+
+  // The objects unpublished by |RepublishPolynomials|.  They are kept alive
+  // until |WaitForReaders| has returned, as readers may still be using them.
+  // The same holds for the polynomials retired in |arena_|.
+  std::vector<std::unique_ptr<PublishedPolynomials>>
+      retired_published_polynomials_ GUARDED_BY(lock_);
+
+  // Indexed by the parity of the epoch and by the stripe.  Only modified by the
+  // |ReaderGuard|s.
+  mutable std::array<std::array<ReaderCount, reader_count_stripes>, 2>
+      reader_counts_;
+  // Only modified by |WaitForReaders|.
+  std::atomic<int> reader_epoch_ = 0;
+
   // Lookups into |polynomials_| are expensive because they entail a binary
   // search into a vector that grows over time.  In benchmarks, this can be as
   // costly as the polynomial evaluation itself.  The accesses are not random,
@@ -218,8 +445,10 @@ class ContinuousTrajectory : public Trajectory<Frame> {
   // multithreading it may be that different threads would want to access
   // polynomials at different indices, but by and large the threads progress in
   // parallel, and benchmarks show that there is no adverse performance effects.
-  // Any value in the range of |polynomials_| or 0 is correct.
-  mutable std::int64_t last_accessed_polynomial_ GUARDED_BY(lock_) = 0;
+  // Callers that evaluate at unrelated times should use a |Cursor| instead.
+  // Any value is correct, as it is checked against the range of the published
+  // polynomials.
+  mutable std::atomic<std::int64_t> last_accessed_polynomial_ = 0;
 
   // The time at which this trajectory starts.  Set for a nonempty trajectory.
   std::optional<Instant> first_time_ GUARDED_BY(lock_);
@@ -229,6 +458,9 @@ class ContinuousTrajectory : public Trajectory<Frame> {
   // |last_points_.begin()->first == polynomials_.back().t_max|
   std::vector<std::pair<Instant, DegreesOfFreedom<Frame>>> last_points_
       GUARDED_BY(lock_);
+  // Whether |last_points_| has |divisions| elements, for reading without
+  // locking.  Updated whenever |last_points_| changes.
+  std::atomic<bool> next_append_computes_polynomial_ = false;
 
   friend class TestableContinuousTrajectory<Frame>;
 };
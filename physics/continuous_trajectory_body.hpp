@@ -4,9 +4,11 @@
 #include "physics/continuous_trajectory.hpp"
 
 #include <algorithm>
+#include <iterator>
 #include <limits>
 #include <optional>
 #include <sstream>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -24,7 +26,6 @@ namespace internal_continuous_trajectory {
 
 using base::Error;
 using base::make_not_null_unique;
-using numerics::EstrinEvaluator;
 using numerics::ULPDistance;
 using numerics::ЧебышёвSeries;
 using quantities::DebugString;
@@ -39,6 +40,11 @@ int const max_degree_age = 100;
 // Only supports 8 divisions for now.
 int const divisions = 8;
 
+// The capacities of the chunks of a |PolynomialArena| double from the first to
+// the last, so that short trajectories don't waste memory.
+std::int64_t const first_chunk_capacity = 4;
+std::int64_t const max_chunk_capacity = 256;
+
 template<typename Frame>
 ContinuousTrajectory<Frame>::ContinuousTrajectory(Time const& step,
                                                   Length const& tolerance)
@@ -53,8 +59,7 @@ ContinuousTrajectory<Frame>::ContinuousTrajectory(Time const& step,
 
 template<typename Frame>
 bool ContinuousTrajectory<Frame>::empty() const {
-  absl::ReaderMutexLock l(&lock_);
-  return polynomials_.empty();
+  return published_polynomials_.load(std::memory_order_acquire) == nullptr;
 }
 
 template<typename Frame>
@@ -108,6 +113,7 @@ Status ContinuousTrajectory<Frame>::Append(
     v.push_back(degrees_of_freedom.velocity());
 
     status = ComputeBestNewhallApproximation(time, q, v);
+    PublishLastPolynomial();
 
     // Wipe-out the points that have just been incorporated in a polynomial.
     last_points_.clear();
@@ -117,10 +123,17 @@ Status ContinuousTrajectory<Frame>::Append(
   // approximation, because clearing the map is much more efficient than erasing
   // every element but one.
   last_points_.emplace_back(time, degrees_of_freedom);
+  next_append_computes_polynomial_.store(last_points_.size() == divisions,
+                                         std::memory_order_relaxed);
 
   return status;
 }
 
+template<typename Frame>
+bool ContinuousTrajectory<Frame>::next_append_computes_polynomial() const {
+  return next_append_computes_polynomial_.load(std::memory_order_relaxed);
+}
+
 template<typename Frame>
 void ContinuousTrajectory<Frame>::ForgetBefore(Instant const& time) {
   absl::MutexLock l(&lock_);
@@ -130,67 +143,144 @@ void ContinuousTrajectory<Frame>::ForgetBefore(Instant const& time) {
     return;
   }
 
-  polynomials_.erase(polynomials_.begin(), FindPolynomialForInstant(time));
+  // The forgotten polynomials may still be in use by concurrent readers.
+  auto const first_kept = FindPolynomialForInstant(time);
+  for (auto it = polynomials_.cbegin(); it != first_kept; ++it) {
+    arena_.ForgetOldest(it->arena_degree);
+  }
+  polynomials_.erase(polynomials_.begin(), first_kept);
 
   // If there are no |polynomials_| left, clear everything.  Otherwise, update
   // the first time.
   if (polynomials_.empty()) {
     first_time_ = std::nullopt;
     last_points_.clear();
-    last_accessed_polynomial_ = 0;
+    next_append_computes_polynomial_.store(false, std::memory_order_relaxed);
   } else {
     first_time_ = time;
-    last_accessed_polynomial_ = polynomials_.size() - 1;
   }
+  RepublishPolynomials();
+
+  // The readers that started before the publication are the only ones that may
+  // use the retired objects.
+  WaitForReaders();
+  arena_.ReleaseRetired();
+  retired_published_polynomials_.clear();
 }
 
 template<typename Frame>
 Instant ContinuousTrajectory<Frame>::t_min() const {
-  absl::ReaderMutexLock l(&lock_);
-  return t_min_locked();
+  ReaderGuard const guard(*this);
+  auto const* const published =
+      published_polynomials_.load(std::memory_order_seq_cst);
+  if (published == nullptr) {
+    return astronomy::InfiniteFuture;
+  }
+  return published->t_min;
 }
 
 template<typename Frame>
 Instant ContinuousTrajectory<Frame>::t_max() const {
-  absl::ReaderMutexLock l(&lock_);
-  return t_max_locked();
+  ReaderGuard const guard(*this);
+  auto const* const published =
+      published_polynomials_.load(std::memory_order_seq_cst);
+  if (published == nullptr) {
+    return astronomy::InfinitePast;
+  }
+  std::int64_t const size = published->size.load(std::memory_order_acquire);
+  return published->entries[size - 1].t_max;
 }
 
 template<typename Frame>
 Position<Frame> ContinuousTrajectory<Frame>::EvaluatePosition(
     Instant const& time) const {
-  absl::ReaderMutexLock l(&lock_);
-  CHECK_LE(t_min_locked(), time);
-  CHECK_GE(t_max_locked(), time);
-  auto const it = FindPolynomialForInstant(time);
-  CHECK(it != polynomials_.end());
-  auto const& polynomial = it->polynomial;
-  return polynomial->Evaluate(time) + Frame::origin;
+  ReaderGuard const guard(*this);
+  return EvaluatePublished(PublishedPolynomialForInstant(time), time) +
+         Frame::origin;
 }
 
 template<typename Frame>
 Velocity<Frame> ContinuousTrajectory<Frame>::EvaluateVelocity(
     Instant const& time) const {
-  absl::ReaderMutexLock l(&lock_);
-  CHECK_LE(t_min_locked(), time);
-  CHECK_GE(t_max_locked(), time);
-  auto const it = FindPolynomialForInstant(time);
-  CHECK(it != polynomials_.end());
-  auto const& polynomial = it->polynomial;
-  return polynomial->EvaluateDerivative(time);
+  ReaderGuard const guard(*this);
+  return EvaluatePublishedDerivative(PublishedPolynomialForInstant(time), time);
 }
 
 template<typename Frame>
 DegreesOfFreedom<Frame> ContinuousTrajectory<Frame>::EvaluateDegreesOfFreedom(
     Instant const& time) const {
-  absl::ReaderMutexLock l(&lock_);
-  CHECK_LE(t_min_locked(), time);
-  CHECK_GE(t_max_locked(), time);
-  auto const it = FindPolynomialForInstant(time);
-  CHECK(it != polynomials_.end());
-  auto const& polynomial = it->polynomial;
-  return DegreesOfFreedom<Frame>(polynomial->Evaluate(time) + Frame::origin,
-                                 polynomial->EvaluateDerivative(time));
+  ReaderGuard const guard(*this);
+  auto const& published = PublishedPolynomialForInstant(time);
+  return DegreesOfFreedom<Frame>(
+             EvaluatePublished(published, time) + Frame::origin,
+             EvaluatePublishedDerivative(published, time));
+}
+
+template<typename Frame>
+Position<Frame> ContinuousTrajectory<Frame>::EvaluatePosition(
+    Instant const& time,
+    Cursor& cursor) const {
+  ReaderGuard const guard(*this);
+  return EvaluatePublished(PublishedPolynomialForInstant(time, cursor.index_),
+                           time) +
+         Frame::origin;
+}
+
+template<typename Frame>
+Velocity<Frame> ContinuousTrajectory<Frame>::EvaluateVelocity(
+    Instant const& time,
+    Cursor& cursor) const {
+  ReaderGuard const guard(*this);
+  return EvaluatePublishedDerivative(
+             PublishedPolynomialForInstant(time, cursor.index_), time);
+}
+
+template<typename Frame>
+DegreesOfFreedom<Frame> ContinuousTrajectory<Frame>::EvaluateDegreesOfFreedom(
+    Instant const& time,
+    Cursor& cursor) const {
+  ReaderGuard const guard(*this);
+  auto const& published = PublishedPolynomialForInstant(time, cursor.index_);
+  return DegreesOfFreedom<Frame>(
+             EvaluatePublished(published, time) + Frame::origin,
+             EvaluatePublishedDerivative(published, time));
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::EvaluatePositions(
+    std::vector<Instant> const& times,
+    std::vector<Position<Frame>>& positions) const {
+  positions.clear();
+  if (times.empty()) {
+    return;
+  }
+  ReaderGuard const guard(*this);
+  auto const* const published =
+      published_polynomials_.load(std::memory_order_seq_cst);
+  CHECK(published != nullptr) << "Empty trajectory";
+  std::int64_t const size = published->size.load(std::memory_order_acquire);
+  PublishedPolynomial const* const begin = published->entries.get();
+  PublishedPolynomial const* const end = begin + size;
+  CHECK_LE(published->t_min, times.front());
+  CHECK_GE(std::prev(end)->t_max, times.back());
+
+  positions.reserve(times.size());
+  auto it = std::lower_bound(begin,
+                             end,
+                             times.front(),
+                             [](PublishedPolynomial const& left,
+                                Instant const& right) {
+                               return left.t_max < right;
+                             });
+  Instant previous_time = times.front();
+  for (Instant const& time : times) {
+    DCHECK_LE(previous_time, time) << "Times are not sorted";
+    previous_time = time;
+    while (it->t_max < time) {
+      ++it;
+    }
+    positions.push_back(EvaluatePublished(*it, time) + Frame::origin);
+  }
 }
 
 template<typename Frame>
@@ -260,6 +350,7 @@ ContinuousTrajectory<Frame>::ReadFromMessage(
       std::make_unique<ContinuousTrajectory<Frame>>(
           Time::ReadFromMessage(message.step()),
           Length::ReadFromMessage(message.tolerance()));
+  absl::MutexLock l(&continuous_trajectory->lock_);
   continuous_trajectory->adjusted_tolerance_ =
       Length::ReadFromMessage(message.adjusted_tolerance());
   continuous_trajectory->is_unstable_ = message.is_unstable();
@@ -280,7 +371,7 @@ ContinuousTrajectory<Frame>::ReadFromMessage(
         v.push_back(series.EvaluateDerivative(t));
       }
       Displacement<Frame> error_estimate;  // Should we do something with this?
-      continuous_trajectory->polynomials_.emplace_back(
+      continuous_trajectory->AddPolynomial(
           series.t_max(),
           continuous_trajectory->NewhallApproximationInMonomialBasis(
               series.degree(),
@@ -290,7 +381,7 @@ ContinuousTrajectory<Frame>::ReadFromMessage(
     }
   } else {
     for (auto const& pair : message.instant_polynomial_pair()) {
-      continuous_trajectory->polynomials_.emplace_back(
+      continuous_trajectory->AddPolynomial(
           Instant::ReadFromMessage(pair.t_max()),
           Polynomial<Displacement<Frame>, Instant>::template ReadFromMessage<
               EstrinEvaluator>(pair.polynomial()));
@@ -305,6 +396,10 @@ ContinuousTrajectory<Frame>::ReadFromMessage(
         {Instant::ReadFromMessage(l.instant()),
          DegreesOfFreedom<Frame>::ReadFromMessage(l.degrees_of_freedom())});
   }
+  continuous_trajectory->next_append_computes_polynomial_.store(
+      continuous_trajectory->last_points_.size() == divisions,
+      std::memory_order_relaxed);
+  continuous_trajectory->RepublishPolynomials();
   return continuous_trajectory;
 }
 
@@ -335,10 +430,188 @@ ContinuousTrajectory<Frame>::ContinuousTrajectory() {}
 template<typename Frame>
 ContinuousTrajectory<Frame>::InstantPolynomialPair::InstantPolynomialPair(
     Instant const t_max,
-    not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
-        polynomial)
+    not_null<Polynomial<Displacement<Frame>, Instant> const*> const polynomial,
+    int const arena_degree)
     : t_max(t_max),
-      polynomial(std::move(polynomial)) {}
+      polynomial(polynomial),
+      arena_degree(arena_degree) {}
+
+template<typename Frame>
+template<int degree>
+struct ContinuousTrajectory<Frame>::PolynomialArena::NewhallPolynomialChunk
+    : Chunk {
+  explicit NewhallPolynomialChunk(std::int64_t capacity);
+  std::int64_t size() const override;
+
+  // Never grows beyond its initial capacity, so that the addresses of the
+  // polynomials are stable.
+  std::vector<NewhallPolynomial<degree>> polynomials;
+};
+
+template<typename Frame>
+template<int degree>
+ContinuousTrajectory<Frame>::PolynomialArena::
+NewhallPolynomialChunk<degree>::NewhallPolynomialChunk(
+    std::int64_t const capacity) {
+  polynomials.reserve(capacity);
+}
+
+template<typename Frame>
+template<int degree>
+std::int64_t ContinuousTrajectory<Frame>::PolynomialArena::
+NewhallPolynomialChunk<degree>::size() const {
+  return polynomials.size();
+}
+
+template<typename Frame>
+ContinuousTrajectory<Frame>::PolynomialArena::PolynomialArena()
+    : shelves_(max_degree + 1) {
+  for (auto& shelf : shelves_) {
+    shelf.next_chunk_capacity = first_chunk_capacity;
+  }
+}
+
+template<typename Frame>
+not_null<Polynomial<Displacement<Frame>, Instant> const*>
+ContinuousTrajectory<Frame>::PolynomialArena::Insert(
+    not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
+        polynomial,
+    int& arena_degree) {
+  static constexpr auto shelf_inserters = ShelfInserters(
+      std::make_index_sequence<max_degree - min_degree + 1>());
+  int const degree = polynomial->degree();
+  if (degree >= min_degree && degree <= max_degree) {
+    auto const* const inserted =
+        (this->*shelf_inserters[degree - min_degree])(*polynomial);
+    if (inserted != nullptr) {
+      arena_degree = degree;
+      return inserted;
+    }
+  }
+  // Not a |NewhallPolynomial|, keep it on the heap.
+  arena_degree = 0;
+  heap_polynomials_.push_back(std::move(polynomial));
+  return heap_polynomials_.back().get();
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::PolynomialArena::ForgetOldest(
+    int const arena_degree) {
+  if (arena_degree == 0) {
+    CHECK(!heap_polynomials_.empty());
+    retired_heap_polynomials_.push_back(std::move(heap_polynomials_.front()));
+    heap_polynomials_.pop_front();
+    return;
+  }
+  auto& shelf = shelves_[arena_degree];
+  CHECK(!shelf.chunks.empty());
+  ++shelf.forgotten;
+  if (shelf.forgotten == shelf.chunks.front()->size()) {
+    // All the polynomials of the oldest chunk have been forgotten.  If it is
+    // not full, it is also the newest chunk, and the next insertion will
+    // allocate a new one.
+    retired_chunks_.push_back(std::move(shelf.chunks.front()));
+    shelf.chunks.pop_front();
+    shelf.forgotten = 0;
+  }
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::PolynomialArena::ReleaseRetired() {
+  retired_chunks_.clear();
+  retired_heap_polynomials_.clear();
+}
+
+template<typename Frame>
+template<int degree>
+Polynomial<Displacement<Frame>, Instant> const*
+ContinuousTrajectory<Frame>::PolynomialArena::InsertInShelf(
+    Polynomial<Displacement<Frame>, Instant> const& polynomial) {
+  auto const* const newhall_polynomial =
+      dynamic_cast<NewhallPolynomial<degree> const*>(&polynomial);
+  if (newhall_polynomial == nullptr) {
+    return nullptr;
+  }
+  auto& shelf = shelves_[degree];
+  NewhallPolynomialChunk<degree>* chunk = nullptr;
+  if (!shelf.chunks.empty()) {
+    chunk = static_cast<NewhallPolynomialChunk<degree>*>(
+        shelf.chunks.back().get());
+  }
+  if (chunk == nullptr ||
+      chunk->polynomials.size() == chunk->polynomials.capacity()) {
+    auto new_chunk = std::make_unique<NewhallPolynomialChunk<degree>>(
+        shelf.next_chunk_capacity);
+    shelf.next_chunk_capacity =
+        std::min(2 * shelf.next_chunk_capacity, max_chunk_capacity);
+    chunk = new_chunk.get();
+    shelf.chunks.push_back(std::move(new_chunk));
+  }
+  chunk->polynomials.push_back(*newhall_polynomial);
+  return &chunk->polynomials.back();
+}
+
+template<typename Frame>
+template<std::size_t... indices>
+constexpr auto ContinuousTrajectory<Frame>::PolynomialArena::ShelfInserters(
+    std::index_sequence<indices...>)
+    -> std::array<ShelfInserter, sizeof...(indices)> {
+  return {&PolynomialArena::InsertInShelf<min_degree + indices>...};
+}
+
+template<typename Frame>
+ContinuousTrajectory<Frame>::PublishedPolynomials::PublishedPolynomials(
+    Instant const& t_min,
+    std::int64_t const capacity)
+    : t_min(t_min),
+      capacity(capacity),
+      entries(std::make_unique<PublishedPolynomial[]>(capacity)) {}
+
+template<typename Frame>
+ContinuousTrajectory<Frame>::ReaderGuard::ReaderGuard(
+    ContinuousTrajectory const& trajectory)
+    : count_(trajectory.reader_counts_[trajectory.reader_epoch_.load(
+                                           std::memory_order_seq_cst)]
+                                      [ReaderCountStripe()].count) {
+  // Sequentially consistent, so that either |WaitForReaders| sees this
+  // increment or the evaluation sees the objects published before it.
+  count_.fetch_add(1, std::memory_order_seq_cst);
+}
+
+template<typename Frame>
+ContinuousTrajectory<Frame>::ReaderGuard::~ReaderGuard() {
+  count_.fetch_sub(1, std::memory_order_release);
+}
+
+template<typename Frame>
+int ContinuousTrajectory<Frame>::ReaderCountStripe() {
+  // Constant-initialized, so that accessing it doesn't go through a guard.
+  thread_local int stripe = -1;
+  if (stripe < 0) {
+    static std::atomic<int> next_stripe = 0;
+    stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) %
+             reader_count_stripes;
+  }
+  return stripe;
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::WaitForReaders() {
+  lock_.AssertHeld();
+  // After the first flip, the readers that start register with the other
+  // epoch, so the counts of the previous epoch eventually drop to zero.  The
+  // second flip does the same for the readers that registered with the other
+  // epoch before the first flip.
+  for (int flip = 0; flip < 2; ++flip) {
+    int const epoch = reader_epoch_.load(std::memory_order_relaxed);
+    reader_epoch_.store(1 - epoch, std::memory_order_seq_cst);
+    for (auto const& reader_count : reader_counts_[epoch]) {
+      while (reader_count.count.load(std::memory_order_seq_cst) > 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+}
 
 template<typename Frame>
 Instant ContinuousTrajectory<Frame>::t_min_locked() const {
@@ -395,12 +668,12 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
 
   // Compute the approximation with the current degree.
   Displacement<Frame> displacement_error_estimate;
-  polynomials_.emplace_back(time,
-                            NewhallApproximationInMonomialBasis(
-                                degree_,
-                                q, v,
-                                last_points_.cbegin()->first, time,
-                                displacement_error_estimate));
+  not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
+      polynomial = NewhallApproximationInMonomialBasis(
+                       degree_,
+                       q, v,
+                       last_points_.cbegin()->first, time,
+                       displacement_error_estimate);
 
   // Estimate the error.  For initializing |previous_error_estimate|, any value
   // greater than |error_estimate| will do.
@@ -432,11 +705,11 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
     ++degree_;
     VLOG(1) << "Increasing degree for " << this << " to " <<degree_
             << " because error estimate was " << error_estimate;
-    polynomials_.back().polynomial = NewhallApproximationInMonomialBasis(
-                                         degree_,
-                                         q, v,
-                                         last_points_.cbegin()->first, time,
-                                         displacement_error_estimate);
+    polynomial = NewhallApproximationInMonomialBasis(
+                     degree_,
+                     q, v,
+                     last_points_.cbegin()->first, time,
+                     displacement_error_estimate);
     previous_error_estimate = error_estimate;
     error_estimate = displacement_error_estimate.Norm();
   }
@@ -459,6 +732,7 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
             << " with error estimate " << error_estimate;
   }
 
+  AddPolynomial(time, std::move(polynomial));
   ++degree_age_;
 
   // Check that the tolerance did not explode.
@@ -477,31 +751,189 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
   }
 }
 
+template<typename Frame>
+void ContinuousTrajectory<Frame>::AddPolynomial(
+    Instant const& t_max,
+    not_null<std::unique_ptr<Polynomial<Displacement<Frame>, Instant>>>
+        polynomial) {
+  lock_.AssertHeld();
+  int arena_degree;
+  auto const stored_polynomial =
+      arena_.Insert(std::move(polynomial), arena_degree);
+  polynomials_.emplace_back(t_max, stored_polynomial, arena_degree);
+}
+
 template<typename Frame>
 typename ContinuousTrajectory<Frame>::InstantPolynomialPairs::const_iterator
 ContinuousTrajectory<Frame>::FindPolynomialForInstant(
     Instant const& time) const {
   lock_.AssertReaderHeld();
   // This returns the first polynomial |p| such that |time <= p.t_max|.
-  {
-    auto const begin = polynomials_.begin();
-    auto const it = begin + last_accessed_polynomial_;
-    if (it != polynomials_.end() && time <= it->t_max &&
-        (it == begin || std::prev(it)->t_max < time)) {
-      return it;
+  return std::lower_bound(polynomials_.begin(),
+                          polynomials_.end(),
+                          time,
+                          [](InstantPolynomialPair const& left,
+                             Instant const& right) {
+                            return left.t_max < right;
+                          });
+}
+
+template<typename Frame>
+typename ContinuousTrajectory<Frame>::PublishedPolynomial const&
+ContinuousTrajectory<Frame>::PublishedPolynomialForInstant(
+    Instant const& time,
+    std::int64_t& index) const {
+  auto const* const published =
+      published_polynomials_.load(std::memory_order_seq_cst);
+  CHECK(published != nullptr) << "Empty trajectory";
+  std::int64_t const size = published->size.load(std::memory_order_acquire);
+  PublishedPolynomial const* const begin = published->entries.get();
+  PublishedPolynomial const* const end = begin + size;
+  CHECK_LE(published->t_min, time);
+  CHECK_GE(std::prev(end)->t_max, time);
+
+  // This finds the first polynomial |p| such that |time <= p.t_max|.  The
+  // callers generally evaluate at increasing times, so we try the polynomial at
+  // |index| and the next one before searching.
+  if (index >= 0 && index < size) {
+    auto const it = begin + index;
+    if (time <= it->t_max) {
+      if (it == begin || std::prev(it)->t_max < time) {
+        return *it;
+      }
+    } else if (std::next(it) != end && time <= std::next(it)->t_max) {
+      ++index;
+      return *std::next(it);
+    }
+  }
+  auto const it = std::lower_bound(begin,
+                                   end,
+                                   time,
+                                   [](PublishedPolynomial const& left,
+                                      Instant const& right) {
+                                     return left.t_max < right;
+                                   });
+  index = it - begin;
+  return *it;
+}
+
+template<typename Frame>
+typename ContinuousTrajectory<Frame>::PublishedPolynomial const&
+ContinuousTrajectory<Frame>::PublishedPolynomialForInstant(
+    Instant const& time) const {
+  std::int64_t const last_accessed_polynomial =
+      last_accessed_polynomial_.load(std::memory_order_relaxed);
+  std::int64_t index = last_accessed_polynomial;
+  auto const& published = PublishedPolynomialForInstant(time, index);
+  // Only write the shared hint if it changed, to avoid bouncing its cache line
+  // between the threads.
+  if (index != last_accessed_polynomial) {
+    last_accessed_polynomial_.store(index, std::memory_order_relaxed);
+  }
+  return published;
+}
+
+#define PRINCIPIA_EVALUATE_PUBLISHED_CASE(degree, evaluate)                   \
+  case (degree): {                                                            \
+    using P = NewhallPolynomial<(degree)>;                                    \
+    return static_cast<P const&>(*published.polynomial).P::evaluate(time);    \
+  }
+
+#define PRINCIPIA_EVALUATE_PUBLISHED(evaluate)                                \
+  switch (published.arena_degree) {                                           \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(3, evaluate);                           \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(4, evaluate);                           \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(5, evaluate);                           \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(6, evaluate);                           \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(7, evaluate);                           \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(8, evaluate);                           \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(9, evaluate);                           \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(10, evaluate);                          \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(11, evaluate);                          \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(12, evaluate);                          \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(13, evaluate);                          \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(14, evaluate);                          \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(15, evaluate);                          \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(16, evaluate);                          \
+    PRINCIPIA_EVALUATE_PUBLISHED_CASE(17, evaluate);                          \
+    default:                                                                  \
+      return published.polynomial->evaluate(time);                            \
+  }
+
+template<typename Frame>
+Displacement<Frame> ContinuousTrajectory<Frame>::EvaluatePublished(
+    PublishedPolynomial const& published,
+    Instant const& time) {
+  // The qualified calls are not virtual and may be inlined.
+  PRINCIPIA_EVALUATE_PUBLISHED(Evaluate);
+}
+
+template<typename Frame>
+Velocity<Frame> ContinuousTrajectory<Frame>::EvaluatePublishedDerivative(
+    PublishedPolynomial const& published,
+    Instant const& time) {
+  PRINCIPIA_EVALUATE_PUBLISHED(EvaluateDerivative);
+}
+
+#undef PRINCIPIA_EVALUATE_PUBLISHED
+#undef PRINCIPIA_EVALUATE_PUBLISHED_CASE
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::PublishLastPolynomial() {
+  lock_.AssertHeld();
+  auto* published = published_polynomials_.load(std::memory_order_relaxed);
+  std::int64_t const size =
+      published == nullptr ? 0
+                           : published->size.load(std::memory_order_relaxed);
+  if (published == nullptr || size == published->capacity) {
+    auto new_published = std::make_unique<PublishedPolynomials>(
+        t_min_locked(), /*capacity=*/std::max<std::int64_t>(2 * size, 16));
+    if (published != nullptr) {
+      std::copy(published->entries.get(),
+                published->entries.get() + size,
+                new_published->entries.get());
+    }
+    new_published->size.store(size, std::memory_order_relaxed);
+    published = new_published.get();
+    all_published_polynomials_.push_back(std::move(new_published));
+  }
+  auto const& last = polynomials_.back();
+  published->entries[size] = {last.t_max, last.polynomial, last.arena_degree};
+  published->size.store(size + 1, std::memory_order_release);
+  published_polynomials_.store(published, std::memory_order_release);
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::RepublishPolynomials() {
+  lock_.AssertHeld();
+  // Build the new object before publishing it with a single store: readers
+  // must never observe an empty trajectory while |polynomials_| is not empty.
+  std::unique_ptr<PublishedPolynomials> published;
+  if (!polynomials_.empty()) {
+    published = std::make_unique<PublishedPolynomials>(
+        t_min_locked(), /*capacity=*/2 * polynomials_.size());
+    for (std::int64_t i = 0; i < polynomials_.size(); ++i) {
+      published->entries[i] = {polynomials_[i].t_max,
+                               polynomials_[i].polynomial,
+                               polynomials_[i].arena_degree};
     }
+    published->size.store(polynomials_.size(), std::memory_order_relaxed);
   }
-  {
-    auto const it =
-        std::lower_bound(polynomials_.begin(),
-                         polynomials_.end(),
-                         time,
-                         [](InstantPolynomialPair const& left,
-                            Instant const& right) {
-                           return left.t_max < right;
-                         });
-    last_accessed_polynomial_ = it - polynomials_.begin();
-    return it;
+  // Sequentially consistent, so that |WaitForReaders| sees the readers that
+  // loaded the previous value.
+  published_polynomials_.store(published.get(), std::memory_order_seq_cst);
+
+  // Only now may the objects published so far be retired.
+  std::move(all_published_polynomials_.begin(),
+            all_published_polynomials_.end(),
+            std::back_inserter(retired_published_polynomials_));
+  all_published_polynomials_.clear();
+  if (published == nullptr) {
+    last_accessed_polynomial_.store(0, std::memory_order_relaxed);
+  } else {
+    last_accessed_polynomial_.store(polynomials_.size() - 1,
+                                    std::memory_order_relaxed);
+    all_published_polynomials_.push_back(std::move(published));
   }
 }
 
@@ -2,9 +2,11 @@
 #include "physics/continuous_trajectory.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
 #include <functional>
 #include <limits>
+#include <thread>
 #include <vector>
 
 #include "geometry/frame.hpp"
@@ -770,6 +772,285 @@ TEST_F(ContinuousTrajectoryTest, Checkpoint) {
   }
 }
 
+// Evaluations concurrent with |Append| see the polynomials as they were
+// published, and yield the same results as after the fact.
+TEST_F(ContinuousTrajectoryTest, ConcurrentAppendAndEvaluate) {
+  int const number_of_steps = 8 * 500;
+  int const number_of_readers = 4;
+  Length const distance = 1 * Kilo(Metre);
+  Time const period = 100 * Second;
+  Time const step = 10 * Milli(Second);
+
+  auto position_function = [this, distance, period](Instant const t) {
+    Angle const angle = 2 * π * Radian * (t - t0_) / period;
+    return World::origin +
+        Displacement<World>({
+            distance * Cos(angle),
+            distance * Sin(angle),
+            0 * Metre});
+  };
+  auto velocity_function = [this, distance, period](Instant const t) {
+    AngularFrequency const ω = 2 * π * Radian / period;
+    Angle const angle = ω * (t - t0_);
+    return Velocity<World>({
+        -ω * distance * Sin(angle) / Radian,
+        ω * distance * Cos(angle) / Radian,
+        0 * Metre / Second});
+  };
+
+  auto const expected_trajectory =
+      std::make_unique<ContinuousTrajectory<World>>(
+          step,
+          /*tolerance=*/1 * Milli(Metre));
+  FillTrajectory(number_of_steps,
+                 step,
+                 position_function,
+                 velocity_function,
+                 t0_,
+                 *expected_trajectory);
+
+  auto const actual_trajectory = std::make_unique<ContinuousTrajectory<World>>(
+                                     step,
+                                     /*tolerance=*/1 * Milli(Metre));
+  std::atomic<bool> done = false;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < number_of_readers; ++i) {
+    readers.emplace_back([&actual_trajectory, &expected_trajectory, &done]() {
+      while (!done) {
+        if (actual_trajectory->empty()) {
+          continue;
+        }
+        Instant const t_min = actual_trajectory->t_min();
+        Instant const t_max = actual_trajectory->t_max();
+        for (Instant const& t : {t_min, t_min + (t_max - t_min) / 3, t_max}) {
+          EXPECT_EQ(expected_trajectory->EvaluateDegreesOfFreedom(t),
+                    actual_trajectory->EvaluateDegreesOfFreedom(t));
+        }
+      }
+    });
+  }
+  FillTrajectory(number_of_steps,
+                 step,
+                 position_function,
+                 velocity_function,
+                 t0_,
+                 *actual_trajectory);
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(expected_trajectory->t_max(), actual_trajectory->t_max());
+}
+
+// Evaluations through cursors and batched evaluations yield the same results as
+// the ordinary evaluations, wherever the cursors point.
+TEST_F(ContinuousTrajectoryTest, CursorsAndBatchedEvaluation) {
+  int const number_of_steps = 8 * 100;
+  Length const distance = 1 * Kilo(Metre);
+  Time const period = 10 * Second;
+  Time const step = 10 * Milli(Second);
+
+  auto position_function = [this, distance, period](Instant const t) {
+    Angle const angle = 2 * π * Radian * (t - t0_) / period;
+    return World::origin +
+        Displacement<World>({
+            distance * Cos(angle),
+            distance * Sin(angle),
+            0 * Metre});
+  };
+  auto velocity_function = [this, distance, period](Instant const t) {
+    AngularFrequency const ω = 2 * π * Radian / period;
+    Angle const angle = ω * (t - t0_);
+    return Velocity<World>({
+        -ω * distance * Sin(angle) / Radian,
+        ω * distance * Cos(angle) / Radian,
+        0 * Metre / Second});
+  };
+
+  auto const trajectory = std::make_unique<ContinuousTrajectory<World>>(
+                              step,
+                              /*tolerance=*/1 * Milli(Metre));
+  FillTrajectory(number_of_steps,
+                 step,
+                 position_function,
+                 velocity_function,
+                 t0_,
+                 *trajectory);
+
+  std::vector<Instant> times;
+  for (Instant t = trajectory->t_min();
+       t <= trajectory->t_max();
+       t += step / 3) {
+    times.push_back(t);
+  }
+
+  // A cursor that moves forward, one that moves backward, and one that jumps
+  // between the two ends of the trajectory.
+  ContinuousTrajectory<World>::Cursor forward;
+  ContinuousTrajectory<World>::Cursor backward;
+  ContinuousTrajectory<World>::Cursor jumping;
+  for (int i = 0; i < times.size(); ++i) {
+    Instant const& t = times[i];
+    Instant const& u = times[times.size() - 1 - i];
+    Instant const& v = i % 2 == 0 ? t : u;
+    EXPECT_EQ(trajectory->EvaluateDegreesOfFreedom(t),
+              trajectory->EvaluateDegreesOfFreedom(t, forward));
+    EXPECT_EQ(trajectory->EvaluatePosition(u),
+              trajectory->EvaluatePosition(u, backward));
+    EXPECT_EQ(trajectory->EvaluateVelocity(v),
+              trajectory->EvaluateVelocity(v, jumping));
+  }
+
+  std::vector<Position<World>> positions;
+  trajectory->EvaluatePositions(times, positions);
+  ASSERT_EQ(times.size(), positions.size());
+  for (int i = 0; i < times.size(); ++i) {
+    EXPECT_EQ(trajectory->EvaluatePosition(times[i]), positions[i]);
+  }
+
+  // The cursors remain usable after the trajectory has been truncated.
+  trajectory->ForgetBefore(times[times.size() / 2]);
+  Instant const& t = times.back();
+  EXPECT_EQ(trajectory->EvaluateDegreesOfFreedom(t),
+            trajectory->EvaluateDegreesOfFreedom(t, forward));
+  EXPECT_EQ(trajectory->EvaluatePosition(t),
+            trajectory->EvaluatePosition(t, backward));
+}
+
+// Forgetting the trajectory piecewise releases the storage of the polynomials
+// without disturbing the ones that remain.
+TEST_F(ContinuousTrajectoryTest, ForgetBeforeIncrementally) {
+  int const number_of_steps = 8 * 1000;
+  Length const distance = 1 * Kilo(Metre);
+  Time const step = 10 * Milli(Second);
+
+  // The angular frequency increases over time, so that polynomials of various
+  // degrees are used.
+  Time const scale = 10 * Second;
+  auto position_function = [this, distance, scale](Instant const t) {
+    double const s = (t - t0_) / scale;
+    Angle const angle = 2 * π * Radian * s * s;
+    return World::origin +
+        Displacement<World>({
+            distance * Cos(angle),
+            distance * Sin(angle),
+            0 * Metre});
+  };
+  auto velocity_function = [this, distance, scale](Instant const t) {
+    double const s = (t - t0_) / scale;
+    Angle const angle = 2 * π * Radian * s * s;
+    AngularFrequency const ω = 4 * π * Radian * s / scale;
+    return Velocity<World>({
+        -ω * distance * Sin(angle) / Radian,
+        ω * distance * Cos(angle) / Radian,
+        0 * Metre / Second});
+  };
+
+  auto const expected_trajectory =
+      std::make_unique<ContinuousTrajectory<World>>(
+          step,
+          /*tolerance=*/1 * Milli(Metre));
+  auto const actual_trajectory = std::make_unique<ContinuousTrajectory<World>>(
+                                     step,
+                                     /*tolerance=*/1 * Milli(Metre));
+  for (auto* const trajectory :
+       {expected_trajectory.get(), actual_trajectory.get()}) {
+    FillTrajectory(number_of_steps,
+                   step,
+                   position_function,
+                   velocity_function,
+                   t0_,
+                   *trajectory);
+  }
+  EXPECT_LT(min_degree, actual_trajectory->average_degree());
+
+  Instant const t_max = actual_trajectory->t_max();
+  for (int i = 1; i < 10; ++i) {
+    Instant const t_min = t0_ + i * (t_max - t0_) / 10;
+    actual_trajectory->ForgetBefore(t_min);
+    EXPECT_EQ(t_min, actual_trajectory->t_min());
+    for (Instant t = t_min; t <= t_max; t += 7 * step) {
+      EXPECT_EQ(expected_trajectory->EvaluateDegreesOfFreedom(t),
+                actual_trajectory->EvaluateDegreesOfFreedom(t));
+    }
+  }
+  actual_trajectory->ForgetBefore(t_max + step);
+  EXPECT_TRUE(actual_trajectory->empty());
+}
+
+// Evaluations concurrent with |ForgetBefore|, which republishes the
+// polynomials, never see an empty trajectory and yield the same results as
+// before the fact.
+TEST_F(ContinuousTrajectoryTest, ConcurrentForgetBeforeAndEvaluate) {
+  int const number_of_steps = 8 * 500;
+  int const number_of_readers = 4;
+  int const number_of_forgets = 100;
+  Length const distance = 1 * Kilo(Metre);
+  Time const period = 100 * Second;
+  Time const step = 10 * Milli(Second);
+
+  auto position_function = [this, distance, period](Instant const t) {
+    Angle const angle = 2 * π * Radian * (t - t0_) / period;
+    return World::origin +
+        Displacement<World>({
+            distance * Cos(angle),
+            distance * Sin(angle),
+            0 * Metre});
+  };
+  auto velocity_function = [this, distance, period](Instant const t) {
+    AngularFrequency const ω = 2 * π * Radian / period;
+    Angle const angle = ω * (t - t0_);
+    return Velocity<World>({
+        -ω * distance * Sin(angle) / Radian,
+        ω * distance * Cos(angle) / Radian,
+        0 * Metre / Second});
+  };
+
+  auto const trajectory = std::make_unique<ContinuousTrajectory<World>>(
+                              step,
+                              /*tolerance=*/1 * Milli(Metre));
+  FillTrajectory(number_of_steps,
+                 step,
+                 position_function,
+                 velocity_function,
+                 t0_,
+                 *trajectory);
+  Instant const t_max = trajectory->t_max();
+  Instant const t_middle = t0_ + (t_max - t0_) / 2;
+  auto const expected_at_t_max = trajectory->EvaluateDegreesOfFreedom(t_max);
+  auto const expected_at_t_middle =
+      trajectory->EvaluateDegreesOfFreedom(t_middle);
+
+  std::atomic<bool> done = false;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < number_of_readers; ++i) {
+    readers.emplace_back([&trajectory,
+                          &done,
+                          t_max,
+                          t_middle,
+                          expected_at_t_max,
+                          expected_at_t_middle]() {
+      while (!done) {
+        EXPECT_FALSE(trajectory->empty());
+        EXPECT_EQ(t_max, trajectory->t_max());
+        EXPECT_EQ(expected_at_t_max,
+                  trajectory->EvaluateDegreesOfFreedom(t_max));
+        EXPECT_EQ(expected_at_t_middle,
+                  trajectory->EvaluateDegreesOfFreedom(t_middle));
+      }
+    });
+  }
+  for (int i = 1; i <= number_of_forgets; ++i) {
+    trajectory->ForgetBefore(
+        t0_ + i * (t_middle - t0_) / (number_of_forgets + 1));
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(t_max, trajectory->t_max());
+}
+
 }  // namespace internal_continuous_trajectory
 }  // namespace physics
 }  // namespace principia
@@ -1,18 +1,22 @@
 ﻿
 #pragma once
 
+#include <deque>
 #include <functional>
 #include <list>
 #include <map>
 #include <memory>
 #include <optional>
+#include <utility>
 #include <vector>
 
+#include "base/chunked_map.hpp"
 #include "base/not_constructible.hpp"
 #include "base/not_null.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/named_quantities.hpp"
 #include "numerics/hermite3.hpp"
+#include "physics/compressed_timeline_block.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "physics/forkable.hpp"
 #include "physics/trajectory.hpp"
@@ -26,15 +30,32 @@ FORWARD_DECLARE_FROM(discrete_trajectory,
                      TEMPLATE(typename Frame) class,
                      DiscreteTrajectory);
 
+// Define this macro to 1 to store the timeline of |DiscreteTrajectory| in a
+// |ChunkedMap| instead of a |std::map|.  The chunked timeline uses less memory
+// and is faster to iterate, but it only supports insertions at the ends of the
+// timeline.
+#if !defined(PRINCIPIA_CHUNKED_DISCRETE_TRAJECTORY_TIMELINE)
+#define PRINCIPIA_CHUNKED_DISCRETE_TRAJECTORY_TIMELINE 0
+#endif
+
 // Reopening |internal_forkable| to specialize a template.
 namespace internal_forkable {
 
 using base::not_constructible;
 
+#if PRINCIPIA_CHUNKED_DISCRETE_TRAJECTORY_TIMELINE
+template<typename Frame>
+using DiscreteTrajectoryTimeline =
+    base::ChunkedMap<Instant, DegreesOfFreedom<Frame>>;
+#else
+template<typename Frame>
+using DiscreteTrajectoryTimeline = std::map<Instant, DegreesOfFreedom<Frame>>;
+#endif
+
 template<typename Frame>
 struct ForkableTraits<DiscreteTrajectory<Frame>> : not_constructible {
   using TimelineConstIterator =
-      typename std::map<Instant, DegreesOfFreedom<Frame>>::const_iterator;
+      typename DiscreteTrajectoryTimeline<Frame>::const_iterator;
   static Instant const& time(TimelineConstIterator it);
 };
 
@@ -64,13 +85,14 @@ using quantities::Acceleration;
 using quantities::Length;
 using quantities::Speed;
 using internal_forkable::DiscreteTrajectoryIterator;
+using internal_forkable::DiscreteTrajectoryTimeline;
 using numerics::Hermite3;
 
 template<typename Frame>
 class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
                                            DiscreteTrajectoryIterator<Frame>>,
                            public Trajectory<Frame> {
-  using Timeline = std::map<Instant, DegreesOfFreedom<Frame>>;
+  using Timeline = DiscreteTrajectoryTimeline<Frame>;
   using TimelineConstIterator = typename Forkable<
       DiscreteTrajectory<Frame>,
       DiscreteTrajectoryIterator<Frame>>::TimelineConstIterator;
@@ -98,6 +120,13 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
   // trajectory is owned by its parent trajectory.  Deleting the parent
   // trajectory deletes all child trajectories.  |time| must be one of the times
   // of this trajectory, and must be at or after the fork time, if any.
+  // The copy is lazy: the child is actually forked at the last point of this
+  // trajectory and shares the points after |time|, so this operation is O(1).
+  // The shared points are only copied if one of the trajectories is about to
+  // remove them, or if the child is forked or detached at an earlier time.
+  // Until then, |Fork()| on the child returns the last point of this
+  // trajectory at the time of the fork.  The copy may invalidate the iterators
+  // on the child.
   not_null<DiscreteTrajectory<Frame>*> NewForkWithCopy(Instant const& time);
 
   // Same as above, except that the parent trajectory after the fork point is
@@ -123,6 +152,18 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
   void Append(Instant const& time,
               DegreesOfFreedom<Frame> const& degrees_of_freedom);
 
+  // Appends the given points, which must be in increasing order of time, to
+  // the trajectory.  Equivalent to calling |Append| for each point, but the
+  // checks against the fork time and the forks are only done once, and the
+  // storage for the points is reserved once.
+  void Append(
+      std::vector<std::pair<Instant, DegreesOfFreedom<Frame>>> const& points);
+
+  // Ensures that |size| more points may be appended to this trajectory without
+  // allocating.  Only the chunked timeline preallocates its storage, this is a
+  // no-op for the |std::map| timeline.
+  void Reserve(std::int64_t size);
+
   // Removes all data for times (strictly) greater than |time|, as well as all
   // child trajectories forked at times (strictly) greater than |time|.  |time|
   // must be at or after the fork time, if any.
@@ -146,6 +187,23 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
   // trajectory are going to be retained.
   void ClearDownsampling();
 
+  // This trajectory must be a root.  Following this call, when |Append| leaves
+  // more than |max_uncompressed_points| points uncompressed, the earliest
+  // points are sealed into compressed blocks, as long as they precede the
+  // forks and the points used by downsampling.  The const accessors, e.g.,
+  // iterating from |Begin()| or evaluating, decode the sealed points without
+  // modifying the trajectory.  The operations that need to modify the sealed
+  // points, e.g., forgetting or forking at their time, decompress them, and a
+  // subsequent |Append| seals them again.
+  void SetMemoryBudget(std::int64_t max_uncompressed_points);
+
+  // Decompresses all the sealed points and stops sealing.
+  void ClearMemoryBudget();
+
+  // The number of sealed points and the memory that they use.
+  std::int64_t number_of_sealed_points() const;
+  std::int64_t sealed_size_in_bytes() const;
+
   // Implementation of the interface |Trajectory|.
 
   // The bounds are the times of |Begin()| and |last()| if this trajectory is
@@ -160,6 +218,32 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
 
   // End of the implementation of the interface.
 
+  // A |Cursor| remembers the interpolation of the segment last used by a
+  // caller, so that successive evaluations in the same segment only evaluate a
+  // polynomial.  It is invalidated when points are removed from the trajectory
+  // or from its ancestors.  A cursor must only be used by one thread at a time
+  // and with one trajectory.
+  class Cursor final {
+   public:
+    Cursor() = default;
+
+   private:
+    // The interpolation of the segment ]lower_time_, upper_time_], or of
+    // |t_min()| if the two times are equal.  Valid if |generation_| is that of
+    // the trajectory.
+    std::int64_t generation_ = -1;
+    Instant lower_time_;
+    Instant upper_time_;
+    std::optional<Hermite3<Instant, Position<Frame>>> interpolation_;
+    friend class DiscreteTrajectory<Frame>;
+  };
+
+  // Same as the above, but use and update |cursor|.
+  Position<Frame> EvaluatePosition(Instant const& time, Cursor& cursor) const;
+  Velocity<Frame> EvaluateVelocity(Instant const& time, Cursor& cursor) const;
+  DegreesOfFreedom<Frame> EvaluateDegreesOfFreedom(Instant const& time,
+                                                   Cursor& cursor) const;
+
   // This trajectory must be a root.  Only the given |forks| are serialized.
   // They must be descended from this trajectory.  The pointers in |forks| may
   // be null at entry.
@@ -188,6 +272,13 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
   bool timeline_empty() const override;
   std::int64_t timeline_size() const override;
 
+  Instant serialized_fork_time() const override;
+
+  std::int64_t sealed_blocks_size() const override;
+  std::int64_t sealed_blocks_lower_bound(Instant const& time) const override;
+  internal_forkable::SealedBlock<DiscreteTrajectory> sealed_block(
+      std::int64_t index) const override;
+
  private:
   class Downsampling {
    public:
@@ -199,22 +290,28 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
     TimelineConstIterator start_of_dense_timeline() const;
     // |start_of_dense_timeline()->first|, for readability.
     Instant const& first_dense_time() const;
-    // Keeps |dense_intervals_| consistent with the new
+    // Keeps the iterators to the dense points consistent with the new
     // |start_of_dense_timeline_|.
     void SetStartOfDenseTimeline(TimelineConstIterator value,
                                  Timeline const& timeline);
 
-    // Sets |dense_intervals_| to
-    // |std::distance(start_of_dense_timeline_, timeline.end()) - 1|.  This is
-    // linear in the value of |dense_intervals_|.
+    // Resets the iterators to the dense points to those of
+    // [start_of_dense_timeline_, timeline.end()[.  This is linear in the
+    // number of dense intervals.
     void RecountDenseIntervals(Timeline const& timeline);
-    // Increments |dense_intervals_|.  The caller must ensure that this is
-    // equivalent to |RecountDenseIntervals(timeline)|.  This is checked in
-    // debug mode.
+    // Records the last point of |timeline| as a dense point.  The caller must
+    // ensure that this is equivalent to |RecountDenseIntervals(timeline)|.
+    // This is checked in debug mode.
     void increment_dense_intervals(Timeline const& timeline);
 
-    std::int64_t max_dense_intervals() const;
-    bool reached_max_dense_intervals() const;
+    // If the dense timeline must be downsampled, returns the right endpoint of
+    // the first downsampled interval: the points strictly between
+    // |start_of_dense_timeline()| and that endpoint may be removed, and the
+    // endpoint becomes the new start of the dense timeline.  Otherwise returns
+    // |std::nullopt|.  The fit is only checked when the number of dense
+    // intervals reaches a power of 2 or |max_dense_intervals_|, so that the
+    // cost is amortized over the appended points.
+    std::optional<TimelineConstIterator> FindRightEndpoint() const;
 
     Length tolerance() const;
 
@@ -226,21 +323,56 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
         Timeline const& timeline);
 
    private:
-    // The maximal value that |dense_intervals| is allowed to reach before
-    // downsampling occurs.
+    // Returns true if the |Hermite3| interpolation of the start of the dense
+    // timeline and of the point |dense_intervals| after it fits the points in
+    // between within |tolerance_|.
+    bool Fits(std::int64_t dense_intervals) const;
+
+    // The maximal number of dense intervals before downsampling occurs.
     std::int64_t const max_dense_intervals_;
-    // The tolerance for downsampling with |FitHermiteSpline|.
+    // The tolerance for the |Hermite3| interpolation of the downsampled
+    // intervals.
     Length const tolerance_;
     // An iterator to the first point of the timeline which is not the left
     // endpoint of a downsampled interval.  Not |timeline_.end()| if the
     // timeline is nonempty.
     TimelineConstIterator start_of_dense_timeline_;
-    // |std::distance(start_of_dense_timeline, timeline_.cend()) - 1|.  Kept as
-    // an optimization for |Append| as it can be maintained by incrementing,
-    // whereas |std::distance| is linear in the value of the result.
-    std::int64_t dense_intervals_;
+    // The iterators to the points of [start_of_dense_timeline_,
+    // timeline_.end()[.  The capacity is reserved at construction so that
+    // appending doesn't allocate.
+    std::vector<TimelineConstIterator> dense_iterators_;
   };
 
+  // If this trajectory shares points of its parent because it was created by
+  // |NewForkWithCopy|, copies these points at the beginning of its timeline
+  // and moves its fork point back to the time requested from
+  // |NewForkWithCopy|.  Otherwise does nothing.
+  void UnshareParentPoints();
+
+  // Returns the children of this trajectory which share some of its points.
+  std::vector<not_null<DiscreteTrajectory<Frame>*>> ChildrenSharingPoints();
+
+  // Appends one point at the end of |timeline_| and downsamples if needed.  The
+  // caller must have checked that |time| is after the fork time, and that there
+  // are no forks before |time| if downsampling is enabled.
+  void AppendToTimeline(Instant const& time,
+                        DegreesOfFreedom<Frame> const& degrees_of_freedom);
+
+  // Seals the earliest points of the timeline if they exceed the memory
+  // budget.
+  void Seal();
+
+  // Puts the points of the sealed blocks back in the timeline until its first
+  // point is before |time|.
+  void Unseal(Instant const& time);
+
+  struct DecodedSealedBlock;
+
+  // Returns the decoded points of the sealed block at |index|, reusing
+  // |last_decoded_sealed_block_| if possible.
+  std::shared_ptr<DecodedSealedBlock const> DecodeSealedBlock(
+      std::int64_t index) const;
+
   // This trajectory need not be a root.
   void WriteSubTreeToMessage(
       not_null<serialization::DiscreteTrajectory*> message,
@@ -257,10 +389,45 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
   Hermite3<Instant, Position<Frame>> GetInterpolation(
       Instant const& time) const;
 
+  // Same as above, but reuses the interpolation remembered by |cursor| if
+  // |time| is in its segment, and otherwise remembers the new one.
+  Hermite3<Instant, Position<Frame>> const& GetInterpolation(
+      Instant const& time,
+      Cursor& cursor) const;
+
+  // Must be called when points are removed from this trajectory or from its
+  // ancestors, as it may invalidate the interpolations remembered by the
+  // cursors of this trajectory and of its descendants.
+  void InvalidateCursors();
+
   Timeline timeline_;
 
+  // Set if this trajectory was created by |NewForkWithCopy| and shares the
+  // points of its parent timeline after this iterator, up to and including its
+  // actual fork point.
+  std::optional<TimelineConstIterator> requested_fork_point_;
+
   std::optional<Downsampling> downsampling_;
 
+  std::optional<std::int64_t> max_uncompressed_points_;
+  // The earliest points of a root trajectory, in increasing order of time.
+  // They all precede the points of |timeline_|, which is not empty if this is
+  // not empty.
+  std::deque<CompressedTimelineBlock<Frame>> sealed_blocks_;
+
+  // The block last decoded by |DecodeSealedBlock|, which is reused as long as
+  // the iterators and the cursors stay in it.  Concurrent const accessors replace
+  // it atomically.  Reset when |sealed_blocks_| loses blocks, as their indices
+  // may then be reused.
+  struct DecodedSealedBlock final {
+    std::int64_t index;
+    Timeline timeline;
+  };
+  mutable std::shared_ptr<DecodedSealedBlock const> last_decoded_sealed_block_;
+
+  // Incremented by |InvalidateCursors|.
+  std::int64_t cursor_generation_ = 0;
+
   template<typename, typename>
   friend class internal_forkable::ForkableIterator;
   template<typename, typename>
@@ -4,14 +4,17 @@
 #include "physics/discrete_trajectory.hpp"
 
 #include <algorithm>
+#include <iterator>
 #include <list>
 #include <map>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include "astronomy/epoch.hpp"
+#include "base/ranges.hpp"
 #include "geometry/named_quantities.hpp"
 #include "glog/logging.h"
-#include "numerics/fit_hermite_spline.hpp"
 
 namespace principia {
 namespace physics {
@@ -55,7 +58,10 @@ namespace internal_discrete_trajectory {
 using astronomy::InfiniteFuture;
 using astronomy::InfinitePast;
 using base::make_not_null_unique;
-using numerics::FitHermiteSpline;
+using base::Range;
+
+// The number of points in a block sealed by |Seal|.
+constexpr std::int64_t points_per_sealed_block = 1000;
 
 template<typename Frame>
 typename DiscreteTrajectory<Frame>::Iterator
@@ -66,24 +72,38 @@ DiscreteTrajectory<Frame>::last() const {
 template<typename Frame>
 not_null<DiscreteTrajectory<Frame>*>
 DiscreteTrajectory<Frame>::NewForkWithCopy(Instant const& time) {
+  Unseal(time);
+  if (requested_fork_point_.has_value() && time < this->Fork().time()) {
+    UnshareParentPoints();
+  }
+
   // May be at |timeline_end()| if |time| is the fork time of this object.
-  auto timeline_it = timeline_.find(time);
+  auto const timeline_it = timeline_.find(time);
   CHECK(timeline_it != timeline_end() ||
         (!this->is_root() && time == this->Fork().time()))
       << "NewForkWithCopy at nonexistent time " << time;
 
-  auto const fork = this->NewFork(timeline_it);
-
-  // Copy the tail of the trajectory in the child object.
-  if (timeline_it != timeline_.end()) {
-    fork->timeline_.insert(++timeline_it, timeline_.end());
+  // If there is no tail to copy, this is an ordinary fork.
+  if (timeline_it == timeline_.end() ||
+      timeline_it == std::prev(timeline_.end())) {
+    return this->NewFork(timeline_it);
   }
+
+  // Instead of copying the tail of the trajectory in the child object, fork at
+  // the last point and share the tail.
+  auto const fork = this->NewFork(std::prev(timeline_.end()));
+  fork->requested_fork_point_ = timeline_it;
   return fork;
 }
 
 template<typename Frame>
 not_null<DiscreteTrajectory<Frame>*>
 DiscreteTrajectory<Frame>::NewForkWithoutCopy(Instant const& time) {
+  Unseal(time);
+  if (requested_fork_point_.has_value() && time < this->Fork().time()) {
+    UnshareParentPoints();
+  }
+
   // May be at |timeline_end()| if |time| is the fork time of this object.
   auto timeline_it = timeline_.find(time);
   CHECK(timeline_it != timeline_end() ||
@@ -109,6 +129,7 @@ void DiscreteTrajectory<Frame>::AttachFork(
     not_null<std::unique_ptr<DiscreteTrajectory<Frame>>> fork) {
   CHECK(fork->is_root());
   CHECK(!this->Empty());
+  fork->ClearMemoryBudget();
 
   auto& fork_timeline = fork->timeline_;
   auto const this_last = last();
@@ -139,6 +160,18 @@ void DiscreteTrajectory<Frame>::AttachFork(
                                this_last.degrees_of_freedom());
   }
 
+  // The children of |fork| which share the points after its first point must
+  // copy them, as that point is going to be removed.
+  for (auto const child : fork->ChildrenSharingPoints()) {
+    if (*child->requested_fork_point_ == fork_timeline.begin()) {
+      child->UnshareParentPoints();
+    }
+  }
+
+  // The points of |fork| and of its descendants before its first point are
+  // about to change.
+  fork->InvalidateCursors();
+
   // Attach |fork| to this trajectory.
   this->AttachForkToCopiedBegin(std::move(fork));
 
@@ -154,6 +187,7 @@ template<typename Frame>
 not_null<std::unique_ptr<DiscreteTrajectory<Frame>>>
 DiscreteTrajectory<Frame>::DetachFork() {
   CHECK(!this->is_root());
+  UnshareParentPoints();
 
   // Insert a new point in the timeline for the fork time.  It should go at the
   // beginning of the timeline.
@@ -161,6 +195,7 @@ DiscreteTrajectory<Frame>::DetachFork() {
   auto const begin_it = timeline_.emplace_hint(
       timeline_.begin(), fork_it.time(), fork_it.degrees_of_freedom());
   CHECK(begin_it == timeline_.begin());
+  InvalidateCursors();
 
   // Detach this trajectory and tell the caller that it owns the pieces.
   return this->DetachForkWithCopiedBegin();
@@ -176,10 +211,61 @@ void DiscreteTrajectory<Frame>::Append(
 
   if (!timeline_.empty() && timeline_.cbegin()->first == time) {
     LOG(WARNING) << "Append at existing time " << time
-                 << ", time range = [" << this->Begin().time() << ", "
+                 << ", time range = [" << t_min() << ", "
                  << last().time() << "]";
     return;
   }
+  if (downsampling_.has_value() && !timeline_.empty()) {
+    this->CheckNoForksBefore(time);
+  }
+  AppendToTimeline(time, degrees_of_freedom);
+  Seal();
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::Append(
+    std::vector<std::pair<Instant, DegreesOfFreedom<Frame>>> const& points) {
+  if (points.empty()) {
+    return;
+  }
+  Instant const& first_time = points.front().first;
+  Instant const& last_time = points.back().first;
+  CHECK(this->is_root() || first_time > this->Fork().time())
+       << "Append at " << first_time << " which is before fork time "
+       << this->Fork().time();
+
+  // Only the first point may be at an existing time, the others are checked
+  // for order by |AppendToTimeline|.
+  auto first = points.begin();
+  if (!timeline_.empty() && timeline_.cbegin()->first == first_time) {
+    LOG(WARNING) << "Append at existing time " << first_time
+                 << ", time range = [" << t_min() << ", "
+                 << last().time() << "]";
+    ++first;
+  }
+  // The forks can only be at existing points, so checking against the last
+  // point is equivalent to checking each point.
+  if (downsampling_.has_value() && !timeline_.empty()) {
+    this->CheckNoForksBefore(last_time);
+  }
+  Reserve(points.end() - first);
+  for (auto it = first; it != points.end(); ++it) {
+    AppendToTimeline(it->first, it->second);
+  }
+  Seal();
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::Reserve(std::int64_t const size) {
+#if PRINCIPIA_CHUNKED_DISCRETE_TRAJECTORY_TIMELINE
+  timeline_.reserve(timeline_.size() + size);
+#endif
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::AppendToTimeline(
+    Instant const& time,
+    DegreesOfFreedom<Frame> const& degrees_of_freedom) {
   auto it = timeline_.emplace_hint(timeline_.end(),
                                    time,
                                    degrees_of_freedom);
@@ -191,34 +277,17 @@ void DiscreteTrajectory<Frame>::Append(
     if (timeline_.size() == 1) {
       downsampling_->SetStartOfDenseTimeline(timeline_.begin(), timeline_);
     } else {
-      this->CheckNoForksBefore(last().time());
       downsampling_->increment_dense_intervals(timeline_);
-      if (downsampling_->reached_max_dense_intervals()) {
-        std::vector<TimelineConstIterator> dense_iterators;
-        // This contains points, hence one more than intervals.
-        dense_iterators.reserve(downsampling_->max_dense_intervals() + 1);
-        for (TimelineConstIterator it =
-                 downsampling_->start_of_dense_timeline();
-             it != timeline_.end();
-             ++it) {
-          dense_iterators.push_back(it);
-        }
-        auto right_endpoints = FitHermiteSpline<Instant, Position<Frame>>(
-            dense_iterators,
-            [](auto&& it) -> auto&& { return it->first; },
-            [](auto&& it) -> auto&& { return it->second.position(); },
-            [](auto&& it) -> auto&& { return it->second.velocity(); },
-            downsampling_->tolerance());
-        if (right_endpoints.empty()) {
-          right_endpoints.push_back(dense_iterators.end() - 1);
-        }
-        TimelineConstIterator left = downsampling_->start_of_dense_timeline();
-        for (const auto& it_in_dense_iterators : right_endpoints) {
-          TimelineConstIterator const right = *it_in_dense_iterators;
-          timeline_.erase(++left, right);
-          left = right;
-        }
-        downsampling_->SetStartOfDenseTimeline(left, timeline_);
+      // Remove the points that are fitted by the Hermite interpolation of
+      // their neighbours.  There are no forks in the dense timeline, and this
+      // doesn't allocate.
+      while (auto const right_endpoint = downsampling_->FindRightEndpoint()) {
+        downsampling_->SetStartOfDenseTimeline(
+            timeline_.erase(
+                std::next(downsampling_->start_of_dense_timeline()),
+                *right_endpoint),
+            timeline_);
+        ++cursor_generation_;
       }
     }
   }
@@ -226,6 +295,19 @@ void DiscreteTrajectory<Frame>::Append(
 
 template<typename Frame>
 void DiscreteTrajectory<Frame>::ForgetAfter(Instant const& time) {
+  Unseal(time);
+  // The shared points that are about to be removed must first be copied by the
+  // trajectories that retain them.
+  if (requested_fork_point_.has_value() && time < this->Fork().time()) {
+    UnshareParentPoints();
+  }
+  for (auto const child : ChildrenSharingPoints()) {
+    if ((*child->requested_fork_point_)->first <= time &&
+        time < child->Fork().time()) {
+      child->UnshareParentPoints();
+    }
+  }
+
   this->DeleteAllForksAfter(time);
 
   // Get an iterator denoting the first entry with time > |time|.  Remove that
@@ -254,6 +336,8 @@ void DiscreteTrajectory<Frame>::ForgetAfter(Instant const& time) {
     }
   }
   timeline_.erase(first_removed_in_timeline, timeline_.end());
+  // The forks after |time| were deleted, the others are not affected.
+  ++cursor_generation_;
   if (downsampling_.has_value()) {
     downsampling_->RecountDenseIntervals(timeline_);
   }
@@ -261,8 +345,20 @@ void DiscreteTrajectory<Frame>::ForgetAfter(Instant const& time) {
 
 template<typename Frame>
 void DiscreteTrajectory<Frame>::ForgetBefore(Instant const& time) {
+  // A child sharing points is recorded at its actual fork time, but it must be
+  // checked at its requested fork time.
+  for (auto const child : ChildrenSharingPoints()) {
+    if ((*child->requested_fork_point_)->first < time) {
+      child->UnshareParentPoints();
+    }
+  }
   this->CheckNoForksBefore(time);
 
+  // The points that are still sealed are all before |time|.
+  Unseal(time);
+  sealed_blocks_.clear();
+  std::atomic_store(&last_decoded_sealed_block_, {});
+
   // Get an iterator denoting the first entry with time >= |time|.  Remove all
   // the entries that precede it.  This preserves any entry with time == |time|.
   auto const first_kept_in_timeline = timeline_.lower_bound(time);
@@ -273,6 +369,7 @@ void DiscreteTrajectory<Frame>::ForgetBefore(Instant const& time) {
     downsampling_->SetStartOfDenseTimeline(first_kept_in_timeline, timeline_);
   }
   timeline_.erase(timeline_.begin(), first_kept_in_timeline);
+  InvalidateCursors();
 }
 
 template<typename Frame>
@@ -281,6 +378,7 @@ void DiscreteTrajectory<Frame>::SetDownsampling(
     Length const& tolerance) {
   CHECK(this->is_root());
   CHECK(!downsampling_.has_value());
+  Unseal(InfinitePast);
   downsampling_.emplace(
       max_dense_intervals, tolerance, timeline_.begin(), timeline_);
 }
@@ -289,8 +387,45 @@ void DiscreteTrajectory<Frame>::ClearDownsampling() {
   downsampling_.reset();
 }
 
+template<typename Frame>
+void DiscreteTrajectory<Frame>::SetMemoryBudget(
+    std::int64_t const max_uncompressed_points) {
+  CHECK(this->is_root());
+  max_uncompressed_points_ = max_uncompressed_points;
+  Seal();
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::ClearMemoryBudget() {
+  max_uncompressed_points_.reset();
+  Unseal(InfinitePast);
+}
+
+template<typename Frame>
+std::int64_t DiscreteTrajectory<Frame>::number_of_sealed_points() const {
+  std::int64_t number_of_sealed_points = 0;
+  for (auto const& block : sealed_blocks_) {
+    number_of_sealed_points += block.size();
+  }
+  return number_of_sealed_points;
+}
+
+template<typename Frame>
+std::int64_t DiscreteTrajectory<Frame>::sealed_size_in_bytes() const {
+  std::int64_t sealed_size_in_bytes = 0;
+  for (auto const& block : sealed_blocks_) {
+    sealed_size_in_bytes += block.size_in_bytes();
+  }
+  return sealed_size_in_bytes;
+}
+
 template<typename Frame>
 Instant DiscreteTrajectory<Frame>::t_min() const {
+  // Don't decode a sealed block of the root just to get its first time.
+  auto const root = this->root();
+  if (!root->sealed_blocks_.empty()) {
+    return root->sealed_blocks_.front().first_time();
+  }
   return this->Empty() ? InfiniteFuture : this->Begin().time();
 }
 
@@ -318,6 +453,28 @@ DegreesOfFreedom<Frame> DiscreteTrajectory<Frame>::EvaluateDegreesOfFreedom(
   return {interpolation.Evaluate(time), interpolation.EvaluateDerivative(time)};
 }
 
+template<typename Frame>
+Position<Frame> DiscreteTrajectory<Frame>::EvaluatePosition(
+    Instant const& time,
+    Cursor& cursor) const {
+  return GetInterpolation(time, cursor).Evaluate(time);
+}
+
+template<typename Frame>
+Velocity<Frame> DiscreteTrajectory<Frame>::EvaluateVelocity(
+    Instant const& time,
+    Cursor& cursor) const {
+  return GetInterpolation(time, cursor).EvaluateDerivative(time);
+}
+
+template<typename Frame>
+DegreesOfFreedom<Frame> DiscreteTrajectory<Frame>::EvaluateDegreesOfFreedom(
+    Instant const& time,
+    Cursor& cursor) const {
+  auto const& interpolation = GetInterpolation(time, cursor);
+  return {interpolation.Evaluate(time), interpolation.EvaluateDerivative(time)};
+}
+
 template<typename Frame>
 void DiscreteTrajectory<Frame>::WriteToMessage(
     not_null<serialization::DiscreteTrajectory*> const message,
@@ -391,7 +548,84 @@ bool DiscreteTrajectory<Frame>::timeline_empty() const {
 
 template<typename Frame>
 std::int64_t DiscreteTrajectory<Frame>::timeline_size() const {
-  return timeline_.size();
+  return timeline_.size() + number_of_sealed_points();
+}
+
+template<typename Frame>
+Instant DiscreteTrajectory<Frame>::serialized_fork_time() const {
+  if (requested_fork_point_.has_value()) {
+    return (*requested_fork_point_)->first;
+  }
+  return Forkable<DiscreteTrajectory, Iterator>::serialized_fork_time();
+}
+
+template<typename Frame>
+std::int64_t DiscreteTrajectory<Frame>::sealed_blocks_size() const {
+  return sealed_blocks_.size();
+}
+
+template<typename Frame>
+std::int64_t DiscreteTrajectory<Frame>::sealed_blocks_lower_bound(
+    Instant const& time) const {
+  return std::partition_point(sealed_blocks_.begin(),
+                              sealed_blocks_.end(),
+                              [&time](CompressedTimelineBlock<Frame> const&
+                                          block) {
+                                return block.last_time() < time;
+                              }) -
+         sealed_blocks_.begin();
+}
+
+template<typename Frame>
+internal_forkable::SealedBlock<DiscreteTrajectory<Frame>>
+DiscreteTrajectory<Frame>::sealed_block(std::int64_t const index) const {
+  std::shared_ptr<DecodedSealedBlock const> decoded = DecodeSealedBlock(index);
+  auto const begin = decoded->timeline.cbegin();
+  auto const end = decoded->timeline.cend();
+  return {index, std::move(decoded), begin, end};
+}
+
+template<typename Frame>
+std::shared_ptr<typename DiscreteTrajectory<Frame>::DecodedSealedBlock const>
+DiscreteTrajectory<Frame>::DecodeSealedBlock(std::int64_t const index) const {
+  CHECK_LE(0, index);
+  CHECK_LT(index, sealed_blocks_.size());
+  std::shared_ptr<DecodedSealedBlock const> decoded =
+      std::atomic_load(&last_decoded_sealed_block_);
+  if (decoded == nullptr || decoded->index != index) {
+    auto new_decoded = std::make_shared<DecodedSealedBlock>();
+    new_decoded->index = index;
+    Timeline& timeline = new_decoded->timeline;
+    sealed_blocks_[index].ForEach(
+        [&timeline](Instant const& time,
+                    DegreesOfFreedom<Frame> const& degrees_of_freedom) {
+          timeline.emplace_hint(timeline.end(), time, degrees_of_freedom);
+        });
+    decoded = std::move(new_decoded);
+    std::atomic_store(&last_decoded_sealed_block_, decoded);
+  }
+  return decoded;
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::Unseal(Instant const& time) {
+  while (!sealed_blocks_.empty() &&
+         (timeline_.empty() || timeline_.begin()->first >= time)) {
+    auto const& block = sealed_blocks_.back();
+    std::vector<std::pair<Instant, DegreesOfFreedom<Frame>>> points;
+    points.reserve(block.size());
+    block.ForEach([&points](Instant const& t,
+                            DegreesOfFreedom<Frame> const& degrees_of_freedom) {
+      points.emplace_back(t, degrees_of_freedom);
+    });
+    // Insert the points in decreasing order of time so that the timeline is
+    // only modified at its beginning.
+    for (auto it = points.crbegin(); it != points.crend(); ++it) {
+      timeline_.emplace_hint(timeline_.begin(), it->first, it->second);
+    }
+    sealed_blocks_.pop_back();
+    std::atomic_store(&last_decoded_sealed_block_, {});
+  }
 }
 
 template<typename Frame>
@@ -403,6 +637,8 @@ DiscreteTrajectory<Frame>::Downsampling::Downsampling(
     : max_dense_intervals_(max_dense_intervals),
       tolerance_(tolerance),
       start_of_dense_timeline_(start_of_dense_timeline) {
+  // This contains points, hence one more than intervals.
+  dense_iterators_.reserve(max_dense_intervals_ + 1);
   RecountDenseIntervals(timeline);
 }
 
@@ -429,28 +665,61 @@ void DiscreteTrajectory<Frame>::Downsampling::SetStartOfDenseTimeline(
 template<typename Frame>
 void DiscreteTrajectory<Frame>::Downsampling::RecountDenseIntervals(
     Timeline const& timeline) {
-  dense_intervals_ =
-      std::distance(start_of_dense_timeline_, timeline.end()) - 1;
+  // The iterators must be recomputed because erasing in the middle of the
+  // timeline may invalidate them.
+  dense_iterators_.clear();
+  for (auto it = start_of_dense_timeline_; it != timeline.end(); ++it) {
+    dense_iterators_.push_back(it);
+  }
 }
 
 template<typename Frame>
 void DiscreteTrajectory<Frame>::Downsampling::increment_dense_intervals(
     Timeline const& timeline) {
-  ++dense_intervals_;
-  DCHECK_EQ(dense_intervals_,
-            std::distance(start_of_dense_timeline_, timeline.end()) - 1);
+  dense_iterators_.push_back(std::prev(timeline.end()));
+  DCHECK_EQ(static_cast<std::int64_t>(dense_iterators_.size()),
+            std::distance(start_of_dense_timeline_, timeline.end()));
 }
 
 template<typename Frame>
-std::int64_t DiscreteTrajectory<Frame>::Downsampling::max_dense_intervals()
-    const {
-  return max_dense_intervals_;
-}
+std::optional<typename DiscreteTrajectory<Frame>::TimelineConstIterator>
+DiscreteTrajectory<Frame>::Downsampling::FindRightEndpoint() const {
+  std::int64_t const dense_intervals =
+      static_cast<std::int64_t>(dense_iterators_.size()) - 1;
+  if (dense_intervals < 1) {
+    return std::nullopt;
+  }
+  bool const must_downsample = dense_intervals >= max_dense_intervals_;
+  bool const is_power_of_2 = (dense_intervals & (dense_intervals - 1)) == 0;
+  if (!must_downsample && !is_power_of_2) {
+    return std::nullopt;
+  }
+  if (Fits(dense_intervals)) {
+    if (must_downsample) {
+      return dense_iterators_.back();
+    }
+    return std::nullopt;
+  }
 
-template<typename Frame>
-bool DiscreteTrajectory<Frame>::Downsampling::reached_max_dense_intervals()
-    const {
-  return dense_intervals_ >= max_dense_intervals_;
+  // Look for an interpolation that fits the beginning of the dense timeline
+  // and such that the interpolation fitting one more point would not fit.  As
+  // in |FitHermiteSpline|, we do not look for the longest such interpolation.
+  // Invariant: The interpolation on [0, lower] fits (trivially so if |lower|
+  // is 1), the interpolation on [0, upper] does not.
+  std::int64_t lower = 1;
+  std::int64_t upper = dense_intervals;
+  for (;;) {
+    std::int64_t const middle = lower + (upper - lower) / 2;
+    if (middle == lower) {
+      break;
+    }
+    if (Fits(middle)) {
+      lower = middle;
+    } else {
+      upper = middle;
+    }
+  }
+  return dense_iterators_[lower];
 }
 
 template<typename Frame>
@@ -458,6 +727,22 @@ Length DiscreteTrajectory<Frame>::Downsampling::tolerance() const {
   return tolerance_;
 }
 
+template<typename Frame>
+bool DiscreteTrajectory<Frame>::Downsampling::Fits(
+    std::int64_t const dense_intervals) const {
+  auto const begin = dense_iterators_.begin();
+  auto const last = begin + dense_intervals;
+  return Hermite3<Instant, Position<Frame>>(
+             {(*begin)->first, (*last)->first},
+             {(*begin)->second.position(), (*last)->second.position()},
+             {(*begin)->second.velocity(), (*last)->second.velocity()})
+             .LInfinityError(
+                 Range(begin, last + 1),
+                 [](auto&& it) -> auto&& { return it->first; },
+                 [](auto&& it) -> auto&& { return it->second.position(); }) <
+         tolerance_;
+}
+
 template<typename Frame>
 void DiscreteTrajectory<Frame>::Downsampling::WriteToMessage(
     not_null<serialization::DiscreteTrajectory::Downsampling*> message,
@@ -491,18 +776,75 @@ DiscreteTrajectory<Frame>::Downsampling::ReadFromMessage(
                       timeline);
 }
 
+template<typename Frame>
+void DiscreteTrajectory<Frame>::Seal() {
+  if (!max_uncompressed_points_.has_value() ||
+      static_cast<std::int64_t>(timeline_.size()) <
+          *max_uncompressed_points_ + points_per_sealed_block) {
+    return;
+  }
+
+  // The points designated by iterators held by the children or by the
+  // downsampling may not be sealed, and neither may the last point.  The
+  // serialized fork time of a child is the time of the first point that it
+  // shares with this trajectory.
+  Instant first_unsealable_time = std::prev(timeline_.end())->first;
+  this->ForEachChild([&first_unsealable_time](DiscreteTrajectory& child) {
+    first_unsealable_time =
+        std::min(first_unsealable_time, child.serialized_fork_time());
+  });
+  if (downsampling_.has_value()) {
+    first_unsealable_time =
+        std::min(first_unsealable_time, downsampling_->first_dense_time());
+  }
+
+  while (static_cast<std::int64_t>(timeline_.size()) >=
+         *max_uncompressed_points_ + points_per_sealed_block) {
+    auto const block_end =
+        std::next(timeline_.cbegin(), points_per_sealed_block);
+    if (std::prev(block_end)->first >= first_unsealable_time) {
+      break;
+    }
+    sealed_blocks_.emplace_back(timeline_.cbegin(), block_end);
+    timeline_.erase(timeline_.cbegin(), block_end);
+  }
+}
+
 template<typename Frame>
 void DiscreteTrajectory<Frame>::WriteSubTreeToMessage(
     not_null<serialization::DiscreteTrajectory*> const message,
     std::vector<DiscreteTrajectory<Frame>*>& forks) const {
   Forkable<DiscreteTrajectory, Iterator>::WriteSubTreeToMessage(message, forks);
-  for (auto const& pair : timeline_) {
+  auto const write_point = [message](
+                               typename Timeline::value_type const& pair) {
     Instant const& instant = pair.first;
     DegreesOfFreedom<Frame> const& degrees_of_freedom = pair.second;
     auto const instantaneous_degrees_of_freedom = message->add_timeline();
     instant.WriteToMessage(instantaneous_degrees_of_freedom->mutable_instant());
     degrees_of_freedom.WriteToMessage(
         instantaneous_degrees_of_freedom->mutable_degrees_of_freedom());
+  };
+  // The points shared with the parent are written as if they had been copied,
+  // so that the serialized form doesn't depend on the sharing.
+  if (requested_fork_point_.has_value()) {
+    Timeline const& parent_timeline = this->parent()->timeline_;
+    auto const end_of_shared_points =
+        std::next(parent_timeline.find(this->Fork().time()));
+    for (auto it = std::next(*requested_fork_point_);
+         it != end_of_shared_points;
+         ++it) {
+      write_point(*it);
+    }
+  }
+  for (auto const& block : sealed_blocks_) {
+    block.ForEach([&write_point](
+                      Instant const& time,
+                      DegreesOfFreedom<Frame> const& degrees_of_freedom) {
+      write_point({time, degrees_of_freedom});
+    });
+  }
+  for (auto const& pair : timeline_) {
+    write_point(pair);
   }
   if (downsampling_.has_value()) {
     downsampling_->WriteToMessage(message->mutable_downsampling(), timeline_);
@@ -530,20 +872,118 @@ void DiscreteTrajectory<Frame>::FillSubTreeFromMessage(
 }
 
 template<typename Frame>
-Hermite3<Instant, Position<Frame>> DiscreteTrajectory<Frame>::GetInterpolation(
-    Instant const& time) const {
+void DiscreteTrajectory<Frame>::UnshareParentPoints() {
+  if (!requested_fork_point_.has_value()) {
+    return;
+  }
+  TimelineConstIterator const requested_fork_point = *requested_fork_point_;
+  requested_fork_point_.reset();
+
+  // The actual fork point is in the parent timeline, see |NewForkWithCopy|.
+  Timeline const& parent_timeline = this->parent()->timeline_;
+  auto const fork_point = parent_timeline.find(this->Fork().time());
+  CHECK(fork_point != parent_timeline.end());
+
+  // Copy the shared points in decreasing order of time so that our timeline is
+  // only modified at its beginning.
+  TimelineConstIterator former_fork_point = timeline_.end();
+  for (auto it = fork_point; it != requested_fork_point; --it) {
+    auto const copied_it =
+        timeline_.emplace_hint(timeline_.begin(), it->first, it->second);
+    if (it == fork_point) {
+      former_fork_point = copied_it;
+    }
+  }
+  this->MoveForkPointBack(requested_fork_point, former_fork_point);
+}
+
+template<typename Frame>
+std::vector<not_null<DiscreteTrajectory<Frame>*>>
+DiscreteTrajectory<Frame>::ChildrenSharingPoints() {
+  std::vector<not_null<DiscreteTrajectory<Frame>*>> children;
+  this->ForEachChild([&children](DiscreteTrajectory<Frame>& child) {
+    if (child.requested_fork_point_.has_value()) {
+      children.push_back(&child);
+    }
+  });
+  return children;
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::InvalidateCursors() {
+  ++cursor_generation_;
+  this->ForEachChild([](DiscreteTrajectory<Frame>& child) {
+    child.InvalidateCursors();
+  });
+}
+
+template<typename Frame>
+Hermite3<Instant, Position<Frame>>
+DiscreteTrajectory<Frame>::GetInterpolation(Instant const& time) const {
+  Cursor cursor;
+  return GetInterpolation(time, cursor);
+}
+
+template<typename Frame>
+Hermite3<Instant, Position<Frame>> const&
+DiscreteTrajectory<Frame>::GetInterpolation(Instant const& time,
+                                            Cursor& cursor) const {
+  if (cursor.generation_ == cursor_generation_ &&
+      ((cursor.lower_time_ < time && time <= cursor.upper_time_) ||
+       (time == cursor.lower_time_ && time == cursor.upper_time_))) {
+    return *cursor.interpolation_;
+  }
+
+  auto const remember = [this, &cursor](Instant const& lower_time,
+                                        DegreesOfFreedom<Frame> const& lower,
+                                        Instant const& upper_time,
+                                        DegreesOfFreedom<Frame> const& upper)
+      -> Hermite3<Instant, Position<Frame>> const& {
+    cursor.generation_ = cursor_generation_;
+    cursor.lower_time_ = lower_time;
+    cursor.upper_time_ = upper_time;
+    cursor.interpolation_.emplace(
+        std::pair{lower_time, upper_time},
+        std::pair{lower.position(), upper.position()},
+        std::pair{lower.velocity(), upper.velocity()});
+    return *cursor.interpolation_;
+  };
+
+  // If the segment is in the timeline of this trajectory, there is no need to
+  // construct the (expensive) iterators of |Forkable|.
+  if (!timeline_.empty() && timeline_.begin()->first < time) {
+    auto const upper = timeline_.lower_bound(time);
+    if (upper != timeline_.end()) {
+      auto const lower = std::prev(upper);
+      return remember(lower->first, lower->second, upper->first, upper->second);
+    }
+  }
+
+  // If the segment is in a sealed block of the root, look it up in the decoded
+  // block, which is generally the one used by the previous lookup.
+  auto const root = this->root();
+  if (!root->sealed_blocks_.empty() &&
+      time <= root->sealed_blocks_.back().last_time()) {
+    auto const decoded =
+        root->DecodeSealedBlock(root->sealed_blocks_lower_bound(time));
+    auto const& timeline = decoded->timeline;
+    auto const upper = timeline.lower_bound(time);
+    if (upper != timeline.begin()) {
+      auto const lower = std::prev(upper);
+      return remember(lower->first, lower->second, upper->first, upper->second);
+    }
+  }
+
   CHECK_LE(t_min(), time);
   CHECK_GE(t_max(), time);
   // This is the upper bound of the interval upon which we will do the
   // interpolation.
   auto const upper = this->LowerBound(time);
-  auto const lower = upper == this->Begin() ? upper : --Iterator{upper};
-  return Hermite3<Instant, Position<Frame>>{
-      {lower.time(), upper.time()},
-      {lower.degrees_of_freedom().position(),
-       upper.degrees_of_freedom().position()},
-      {lower.degrees_of_freedom().velocity(),
-       upper.degrees_of_freedom().velocity()}};
+  // Comparing with |t_min()| rather than |Begin()| avoids decoding the first
+  // sealed block.
+  auto const lower = upper.time() == t_min() ? upper : --Iterator{upper};
+  return remember(lower.time(), lower.degrees_of_freedom(),
+                  upper.time(), upper.degrees_of_freedom());
 }
 
 }  // namespace internal_discrete_trajectory
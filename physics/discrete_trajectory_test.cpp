@@ -6,6 +6,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "geometry/frame.hpp"
@@ -54,6 +55,7 @@ using ::std::placeholders::_3;
 using ::testing::Contains;
 using ::testing::Each;
 using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 using ::testing::Eq;
 using ::testing::Gt;
 using ::testing::Lt;
@@ -352,6 +354,45 @@ TEST_F(DiscreteTrajectoryTest, NewForkWithCopyAtLast) {
   EXPECT_THAT(after, ElementsAre(t2_, t3_, t4_));
 }
 
+TEST_F(DiscreteTrajectoryTest, NewForkWithCopySharing) {
+  massive_trajectory_->Append(t1_, d1_);
+  massive_trajectory_->Append(t2_, d2_);
+  massive_trajectory_->Append(t3_, d3_);
+  not_null<DiscreteTrajectory<World>*> const fork1 =
+      massive_trajectory_->NewForkWithCopy(t1_);
+  not_null<DiscreteTrajectory<World>*> const fork2 =
+      massive_trajectory_->NewForkWithCopy(t2_);
+
+  // The forks share the tail of their parent until it is removed.
+  EXPECT_EQ(t3_, fork1->Fork().time());
+  EXPECT_EQ(t3_, fork2->Fork().time());
+  fork1->Append(t4_, d4_);
+  massive_trajectory_->Append(t4_, d1_);
+  EXPECT_THAT(Positions(*fork1),
+              ElementsAre(Pair(t1_, q1_), Pair(t2_, q2_),
+                          Pair(t3_, q3_), Pair(t4_, q4_)));
+  EXPECT_THAT(Positions(*fork2),
+              ElementsAre(Pair(t1_, q1_), Pair(t2_, q2_), Pair(t3_, q3_)));
+  EXPECT_THAT(Positions(*massive_trajectory_),
+              ElementsAre(Pair(t1_, q1_), Pair(t2_, q2_),
+                          Pair(t3_, q3_), Pair(t4_, q1_)));
+
+  massive_trajectory_->ForgetAfter(t1_);
+  EXPECT_THAT(Times(*massive_trajectory_), ElementsAre(t1_));
+  EXPECT_EQ(t1_, fork1->Fork().time());
+  EXPECT_EQ(4, fork1->Size());
+  EXPECT_THAT(Positions(*fork1),
+              ElementsAre(Pair(t1_, q1_), Pair(t2_, q2_),
+                          Pair(t3_, q3_), Pair(t4_, q4_)));
+  EXPECT_THAT(Velocities(*fork1),
+              ElementsAre(Pair(t1_, p1_), Pair(t2_, p2_),
+                          Pair(t3_, p3_), Pair(t4_, p4_)));
+  // Don't use fork2, it is dangling.
+
+  fork1->ForgetAfter(t2_);
+  EXPECT_THAT(Times(*fork1), ElementsAre(t1_, t2_));
+}
+
 TEST_F(DiscreteTrajectoryTest, NewForkAtLast) {
   massive_trajectory_->Append(t1_, d1_);
   massive_trajectory_->Append(t2_, d2_);
@@ -569,6 +610,22 @@ TEST_F(DiscreteTrajectoryTest, AppendSuccess) {
   EXPECT_THAT(times, ElementsAre(t1_, t2_, t3_));
 }
 
+TEST_F(DiscreteTrajectoryTest, AppendBatch) {
+  massive_trajectory_->Append({{t1_, d1_}, {t2_, d2_}});
+  not_null<DiscreteTrajectory<World>*> const fork =
+      massive_trajectory_->NewForkAtLast();
+  fork->Append({{t3_, d3_}, {t4_, d4_}});
+  massive_trajectory_->Append({});
+  EXPECT_THAT(Positions(*massive_trajectory_),
+              ElementsAre(Pair(t1_, q1_), Pair(t2_, q2_)));
+  EXPECT_THAT(Positions(*fork),
+              ElementsAre(Pair(t1_, q1_), Pair(t2_, q2_),
+                          Pair(t3_, q3_), Pair(t4_, q4_)));
+  EXPECT_THAT(Velocities(*fork),
+              ElementsAre(Pair(t1_, p1_), Pair(t2_, p2_),
+                          Pair(t3_, p3_), Pair(t4_, p4_)));
+}
+
 TEST_F(DiscreteTrajectoryTest, ForgetAfter) {
   massive_trajectory_->Append(t1_, d1_);
   massive_trajectory_->Append(t2_, d2_);
@@ -872,6 +929,49 @@ TEST_F(DiscreteTrajectoryTest, QuadrilateralCircle) {
   EXPECT_THAT(max_v_error, IsNear(0.012));
 }
 
+TEST_F(DiscreteTrajectoryTest, Cursor) {
+  DiscreteTrajectory<World> expected;
+  expected.Append(t1_, d1_);
+  expected.Append(t2_, d2_);
+  expected.Append(t3_, d4_);
+
+  massive_trajectory_->Append(t1_, d1_);
+  massive_trajectory_->Append(t2_, d2_);
+  massive_trajectory_->Append(t3_, d3_);
+  DiscreteTrajectory<World>::Cursor cursor;
+  Instant const t = t2_ + 1 * Second;
+  Position<World> const q = massive_trajectory_->EvaluatePosition(t, cursor);
+  EXPECT_EQ(massive_trajectory_->EvaluatePosition(t), q);
+
+  // Replacing the last point changes the interpolation.
+  massive_trajectory_->ForgetAfter(t2_);
+  massive_trajectory_->Append(t3_, d4_);
+  EXPECT_NE(q, massive_trajectory_->EvaluatePosition(t, cursor));
+  EXPECT_EQ(expected.EvaluatePosition(t),
+            massive_trajectory_->EvaluatePosition(t, cursor));
+  EXPECT_EQ(expected.EvaluateVelocity(t1_ + 1 * Second),
+            massive_trajectory_->EvaluateVelocity(t1_ + 1 * Second, cursor));
+  EXPECT_EQ(expected.EvaluateDegreesOfFreedom(t1_),
+            massive_trajectory_->EvaluateDegreesOfFreedom(t1_, cursor));
+
+  // A fork interpolates the points of its parent.
+  not_null<DiscreteTrajectory<World>*> const fork =
+      massive_trajectory_->NewForkAtLast();
+  fork->Append(t4_, d1_);
+  DiscreteTrajectory<World>::Cursor fork_cursor;
+  EXPECT_EQ(expected.EvaluatePosition(t), fork->EvaluatePosition(t));
+  EXPECT_EQ(expected.EvaluatePosition(t),
+            fork->EvaluatePosition(t, fork_cursor));
+
+  // Replacing the last point of the fork changes the interpolation.
+  Instant const u = t3_ + 1 * Second;
+  Position<World> const r = fork->EvaluatePosition(u, fork_cursor);
+  fork->ForgetAfter(t3_);
+  fork->Append(t4_, d2_);
+  EXPECT_NE(r, fork->EvaluatePosition(u, fork_cursor));
+  EXPECT_EQ(fork->EvaluatePosition(u), fork->EvaluatePosition(u, fork_cursor));
+}
+
 TEST_F(DiscreteTrajectoryTest, Downsampling) {
   DiscreteTrajectory<World> circle;
   DiscreteTrajectory<World> downsampled_circle;
@@ -894,7 +994,7 @@ TEST_F(DiscreteTrajectoryTest, Downsampling) {
     downsampled_circle.Append(t.value, dof);
   }
   EXPECT_THAT(circle.Size(), Eq(1001));
-  EXPECT_THAT(downsampled_circle.Size(), Eq(77));
+  EXPECT_THAT(downsampled_circle.Size(), Eq(56));
   std::vector<Length> errors;
   for (auto it = circle.Begin(); it != circle.End(); ++it) {
     errors.push_back((downsampled_circle.EvaluatePosition(it.time()) -
@@ -905,6 +1005,41 @@ TEST_F(DiscreteTrajectoryTest, Downsampling) {
       << *std::max_element(errors.begin(), errors.end());
 }
 
+TEST_F(DiscreteTrajectoryTest, DownsamplingBatch) {
+  DiscreteTrajectory<World> downsampled_circle;
+  DiscreteTrajectory<World> batch_downsampled_circle;
+  downsampled_circle.SetDownsampling(/*max_dense_intervals=*/50,
+                                     /*tolerance=*/1 * Milli(Metre));
+  batch_downsampled_circle.SetDownsampling(/*max_dense_intervals=*/50,
+                                           /*tolerance=*/1 * Milli(Metre));
+  AngularFrequency const ω = 3 * Radian / Second;
+  Length const r = 2 * Metre;
+  Speed const v = ω * r / Radian;
+  std::vector<std::pair<Instant, DegreesOfFreedom<World>>> batch;
+  for (auto t = DoublePrecision<Instant>(t0_);
+       t.value <= t0_ + 10 * Second;
+       t.Increment(10 * Milli(Second))) {
+    DegreesOfFreedom<World> const dof =
+        {World::origin + Displacement<World>{{r * Cos(ω * (t.value - t0_)),
+                                              r * Sin(ω * (t.value - t0_)),
+                                              0 * Metre}},
+         Velocity<World>{{-v * Sin(ω * (t.value - t0_)),
+                          v * Cos(ω * (t.value - t0_)),
+                          0 * Metre / Second}}};
+    downsampled_circle.Append(t.value, dof);
+    // A batch size which is not commensurate with |max_dense_intervals|.
+    batch.emplace_back(t.value, dof);
+    if (batch.size() == 37) {
+      batch_downsampled_circle.Append(batch);
+      batch.clear();
+    }
+  }
+  batch_downsampled_circle.Append(batch);
+  EXPECT_THAT(batch_downsampled_circle.Size(), Eq(56));
+  EXPECT_THAT(Times(batch_downsampled_circle),
+              ElementsAreArray(Times(downsampled_circle)));
+}
+
 TEST_F(DiscreteTrajectoryTest, DownsamplingSerialization) {
   DiscreteTrajectory<World> circle;
   auto deserialized_circle = make_not_null_unique<DiscreteTrajectory<World>>();
@@ -942,7 +1077,7 @@ TEST_F(DiscreteTrajectoryTest, DownsamplingSerialization) {
     circle.Append(t.value, dof);
     deserialized_circle->Append(t.value, dof);
   }
-  EXPECT_THAT(circle.Size(), Eq(77));
+  EXPECT_THAT(circle.Size(), Eq(56));
   EXPECT_THAT(deserialized_circle->Size(), Eq(circle.Size()));
   for (auto it1 = circle.Begin(), it2 = deserialized_circle->Begin();
        it1 != circle.End();
@@ -987,7 +1122,7 @@ TEST_F(DiscreteTrajectoryTest, DownsamplingForgetAfter) {
                           0 * Metre / Second}}};
     forgotten_circle.Append(t, dof);
   }
-  EXPECT_THAT(circle.Size(), Eq(77));
+  EXPECT_THAT(circle.Size(), Eq(56));
   EXPECT_THAT(forgotten_circle.Size(), Eq(circle.Size()));
   std::vector<Length> errors;
   for (auto it = forgotten_circle.Begin(); it != forgotten_circle.End(); ++it) {
@@ -997,6 +1132,96 @@ TEST_F(DiscreteTrajectoryTest, DownsamplingForgetAfter) {
   EXPECT_THAT(errors, Each(Eq(0 * Metre)));
 }
 
+TEST_F(DiscreteTrajectoryTest, MemoryBudget) {
+  DiscreteTrajectory<World> circle;
+  DiscreteTrajectory<World> sealed_circle;
+  sealed_circle.SetMemoryBudget(/*max_uncompressed_points=*/500);
+  AngularFrequency const ω = 3 * Radian / Second;
+  Length const r = 2 * Metre;
+  Speed const v = ω * r / Radian;
+  for (int i = 0; i < 5000; ++i) {
+    Instant const t = t0_ + i * 10 * Milli(Second);
+    DegreesOfFreedom<World> const dof =
+        {World::origin + Displacement<World>{{r * Cos(ω * (t - t0_)),
+                                              r * Sin(ω * (t - t0_)),
+                                              0 * Metre}},
+         Velocity<World>{{-v * Sin(ω * (t - t0_)),
+                          v * Cos(ω * (t - t0_)),
+                          0 * Metre / Second}}};
+    circle.Append(t, dof);
+    sealed_circle.Append(t, dof);
+  }
+  EXPECT_EQ(4000, sealed_circle.number_of_sealed_points());
+  EXPECT_EQ(circle.Size(), sealed_circle.Size());
+  EXPECT_EQ(circle.t_min(), sealed_circle.t_min());
+  EXPECT_EQ(circle.t_max(), sealed_circle.t_max());
+
+  // Evaluating, finding and iterating don't modify the sealed points.
+  Instant const t = t0_ + 34'567 * Milli(Second);
+  EXPECT_EQ(circle.EvaluateDegreesOfFreedom(t),
+            sealed_circle.EvaluateDegreesOfFreedom(t));
+  EXPECT_EQ(circle.Find(t0_ + 12 * Second).degrees_of_freedom(),
+            sealed_circle.Find(t0_ + 12 * Second).degrees_of_freedom());
+  EXPECT_TRUE(sealed_circle.Find(t0_ + 12'345 * Milli(Second)) ==
+              sealed_circle.End());
+  EXPECT_EQ(t0_ + 12'350 * Milli(Second),
+            sealed_circle.LowerBound(t0_ + 12'345 * Milli(Second)).time());
+  EXPECT_THAT(Times(sealed_circle), ElementsAreArray(Times(circle)));
+  EXPECT_EQ(4000, sealed_circle.number_of_sealed_points());
+
+  // Evaluating with a cursor walks through the sealed blocks and across their
+  // boundaries.
+  DiscreteTrajectory<World>::Cursor circle_cursor;
+  DiscreteTrajectory<World>::Cursor sealed_circle_cursor;
+  for (Instant t = circle.t_min();
+       t <= circle.t_max();
+       t += 3 * Milli(Second)) {
+    EXPECT_EQ(circle.EvaluateDegreesOfFreedom(t, circle_cursor),
+              sealed_circle.EvaluateDegreesOfFreedom(t, sealed_circle_cursor))
+        << t;
+  }
+  EXPECT_EQ(4000, sealed_circle.number_of_sealed_points());
+
+  // Iterating backward crosses the boundaries of the sealed blocks and the
+  // beginning of the timeline.
+  auto circle_it = circle.last();
+  auto sealed_circle_it = sealed_circle.last();
+  for (;;) {
+    EXPECT_EQ(circle_it.time(), sealed_circle_it.time());
+    EXPECT_EQ(circle_it.degrees_of_freedom(),
+              sealed_circle_it.degrees_of_freedom());
+    if (circle_it == circle.Begin()) {
+      break;
+    }
+    --circle_it;
+    --sealed_circle_it;
+  }
+  EXPECT_TRUE(sealed_circle_it == sealed_circle.Begin());
+  EXPECT_EQ(4000, sealed_circle.number_of_sealed_points());
+
+  // Serialization doesn't unseal.
+  serialization::DiscreteTrajectory message;
+  serialization::DiscreteTrajectory sealed_message;
+  circle.WriteToMessage(&message, /*forks=*/{});
+  sealed_circle.WriteToMessage(&sealed_message, /*forks=*/{});
+  EXPECT_THAT(sealed_message, EqualsProto(message));
+  EXPECT_EQ(4000, sealed_circle.number_of_sealed_points());
+
+  // The points shared with a fork are not sealed.
+  sealed_circle.ForgetAfter(t0_ + 35 * Second);
+  EXPECT_EQ(3000, sealed_circle.number_of_sealed_points());
+  sealed_circle.NewForkWithCopy(t0_ + 15 * Second);
+  EXPECT_EQ(1000, sealed_circle.number_of_sealed_points());
+  for (int i = 3501; i < 5000; ++i) {
+    sealed_circle.Append(t0_ + i * 10 * Milli(Second), d1_);
+  }
+  EXPECT_EQ(1000, sealed_circle.number_of_sealed_points());
+
+  sealed_circle.ClearMemoryBudget();
+  EXPECT_EQ(0, sealed_circle.number_of_sealed_points());
+  EXPECT_EQ(5000, sealed_circle.Size());
+}
+
 }  // namespace internal_discrete_trajectory
 }  // namespace physics
 }  // namespace principia
@@ -1,6 +1,9 @@
 ﻿
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <limits>
 #include <map>
@@ -8,11 +11,14 @@
 #include <vector>
 
 #include "absl/synchronization/mutex.h"
+#include "astronomy/epoch.hpp"
 #include "base/not_null.hpp"
 #include "base/status.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/named_quantities.hpp"
 #include "google/protobuf/repeated_field.h"
+#include "integrators/ensemble.hpp"
 #include "integrators/integrators.hpp"
 #include "integrators/ordinary_differential_equations.hpp"
 #include "physics/continuous_trajectory.hpp"
@@ -29,19 +35,24 @@ namespace principia {
 namespace physics {
 namespace internal_ephemeris {
 
+using astronomy::InfinitePast;
 using base::Error;
 using base::not_null;
 using base::Status;
+using base::ThreadPool;
 using geometry::Instant;
 using geometry::Position;
 using geometry::Vector;
 using integrators::AdaptiveStepSizeIntegrator;
+using integrators::EnsembleInstance;
+using integrators::EnsembleProblem;
 using integrators::ExplicitSecondOrderOrdinaryDifferentialEquation;
 using integrators::FixedStepSizeIntegrator;
 using integrators::Integrator;
 using integrators::IntegrationProblem;
 using integrators::SpecialSecondOrderDifferentialEquation;
 using quantities::Acceleration;
+using quantities::GravitationalParameter;
 using quantities::Length;
 using quantities::Speed;
 using quantities::Time;
@@ -101,6 +112,11 @@ class Ephemeris {
           Instant const& time,
           DegreesOfFreedom<Frame> const& degrees_of_freedom)>;
   using IntrinsicAccelerations = std::vector<IntrinsicAcceleration>;
+  // A function of the degrees of freedom of a massless body whose changes of
+  // sign are events, see |AdaptiveStepSizeIntegrator::EventFunction|.
+  using EventFunction = std::function<double(
+      Instant const& time,
+      DegreesOfFreedom<Frame> const& degrees_of_freedom)>;
   static IntrinsicAccelerations const NoIntrinsicAccelerations;
   static std::int64_t constexpr unlimited_max_ephemeris_steps =
       std::numeric_limits<std::int64_t>::max();
@@ -118,8 +134,15 @@ class Ephemeris {
 
   class PHYSICS_DLL AccuracyParameters final {
    public:
+    // If |hierarchical_approximation_tolerance| is positive, the attraction
+    // of a subsystem (a body and its satellites) on a massless body is
+    // approximated by that of a point mass at its barycentre when the radius of
+    // the subsystem is less than |hierarchical_approximation_tolerance| times
+    // the distance to the massless body.  The relative error on the attraction
+    // of the subsystem is then of the order of the square of that tolerance.
     AccuracyParameters(Length const& fitting_tolerance,
-                       double geopotential_tolerance);
+                       double geopotential_tolerance,
+                       double hierarchical_approximation_tolerance = 0);
 
     void WriteToMessage(
         not_null<serialization::Ephemeris::AccuracyParameters*> const
@@ -130,6 +153,7 @@ class Ephemeris {
    private:
     Length fitting_tolerance_;
     double geopotential_tolerance_ = 0;
+    double hierarchical_approximation_tolerance_ = 0;
     friend class Ephemeris<Frame>;
   };
 
@@ -154,6 +178,52 @@ class Ephemeris {
     friend class Ephemeris<Frame>;
   };
 
+  // The linearization of the flow of a massless body along a trajectory, i.e.,
+  // the 6×6 matrix of the derivatives of its final degrees of freedom with
+  // respect to its initial degrees of freedom.
+  class StateTransitionMatrix final {
+   public:
+    // The matrix of a flow that doesn't move.
+    StateTransitionMatrix();
+
+    // Returns, to first order, the perturbation of the final degrees of
+    // freedom caused by the perturbation |initial| of the initial degrees of
+    // freedom.
+    RelativeDegreesOfFreedom<Frame> operator()(
+        RelativeDegreesOfFreedom<Frame> const& initial) const;
+
+   private:
+    // The perturbations of the initial degrees of freedom whose images are the
+    // columns of the matrix: 1 m along each axis of |Frame|, followed by 1 m/s
+    // along each axis.
+    static std::array<RelativeDegreesOfFreedom<Frame>, 6> const&
+    InitialPerturbations();
+
+    std::array<RelativeDegreesOfFreedom<Frame>, 6> columns_;
+    friend class Ephemeris<Frame>;
+  };
+
+  // The number of times that the positions of the massive bodies needed to
+  // compute the accelerations on massless bodies integrated with a fixed step
+  // were found in the cache (|hits|) or had to be evaluated from the
+  // trajectories (|misses|).  Integrations with an adaptive step don't use the
+  // cache, as they practically never share their instants: when they used it,
+  // fewer than one evaluation in a thousand was a hit.
+  struct BodyPositionsCacheStatistics final {
+    std::int64_t hits = 0;
+    std::int64_t misses = 0;
+  };
+
+  // The number of calls to |Prolong| that returned without integrating
+  // (|immediate|) and of those that had to integrate or to wait for the
+  // background prolongation (|blocking|), together with the total wall time
+  // spent in the latter.
+  struct ProlongationStatistics final {
+    std::int64_t immediate = 0;
+    std::int64_t blocking = 0;
+    std::chrono::nanoseconds blocking_time{0};
+  };
+
   // Constructs an Ephemeris that owns the |bodies|.  The elements of vectors
   // |bodies| and |initial_state| correspond to one another.
   Ephemeris(std::vector<not_null<std::unique_ptr<MassiveBody const>>>&& bodies,
@@ -162,7 +232,7 @@ class Ephemeris {
             AccuracyParameters const& accuracy_parameters,
             FixedStepParameters const& fixed_step_parameters);
 
-  virtual ~Ephemeris() = default;
+  virtual ~Ephemeris();
 
   // Returns the bodies in the order in which they were given at construction.
   virtual std::vector<not_null<MassiveBody const*>> const& bodies() const;
@@ -195,6 +265,24 @@ class Ephemeris {
   // Prolongs the ephemeris up to at least |t|.  After the call, |t_max() >= t|.
   virtual void Prolong(Instant const& t) EXCLUDES(lock_);
 
+  // Causes |Prolong| to compute the accelerations between the massive bodies,
+  // and to fit the polynomials of their trajectories, using
+  // |number_of_threads| threads.  The results are bitwise identical to those of
+  // the serial computation, which is used if |number_of_threads| is 1.
+  virtual void SetMassiveBodiesParallelism(int number_of_threads)
+      EXCLUDES(lock_);
+
+  // Causes |Prolong(t)| to also request the prolongation of the ephemeris up
+  // to |t + horizon| on a background thread, so that subsequent calls with
+  // times within the horizon return immediately.  The background thread
+  // releases |lock_| after each step, so that it doesn't delay the readers.  A
+  // zero |horizon| (the default) disables background prolongation.
+  virtual void SetBackgroundProlongationHorizon(Time const& horizon)
+      EXCLUDES(lock_);
+
+  virtual BodyPositionsCacheStatistics body_positions_cache_statistics() const;
+  virtual ProlongationStatistics prolongation_statistics() const;
+
   // Creates an instance suitable for integrating the given |trajectories| with
   // their |intrinsic_accelerations| using a fixed-step integrator parameterized
   // by |parameters|.
@@ -220,7 +308,46 @@ class Ephemeris {
       std::int64_t max_ephemeris_steps,
       bool last_point_only) EXCLUDES(lock_);
 
-  // Same as above, but uses a generalized integrator.
+  // Same as above, but also integrates the variational equations of the
+  // massless body along the trajectory, and sets |*state_transition_matrix| to
+  // the linearization of the flow from the last point of |trajectory| on entry
+  // to its last point on exit.  This makes it possible to estimate the effect
+  // of a small change of the initial degrees of freedom, e.g., of a manœuvre,
+  // without integrating again.  The variational equations use the gradient of
+  // the gravitational acceleration of the point masses: the geopotentials and
+  // the hierarchical approximation are ignored in the linearization.  They
+  // don't participate in step size control.
+  virtual Status FlowWithAdaptiveStep(
+      not_null<DiscreteTrajectory<Frame>*> trajectory,
+      IntrinsicAcceleration intrinsic_acceleration,
+      Instant const& t,
+      AdaptiveStepParameters const& parameters,
+      std::int64_t max_ephemeris_steps,
+      bool last_point_only,
+      not_null<StateTransitionMatrix*> state_transition_matrix)
+      EXCLUDES(lock_);
+
+  // Same as the first overload, but also locates the changes of sign of the
+  // |event_functions| in the same pass as the integration, and appends the
+  // degrees of freedom of the massless body at the events of
+  // |event_functions[i]| to |*events[i]|.  The events are found on the
+  // interpolant of each step, between its actual ends: an event function that
+  // changes sign twice within a step, e.g., the height above a body for an
+  // orbit that grazes its surface, has no events there.  Callers that cannot
+  // tolerate this must bound the step with |parameters| or check the
+  // trajectory afterwards.
+  virtual Status FlowWithAdaptiveStep(
+      not_null<DiscreteTrajectory<Frame>*> trajectory,
+      IntrinsicAcceleration intrinsic_acceleration,
+      Instant const& t,
+      AdaptiveStepParameters const& parameters,
+      std::int64_t max_ephemeris_steps,
+      bool last_point_only,
+      std::vector<EventFunction> const& event_functions,
+      std::vector<not_null<DiscreteTrajectory<Frame>*>> const& events)
+      EXCLUDES(lock_);
+
+  // Same as the first overload, but uses a generalized integrator.
   virtual Status FlowWithAdaptiveStep(
       not_null<DiscreteTrajectory<Frame>*> trajectory,
       GeneralizedIntrinsicAcceleration intrinsic_acceleration,
@@ -229,6 +356,31 @@ class Ephemeris {
       std::int64_t max_ephemeris_steps,
       bool last_point_only) EXCLUDES(lock_);
 
+  // Integrates each of the |trajectories| as if by |FlowWithAdaptiveStep|, with
+  // the corresponding |intrinsic_accelerations|.  The ephemeris is prolonged
+  // once for the entire ensemble.  Returns the status of each member.
+  // If |lockstep| is false, each member has its own step size control, and the
+  // members share the positions of the massive bodies at the instants that they
+  // have in common.  If |thread_pool| is not null, the members are integrated
+  // concurrently on it.  The results are identical to those of independent
+  // calls to |FlowWithAdaptiveStep|.
+  // If |lockstep| is true, the |trajectories| must all end at the same time and
+  // |thread_pool| must be null.  The gravitational accelerations on the members
+  // are computed together and the members share their step size, so the
+  // results differ from those of independent calls to |FlowWithAdaptiveStep|.
+  // A member which collides with a body, or which makes the step size vanish,
+  // terminates early: its trajectory ends before the failure and its status is
+  // the error.
+  virtual std::vector<Status> FlowEnsembleWithAdaptiveStep(
+      std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+      IntrinsicAccelerations const& intrinsic_accelerations,
+      Instant const& t,
+      AdaptiveStepParameters const& parameters,
+      std::int64_t max_ephemeris_steps,
+      bool last_point_only,
+      bool lockstep,
+      ThreadPool<void>* thread_pool) EXCLUDES(lock_);
+
   // Integrates, until at most |t|, the trajectories followed by massless
   // bodies in the gravitational potential described by |*this|.  If
   // |t > t_max()|, calls |Prolong(t)| beforehand.  The trajectories and
@@ -238,6 +390,24 @@ class Ephemeris {
       typename Integrator<NewtonianMotionEquation>::Instance& instance)
       EXCLUDES(lock_);
 
+  // Creates an instance suitable for integrating in lockstep the given
+  // |trajectories|, which must all end at the same time, with their
+  // |intrinsic_accelerations| using a fixed-step integrator parameterized by
+  // |parameters|.  Contrary to |NewInstance|, a trajectory which collides with
+  // a body is masked out of the ensemble and its last point precedes the
+  // collision.
+  virtual not_null<std::unique_ptr<EnsembleInstance<NewtonianMotionEquation>>>
+  NewEnsembleInstance(
+      std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+      IntrinsicAccelerations const& intrinsic_accelerations,
+      FixedStepParameters const& parameters);
+
+  // Same as |FlowWithFixedStep|, for an |instance| created by
+  // |NewEnsembleInstance|.
+  virtual Status FlowEnsembleWithFixedStep(
+      Instant const& t,
+      EnsembleInstance<NewtonianMotionEquation>& instance) EXCLUDES(lock_);
+
   // Returns the gravitational acceleration on a massless body located at the
   // given |position| at time |t|.
   virtual Vector<Acceleration, Frame>
@@ -300,6 +470,70 @@ class Ephemeris {
     std::vector<typename ContinuousTrajectory<Frame>::Checkpoint> checkpoints;
   };
 
+  // The positions of the massive bodies at time |t|, indexed like |bodies_|,
+  // and the equatorial axes of the oblate bodies, indexed like
+  // |geopotentials_|.
+  // If the hierarchical approximation is used, |barycentres| and |radii| hold
+  // the barycentre of each of the |subsystems_| and the largest distance from
+  // that barycentre to one of its bodies.
+  struct BodyPositions final {
+    Instant t;
+    std::vector<Position<Frame>> positions;
+    std::vector<typename Geopotential<Frame>::EquatorialAxes> equatorial_axes;
+    std::vector<Position<Frame>> barycentres;
+    std::vector<Length> radii;
+  };
+
+  // A body and its satellites, recursively, the unit of the hierarchical
+  // approximation.  The primary of |subsystems_[b]| is |bodies_[b]|.
+  struct Subsystem final {
+    // Indices in |bodies_| of the primary, which comes first, and of all the
+    // bodies orbiting it, directly or not.
+    std::vector<int> bodies;
+    // Indices in |subsystems_| of the subsystems orbiting the primary.
+    std::vector<int> satellites;
+    // Index in |subsystems_| of the subsystem of which this one is a satellite,
+    // or -1 for the root.
+    int parent = -1;
+    GravitationalParameter gravitational_parameter;
+    // Beyond this distance from each of the |bodies|, the geopotentials of the
+    // subsystem vanish, so they may be approximated by a point mass.
+    Length geopotential_threshold;
+  };
+
+  // The number of instants for which the |BodyPositions| are cached.  Large
+  // enough for a few integrations evaluating the accelerations at the same
+  // instants concurrently, small enough that a linear search is cheap.
+  static int constexpr body_positions_cache_size = 16;
+
+  // The terms added to the acceleration of a massive body by its interaction
+  // with another massive body, recorded so that they may be summed in the same
+  // order as in the serial computation.
+  class AccelerationTerms final {
+   public:
+    AccelerationTerms& operator+=(Vector<Acceleration, Frame> const& term);
+    AccelerationTerms& operator-=(Vector<Acceleration, Frame> const& term);
+
+    // Adds the recorded terms to |acceleration| in the order in which they were
+    // recorded.
+    void AddTo(Vector<Acceleration, Frame>& acceleration) const;
+
+   private:
+    // At most one term for the central force and one for each geopotential.
+    std::array<Vector<Acceleration, Frame>, 3> terms_;
+    std::size_t size_ = 0;
+  };
+
+  // If background prolongation is enabled, ensures that the background thread
+  // prolongs the ephemeris up to at least |t| plus the horizon.
+  void RequestBackgroundProlongation(Instant const& t)
+      EXCLUDES(background_prolongation_lock_);
+
+  // The function executed by the background thread.  Returns when the target
+  // is reached or when background prolongation is stopped.
+  void ProlongInBackground()
+      EXCLUDES(lock_) EXCLUDES(background_prolongation_lock_);
+
   void AppendMassiveBodiesState(
       typename NewtonianMotionEquation::SystemState const& state)
       REQUIRES(lock_);
@@ -307,12 +541,56 @@ class Ephemeris {
       typename NewtonianMotionEquation::SystemState const& state,
       std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories);
 
+  // The problem for integrating in lockstep the massless bodies following the
+  // |trajectories|, from the time where they end.  The positions of the
+  // massive bodies are looked up in the cache iff |use_body_positions_cache|.
+  EnsembleProblem<NewtonianMotionEquation> MakeEnsembleProblem(
+      std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+      IntrinsicAccelerations const& intrinsic_accelerations,
+      bool use_body_positions_cache);
+
   Checkpoint GetCheckpoint() REQUIRES_SHARED(lock_);
 
+  // Returns the indices in |bodies_| sorted by decreasing gravitational
+  // parameter, so that the primary of a body comes before it.
+  std::vector<int> BodiesByDecreasingGravitationalParameter() const;
+
+  // Determines the parent of each of the |bodies_| from their |positions| by
+  // attaching each body to the smallest sphere of influence that contains it,
+  // in the manner of |HierarchicalSystem|.  The result is indexed like
+  // |bodies_|, the parent of the most massive body is -1.
+  std::vector<int> ComputeSubsystemParents(
+      std::vector<Position<Frame>> const& positions) const;
+
+  // Determines the |subsystems_| from the |parents| of the |bodies_|.  The
+  // hierarchy is serialized so that it doesn't depend on the state from which
+  // the ephemeris is restored.
+  void ComputeSubsystems(std::vector<int> const& parents);
+
   // Note the return by copy: the returned value is usable even if the
   // |instance_| is being integrated.
   Instant instance_time() const EXCLUDES(lock_);
 
+  // Computes the accelerations between |body1| (with index |b1| in the
+  // |geopotentials| array) and |body2| (with index |b2|), located at
+  // |position1| and |position2|, and adds them to |acceleration_on_b1| and
+  // |acceleration_on_b2|.  The |Accumulator| is either a
+  // |Vector<Acceleration, Frame>| or an |AccelerationTerms|.
+  template<bool body1_is_oblate,
+           bool body2_is_oblate,
+           typename Accumulator>
+  static void ComputeGravitationalAccelerationBetweenTwoMassiveBodies(
+      Instant const& t,
+      MassiveBody const& body1,
+      std::size_t const b1,
+      Position<Frame> const& position1,
+      MassiveBody const& body2,
+      std::size_t const b2,
+      Position<Frame> const& position2,
+      std::vector<Geopotential<Frame>> const& geopotentials,
+      Accumulator& acceleration_on_b1,
+      Accumulator& acceleration_on_b2);
+
   // Computes the accelerations between one body, |body1| (with index |b1| in
   // the |positions| and |accelerations| arrays) and the bodies |bodies2| (with
   // indices [b2_begin, b2_end[ in the |bodies2|, |positions| and
@@ -334,15 +612,47 @@ class Ephemeris {
       std::vector<Vector<Acceleration, Frame>>& accelerations,
       std::vector<Geopotential<Frame>> const& geopotentials);
 
+  // Evaluates the positions of the massive bodies at |t|, which must be within
+  // the trajectories, into |body_positions|, whose vectors are reused.
+  void EvaluateBodyPositions(Instant const& t,
+                             BodyPositions& body_positions) const
+      REQUIRES_SHARED(lock_);
+
+  // Same as above, but returns the positions from the cache if possible.
+  std::shared_ptr<BodyPositions const> EvaluateCachedBodyPositions(
+      Instant const& t) const
+      REQUIRES_SHARED(lock_) EXCLUDES(body_positions_cache_lock_);
+
+  // Computes the acceleration due to one body, |body1| (with index |b1| in the
+  // |bodies_| array and in the |body_positions|), on a massless body at the
+  // given |position|, and adds it to |acceleration|.  The template parameter
+  // specifies what we know about the massive body, and therefore what forces
+  // apply.
+  template<bool body1_is_oblate>
+  Error ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody(
+      MassiveBody const& body1,
+      std::size_t const b1,
+      BodyPositions const& body_positions,
+      Position<Frame> const& position,
+      Vector<Acceleration, Frame>& acceleration) const;
+
   // Computes the accelerations due to one body, |body1| (with index |b1| in the
-  // |bodies_| and |trajectories_| arrays) on massless bodies at the given
-  // |positions|.  The template parameter specifies what we know about the
-  // massive body, and therefore what forces apply.
+  // |bodies_| and |trajectories_| arrays), on massless bodies at the given
+  // |positions|.
   template<bool body1_is_oblate>
   Error ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies(
       Instant const& t,
       MassiveBody const& body1,
       std::size_t const b1,
+      BodyPositions const& body_positions,
+      std::vector<Position<Frame>> const& positions,
+      std::vector<Vector<Acceleration, Frame>>& accelerations) const
+      REQUIRES_SHARED(lock_);
+
+  // Same as above, but for all the |bodies_|, using the hierarchical
+  // approximation for the subsystems that are far enough.
+  Error ComputeHierarchicalGravitationalAccelerationsOnMasslessBodies(
+      BodyPositions const& body_positions,
       std::vector<Position<Frame>> const& positions,
       std::vector<Vector<Acceleration, Frame>>& accelerations) const
       REQUIRES_SHARED(lock_);
@@ -354,17 +664,66 @@ class Ephemeris {
       std::vector<Vector<Acceleration, Frame>>& accelerations) const
       REQUIRES_SHARED(lock_);
 
+  // Same as above, but distributes the pairs of bodies over the
+  // |massive_bodies_thread_pool_|.
+  void ComputeMassiveBodiesGravitationalAccelerationsInParallel(
+      Instant const& t,
+      std::vector<Position<Frame>> const& positions,
+      std::vector<Vector<Acceleration, Frame>>& accelerations) const
+      REQUIRES_SHARED(lock_);
+
   // Computes the acceleration exerted by the massive bodies in |bodies_| on
   // massless bodies.  The massless bodies are at the given |positions|.
   // Returns false iff a collision occurred, i.e., the massless body is inside
-  // one of the |bodies_|.
+  // one of the |bodies_|.  If |body_positions| is null, the positions of the
+  // massive bodies are looked up in the cache, which only pays off for
+  // integrations that share their instants with other integrations, i.e.,
+  // fixed-step ones.  Otherwise they are evaluated into |*body_positions|,
+  // which must not be shared between threads.
   Error ComputeMasslessBodiesGravitationalAccelerations(
       Instant const& t,
       std::vector<Position<Frame>> const& positions,
-      std::vector<Vector<Acceleration, Frame>>& accelerations) const
+      std::vector<Vector<Acceleration, Frame>>& accelerations,
+      BodyPositions* body_positions) const
       EXCLUDES(lock_);
 
-  // Flows the given ODE with an adaptive step integrator.
+  // Adds to |accelerations[j]|, for j > 0, the variation of the gravitational
+  // acceleration of the point masses on a massless body at |positions[0]|
+  // caused by the small variation |positions[j] - Frame::origin| of its
+  // position, i.e., the product of the gradient of the acceleration by that
+  // variation.  These are the right-hand sides of the variational equations.
+  // |body_positions| must have been evaluated at the time of the |positions|.
+  void ComputeMasslessBodyGravitationalAccelerationVariations(
+      BodyPositions const& body_positions,
+      std::vector<Position<Frame>> const& positions,
+      std::vector<Vector<Acceleration, Frame>>& accelerations) const;
+
+  // Returns the time at which an adaptive-step flow of trajectories ending at
+  // |trajectory_last_time| stops on its way to |t|.  The flow progresses by at
+  // least one step of the ephemeris, but it does not prolong the ephemeris by
+  // more than |max_ephemeris_steps|.
+  Instant AdaptiveStepFinalTime(Instant const& trajectory_last_time,
+                                Instant const& t,
+                                std::int64_t max_ephemeris_steps) const
+      EXCLUDES(lock_);
+
+  // The implementation of |FlowEnsembleWithAdaptiveStep| when |lockstep| is
+  // true.
+  std::vector<Status> FlowEnsembleInLockstepWithAdaptiveStep(
+      std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+      IntrinsicAccelerations const& intrinsic_accelerations,
+      Instant const& t,
+      AdaptiveStepParameters const& parameters,
+      std::int64_t max_ephemeris_steps,
+      bool last_point_only) EXCLUDES(lock_);
+
+  // Flows the given ODE with an adaptive step integrator.  If
+  // |state_transition_matrix| is not null, the variational equations are
+  // integrated together with the trajectory: |compute_acceleration| is called
+  // with the position of the massless body followed by 6 variations of that
+  // position (see |ComputeMasslessBodyGravitationalAccelerationVariations|),
+  // and the matrix is set from the final state.  The events of the
+  // |event_functions| are appended to the corresponding |events|.
   template<typename ODE>
   Status FlowODEWithAdaptiveStep(
       typename ODE::RightHandSideComputation compute_acceleration,
@@ -372,7 +731,11 @@ class Ephemeris {
       Instant const& t,
       ODEAdaptiveStepParameters<ODE> const& parameters,
       std::int64_t max_ephemeris_steps,
-      bool last_point_only) EXCLUDES(lock_);
+      bool last_point_only,
+      StateTransitionMatrix* state_transition_matrix,
+      std::vector<EventFunction> const& event_functions,
+      std::vector<not_null<DiscreteTrajectory<Frame>*>> const& events)
+      EXCLUDES(lock_);
 
   // Computes an estimate of the ratio |tolerance / error|.
   static double ToleranceToErrorRatio(
@@ -397,6 +760,12 @@ class Ephemeris {
   // The indices in |bodies_| correspond to those in |trajectories_|.
   std::vector<not_null<ContinuousTrajectory<Frame>*>> trajectories_;
 
+  // Only used if the hierarchical approximation is enabled.  Indexed like
+  // |bodies_|.  |root_subsystem_| is the subsystem of the most massive body,
+  // which contains all the others.
+  std::vector<Subsystem> subsystems_;
+  int root_subsystem_ = 0;
+
   std::map<not_null<MassiveBody const*>,
            not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>>
       bodies_to_trajectories_;
@@ -414,6 +783,62 @@ class Ephemeris {
   // implement compact serialization.  The vector is time-ordered.
   std::vector<Checkpoint> checkpoints_ GUARDED_BY(lock_);
 
+  // The number of threads used to compute the accelerations between the
+  // massive bodies and to fit their trajectories, including the thread calling
+  // |Prolong|.  The pool is null iff the parallelism is 1.
+  int massive_bodies_parallelism_ GUARDED_BY(lock_) = 1;
+  std::unique_ptr<ThreadPool<void>> massive_bodies_thread_pool_
+      GUARDED_BY(lock_);
+  // Scratch storage for the terms of the accelerations computed by
+  // |ComputeMassiveBodiesGravitationalAccelerationsInParallel|, sized by
+  // |SetMassiveBodiesParallelism| so that the steps do not allocate.  The
+  // massive bodies are only integrated with |lock_| held exclusively.
+  mutable std::vector<AccelerationTerms> massive_bodies_acceleration_terms_;
+  // Scratch storage for the structure of arrays passed to the vectorized
+  // kernel by |ComputeMassiveBodiesGravitationalAccelerations|, sized at
+  // construction: 7 arrays of |number_of_spherical_bodies_| elements.
+  mutable std::vector<double> spherical_bodies_arrays_;
+  // Scratch storage for the statuses of the appends to the |trajectories_|
+  // made by |AppendMassiveBodiesState|, sized at construction.
+  std::vector<Status> append_statuses_ GUARDED_BY(lock_);
+
+  // The |BodyPositions| most recently used to compute the accelerations on
+  // massless bodies by the fixed-step integrations, shared by all the threads
+  // that integrate them.  An entry remains valid as long as its time is within
+  // the trajectories, since the trajectories are only ever extended.  On a miss
+  // the entry at |next_body_positions_| is replaced.
+  mutable absl::Mutex body_positions_cache_lock_;
+  mutable std::array<std::shared_ptr<BodyPositions const>,
+                     body_positions_cache_size>
+      body_positions_cache_ GUARDED_BY(body_positions_cache_lock_);
+  mutable int next_body_positions_ GUARDED_BY(body_positions_cache_lock_) = 0;
+  mutable std::atomic<std::int64_t> body_positions_cache_hits_ = 0;
+  mutable std::atomic<std::int64_t> body_positions_cache_misses_ = 0;
+
+  // Incremented without a read-modify-write, as it is bumped by every call to
+  // |Prolong|.  Concurrent calls may therefore be undercounted.
+  mutable std::atomic<std::int64_t> immediate_prolongations_ = 0;
+  mutable std::atomic<std::int64_t> blocking_prolongations_ = 0;
+  mutable std::atomic<std::int64_t> blocking_prolongation_nanoseconds_ = 0;
+
+  // The background prolongation runs on a single thread, created on demand.
+  // It advances |instance_| one step at a time until |t_max()| reaches
+  // |background_prolongation_target_|.  At most one call is ever queued on
+  // |background_prolongation_thread_pool_|, as indicated by
+  // |background_prolongation_running_|.  The horizon and the target are only
+  // modified under |background_prolongation_lock_|, but they are atomic so
+  // that |RequestBackgroundProlongation| may skip the lock when there is
+  // nothing to request.
+  absl::Mutex background_prolongation_lock_;
+  std::atomic<Time> background_prolongation_horizon_ = Time();
+  std::atomic<Instant> background_prolongation_target_ = InfinitePast;
+  bool background_prolongation_running_
+      GUARDED_BY(background_prolongation_lock_) = false;
+  bool background_prolongation_shutdown_
+      GUARDED_BY(background_prolongation_lock_) = false;
+  std::unique_ptr<ThreadPool<void>> background_prolongation_thread_pool_
+      GUARDED_BY(background_prolongation_lock_);
+
   int number_of_oblate_bodies_ = 0;
   int number_of_spherical_bodies_ = 0;
 
@@ -4,21 +4,28 @@
 #include "physics/ephemeris.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <functional>
+#include <future>
 #include <limits>
+#include <numeric>
 #include <optional>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include "astronomy/epoch.hpp"
 #include "base/macros.hpp"
 #include "base/map_util.hpp"
 #include "base/not_null.hpp"
+#include "geometry/barycentre_calculator.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/r3_element.hpp"
 #include "integrators/integrators.hpp"
 #include "integrators/ordinary_differential_equations.hpp"
 #include "numerics/hermite3.hpp"
+#include "numerics/pairwise_gravitation.hpp"
 #include "physics/continuous_trajectory.hpp"
 #include "quantities/elementary_functions.hpp"
 #include "quantities/named_quantities.hpp"
@@ -35,6 +42,7 @@ using base::Error;
 using base::FindOrDie;
 using base::make_not_null_unique;
 using geometry::Barycentre;
+using geometry::BarycentreCalculator;
 using geometry::Displacement;
 using geometry::InnerProduct;
 using geometry::Position;
@@ -46,13 +54,16 @@ using integrators::ExplicitSecondOrderOrdinaryDifferentialEquation;
 using integrators::Integrator;
 using integrators::IntegrationProblem;
 using integrators::methods::Fine1987RKNG34;
+using numerics::AddMutualGravitationalAccelerations;
 using numerics::Bisect;
 using numerics::DoublePrecision;
 using numerics::Hermite3;
 using quantities::Abs;
 using quantities::Exponentiation;
 using quantities::GravitationalParameter;
+using quantities::Infinity;
 using quantities::Quotient;
+using quantities::SIUnit;
 using quantities::Sqrt;
 using quantities::Square;
 using quantities::Time;
@@ -68,6 +79,10 @@ using ::std::placeholders::_3;
 constexpr Length pre_ἐρατοσθένης_default_ephemeris_fitting_tolerance =
     1 * Milli(Metre);
 constexpr Time max_time_between_checkpoints = 180 * Day;
+// The number of states that |FlowODEWithAdaptiveStep| buffers before appending
+// them to the trajectory.  Larger batches bring little more, and this keeps the
+// buffer (about 6 KiB) in the L1 cache.
+constexpr std::size_t max_buffered_states = 100;
 // Below this threshold detect a collision to prevent the integrator and the
 // downsampling from going postal.
 constexpr double mean_radius_tolerance = 0.9;
@@ -170,9 +185,15 @@ Ephemeris<Frame>::ODEAdaptiveStepParameters<ODE>::ReadFromMessage(
 template<typename Frame>
 Ephemeris<Frame>::AccuracyParameters::AccuracyParameters(
     Length const& fitting_tolerance,
-    double const geopotential_tolerance)
+    double const geopotential_tolerance,
+    double const hierarchical_approximation_tolerance)
     : fitting_tolerance_(fitting_tolerance),
-      geopotential_tolerance_(geopotential_tolerance) {}
+      geopotential_tolerance_(geopotential_tolerance),
+      hierarchical_approximation_tolerance_(
+          hierarchical_approximation_tolerance) {
+  CHECK_LE(0, hierarchical_approximation_tolerance_);
+  CHECK_LT(hierarchical_approximation_tolerance_, 1);
+}
 
 template<typename Frame>
 void Ephemeris<Frame>::AccuracyParameters::WriteToMessage(
@@ -180,6 +201,10 @@ void Ephemeris<Frame>::AccuracyParameters::WriteToMessage(
     const {
   fitting_tolerance_.WriteToMessage(message->mutable_fitting_tolerance());
   message->set_geopotential_tolerance(geopotential_tolerance_);
+  if (hierarchical_approximation_tolerance_ > 0) {
+    message->set_hierarchical_approximation_tolerance(
+        hierarchical_approximation_tolerance_);
+  }
 }
 
 template<typename Frame>
@@ -188,7 +213,8 @@ Ephemeris<Frame>::AccuracyParameters::ReadFromMessage(
     serialization::Ephemeris::AccuracyParameters const& message) {
   return AccuracyParameters(
       Length::ReadFromMessage(message.fitting_tolerance()),
-      message.geopotential_tolerance());
+      message.geopotential_tolerance(),
+      message.hierarchical_approximation_tolerance());
 }
 
 template<typename Frame>
@@ -223,6 +249,53 @@ Ephemeris<Frame>::FixedStepParameters::ReadFromMessage(
       Time::ReadFromMessage(message.step()));
 }
 
+template<typename Frame>
+Ephemeris<Frame>::StateTransitionMatrix::StateTransitionMatrix()
+    : columns_(InitialPerturbations()) {}
+
+template<typename Frame>
+RelativeDegreesOfFreedom<Frame>
+Ephemeris<Frame>::StateTransitionMatrix::operator()(
+    RelativeDegreesOfFreedom<Frame> const& initial) const {
+  R3Element<double> const δq = initial.displacement().coordinates() / Metre;
+  R3Element<double> const δv =
+      initial.velocity().coordinates() / (Metre / Second);
+  return δq.x * columns_[0] + δq.y * columns_[1] + δq.z * columns_[2] +
+         δv.x * columns_[3] + δv.y * columns_[4] + δv.z * columns_[5];
+}
+
+template<typename Frame>
+std::array<RelativeDegreesOfFreedom<Frame>, 6> const&
+Ephemeris<Frame>::StateTransitionMatrix::InitialPerturbations() {
+  static std::array<RelativeDegreesOfFreedom<Frame>, 6> const
+      initial_perturbations = {
+          RelativeDegreesOfFreedom<Frame>(
+              Displacement<Frame>({1 * Metre, 0 * Metre, 0 * Metre}),
+              Velocity<Frame>()),
+          RelativeDegreesOfFreedom<Frame>(
+              Displacement<Frame>({0 * Metre, 1 * Metre, 0 * Metre}),
+              Velocity<Frame>()),
+          RelativeDegreesOfFreedom<Frame>(
+              Displacement<Frame>({0 * Metre, 0 * Metre, 1 * Metre}),
+              Velocity<Frame>()),
+          RelativeDegreesOfFreedom<Frame>(
+              Displacement<Frame>(),
+              Velocity<Frame>({1 * Metre / Second,
+                               0 * Metre / Second,
+                               0 * Metre / Second})),
+          RelativeDegreesOfFreedom<Frame>(
+              Displacement<Frame>(),
+              Velocity<Frame>({0 * Metre / Second,
+                               1 * Metre / Second,
+                               0 * Metre / Second})),
+          RelativeDegreesOfFreedom<Frame>(
+              Displacement<Frame>(),
+              Velocity<Frame>({0 * Metre / Second,
+                               0 * Metre / Second,
+                               1 * Metre / Second}))};
+  return initial_perturbations;
+}
+
 template<typename Frame>
 Ephemeris<Frame>::Ephemeris(
     std::vector<not_null<std::unique_ptr<MassiveBody const>>>&& bodies,
@@ -288,6 +361,16 @@ Ephemeris<Frame>::Ephemeris(
       ++number_of_spherical_bodies_;
     }
   }
+  spherical_bodies_arrays_.resize(7 * number_of_spherical_bodies_);
+  append_statuses_.resize(trajectories_.size());
+
+  if (accuracy_parameters_.hierarchical_approximation_tolerance_ > 0) {
+    std::vector<Position<Frame>> positions;
+    for (auto const& position : state.positions) {
+      positions.push_back(position.value);
+    }
+    ComputeSubsystems(ComputeSubsystemParents(positions));
+  }
 
   absl::ReaderMutexLock l(&lock_);  // For locking checks.
   instance_ = fixed_step_parameters_.integrator_->NewInstance(
@@ -297,6 +380,20 @@ Ephemeris<Frame>::Ephemeris(
       fixed_step_parameters_.step_);
 }
 
+template<typename Frame>
+Ephemeris<Frame>::~Ephemeris() {
+  std::unique_ptr<ThreadPool<void>> background_prolongation_thread_pool;
+  {
+    absl::MutexLock l(&background_prolongation_lock_);
+    background_prolongation_shutdown_ = true;
+    background_prolongation_thread_pool =
+        std::move(background_prolongation_thread_pool_);
+  }
+  // Wait for the background prolongation, if any, to stop before destroying
+  // the objects that it uses.
+  background_prolongation_thread_pool.reset();
+}
+
 template<typename Frame>
 std::vector<not_null<MassiveBody const*>> const&
 Ephemeris<Frame>::bodies() const {
@@ -390,8 +487,13 @@ template<typename Frame>
 void Ephemeris<Frame>::Prolong(Instant const& t) {
   // Short-circuit without locking.
   if (t <= t_max()) {
+    immediate_prolongations_.store(
+        immediate_prolongations_.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    RequestBackgroundProlongation(t);
     return;
   }
+  auto const start = std::chrono::steady_clock::now();
 
   // Note that |t| may be before the last time that we integrated and still
   // after |t_max()|.  In this case we want to make sure that the integrator
@@ -407,13 +509,73 @@ void Ephemeris<Frame>::Prolong(Instant const& t) {
   // Perform the integration.  Note that we may have to iterate until |t_max()|
   // actually reaches |t| because the last series may not be fully determined
   // after the first integration.
+  {
+    absl::MutexLock l(&lock_);
+    while (t_max() < t) {
+      instance_->Solve(t_final);
+      t_final += fixed_step_parameters_.step_;
+    }
+  }
+
+  ++blocking_prolongations_;
+  blocking_prolongation_nanoseconds_ +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start).count();
+  RequestBackgroundProlongation(t);
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::SetMassiveBodiesParallelism(
+    int const number_of_threads) {
+  CHECK_LE(1, number_of_threads);
   absl::MutexLock l(&lock_);
-  while (t_max() < t) {
-    instance_->Solve(t_final);
-    t_final += fixed_step_parameters_.step_;
+  massive_bodies_parallelism_ = number_of_threads;
+  if (number_of_threads == 1) {
+    massive_bodies_thread_pool_.reset();
+    massive_bodies_acceleration_terms_.clear();
+  } else {
+    // The thread calling |Prolong| does its share of the work.
+    massive_bodies_thread_pool_ =
+        std::make_unique<ThreadPool<void>>(number_of_threads - 1);
+    massive_bodies_acceleration_terms_.resize(bodies_.size() * bodies_.size());
   }
 }
 
+template<typename Frame>
+void Ephemeris<Frame>::SetBackgroundProlongationHorizon(Time const& horizon) {
+  CHECK_LE(Time(), horizon);
+  absl::MutexLock l(&background_prolongation_lock_);
+  background_prolongation_horizon_.store(horizon, std::memory_order_relaxed);
+  if (horizon == Time()) {
+    // Causes a running background prolongation to stop after its current step.
+    background_prolongation_target_.store(InfinitePast,
+                                          std::memory_order_relaxed);
+  } else if (background_prolongation_thread_pool_ == nullptr) {
+    background_prolongation_thread_pool_ =
+        std::make_unique<ThreadPool<void>>(/*pool_size=*/1);
+  }
+}
+
+template<typename Frame>
+typename Ephemeris<Frame>::BodyPositionsCacheStatistics
+Ephemeris<Frame>::body_positions_cache_statistics() const {
+  BodyPositionsCacheStatistics statistics;
+  statistics.hits = body_positions_cache_hits_;
+  statistics.misses = body_positions_cache_misses_;
+  return statistics;
+}
+
+template<typename Frame>
+typename Ephemeris<Frame>::ProlongationStatistics
+Ephemeris<Frame>::prolongation_statistics() const {
+  ProlongationStatistics statistics;
+  statistics.immediate = immediate_prolongations_;
+  statistics.blocking = blocking_prolongations_;
+  statistics.blocking_time =
+      std::chrono::nanoseconds(blocking_prolongation_nanoseconds_);
+  return statistics;
+}
+
 template<typename Frame>
 not_null<std::unique_ptr<typename Integrator<
     typename Ephemeris<Frame>::NewtonianMotionEquation>::Instance>>
@@ -428,10 +590,11 @@ Ephemeris<Frame>::NewInstance(
           Instant const& t,
           std::vector<Position<Frame>> const& positions,
           std::vector<Vector<Acceleration, Frame>>& accelerations) {
+    // The instances for the various massless bodies take steps at the same
+    // instants, so they share the positions of the massive bodies.
     Error const error =
-        ComputeMasslessBodiesGravitationalAccelerations(t,
-                                                        positions,
-                                                        accelerations);
+        ComputeMasslessBodiesGravitationalAccelerations(
+            t, positions, accelerations, /*body_positions=*/nullptr);
     // Add the intrinsic accelerations.
     for (int i = 0; i < intrinsic_accelerations.size(); ++i) {
       auto const intrinsic_acceleration = intrinsic_accelerations[i];
@@ -476,14 +639,34 @@ Status Ephemeris<Frame>::FlowWithAdaptiveStep(
     AdaptiveStepParameters const& parameters,
     std::int64_t const max_ephemeris_steps,
     bool const last_point_only) {
-  auto compute_acceleration = [this, &intrinsic_acceleration](
+  return FlowWithAdaptiveStep(trajectory,
+                              std::move(intrinsic_acceleration),
+                              t,
+                              parameters,
+                              max_ephemeris_steps,
+                              last_point_only,
+                              /*event_functions=*/{},
+                              /*events=*/{});
+}
+
+template<typename Frame>
+Status Ephemeris<Frame>::FlowWithAdaptiveStep(
+    not_null<DiscreteTrajectory<Frame>*> const trajectory,
+    IntrinsicAcceleration intrinsic_acceleration,
+    Instant const& t,
+    AdaptiveStepParameters const& parameters,
+    std::int64_t const max_ephemeris_steps,
+    bool const last_point_only,
+    std::vector<EventFunction> const& event_functions,
+    std::vector<not_null<DiscreteTrajectory<Frame>*>> const& events) {
+  BodyPositions body_positions;
+  auto compute_acceleration = [this, &intrinsic_acceleration, &body_positions](
       Instant const& t,
       std::vector<Position<Frame>> const& positions,
       std::vector<Vector<Acceleration, Frame>>& accelerations) {
     Error const error =
-        ComputeMasslessBodiesGravitationalAccelerations(t,
-                                                        positions,
-                                                        accelerations);
+        ComputeMasslessBodiesGravitationalAccelerations(
+            t, positions, accelerations, &body_positions);
     if (intrinsic_acceleration != nullptr) {
       accelerations[0] += intrinsic_acceleration(t);
     }
@@ -498,7 +681,64 @@ Status Ephemeris<Frame>::FlowWithAdaptiveStep(
              t,
              parameters,
              max_ephemeris_steps,
-             last_point_only);
+             last_point_only,
+             /*state_transition_matrix=*/nullptr,
+             event_functions,
+             events);
+}
+
+template<typename Frame>
+Status Ephemeris<Frame>::FlowWithAdaptiveStep(
+    not_null<DiscreteTrajectory<Frame>*> const trajectory,
+    IntrinsicAcceleration intrinsic_acceleration,
+    Instant const& t,
+    AdaptiveStepParameters const& parameters,
+    std::int64_t const max_ephemeris_steps,
+    bool const last_point_only,
+    not_null<StateTransitionMatrix*> const state_transition_matrix) {
+  // The gravitational acceleration must only be computed at the position of
+  // the massless body, not at its variations.
+  std::vector<Position<Frame>> massless_body_position(1);
+  std::vector<Vector<Acceleration, Frame>> massless_body_acceleration(1);
+  BodyPositions body_positions;
+  auto compute_acceleration = [this,
+                               &intrinsic_acceleration,
+                               &massless_body_position,
+                               &massless_body_acceleration,
+                               &body_positions](
+      Instant const& t,
+      std::vector<Position<Frame>> const& positions,
+      std::vector<Vector<Acceleration, Frame>>& accelerations) {
+    massless_body_position[0] = positions[0];
+    Error const error =
+        ComputeMasslessBodiesGravitationalAccelerations(
+            t, massless_body_position, massless_body_acceleration,
+            &body_positions);
+    if (error == Error::CANCELLED) {
+      // The positions of the massive bodies were not evaluated.
+      return Status::CANCELLED;
+    }
+    accelerations[0] = massless_body_acceleration[0];
+    if (intrinsic_acceleration != nullptr) {
+      accelerations[0] += intrinsic_acceleration(t);
+    }
+    ComputeMasslessBodyGravitationalAccelerationVariations(
+        body_positions, positions, accelerations);
+    return error == Error::OK ? Status::OK :
+           error == Error::CANCELLED ? Status::CANCELLED :
+                    CollisionDetected();
+  };
+
+  return FlowODEWithAdaptiveStep<NewtonianMotionEquation>(
+             std::move(compute_acceleration),
+             trajectory,
+             t,
+             parameters,
+             max_ephemeris_steps,
+             last_point_only,
+             state_transition_matrix,
+             /*event_functions=*/{},
+             /*events=*/{});
 }
 
 template<typename Frame>
@@ -509,16 +749,16 @@ Status Ephemeris<Frame>::FlowWithAdaptiveStep(
     GeneralizedAdaptiveStepParameters const& parameters,
     std::int64_t max_ephemeris_steps,
     bool last_point_only) {
+  BodyPositions body_positions;
   auto compute_acceleration =
-      [this, &intrinsic_acceleration](
+      [this, &intrinsic_acceleration, &body_positions](
           Instant const& t,
           std::vector<Position<Frame>> const& positions,
           std::vector<Velocity<Frame>> const& velocities,
           std::vector<Vector<Acceleration, Frame>>& accelerations) {
         Error const error =
-            ComputeMasslessBodiesGravitationalAccelerations(t,
-                                                            positions,
-                                                            accelerations);
+            ComputeMasslessBodiesGravitationalAccelerations(
+                t, positions, accelerations, &body_positions);
         if (intrinsic_acceleration != nullptr) {
           accelerations[0] +=
               intrinsic_acceleration(t, {positions[0], velocities[0]});
@@ -534,7 +774,76 @@ Status Ephemeris<Frame>::FlowWithAdaptiveStep(
              t,
              parameters,
              max_ephemeris_steps,
-             last_point_only);
+             last_point_only,
+             /*state_transition_matrix=*/nullptr,
+             /*event_functions=*/{},
+             /*events=*/{});
+}
+
+template<typename Frame>
+std::vector<Status> Ephemeris<Frame>::FlowEnsembleWithAdaptiveStep(
+    std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+    IntrinsicAccelerations const& intrinsic_accelerations,
+    Instant const& t,
+    AdaptiveStepParameters const& parameters,
+    std::int64_t const max_ephemeris_steps,
+    bool const last_point_only,
+    bool const lockstep,
+    ThreadPool<void>* const thread_pool) {
+  CHECK_EQ(trajectories.size(), intrinsic_accelerations.size());
+  if (lockstep) {
+    CHECK(thread_pool == nullptr);
+    return FlowEnsembleInLockstepWithAdaptiveStep(trajectories,
+                                                  intrinsic_accelerations,
+                                                  t,
+                                                  parameters,
+                                                  max_ephemeris_steps,
+                                                  last_point_only);
+  }
+
+  std::vector<Status> statuses(trajectories.size());
+  if (trajectories.empty()) {
+    return statuses;
+  }
+
+  // Prolong the ephemeris as far as the member that needs it most, so that the
+  // members don't take turns extending it.  This is the maximum of the
+  // |t_final| computed by |FlowODEWithAdaptiveStep| for the individual members.
+  Instant latest_last_time = trajectories.front()->last().time();
+  for (auto const trajectory : trajectories) {
+    latest_last_time = std::max(latest_last_time, trajectory->last().time());
+  }
+  Prolong(AdaptiveStepFinalTime(latest_last_time, t, max_ephemeris_steps));
+
+  auto const flow = [this,
+                     &trajectories,
+                     &intrinsic_accelerations,
+                     &t,
+                     &parameters,
+                     max_ephemeris_steps,
+                     last_point_only,
+                     &statuses](int const i) {
+    statuses[i] = FlowWithAdaptiveStep(trajectories[i],
+                                       intrinsic_accelerations[i],
+                                       t,
+                                       parameters,
+                                       max_ephemeris_steps,
+                                       last_point_only);
+  };
+  if (thread_pool == nullptr) {
+    for (int i = 0; i < trajectories.size(); ++i) {
+      flow(i);
+    }
+  } else {
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < trajectories.size(); ++i) {
+      futures.push_back(thread_pool->Add(std::bind(flow, i)));
+    }
+    for (auto const& future : futures) {
+      future.wait();
+    }
+  }
+  return statuses;
 }
 
 template<typename Frame>
@@ -548,13 +857,56 @@ Status Ephemeris<Frame>::FlowWithFixedStep(
   return instance.Solve(t);
 }
 
+template<typename Frame>
+not_null<std::unique_ptr<EnsembleInstance<
+    typename Ephemeris<Frame>::NewtonianMotionEquation>>>
+Ephemeris<Frame>::NewEnsembleInstance(
+    std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+    IntrinsicAccelerations const& intrinsic_accelerations,
+    FixedStepParameters const& parameters) {
+  auto const append_state =
+      [trajectories](
+          int const member,
+          typename NewtonianMotionEquation::SystemState const& state) {
+        trajectories[member]->Append(
+            state.time.value,
+            DegreesOfFreedom<Frame>(state.positions[0].value,
+                                    state.velocities[0].value));
+      };
+
+  // The construction of the instance may evaluate the degrees of freedom of the
+  // bodies.
+  CHECK(!trajectories.empty());
+  Prolong(trajectories.front()->last().time() + parameters.step_);
+
+  return parameters.integrator_->NewEnsembleInstance(
+      MakeEnsembleProblem(trajectories,
+                          intrinsic_accelerations,
+                          /*use_body_positions_cache=*/true),
+      append_state,
+      parameters.step_);
+}
+
+template<typename Frame>
+Status Ephemeris<Frame>::FlowEnsembleWithFixedStep(
+    Instant const& t,
+    EnsembleInstance<NewtonianMotionEquation>& instance) {
+  if (empty() || t > t_max()) {
+    Prolong(t);
+  }
+
+  return instance.Solve(t);
+}
+
 template<typename Frame>
 Vector<Acceleration, Frame> Ephemeris<Frame>::
 ComputeGravitationalAccelerationOnMasslessBody(
     Position<Frame> const& position,
     Instant const& t) const {
   std::vector<Vector<Acceleration, Frame>> accelerations(1);
-  ComputeMasslessBodiesGravitationalAccelerations(t, {position}, accelerations);
+  BodyPositions body_positions;
+  ComputeMasslessBodiesGravitationalAccelerations(
+      t, {position}, accelerations, &body_positions);
 
   return accelerations[0];
 }
@@ -760,6 +1112,9 @@ void Ephemeris<Frame>::WriteToMessage(
       message->mutable_fixed_step_parameters());
   accuracy_parameters_.WriteToMessage(
       message->mutable_accuracy_parameters());
+  for (auto const& subsystem : subsystems_) {
+    message->add_subsystem_parent(subsystem.parent);
+  }
   LOG(INFO) << NAMED(message->SpaceUsed());
   LOG(INFO) << NAMED(message->ByteSize());
 }
@@ -841,6 +1196,14 @@ not_null<std::unique_ptr<Ephemeris<Frame>>> Ephemeris<Frame>::ReadFromMessage(
     // The ephemeris will need to be prolonged as needed when deserializing the
     // plugin.
   }
+  if (accuracy_parameters.hierarchical_approximation_tolerance_ > 0) {
+    // The hierarchy is restored as it was computed at construction, not
+    // recomputed from the state of the integrator.
+    CHECK_EQ(ephemeris->bodies_.size(), message.subsystem_parent_size());
+    ephemeris->ComputeSubsystems(
+        std::vector<int>(message.subsystem_parent().begin(),
+                         message.subsystem_parent().end()));
+  }
   return ephemeris;
 }
 
@@ -852,19 +1215,225 @@ Ephemeris<Frame>::Ephemeris(
                            /*geopotential_tolerance=*/0),
       fixed_step_parameters_(integrator, 1 * Second) {}
 
+template<typename Frame>
+typename Ephemeris<Frame>::AccelerationTerms&
+Ephemeris<Frame>::AccelerationTerms::operator+=(
+    Vector<Acceleration, Frame> const& term) {
+  DCHECK_LT(size_, terms_.size());
+  terms_[size_++] = term;
+  return *this;
+}
+
+template<typename Frame>
+typename Ephemeris<Frame>::AccelerationTerms&
+Ephemeris<Frame>::AccelerationTerms::operator-=(
+    Vector<Acceleration, Frame> const& term) {
+  // Exact: IEEE 754 defines subtraction as the addition of the opposite.
+  DCHECK_LT(size_, terms_.size());
+  terms_[size_++] = -term;
+  return *this;
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::AccelerationTerms::AddTo(
+    Vector<Acceleration, Frame>& acceleration) const {
+  for (std::size_t i = 0; i < size_; ++i) {
+    acceleration += terms_[i];
+  }
+}
+
+template<typename Frame>
+std::vector<int>
+Ephemeris<Frame>::BodiesByDecreasingGravitationalParameter() const {
+  std::vector<int> order(bodies_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](int const left,
+                                                      int const right) {
+    return bodies_[left]->gravitational_parameter() >
+           bodies_[right]->gravitational_parameter();
+  });
+  return order;
+}
+
+template<typename Frame>
+std::vector<int> Ephemeris<Frame>::ComputeSubsystemParents(
+    std::vector<Position<Frame>> const& positions) const {
+  int const number_of_bodies = bodies_.size();
+  CHECK_EQ(number_of_bodies, positions.size());
+
+  // Place the bodies by decreasing gravitational parameter, so that the
+  // primary of a body has been placed before it.
+  std::vector<int> const order = BodiesByDecreasingGravitationalParameter();
+
+  // The radii of the spheres of influence, in the sense of Laplace.
+  std::vector<Length> sphere_of_influence(number_of_bodies,
+                                          Infinity<Length>());
+  std::vector<int> parents(number_of_bodies, -1);
+  int const root = order.front();
+  for (int i = 1; i < number_of_bodies; ++i) {
+    int const b = order[i];
+    int parent = root;
+    for (int j = 1; j < i; ++j) {
+      int const candidate = order[j];
+      if ((positions[b] - positions[candidate]).Norm() <
+              sphere_of_influence[candidate] &&
+          sphere_of_influence[candidate] < sphere_of_influence[parent]) {
+        parent = candidate;
+      }
+    }
+    parents[b] = parent;
+    sphere_of_influence[b] =
+        (positions[b] - positions[parent]).Norm() *
+        std::pow(bodies_[b]->gravitational_parameter() /
+                     bodies_[parent]->gravitational_parameter(),
+                 0.4);
+  }
+  return parents;
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::ComputeSubsystems(std::vector<int> const& parents) {
+  int const number_of_bodies = bodies_.size();
+  CHECK_EQ(number_of_bodies, parents.size());
+  std::vector<int> const order = BodiesByDecreasingGravitationalParameter();
+  root_subsystem_ = order.front();
+  CHECK_EQ(-1, parents[root_subsystem_]);
+
+  subsystems_.clear();
+  subsystems_.resize(number_of_bodies);
+  for (int b = 0; b < number_of_bodies; ++b) {
+    subsystems_[b].bodies.push_back(b);
+    subsystems_[b].parent = parents[b];
+  }
+  // Visiting the bodies by increasing gravitational parameter ensures that
+  // the bodies of a subsystem are complete when it is added to its parent.
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    int const b = *it;
+    Subsystem& subsystem = subsystems_[b];
+    for (int const body : subsystem.bodies) {
+      subsystem.gravitational_parameter +=
+          bodies_[body]->gravitational_parameter();
+      if (body < number_of_oblate_bodies_) {
+        auto const& degree_damping = geopotentials_[body].degree_damping();
+        if (degree_damping.size() > 2) {
+          subsystem.geopotential_threshold =
+              std::max(subsystem.geopotential_threshold,
+                       degree_damping[2].outer_threshold());
+        }
+      }
+    }
+    if (subsystem.parent >= 0) {
+      Subsystem& parent = subsystems_[subsystem.parent];
+      parent.satellites.push_back(b);
+      parent.bodies.insert(parent.bodies.end(),
+                           subsystem.bodies.begin(),
+                           subsystem.bodies.end());
+    }
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::RequestBackgroundProlongation(Instant const& t) {
+  // Don't lock if background prolongation is disabled or if the target leaves
+  // at least half of the horizon after |t|.  When |t| increases, the lock is
+  // thus taken about once per half horizon.
+  Time const horizon =
+      background_prolongation_horizon_.load(std::memory_order_relaxed);
+  if (horizon == Time() ||
+      t + 0.5 * horizon <=
+          background_prolongation_target_.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  absl::MutexLock l(&background_prolongation_lock_);
+  Time const locked_horizon =
+      background_prolongation_horizon_.load(std::memory_order_relaxed);
+  if (locked_horizon == Time() || background_prolongation_shutdown_) {
+    return;
+  }
+  background_prolongation_target_.store(
+      std::max(background_prolongation_target_.load(std::memory_order_relaxed),
+               t + locked_horizon),
+      std::memory_order_relaxed);
+  if (!background_prolongation_running_) {
+    background_prolongation_running_ = true;
+    background_prolongation_thread_pool_->Add(
+        [this]() { ProlongInBackground(); });
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::ProlongInBackground() {
+  for (;;) {
+    Instant const t_max = this->t_max();
+    {
+      absl::MutexLock l(&background_prolongation_lock_);
+      if (background_prolongation_shutdown_ ||
+          t_max >= background_prolongation_target_.load(
+                       std::memory_order_relaxed)) {
+        background_prolongation_running_ = false;
+        return;
+      }
+    }
+    // Integrate a single step so that |lock_| is held briefly and the readers
+    // and the foreground |Prolong| may interleave with the background.  The
+    // checkpoints are created by the integration callback as for |Prolong|.
+    absl::MutexLock l(&lock_);
+    instance_->Solve(instance_->time().value + fixed_step_parameters_.step_);
+  }
+}
+
 template<typename Frame>
 void Ephemeris<Frame>::AppendMassiveBodiesState(
     typename NewtonianMotionEquation::SystemState const& state) {
   lock_.AssertHeld();
-  int index = 0;
-  for (int i = 0; i < trajectories_.size(); ++i) {
-    auto const& trajectory = trajectories_[i];
-    auto const status = trajectory->Append(
+  std::vector<Status>& statuses = append_statuses_;
+  DCHECK_EQ(trajectories_.size(), statuses.size());
+  auto const append = [this, &state, &statuses](std::size_t const i) {
+    statuses[i] = trajectories_[i]->Append(
         state.time.value,
-        DegreesOfFreedom<Frame>(state.positions[index].value,
-                                state.velocities[index].value));
+        DegreesOfFreedom<Frame>(state.positions[i].value,
+                                state.velocities[i].value));
+  };
 
-    // Handle the apocalypse.
+  // The Newhall fits of the different bodies are independent, so when they
+  // happen they are distributed over the |massive_bodies_thread_pool_|.  The
+  // other appends are too cheap to be worth distributing.
+  bool const computes_polynomials =
+      massive_bodies_thread_pool_ != nullptr &&
+      std::any_of(trajectories_.begin(),
+                  trajectories_.end(),
+                  [](not_null<ContinuousTrajectory<Frame>*> const trajectory) {
+                    return trajectory->next_append_computes_polynomial();
+                  });
+  if (computes_polynomials) {
+    std::size_t const parallelism = massive_bodies_parallelism_;
+    auto const append_bodies = [this, parallelism, &append](
+                                   std::size_t const first_i) {
+      for (std::size_t i = first_i;
+           i < trajectories_.size();
+           i += parallelism) {
+        append(i);
+      }
+    };
+    std::vector<std::future<void>> futures;
+    for (std::size_t i = 1; i < parallelism; ++i) {
+      futures.push_back(
+          massive_bodies_thread_pool_->Add(std::bind(append_bodies, i)));
+    }
+    append_bodies(0);
+    for (auto const& future : futures) {
+      future.wait();
+    }
+  } else {
+    for (std::size_t i = 0; i < trajectories_.size(); ++i) {
+      append(i);
+    }
+  }
+
+  // Handle the apocalypse.
+  for (std::size_t i = 0; i < trajectories_.size(); ++i) {
+    Status const& status = statuses[i];
     if (!status.ok()) {
       last_severe_integration_status_ =
           Status(status.error(),
@@ -872,8 +1441,6 @@ void Ephemeris<Frame>::AppendMassiveBodiesState(
                      status.message());
       LOG(ERROR) << "New Apocalypse: " << last_severe_integration_status_;
     }
-
-    ++index;
   }
 
   // Record an intermediate state if we haven't done so for too long.
@@ -901,6 +1468,55 @@ void Ephemeris<Frame>::AppendMasslessBodiesState(
   }
 }
 
+template<typename Frame>
+EnsembleProblem<typename Ephemeris<Frame>::NewtonianMotionEquation>
+Ephemeris<Frame>::MakeEnsembleProblem(
+    std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+    IntrinsicAccelerations const& intrinsic_accelerations,
+    bool const use_body_positions_cache) {
+  EnsembleProblem<NewtonianMotionEquation> problem;
+
+  // Each member has a single position, so the accelerations computed for a
+  // subset of the members are indexed like the |members|.  The problem is
+  // copied, so the positions of the massive bodies are shared.
+  std::shared_ptr<BodyPositions> const body_positions =
+      use_body_positions_cache ? nullptr : std::make_shared<BodyPositions>();
+  problem.compute_acceleration =
+      [this, intrinsic_accelerations, body_positions](
+          Instant const& t,
+          std::vector<int> const& members,
+          std::vector<Position<Frame>> const& positions,
+          std::vector<Vector<Acceleration, Frame>>& accelerations) {
+    Error const error =
+        ComputeMasslessBodiesGravitationalAccelerations(
+            t, positions, accelerations, body_positions.get());
+    // Add the intrinsic accelerations.
+    for (int i = 0; i < members.size(); ++i) {
+      int const member = members[i];
+      if (member < intrinsic_accelerations.size() &&
+          intrinsic_accelerations[member] != nullptr) {
+        accelerations[i] += intrinsic_accelerations[member](t);
+      }
+    }
+    return error == Error::OK ? Status::OK :
+           error == Error::CANCELLED ? Status::CANCELLED :
+                    CollisionDetected();
+  };
+
+  CHECK(!trajectories.empty());
+  Instant const trajectory_last_time = trajectories.front()->last().time();
+  for (auto const& trajectory : trajectories) {
+    auto const trajectory_last = trajectory->last();
+    auto const last_degrees_of_freedom = trajectory_last.degrees_of_freedom();
+    CHECK_EQ(trajectory_last.time(), trajectory_last_time);
+    problem.initial_states.emplace_back(
+        std::vector<Position<Frame>>{last_degrees_of_freedom.position()},
+        std::vector<Velocity<Frame>>{last_degrees_of_freedom.velocity()},
+        trajectory_last_time);
+  }
+  return problem;
+}
+
 template<typename Frame>
 typename Ephemeris<Frame>::Checkpoint Ephemeris<Frame>::GetCheckpoint() {
   lock_.AssertReaderHeld();
@@ -917,6 +1533,70 @@ Instant Ephemeris<Frame>::instance_time() const {
   return instance_->time().value;
 }
 
+template<typename Frame>
+template<bool body1_is_oblate,
+         bool body2_is_oblate,
+         typename Accumulator>
+void Ephemeris<Frame>::ComputeGravitationalAccelerationBetweenTwoMassiveBodies(
+    Instant const& t,
+    MassiveBody const& body1,
+    std::size_t const b1,
+    Position<Frame> const& position1,
+    MassiveBody const& body2,
+    std::size_t const b2,
+    Position<Frame> const& position2,
+    std::vector<Geopotential<Frame>> const& geopotentials,
+    Accumulator& acceleration_on_b1,
+    Accumulator& acceleration_on_b2) {
+  GravitationalParameter const& μ1 = body1.gravitational_parameter();
+  GravitationalParameter const& μ2 = body2.gravitational_parameter();
+
+  // A vector from the center of |b2| to the center of |b1|.
+  Displacement<Frame> const Δq = position1 - position2;
+
+  Square<Length> const Δq² = Δq.Norm²();
+  Length const Δq_norm = Sqrt(Δq²);
+  Exponentiation<Length, -3> const one_over_Δq³ = Δq_norm / (Δq² * Δq²);
+
+  auto const μ1_over_Δq³ = μ1 * one_over_Δq³;
+  acceleration_on_b2 += Δq * μ1_over_Δq³;
+
+  // Lex. III. Actioni contrariam semper & æqualem esse reactionem:
+  // sive corporum duorum actiones in se mutuo semper esse æquales &
+  // in partes contrarias dirigi.
+  auto const μ2_over_Δq³ = μ2 * one_over_Δq³;
+  acceleration_on_b1 -= Δq * μ2_over_Δq³;
+
+  if (body1_is_oblate || body2_is_oblate) {
+    if (body1_is_oblate) {
+      Vector<Quotient<Acceleration,
+                      GravitationalParameter>, Frame> const
+          degree_2_zonal_effect1 =
+              geopotentials[b1].GeneralSphericalHarmonicsAcceleration(
+                  t,
+                  -Δq,
+                  Δq_norm,
+                  Δq²,
+                  one_over_Δq³);
+      acceleration_on_b1 -= μ2 * degree_2_zonal_effect1;
+      acceleration_on_b2 += μ1 * degree_2_zonal_effect1;
+    }
+    if (body2_is_oblate) {
+      Vector<Quotient<Acceleration,
+                      GravitationalParameter>, Frame> const
+          degree_2_zonal_effect2 =
+              geopotentials[b2].GeneralSphericalHarmonicsAcceleration(
+                  t,
+                  Δq,
+                  Δq_norm,
+                  Δq²,
+                  one_over_Δq³);
+      acceleration_on_b1 += μ2 * degree_2_zonal_effect2;
+      acceleration_on_b2 -= μ1 * degree_2_zonal_effect2;
+    }
+  }
+}
+
 template<typename Frame>
 template<bool body1_is_oblate,
          bool body2_is_oblate,
@@ -934,57 +1614,117 @@ void Ephemeris<Frame>::
         std::vector<Geopotential<Frame>> const& geopotentials) {
   Position<Frame> const& position_of_b1 = positions[b1];
   Vector<Acceleration, Frame>& acceleration_on_b1 = accelerations[b1];
-  GravitationalParameter const& μ1 = body1.gravitational_parameter();
   for (std::size_t b2 = b2_begin; b2 < b2_end; ++b2) {
-    Vector<Acceleration, Frame>& acceleration_on_b2 = accelerations[b2];
-    MassiveBody const& body2 = *bodies2[b2];
-    GravitationalParameter const& μ2 = body2.gravitational_parameter();
-
-    // A vector from the center of |b2| to the center of |b1|.
-    Displacement<Frame> const Δq = position_of_b1 - positions[b2];
+    ComputeGravitationalAccelerationBetweenTwoMassiveBodies<body1_is_oblate,
+                                                            body2_is_oblate>(
+        t,
+        body1, b1, position_of_b1,
+        /*body2=*/*bodies2[b2], b2, /*position2=*/positions[b2],
+        geopotentials,
+        acceleration_on_b1,
+        /*acceleration_on_b2=*/accelerations[b2]);
+  }
+}
 
-    Square<Length> const Δq² = Δq.Norm²();
-    Length const Δq_norm = Sqrt(Δq²);
-    Exponentiation<Length, -3> const one_over_Δq³ = Δq_norm / (Δq² * Δq²);
+template<typename Frame>
+void Ephemeris<Frame>::EvaluateBodyPositions(
+    Instant const& t,
+    BodyPositions& body_positions) const {
+  lock_.AssertReaderHeld();
+  body_positions.t = t;
+  body_positions.positions.clear();
+  body_positions.positions.reserve(trajectories_.size());
+  for (auto const& trajectory : trajectories_) {
+    body_positions.positions.push_back(trajectory->EvaluatePosition(t));
+  }
+  body_positions.equatorial_axes.clear();
+  body_positions.equatorial_axes.reserve(geopotentials_.size());
+  for (auto const& geopotential : geopotentials_) {
+    body_positions.equatorial_axes.push_back(geopotential.EquatorialAxesAt(t));
+  }
+  body_positions.barycentres.clear();
+  body_positions.radii.clear();
+  body_positions.barycentres.reserve(subsystems_.size());
+  body_positions.radii.reserve(subsystems_.size());
+  for (auto const& subsystem : subsystems_) {
+    BarycentreCalculator<Position<Frame>, GravitationalParameter> calculator;
+    for (int const b : subsystem.bodies) {
+      calculator.Add(body_positions.positions[b],
+                     bodies_[b]->gravitational_parameter());
+    }
+    Position<Frame> const barycentre = calculator.Get();
+    Length radius;
+    for (int const b : subsystem.bodies) {
+      radius = std::max(radius,
+                        (body_positions.positions[b] - barycentre).Norm());
+    }
+    body_positions.barycentres.push_back(barycentre);
+    body_positions.radii.push_back(radius);
+  }
+}
 
-    auto const μ1_over_Δq³ = μ1 * one_over_Δq³;
-    acceleration_on_b2 += Δq * μ1_over_Δq³;
-
-    // Lex. III. Actioni contrariam semper & æqualem esse reactionem:
-    // sive corporum duorum actiones in se mutuo semper esse æquales &
-    // in partes contrarias dirigi.
-    auto const μ2_over_Δq³ = μ2 * one_over_Δq³;
-    acceleration_on_b1 -= Δq * μ2_over_Δq³;
-
-    if (body1_is_oblate || body2_is_oblate) {
-      if (body1_is_oblate) {
-        Vector<Quotient<Acceleration,
-                        GravitationalParameter>, Frame> const
-            degree_2_zonal_effect1 =
-                geopotentials[b1].GeneralSphericalHarmonicsAcceleration(
-                    t,
-                    -Δq,
-                    Δq_norm,
-                    Δq²,
-                    one_over_Δq³);
-        acceleration_on_b1 -= μ2 * degree_2_zonal_effect1;
-        acceleration_on_b2 += μ1 * degree_2_zonal_effect1;
-      }
-      if (body2_is_oblate) {
-        Vector<Quotient<Acceleration,
-                        GravitationalParameter>, Frame> const
-            degree_2_zonal_effect2 =
-                geopotentials[b2].GeneralSphericalHarmonicsAcceleration(
-                    t,
-                    Δq,
-                    Δq_norm,
-                    Δq²,
-                    one_over_Δq³);
-        acceleration_on_b1 += μ2 * degree_2_zonal_effect2;
-        acceleration_on_b2 -= μ1 * degree_2_zonal_effect2;
+template<typename Frame>
+std::shared_ptr<typename Ephemeris<Frame>::BodyPositions const>
+Ephemeris<Frame>::EvaluateCachedBodyPositions(Instant const& t) const {
+  lock_.AssertReaderHeld();
+  {
+    absl::ReaderMutexLock l(&body_positions_cache_lock_);
+    for (auto const& body_positions : body_positions_cache_) {
+      if (body_positions != nullptr && body_positions->t == t) {
+        ++body_positions_cache_hits_;
+        return body_positions;
       }
     }
   }
+
+  // Evaluate the trajectories without holding the lock of the cache: other
+  // threads may be looking up different times.
+  ++body_positions_cache_misses_;
+  auto body_positions = std::make_shared<BodyPositions>();
+  EvaluateBodyPositions(t, *body_positions);
+
+  absl::MutexLock l(&body_positions_cache_lock_);
+  body_positions_cache_[next_body_positions_] = body_positions;
+  next_body_positions_ = (next_body_positions_ + 1) % body_positions_cache_size;
+  return body_positions;
+}
+
+template<typename Frame>
+template<bool body1_is_oblate>
+Error Ephemeris<Frame>::
+ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody(
+    MassiveBody const& body1,
+    std::size_t const b1,
+    BodyPositions const& body_positions,
+    Position<Frame> const& position,
+    Vector<Acceleration, Frame>& acceleration) const {
+  GravitationalParameter const& μ1 = body1.gravitational_parameter();
+  Length const body1_collision_radius =
+      mean_radius_tolerance * body1.mean_radius();
+
+  // A vector from the massless body to the center of |b1|.
+  Displacement<Frame> const Δq = body_positions.positions[b1] - position;
+
+  Square<Length> const Δq² = Δq.Norm²();
+  Length const Δq_norm = Sqrt(Δq²);
+  Exponentiation<Length, -3> const one_over_Δq³ = Δq_norm / (Δq² * Δq²);
+
+  auto const μ1_over_Δq³ = μ1 * one_over_Δq³;
+  acceleration += Δq * μ1_over_Δq³;
+
+  if (body1_is_oblate) {
+    Vector<Quotient<Acceleration,
+                    GravitationalParameter>, Frame> const
+        degree_2_zonal_effect1 =
+            geopotentials_[b1].GeneralSphericalHarmonicsAcceleration(
+                body_positions.equatorial_axes[b1],
+                -Δq,
+                Δq_norm,
+                Δq²,
+                one_over_Δq³);
+    acceleration += μ1 * degree_2_zonal_effect1;
+  }
+  return Δq_norm > body1_collision_radius ? Error::OK : Error::OUT_OF_RANGE;
 }
 
 template<typename Frame>
@@ -994,46 +1734,67 @@ ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies(
     Instant const& t,
     MassiveBody const& body1,
     std::size_t const b1,
+    BodyPositions const& body_positions,
     std::vector<Position<Frame>> const& positions,
     std::vector<Vector<Acceleration, Frame>>& accelerations) const {
   lock_.AssertReaderHeld();
-  GravitationalParameter const& μ1 = body1.gravitational_parameter();
-  auto const& trajectory1 = *trajectories_[b1];
-  if (t < trajectory1.t_min()) {
-    // This can happen when computing a prediction asynchronously and the
-    // continuous trajectories have been "forgotten before" already.  Just
-    // cancel the prediction.
-    return Error::CANCELLED;
-  }
-  Position<Frame> const position1 = trajectory1.EvaluatePosition(t);
-  Length const body1_collision_radius =
-      mean_radius_tolerance * body1.mean_radius();
   Error error = Error::OK;
-
   for (std::size_t b2 = 0; b2 < positions.size(); ++b2) {
-    // A vector from the center of |b2| to the center of |b1|.
-    Displacement<Frame> const Δq = position1 - positions[b2];
-
-    Square<Length> const Δq² = Δq.Norm²();
-    Length const Δq_norm = Sqrt(Δq²);
-    error |= Δq_norm > body1_collision_radius ? Error::OK : Error::OUT_OF_RANGE;
-
-    Exponentiation<Length, -3> const one_over_Δq³ = Δq_norm / (Δq² * Δq²);
-
-    auto const μ1_over_Δq³ = μ1 * one_over_Δq³;
-    accelerations[b2] += Δq * μ1_over_Δq³;
+    error |= ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody<
+                 body1_is_oblate>(body1,
+                                  b1,
+                                  body_positions,
+                                  positions[b2],
+                                  accelerations[b2]);
+  }
+  return error;
+}
 
-    if (body1_is_oblate) {
-      Vector<Quotient<Acceleration,
-                      GravitationalParameter>, Frame> const
-          degree_2_zonal_effect1 =
-              geopotentials_[b1].GeneralSphericalHarmonicsAcceleration(
-                  t,
-                  -Δq,
-                  Δq_norm,
-                  Δq²,
-                  one_over_Δq³);
-      accelerations[b2] += μ1 * degree_2_zonal_effect1;
+template<typename Frame>
+Error Ephemeris<Frame>::
+ComputeHierarchicalGravitationalAccelerationsOnMasslessBodies(
+    BodyPositions const& body_positions,
+    std::vector<Position<Frame>> const& positions,
+    std::vector<Vector<Acceleration, Frame>>& accelerations) const {
+  lock_.AssertReaderHeld();
+  double const tolerance =
+      accuracy_parameters_.hierarchical_approximation_tolerance_;
+  Error error = Error::OK;
+  std::vector<int> subsystems_to_visit;
+  for (std::size_t b2 = 0; b2 < positions.size(); ++b2) {
+    Position<Frame> const& position = positions[b2];
+    Vector<Acceleration, Frame>& acceleration = accelerations[b2];
+    subsystems_to_visit.assign({root_subsystem_});
+    while (!subsystems_to_visit.empty()) {
+      int const b1 = subsystems_to_visit.back();
+      subsystems_to_visit.pop_back();
+      Subsystem const& subsystem = subsystems_[b1];
+      if (!subsystem.satellites.empty()) {
+        Displacement<Frame> const Δq =
+            body_positions.barycentres[b1] - position;
+        Length const Δq_norm = Δq.Norm();
+        Length const radius = body_positions.radii[b1];
+        if (radius < tolerance * Δq_norm &&
+            Δq_norm - radius > subsystem.geopotential_threshold) {
+          // The subsystem is far enough to be seen as a point mass.
+          acceleration += Δq * (subsystem.gravitational_parameter /
+                                (Δq_norm * Δq_norm * Δq_norm));
+          continue;
+        }
+        subsystems_to_visit.insert(subsystems_to_visit.end(),
+                                   subsystem.satellites.begin(),
+                                   subsystem.satellites.end());
+      }
+      MassiveBody const& body1 = *bodies_[b1];
+      if (b1 < number_of_oblate_bodies_) {
+        error |= ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody<
+                     /*body1_is_oblate=*/true>(
+                     body1, b1, body_positions, position, acceleration);
+      } else {
+        error |= ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody<
+                     /*body1_is_oblate=*/false>(
+                     body1, b1, body_positions, position, acceleration);
+      }
     }
   }
   return error;
@@ -1045,6 +1806,13 @@ void Ephemeris<Frame>::ComputeMassiveBodiesGravitationalAccelerations(
     std::vector<Position<Frame>> const& positions,
     std::vector<Vector<Acceleration, Frame>>& accelerations) const {
   lock_.AssertReaderHeld();
+  if (massive_bodies_thread_pool_ != nullptr) {
+    ComputeMassiveBodiesGravitationalAccelerationsInParallel(t,
+                                                             positions,
+                                                             accelerations);
+    return;
+  }
+
   accelerations.assign(accelerations.size(), Vector<Acceleration, Frame>());
 
   for (std::size_t b1 = 0; b1 < number_of_oblate_bodies_; ++b1) {
@@ -1068,40 +1836,164 @@ void Ephemeris<Frame>::ComputeMassiveBodiesGravitationalAccelerations(
         /*b2_end=*/number_of_oblate_bodies_ + number_of_spherical_bodies_,
         positions, accelerations, geopotentials_);
   }
-  for (std::size_t b1 = number_of_oblate_bodies_;
-       b1 < number_of_oblate_bodies_ +
-            number_of_spherical_bodies_;
-       ++b1) {
-    MassiveBody const& body1 = *bodies_[b1];
-    ComputeGravitationalAccelerationByMassiveBodyOnMassiveBodies<
-        /*body1_is_oblate=*/false,
-        /*body2_is_oblate=*/false>(
-        t,
-        body1, b1,
-        /*bodies2=*/bodies_,
-        /*b2_begin=*/b1 + 1,
-        /*b2_end=*/number_of_oblate_bodies_ + number_of_spherical_bodies_,
-        positions, accelerations, geopotentials_);
+
+  // The spherical bodies only interact through their central forces, which are
+  // computed by a vectorized kernel on a structure of arrays.  The kernel
+  // processes the pairs in the same order and with the same operations as the
+  // loops above, so the results are identical.
+  std::size_t const n = number_of_spherical_bodies_;
+  DCHECK_EQ(7 * n, spherical_bodies_arrays_.size());
+  double* const μ = spherical_bodies_arrays_.data();
+  double* const x = μ + n;
+  double* const y = x + n;
+  double* const z = y + n;
+  double* const ax = z + n;
+  double* const ay = ax + n;
+  double* const az = ay + n;
+  for (std::size_t i = 0; i < n; ++i) {
+    std::size_t const b = number_of_oblate_bodies_ + i;
+    μ[i] = bodies_[b]->gravitational_parameter() /
+           SIUnit<GravitationalParameter>();
+    R3Element<Length> const position =
+        (positions[b] - Frame::origin).coordinates();
+    x[i] = position.x / SIUnit<Length>();
+    y[i] = position.y / SIUnit<Length>();
+    z[i] = position.z / SIUnit<Length>();
+    R3Element<Acceleration> const& acceleration =
+        accelerations[b].coordinates();
+    ax[i] = acceleration.x / SIUnit<Acceleration>();
+    ay[i] = acceleration.y / SIUnit<Acceleration>();
+    az[i] = acceleration.z / SIUnit<Acceleration>();
+  }
+  AddMutualGravitationalAccelerations(/*begin=*/0, /*end=*/n,
+                                      μ, x, y, z, ax, ay, az);
+  for (std::size_t i = 0; i < n; ++i) {
+    accelerations[number_of_oblate_bodies_ + i] = Vector<Acceleration, Frame>(
+        {ax[i] * SIUnit<Acceleration>(),
+         ay[i] * SIUnit<Acceleration>(),
+         az[i] * SIUnit<Acceleration>()});
   }
 }
 
 template<typename Frame>
-Error Ephemeris<Frame>::ComputeMasslessBodiesGravitationalAccelerations(
+void Ephemeris<Frame>::ComputeMassiveBodiesGravitationalAccelerationsInParallel(
     Instant const& t,
     std::vector<Position<Frame>> const& positions,
     std::vector<Vector<Acceleration, Frame>>& accelerations) const {
+  lock_.AssertReaderHeld();
+  std::size_t const number_of_bodies =
+      number_of_oblate_bodies_ + number_of_spherical_bodies_;
+  std::size_t const parallelism = massive_bodies_parallelism_;
+
+  // The element at index |b1 * number_of_bodies + b2| holds the terms added to
+  // the acceleration of |b1| by its interaction with |b2|.  Each pair is
+  // computed once, by the thread that owns the row of its smallest index, which
+  // also clears the terms of the previous call.  The diagonal is always empty.
+  std::vector<AccelerationTerms>& terms = massive_bodies_acceleration_terms_;
+  DCHECK_EQ(number_of_bodies * number_of_bodies, terms.size());
+  auto const compute_rows = [this, number_of_bodies, parallelism, &t,
+                             &positions, &terms](std::size_t const first_b1) {
+    // The rows are dealt round-robin to balance their decreasing lengths.
+    for (std::size_t b1 = first_b1;
+         b1 < number_of_bodies;
+         b1 += parallelism) {
+      MassiveBody const& body1 = *bodies_[b1];
+      for (std::size_t b2 = b1 + 1; b2 < number_of_bodies; ++b2) {
+        MassiveBody const& body2 = *bodies_[b2];
+        AccelerationTerms& on_b1 = terms[b1 * number_of_bodies + b2];
+        AccelerationTerms& on_b2 = terms[b2 * number_of_bodies + b1];
+        on_b1 = AccelerationTerms();
+        on_b2 = AccelerationTerms();
+        if (b2 < number_of_oblate_bodies_) {
+          ComputeGravitationalAccelerationBetweenTwoMassiveBodies<
+              /*body1_is_oblate=*/true,
+              /*body2_is_oblate=*/true>(
+              t,
+              body1, b1, positions[b1],
+              body2, b2, positions[b2],
+              geopotentials_, on_b1, on_b2);
+        } else if (b1 < number_of_oblate_bodies_) {
+          ComputeGravitationalAccelerationBetweenTwoMassiveBodies<
+              /*body1_is_oblate=*/true,
+              /*body2_is_oblate=*/false>(
+              t,
+              body1, b1, positions[b1],
+              body2, b2, positions[b2],
+              geopotentials_, on_b1, on_b2);
+        } else {
+          ComputeGravitationalAccelerationBetweenTwoMassiveBodies<
+              /*body1_is_oblate=*/false,
+              /*body2_is_oblate=*/false>(
+              t,
+              body1, b1, positions[b1],
+              body2, b2, positions[b2],
+              geopotentials_, on_b1, on_b2);
+        }
+      }
+    }
+  };
+
+  std::vector<std::future<void>> futures;
+  for (std::size_t i = 1; i < parallelism; ++i) {
+    futures.push_back(
+        massive_bodies_thread_pool_->Add(std::bind(compute_rows, i)));
+  }
+  compute_rows(0);
+  for (auto const& future : futures) {
+    future.wait();
+  }
+
+  // The serial computation adds the terms of the pairs involving a body in
+  // increasing order of the other body.  Do the same to get identical results.
+  for (std::size_t b1 = 0; b1 < number_of_bodies; ++b1) {
+    Vector<Acceleration, Frame>& acceleration = accelerations[b1];
+    acceleration = Vector<Acceleration, Frame>();
+    for (std::size_t b2 = 0; b2 < number_of_bodies; ++b2) {
+      terms[b1 * number_of_bodies + b2].AddTo(acceleration);
+    }
+  }
+}
+
+template<typename Frame>
+Error Ephemeris<Frame>::ComputeMasslessBodiesGravitationalAccelerations(
+    Instant const& t,
+    std::vector<Position<Frame>> const& positions,
+    std::vector<Vector<Acceleration, Frame>>& accelerations,
+    BodyPositions* const body_positions) const {
   CHECK_EQ(positions.size(), accelerations.size());
   accelerations.assign(accelerations.size(), Vector<Acceleration, Frame>());
   Error error = Error::OK;
 
   // Locking ensures that we see a consistent state of all the trajectories.
   absl::ReaderMutexLock l(&lock_);
+  for (auto const& trajectory : trajectories_) {
+    if (t < trajectory->t_min()) {
+      // This can happen when computing a prediction asynchronously and the
+      // continuous trajectories have been "forgotten before" already.  Just
+      // cancel the prediction.
+      return Error::CANCELLED;
+    }
+  }
+  std::shared_ptr<BodyPositions const> cached_body_positions;
+  if (body_positions == nullptr) {
+    cached_body_positions = EvaluateCachedBodyPositions(t);
+  } else {
+    EvaluateBodyPositions(t, *body_positions);
+  }
+  BodyPositions const& evaluated_body_positions =
+      body_positions == nullptr ? *cached_body_positions : *body_positions;
+  if (!subsystems_.empty()) {
+    return ComputeHierarchicalGravitationalAccelerationsOnMasslessBodies(
+        evaluated_body_positions, positions, accelerations);
+  }
+
   for (std::size_t b1 = 0; b1 < number_of_oblate_bodies_; ++b1) {
     MassiveBody const& body1 = *bodies_[b1];
     error |= ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies<
                  /*body1_is_oblate=*/true>(
                  t,
                  body1, b1,
+                 evaluated_body_positions,
                  positions,
                  accelerations);
   }
@@ -1114,12 +2006,136 @@ Error Ephemeris<Frame>::ComputeMasslessBodiesGravitationalAccelerations(
                  /*body1_is_oblate=*/false>(
                  t,
                  body1, b1,
+                 evaluated_body_positions,
                  positions,
                  accelerations);
   }
   return error;
 }
 
+template<typename Frame>
+void Ephemeris<Frame>::ComputeMasslessBodyGravitationalAccelerationVariations(
+    BodyPositions const& body_positions,
+    std::vector<Position<Frame>> const& positions,
+    std::vector<Vector<Acceleration, Frame>>& accelerations) const {
+  CHECK_EQ(positions.size(), accelerations.size());
+  for (std::size_t j = 1; j < accelerations.size(); ++j) {
+    accelerations[j] = Vector<Acceleration, Frame>();
+  }
+  for (std::size_t b1 = 0; b1 < bodies_.size(); ++b1) {
+    GravitationalParameter const& μ1 = bodies_[b1]->gravitational_parameter();
+
+    // A vector from the massless body to the center of |b1|.  The gradient of
+    // the acceleration is μ1 (3 Δq ⊗ Δq / Δq² - 𝟙) / Δq³.
+    Displacement<Frame> const Δq = body_positions.positions[b1] - positions[0];
+    Square<Length> const Δq² = Δq.Norm²();
+    Exponentiation<Length, -3> const one_over_Δq³ =
+        Sqrt(Δq²) / (Δq² * Δq²);
+    auto const μ1_over_Δq³ = μ1 * one_over_Δq³;
+    auto const three_Δq_over_Δq² = Δq * (3 / Δq²);
+    for (std::size_t j = 1; j < positions.size(); ++j) {
+      Displacement<Frame> const δq = positions[j] - Frame::origin;
+      accelerations[j] +=
+          μ1_over_Δq³ * (three_Δq_over_Δq² * InnerProduct(Δq, δq) - δq);
+    }
+  }
+}
+
+template<typename Frame>
+Instant Ephemeris<Frame>::AdaptiveStepFinalTime(
+    Instant const& trajectory_last_time,
+    Instant const& t,
+    std::int64_t const max_ephemeris_steps) const {
+  // The |min| is here to prevent us from spending too much time computing the
+  // ephemeris.  The |max| is here to ensure that we always try to integrate
+  // forward.  We use |last_state_.time.value| because this is always finite,
+  // contrary to |t_max()|, which is -∞ when |empty()|.
+  return std::min(std::max(instance_time() +
+                               max_ephemeris_steps *
+                                   fixed_step_parameters_.step(),
+                           trajectory_last_time +
+                               fixed_step_parameters_.step()),
+                  t);
+}
+
+template<typename Frame>
+std::vector<Status> Ephemeris<Frame>::FlowEnsembleInLockstepWithAdaptiveStep(
+    std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+    IntrinsicAccelerations const& intrinsic_accelerations,
+    Instant const& t,
+    AdaptiveStepParameters const& parameters,
+    std::int64_t const max_ephemeris_steps,
+    bool const last_point_only) {
+  std::vector<Status> statuses(trajectories.size());
+  if (trajectories.empty()) {
+    return statuses;
+  }
+  Instant const trajectory_last_time = trajectories.front()->last().time();
+  if (trajectory_last_time == t) {
+    return statuses;
+  }
+
+  Instant const t_final =
+      AdaptiveStepFinalTime(trajectory_last_time, t, max_ephemeris_steps);
+  Prolong(t_final);
+
+  typename AdaptiveStepSizeIntegrator<NewtonianMotionEquation>::Parameters const
+      integrator_parameters(
+          /*first_time_step=*/t_final - trajectory_last_time,
+          /*safety_factor=*/0.9,
+          parameters.max_steps_,
+          /*last_step_is_exact=*/true);
+  CHECK_GT(integrator_parameters.first_time_step, 0 * Second)
+      << "Flow back to the future: " << t_final
+      << " <= " << trajectory_last_time;
+  auto const tolerance_to_error_ratio =
+      std::bind(&Ephemeris<Frame>::ToleranceToErrorRatio,
+                std::cref(parameters.length_integration_tolerance_),
+                std::cref(parameters.speed_integration_tolerance_),
+                _1, _2);
+  // The last state of each member, if |last_point_only|.
+  std::vector<std::optional<typename NewtonianMotionEquation::SystemState>>
+      last_states(trajectories.size());
+  auto const append_state =
+      [&trajectories, last_point_only, &last_states](
+          int const member,
+          typename NewtonianMotionEquation::SystemState const& state) {
+        if (last_point_only) {
+          last_states[member] = state;
+          return;
+        }
+        trajectories[member]->Append(
+            state.time.value,
+            DegreesOfFreedom<Frame>(state.positions[0].value,
+                                    state.velocities[0].value));
+      };
+
+  auto const instance = parameters.integrator_->NewEnsembleInstance(
+      MakeEnsembleProblem(trajectories,
+                          intrinsic_accelerations,
+                          /*use_body_positions_cache=*/false),
+      append_state,
+      tolerance_to_error_ratio,
+      integrator_parameters);
+  Status const status = instance->Solve(t_final);
+
+  for (int i = 0; i < trajectories.size(); ++i) {
+    if (last_states[i].has_value()) {
+      AppendMasslessBodiesState(*last_states[i], {trajectories[i]});
+    }
+    if (!instance->active(i)) {
+      statuses[i] = instance->status(i);
+    } else if (!status.ok() || t_final == t) {
+      statuses[i] = status;
+    } else {
+      statuses[i] = Status(Error::DEADLINE_EXCEEDED,
+                           "Couldn't reach " + DebugString(t) +
+                               ", stopping at " + DebugString(t_final));
+    }
+  }
+  return statuses;
+}
+
 template<typename Frame>
 template<typename ODE>
 Status Ephemeris<Frame>::FlowODEWithAdaptiveStep(
@@ -1128,23 +2144,23 @@ Status Ephemeris<Frame>::FlowODEWithAdaptiveStep(
       Instant const& t,
       ODEAdaptiveStepParameters<ODE> const& parameters,
       std::int64_t max_ephemeris_steps,
-      bool last_point_only) {
+      bool last_point_only,
+      StateTransitionMatrix* const state_transition_matrix,
+      std::vector<EventFunction> const& event_functions,
+      std::vector<not_null<DiscreteTrajectory<Frame>*>> const& events) {
+  CHECK_EQ(event_functions.size(), events.size());
   Instant const& trajectory_last_time = trajectory->last().time();
   if (trajectory_last_time == t) {
+    if (state_transition_matrix != nullptr) {
+      *state_transition_matrix = StateTransitionMatrix();
+    }
     return Status::OK;
   }
 
   std::vector<not_null<DiscreteTrajectory<Frame>*>> const trajectories =
       {trajectory};
-  // The |min| is here to prevent us from spending too much time computing the
-  // ephemeris.  The |max| is here to ensure that we always try to integrate
-  // forward.  We use |last_state_.time.value| because this is always finite,
-  // contrary to |t_max()|, which is -∞ when |empty()|.
   Instant const t_final =
-      std::min(std::max(instance_time() +
-                            max_ephemeris_steps * fixed_step_parameters_.step(),
-                        trajectory_last_time + fixed_step_parameters_.step()),
-               t);
+      AdaptiveStepFinalTime(trajectory_last_time, t, max_ephemeris_steps);
   Prolong(t_final);
 
   IntegrationProblem<ODE> problem;
@@ -1152,42 +2168,127 @@ Status Ephemeris<Frame>::FlowODEWithAdaptiveStep(
 
   auto const trajectory_last = trajectory->last();
   auto const last_degrees_of_freedom = trajectory_last.degrees_of_freedom();
-  problem.initial_state = {{last_degrees_of_freedom.position()},
-                           {last_degrees_of_freedom.velocity()},
-                           trajectory_last.time()};
+  typename ODE::SystemState& initial_state = problem.initial_state;
+  initial_state = {{last_degrees_of_freedom.position()},
+                   {last_degrees_of_freedom.velocity()},
+                   trajectory_last.time()};
+  if (state_transition_matrix != nullptr) {
+    // The variations are linear in the initial perturbations, so they are
+    // integrated from the perturbations of 1 m and 1 m/s which define the
+    // columns of the matrix.
+    for (auto const& perturbation :
+         StateTransitionMatrix::InitialPerturbations()) {
+      initial_state.positions.emplace_back(Frame::origin +
+                                           perturbation.displacement());
+      initial_state.velocities.emplace_back(perturbation.velocity());
+    }
+  }
 
   typename AdaptiveStepSizeIntegrator<ODE>::Parameters const
       integrator_parameters(
-          /*first_time_step=*/t_final - problem.initial_state.time.value,
+          /*first_time_step=*/t_final - initial_state.time.value,
           /*safety_factor=*/0.9,
           parameters.max_steps_,
           /*last_step_is_exact=*/true);
   CHECK_GT(integrator_parameters.first_time_step, 0 * Second)
       << "Flow back to the future: " << t_final
-      << " <= " << problem.initial_state.time.value;
+      << " <= " << initial_state.time.value;
   auto const tolerance_to_error_ratio =
-      std::bind(&Ephemeris<Frame>::ToleranceToErrorRatio,
-                std::cref(parameters.length_integration_tolerance_),
-                std::cref(parameters.speed_integration_tolerance_),
-                _1, _2);
+      [&parameters, state_transition_matrix](
+          Time const& current_step_size,
+          typename ODE::SystemStateError const& error) {
+        if (state_transition_matrix == nullptr) {
+          return ToleranceToErrorRatio(
+              parameters.length_integration_tolerance_,
+              parameters.speed_integration_tolerance_,
+              current_step_size,
+              error);
+        }
+        // The step size is controlled by the trajectory alone, the
+        // variational equations follow.
+        return std::min(parameters.length_integration_tolerance_ /
+                            error.position_error[0].Norm(),
+                        parameters.speed_integration_tolerance_ /
+                            error.velocity_error[0].Norm());
+      };
+
+  // The states are buffered and appended to the trajectory in batches, which
+  // amortizes the checks done by |DiscreteTrajectory::Append|.
+  std::vector<std::pair<Instant, DegreesOfFreedom<Frame>>> buffered_states;
+  auto const flush_buffered_states = [&buffered_states, trajectory]() {
+    trajectory->Append(buffered_states);
+    buffered_states.clear();
+  };
 
-  typename AdaptiveStepSizeIntegrator<ODE>::AppendState append_state;
   typename ODE::SystemState last_state;
-  if (last_point_only) {
-    append_state = [&last_state](typename ODE::SystemState const& state) {
-      last_state = state;
-    };
-  } else {
-    append_state = std::bind(
-        &Ephemeris::AppendMasslessBodiesState, _1, std::cref(trajectories));
+  if (!last_point_only) {
+    buffered_states.reserve(max_buffered_states);
+  }
+  if (state_transition_matrix != nullptr) {
+    // In case no step is accepted.
+    *state_transition_matrix = StateTransitionMatrix();
   }
+  auto const append_state =
+      [last_point_only,
+       state_transition_matrix,
+       &last_state,
+       &buffered_states,
+       &flush_buffered_states](typename ODE::SystemState const& state) {
+        if (state_transition_matrix != nullptr) {
+          // The instance doesn't give access to the state at the end of the
+          // integration, so the matrix is updated after each step.
+          auto& columns = state_transition_matrix->columns_;
+          for (int j = 0; j < columns.size(); ++j) {
+            columns[j] = RelativeDegreesOfFreedom<Frame>(
+                state.positions[j + 1].value - Frame::origin,
+                state.velocities[j + 1].value);
+          }
+        }
+        if (last_point_only) {
+          last_state = state;
+          return;
+        }
+        buffered_states.emplace_back(
+            state.time.value,
+            DegreesOfFreedom<Frame>(state.positions[0].value,
+                                    state.velocities[0].value));
+        if (buffered_states.size() == max_buffered_states) {
+          flush_buffered_states();
+        }
+      };
 
   auto const instance =
       parameters.integrator_->NewInstance(problem,
                                           append_state,
                                           tolerance_to_error_ratio,
                                           integrator_parameters);
+  if (!event_functions.empty()) {
+    // The events are found on the massless body, not on its variations.
+    std::vector<typename AdaptiveStepSizeIntegrator<ODE>::EventFunction>
+        integrator_event_functions;
+    for (auto const& event_function : event_functions) {
+      integrator_event_functions.push_back(
+          [&event_function](
+              Instant const& t,
+              std::vector<Position<Frame>> const& positions,
+              std::vector<Velocity<Frame>> const& velocities) {
+            return event_function(
+                t, DegreesOfFreedom<Frame>(positions[0], velocities[0]));
+          });
+    }
+    dynamic_cast<typename AdaptiveStepSizeIntegrator<ODE>::Instance&>(
+        *instance).SetEventFunctions(
+            integrator_event_functions,
+            [&events](int const event,
+                      typename ODE::SystemState const& state) {
+              events[event]->Append(
+                  state.time.value,
+                  DegreesOfFreedom<Frame>(state.positions[0].value,
+                                          state.velocities[0].value));
+            });
+  }
   auto status = instance->Solve(t_final);
+  flush_buffered_states();
 
   // We probably don't care if the vessel gets too close to the singularity, as
   // we only use this integrator for the future.  So we swallow the error.  Note
@@ -5,12 +5,16 @@
 #include <map>
 #include <optional>
 #include <set>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "astronomy/frames.hpp"
 #include "base/macros.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/barycentre_calculator.hpp"
 #include "geometry/frame.hpp"
+#include "geometry/sign.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
@@ -45,6 +49,7 @@ using geometry::AngularVelocity;
 using geometry::Displacement;
 using geometry::Frame;
 using geometry::Rotation;
+using geometry::Sign;
 using geometry::Velocity;
 using integrators::EmbeddedExplicitRungeKuttaNyströmIntegrator;
 using integrators::SymmetricLinearMultistepIntegrator;
@@ -65,6 +70,7 @@ using quantities::astronomy::JulianYear;
 using quantities::astronomy::SolarGravitationalParameter;
 using quantities::astronomy::TerrestrialEquatorialRadius;
 using quantities::astronomy::TerrestrialPolarRadius;
+using quantities::si::Day;
 using quantities::si::Hour;
 using quantities::si::Kilo;
 using quantities::si::Kilogram;
@@ -246,6 +252,423 @@ TEST_P(EphemerisTest, FlowWithAdaptiveStepSpecialCase) {
       /*last_point_only=*/false));
 }
 
+// The events are located in the same pass as the integration, including those
+// at the end of a step or just after it.
+TEST_P(EphemerisTest, FlowWithAdaptiveStepEvents) {
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<ICRS>> initial_state;
+  Position<ICRS> centre_of_mass;
+  Time period;
+  SetUpEarthMoonSystem(bodies, initial_state, centre_of_mass, period);
+
+  Position<ICRS> const earth_position = initial_state[0].position();
+
+  Ephemeris<ICRS> ephemeris(
+      std::move(bodies),
+      initial_state,
+      t0_,
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(), period / 100));
+  Ephemeris<ICRS>::AdaptiveStepParameters const parameters(
+      EmbeddedExplicitRungeKuttaNyströmIntegrator<
+          DormandالمكاوىPrince1986RKN434FM,
+          Position<ICRS>>(),
+      max_steps,
+      1 * Metre,
+      1e-3 * Metre / Second);
+
+  // An inclined orbit around the Earth.  The Earth and the Moon stay in the
+  // plane z = 0, so the nodes are where the probe crosses that plane.
+  DegreesOfFreedom<ICRS> const probe_initial_degrees_of_freedom(
+      earth_position + Displacement<ICRS>({1e7 * Metre, 0 * Metre, 0 * Metre}),
+      Velocity<ICRS>({0 * Metre / Second,
+                      5e3 * Metre / Second,
+                      3.8e3 * Metre / Second}));
+  Instant const t_final = t0_ + period / 10;
+
+  // The event functions don't change the steps, so a first integration gives
+  // their ends.
+  DiscreteTrajectory<ICRS> steps;
+  steps.Append(t0_, probe_initial_degrees_of_freedom);
+  EXPECT_OK(ephemeris.FlowWithAdaptiveStep(
+      &steps,
+      Ephemeris<ICRS>::NoIntrinsicAcceleration,
+      t_final,
+      parameters,
+      Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+      /*last_point_only=*/false));
+  auto step = steps.Begin();
+  for (int i = 0; i < steps.Size() / 2; ++i) {
+    ++step;
+  }
+  Instant const t_j = step.time();
+  DegreesOfFreedom<ICRS> const degrees_of_freedom_j =
+      step.degrees_of_freedom();
+  Time const δt =
+      4 * std::numeric_limits<double>::epsilon() * (t_j - Instant());
+
+  std::vector<Ephemeris<ICRS>::EventFunction> const event_functions = {
+      [](Instant const& t, DegreesOfFreedom<ICRS> const& degrees_of_freedom) {
+        return (degrees_of_freedom.position() - ICRS::origin).coordinates().z /
+               Metre;
+      },
+      [t_j](Instant const& t,
+            DegreesOfFreedom<ICRS> const& degrees_of_freedom) {
+        return (t - t_j) / Second;
+      },
+      [t_j, δt](Instant const& t,
+                DegreesOfFreedom<ICRS> const& degrees_of_freedom) {
+        return (t - (t_j + δt)) / Second;
+      }};
+  DiscreteTrajectory<ICRS> trajectory;
+  DiscreteTrajectory<ICRS> nodes;
+  DiscreteTrajectory<ICRS> at_step_end;
+  DiscreteTrajectory<ICRS> after_step_end;
+  trajectory.Append(t0_, probe_initial_degrees_of_freedom);
+  EXPECT_OK(ephemeris.FlowWithAdaptiveStep(
+      &trajectory,
+      Ephemeris<ICRS>::NoIntrinsicAcceleration,
+      t_final,
+      parameters,
+      Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+      /*last_point_only=*/false,
+      event_functions,
+      {&nodes, &at_step_end, &after_step_end}));
+  EXPECT_EQ(steps.Size(), trajectory.Size());
+
+  // Each change of sign of z between two points of the trajectory is a node.
+  int sign_changes = 0;
+  Length previous_z;
+  for (auto it = trajectory.Begin(); it != trajectory.End(); ++it) {
+    Length const z =
+        (it.degrees_of_freedom().position() - ICRS::origin).coordinates().z;
+    if (it != trajectory.Begin() && Sign(z) != Sign(previous_z)) {
+      ++sign_changes;
+    }
+    previous_z = z;
+  }
+  EXPECT_THAT(sign_changes, Gt(40));
+  EXPECT_EQ(sign_changes, nodes.Size());
+  for (auto it = nodes.Begin(); it != nodes.End(); ++it) {
+    EXPECT_THAT(Abs((it.degrees_of_freedom().position() - ICRS::origin)
+                        .coordinates().z),
+                Lt(1 * Milli(Metre)));
+  }
+
+  // The event at the end of step |j| is found once, at the end of that step,
+  // and the one just after is found once, at the beginning of the next step.
+  ASSERT_EQ(1, at_step_end.Size());
+  EXPECT_EQ(t_j, at_step_end.Begin().time());
+  EXPECT_THAT(
+      AbsoluteError(degrees_of_freedom_j.position(),
+                    at_step_end.Begin().degrees_of_freedom().position()),
+      Lt(1 * Milli(Metre)));
+  ASSERT_EQ(1, after_step_end.Size());
+  EXPECT_THAT(after_step_end.Begin().time(), AlmostEquals(t_j + δt, 0, 1));
+}
+
+// The members of an ensemble are integrated exactly as by independent calls.
+TEST_P(EphemerisTest, FlowEnsembleWithAdaptiveStep) {
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<ICRS>> initial_state;
+  Position<ICRS> centre_of_mass;
+  Time period;
+  SetUpEarthMoonSystem(bodies, initial_state, centre_of_mass, period);
+
+  Position<ICRS> const earth_position = initial_state[0].position();
+
+  Ephemeris<ICRS> ephemeris(
+      std::move(bodies),
+      initial_state,
+      t0_,
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(), period / 100));
+  Ephemeris<ICRS>::AdaptiveStepParameters const parameters(
+      EmbeddedExplicitRungeKuttaNyströmIntegrator<
+          DormandالمكاوىPrince1986RKN434FM,
+          Position<ICRS>>(),
+      max_steps,
+      1 * Metre,
+      1e-3 * Metre / Second);
+
+  constexpr int ensemble_size = 3;
+  std::vector<DiscreteTrajectory<ICRS>> independent_trajectories(
+      ensemble_size);
+  std::vector<DiscreteTrajectory<ICRS>> serial_trajectories(ensemble_size);
+  std::vector<DiscreteTrajectory<ICRS>> parallel_trajectories(ensemble_size);
+  std::vector<not_null<DiscreteTrajectory<ICRS>*>> serial_ensemble;
+  std::vector<not_null<DiscreteTrajectory<ICRS>*>> parallel_ensemble;
+  for (int i = 0; i < ensemble_size; ++i) {
+    DegreesOfFreedom<ICRS> const degrees_of_freedom(
+        earth_position +
+            Displacement<ICRS>({0 * Metre, (i + 1) * 1e8 * Metre, 0 * Metre}),
+        Velocity<ICRS>({1e3 * Metre / Second,
+                        0 * Metre / Second,
+                        0 * Metre / Second}));
+    independent_trajectories[i].Append(t0_, degrees_of_freedom);
+    serial_trajectories[i].Append(t0_, degrees_of_freedom);
+    parallel_trajectories[i].Append(t0_, degrees_of_freedom);
+    serial_ensemble.push_back(&serial_trajectories[i]);
+    parallel_ensemble.push_back(&parallel_trajectories[i]);
+  }
+
+  Instant const t_final = t0_ + period / 10;
+  for (auto& trajectory : independent_trajectories) {
+    EXPECT_OK(ephemeris.FlowWithAdaptiveStep(
+        &trajectory,
+        Ephemeris<ICRS>::NoIntrinsicAcceleration,
+        t_final,
+        parameters,
+        Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+        /*last_point_only=*/false));
+  }
+  Ephemeris<ICRS>::IntrinsicAccelerations const intrinsic_accelerations(
+      ensemble_size, Ephemeris<ICRS>::NoIntrinsicAcceleration);
+  for (Status const& status : ephemeris.FlowEnsembleWithAdaptiveStep(
+           serial_ensemble,
+           intrinsic_accelerations,
+           t_final,
+           parameters,
+           Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+           /*last_point_only=*/false,
+           /*lockstep=*/false,
+           /*thread_pool=*/nullptr)) {
+    EXPECT_OK(status);
+  }
+  ThreadPool<void> pool(/*pool_size=*/2);
+  for (Status const& status : ephemeris.FlowEnsembleWithAdaptiveStep(
+           parallel_ensemble,
+           intrinsic_accelerations,
+           t_final,
+           parameters,
+           Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+           /*last_point_only=*/false,
+           /*lockstep=*/false,
+           &pool)) {
+    EXPECT_OK(status);
+  }
+
+  for (int i = 0; i < ensemble_size; ++i) {
+    EXPECT_EQ(independent_trajectories[i].Size(),
+              serial_trajectories[i].Size());
+    EXPECT_EQ(independent_trajectories[i].Size(),
+              parallel_trajectories[i].Size());
+    EXPECT_EQ(t_final, serial_trajectories[i].last().time());
+    EXPECT_EQ(independent_trajectories[i].last().degrees_of_freedom(),
+              serial_trajectories[i].last().degrees_of_freedom());
+    EXPECT_EQ(independent_trajectories[i].last().degrees_of_freedom(),
+              parallel_trajectories[i].last().degrees_of_freedom());
+  }
+}
+
+// The members of an ensemble integrated in lockstep share their steps, and end
+// close to where independent calls would take them.
+TEST_P(EphemerisTest, FlowEnsembleWithAdaptiveStepInLockstep) {
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<ICRS>> initial_state;
+  Position<ICRS> centre_of_mass;
+  Time period;
+  SetUpEarthMoonSystem(bodies, initial_state, centre_of_mass, period);
+
+  Position<ICRS> const earth_position = initial_state[0].position();
+
+  Ephemeris<ICRS> ephemeris(
+      std::move(bodies),
+      initial_state,
+      t0_,
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(), period / 100));
+  Ephemeris<ICRS>::AdaptiveStepParameters const parameters(
+      EmbeddedExplicitRungeKuttaNyströmIntegrator<
+          DormandالمكاوىPrince1986RKN434FM,
+          Position<ICRS>>(),
+      max_steps,
+      1 * Metre,
+      1e-3 * Metre / Second);
+
+  constexpr int ensemble_size = 3;
+  std::vector<DiscreteTrajectory<ICRS>> independent_trajectories(
+      ensemble_size);
+  std::vector<DiscreteTrajectory<ICRS>> lockstep_trajectories(ensemble_size);
+  std::vector<DiscreteTrajectory<ICRS>> last_point_trajectories(
+      ensemble_size);
+  std::vector<not_null<DiscreteTrajectory<ICRS>*>> lockstep_ensemble;
+  std::vector<not_null<DiscreteTrajectory<ICRS>*>> last_point_ensemble;
+  for (int i = 0; i < ensemble_size; ++i) {
+    DegreesOfFreedom<ICRS> const degrees_of_freedom(
+        earth_position +
+            Displacement<ICRS>({0 * Metre, (i + 1) * 1e8 * Metre, 0 * Metre}),
+        Velocity<ICRS>({1e3 * Metre / Second,
+                        0 * Metre / Second,
+                        0 * Metre / Second}));
+    independent_trajectories[i].Append(t0_, degrees_of_freedom);
+    lockstep_trajectories[i].Append(t0_, degrees_of_freedom);
+    last_point_trajectories[i].Append(t0_, degrees_of_freedom);
+    lockstep_ensemble.push_back(&lockstep_trajectories[i]);
+    last_point_ensemble.push_back(&last_point_trajectories[i]);
+  }
+
+  Instant const t_final = t0_ + period / 10;
+  for (auto& trajectory : independent_trajectories) {
+    EXPECT_OK(ephemeris.FlowWithAdaptiveStep(
+        &trajectory,
+        Ephemeris<ICRS>::NoIntrinsicAcceleration,
+        t_final,
+        parameters,
+        Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+        /*last_point_only=*/false));
+  }
+  Ephemeris<ICRS>::IntrinsicAccelerations const intrinsic_accelerations(
+      ensemble_size, Ephemeris<ICRS>::NoIntrinsicAcceleration);
+  for (Status const& status : ephemeris.FlowEnsembleWithAdaptiveStep(
+           lockstep_ensemble,
+           intrinsic_accelerations,
+           t_final,
+           parameters,
+           Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+           /*last_point_only=*/false,
+           /*lockstep=*/true,
+           /*thread_pool=*/nullptr)) {
+    EXPECT_OK(status);
+  }
+  for (Status const& status : ephemeris.FlowEnsembleWithAdaptiveStep(
+           last_point_ensemble,
+           intrinsic_accelerations,
+           t_final,
+           parameters,
+           Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+           /*last_point_only=*/true,
+           /*lockstep=*/true,
+           /*thread_pool=*/nullptr)) {
+    EXPECT_OK(status);
+  }
+
+  for (int i = 0; i < ensemble_size; ++i) {
+    EXPECT_EQ(lockstep_trajectories[0].Size(),
+              lockstep_trajectories[i].Size());
+    EXPECT_EQ(2, last_point_trajectories[i].Size());
+    EXPECT_EQ(t_final, lockstep_trajectories[i].last().time());
+    EXPECT_EQ(lockstep_trajectories[i].last().degrees_of_freedom(),
+              last_point_trajectories[i].last().degrees_of_freedom());
+    EXPECT_THAT(
+        AbsoluteError(
+            independent_trajectories[i].last().degrees_of_freedom().position(),
+            lockstep_trajectories[i].last().degrees_of_freedom().position()),
+        Lt(1 * Metre));
+  }
+}
+
+// The state transition matrix predicts the effect of small perturbations of the
+// initial state, as estimated by central differences of perturbed flows.
+TEST_P(EphemerisTest, StateTransitionMatrix) {
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<ICRS>> initial_state;
+  Position<ICRS> centre_of_mass;
+  Time period;
+  SetUpEarthMoonSystem(bodies, initial_state, centre_of_mass, period);
+
+  DegreesOfFreedom<ICRS> const earth_degrees_of_freedom = initial_state[0];
+  GravitationalParameter const μ = bodies[0]->gravitational_parameter();
+
+  Ephemeris<ICRS> ephemeris(
+      std::move(bodies),
+      initial_state,
+      t0_,
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(), period / 100));
+
+  // A slightly inclined low orbit, flowed for one revolution.
+  Length const r = 7000 * Kilo(Metre);
+  Speed const v = Sqrt(μ / r);
+  DegreesOfFreedom<ICRS> const probe_degrees_of_freedom(
+      earth_degrees_of_freedom.position() +
+          Displacement<ICRS>({r, 0 * Metre, 0 * Metre}),
+      earth_degrees_of_freedom.velocity() +
+          Velocity<ICRS>({0 * Metre / Second, v, 0.1 * v}));
+  Instant const t_final = t0_ + 2 * π * r / v;
+
+  DiscreteTrajectory<ICRS> trajectory;
+  trajectory.Append(t0_, probe_degrees_of_freedom);
+  Ephemeris<ICRS>::StateTransitionMatrix state_transition_matrix;
+  EXPECT_OK(ephemeris.FlowWithAdaptiveStep(
+      &trajectory,
+      Ephemeris<ICRS>::NoIntrinsicAcceleration,
+      t_final,
+      Ephemeris<ICRS>::AdaptiveStepParameters(
+          EmbeddedExplicitRungeKuttaNyströmIntegrator<
+              DormandالمكاوىPrince1986RKN434FM,
+              Position<ICRS>>(),
+          max_steps,
+          1e-6 * Metre,
+          1e-9 * Metre / Second),
+      Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+      /*last_point_only=*/true,
+      &state_transition_matrix));
+  EXPECT_EQ(t_final, trajectory.last().time());
+
+  Ephemeris<ICRS>::AdaptiveStepParameters const fine_parameters(
+      EmbeddedExplicitRungeKuttaNyströmIntegrator<
+          DormandالمكاوىPrince1986RKN434FM,
+          Position<ICRS>>(),
+      max_steps,
+      1e-9 * Metre,
+      1e-12 * Metre / Second);
+  for (auto const& perturbation :
+       {RelativeDegreesOfFreedom<ICRS>(
+            Displacement<ICRS>({1 * Metre, 0 * Metre, 0 * Metre}),
+            Velocity<ICRS>()),
+        RelativeDegreesOfFreedom<ICRS>(
+            Displacement<ICRS>(),
+            Velocity<ICRS>({0 * Metre / Second,
+                            1e-3 * Metre / Second,
+                            1e-3 * Metre / Second}))}) {
+    DiscreteTrajectory<ICRS> plus;
+    DiscreteTrajectory<ICRS> minus;
+    plus.Append(t0_, probe_degrees_of_freedom + perturbation);
+    minus.Append(t0_, probe_degrees_of_freedom - perturbation);
+    for (auto* const perturbed : {&plus, &minus}) {
+      EXPECT_OK(ephemeris.FlowWithAdaptiveStep(
+          perturbed,
+          Ephemeris<ICRS>::NoIntrinsicAcceleration,
+          t_final,
+          fine_parameters,
+          Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+          /*last_point_only=*/true));
+    }
+    RelativeDegreesOfFreedom<ICRS> const central_difference =
+        0.5 * (plus.last().degrees_of_freedom() -
+               minus.last().degrees_of_freedom());
+    RelativeDegreesOfFreedom<ICRS> const linearized =
+        state_transition_matrix(perturbation);
+    EXPECT_THAT(RelativeError(central_difference.displacement(),
+                              linearized.displacement()),
+                Lt(1e-7));
+    EXPECT_THAT(RelativeError(central_difference.velocity(),
+                              linearized.velocity()),
+                Lt(1e-7));
+  }
+
+  // Flowing to the last point doesn't move anything.
+  EXPECT_OK(ephemeris.FlowWithAdaptiveStep(
+      &trajectory,
+      Ephemeris<ICRS>::NoIntrinsicAcceleration,
+      t_final,
+      fine_parameters,
+      Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+      /*last_point_only=*/true,
+      &state_transition_matrix));
+  RelativeDegreesOfFreedom<ICRS> const δ(
+      Displacement<ICRS>({1 * Metre, -2 * Metre, 3 * Metre}),
+      Velocity<ICRS>({-4 * Metre / Second,
+                      5 * Metre / Second,
+                      -6 * Metre / Second}));
+  EXPECT_EQ(δ, state_transition_matrix(δ));
+}
+
 // The canonical Earth-Moon system, tuned to produce circular orbits.
 TEST_P(EphemerisTest, EarthMoon) {
   std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
@@ -1038,6 +1461,217 @@ TEST_P(EphemerisTest, ComputeApsidesContinuousTrajectory) {
   }
 }
 
+// The parallel computation of the accelerations between the massive bodies and
+// of the fits of their trajectories must give the same results as the serial
+// one, bit for bit.
+TEST_P(EphemerisTest, MassiveBodiesParallelism) {
+  Instant const t_final = t0_ + 0.1 * JulianYear;
+  auto const serial_ephemeris = solar_system_.MakeEphemeris(
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(),
+                                           /*step=*/10 * Minute));
+  auto const parallel_ephemeris = solar_system_.MakeEphemeris(
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(),
+                                           /*step=*/10 * Minute));
+  parallel_ephemeris->SetMassiveBodiesParallelism(4);
+
+  serial_ephemeris->Prolong(t_final);
+  parallel_ephemeris->Prolong(t_final);
+  EXPECT_EQ(serial_ephemeris->t_max(), parallel_ephemeris->t_max());
+  for (std::string const& name : solar_system_.names()) {
+    EXPECT_EQ(solar_system_.trajectory(*serial_ephemeris, name).
+                  EvaluateDegreesOfFreedom(t_final),
+              solar_system_.trajectory(*parallel_ephemeris, name).
+                  EvaluateDegreesOfFreedom(t_final)) << name;
+    EXPECT_EQ(solar_system_.trajectory(*serial_ephemeris, name).
+                  average_degree(),
+              solar_system_.trajectory(*parallel_ephemeris, name).
+                  average_degree()) << name;
+  }
+}
+
+// Fixed-step integrations which take steps at the same instants share the
+// positions of the massive bodies.  The other evaluations don't use the cache.
+TEST_P(EphemerisTest, BodyPositionsCache) {
+  auto const ephemeris = solar_system_.MakeEphemeris(
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(),
+                                           /*step=*/10 * Minute));
+  Time const step = 10 * Second;
+  Instant const t1 = t0_ + 1 * Hour;
+  ephemeris->Prolong(t1);
+  DegreesOfFreedom<ICRS> const earth_degrees_of_freedom =
+      solar_system_.trajectory(*ephemeris, "Earth").
+          EvaluateDegreesOfFreedom(t0_);
+  DegreesOfFreedom<ICRS> const probe_degrees_of_freedom(
+      earth_degrees_of_freedom.position() +
+          Displacement<ICRS>({0 * Metre, 0 * Metre, 10'000 * Kilo(Metre)}),
+      earth_degrees_of_freedom.velocity() +
+          Velocity<ICRS>({6 * Kilo(Metre) / Second,
+                          0 * Metre / Second,
+                          0 * Metre / Second}));
+
+  ephemeris->ComputeGravitationalAccelerationOnMasslessBody(
+      probe_degrees_of_freedom.position(), t1);
+  EXPECT_EQ(0, ephemeris->body_positions_cache_statistics().hits);
+  EXPECT_EQ(0, ephemeris->body_positions_cache_statistics().misses);
+
+  // Each step of the first instance misses, and the same step of the second
+  // instance hits.
+  DiscreteTrajectory<ICRS> trajectory1;
+  DiscreteTrajectory<ICRS> trajectory2;
+  trajectory1.Append(t0_, probe_degrees_of_freedom);
+  trajectory2.Append(t0_, probe_degrees_of_freedom);
+  Ephemeris<ICRS>::FixedStepParameters const parameters(
+      SymplecticRungeKuttaNyströmIntegrator<McLachlanAtela1992Order5Optimal,
+                                            Position<ICRS>>(),
+      step);
+  auto const instance1 = ephemeris->NewInstance(
+      {&trajectory1}, Ephemeris<ICRS>::NoIntrinsicAccelerations, parameters);
+  auto const instance2 = ephemeris->NewInstance(
+      {&trajectory2}, Ephemeris<ICRS>::NoIntrinsicAccelerations, parameters);
+  for (Instant t = t0_ + step; t <= t1; t += step) {
+    EXPECT_OK(ephemeris->FlowWithFixedStep(t, *instance1));
+    EXPECT_OK(ephemeris->FlowWithFixedStep(t, *instance2));
+  }
+  auto const statistics = ephemeris->body_positions_cache_statistics();
+  EXPECT_THAT(statistics.misses, Gt(360));
+  EXPECT_EQ(statistics.misses, statistics.hits);
+  EXPECT_EQ(trajectory1.last().degrees_of_freedom(),
+            trajectory2.last().degrees_of_freedom());
+
+  DiscreteTrajectory<ICRS> trajectory3;
+  trajectory3.Append(t0_, probe_degrees_of_freedom);
+  EXPECT_OK(ephemeris->FlowWithAdaptiveStep(
+      &trajectory3,
+      Ephemeris<ICRS>::NoIntrinsicAcceleration,
+      t1,
+      Ephemeris<ICRS>::AdaptiveStepParameters(
+          EmbeddedExplicitRungeKuttaNyströmIntegrator<
+              DormandالمكاوىPrince1986RKN434FM,
+              Position<ICRS>>(),
+          max_steps,
+          1e-3 * Metre,
+          1e-6 * Metre / Second),
+      Ephemeris<ICRS>::unlimited_max_ephemeris_steps,
+      /*last_point_only=*/true));
+  EXPECT_EQ(statistics.hits,
+            ephemeris->body_positions_cache_statistics().hits);
+  EXPECT_EQ(statistics.misses,
+            ephemeris->body_positions_cache_statistics().misses);
+}
+
+// The hierarchical approximation treats the distant planetary systems as point
+// masses, with a small effect on the acceleration of a probe in low Earth orbit.
+TEST_P(EphemerisTest, HierarchicalApproximation) {
+  auto const exact_ephemeris = solar_system_.MakeEphemeris(
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(),
+                                           /*step=*/10 * Minute));
+  auto const approximate_ephemeris = solar_system_.MakeEphemeris(
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24,
+                               /*hierarchical_approximation_tolerance=*/0.1},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(),
+                                           /*step=*/10 * Minute));
+  Instant const t = t0_ + 1 * Day;
+  exact_ephemeris->Prolong(t);
+  approximate_ephemeris->Prolong(t);
+
+  Position<ICRS> const earth_position =
+      solar_system_.trajectory(*exact_ephemeris, "Earth").EvaluatePosition(t);
+  Position<ICRS> const probe_position =
+      earth_position +
+      Displacement<ICRS>({TerrestrialEquatorialRadius + 200 * Kilo(Metre),
+                          0 * Metre,
+                          0 * Metre});
+  auto const exact_acceleration =
+      exact_ephemeris->ComputeGravitationalAccelerationOnMasslessBody(
+          probe_position, t);
+  auto const approximate_acceleration =
+      approximate_ephemeris->ComputeGravitationalAccelerationOnMasslessBody(
+          probe_position, t);
+  EXPECT_NE(exact_acceleration, approximate_acceleration);
+  EXPECT_THAT(RelativeError(exact_acceleration, approximate_acceleration),
+              Lt(1e-14));
+}
+
+// The hierarchy of subsystems is serialized, so it does not depend on the state
+// of the integrator when the ephemeris is restored.
+TEST_P(EphemerisTest, HierarchicalApproximationSerialization) {
+  auto const ephemeris = solar_system_.MakeEphemeris(
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24,
+                               /*hierarchical_approximation_tolerance=*/0.1},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(),
+                                           /*step=*/10 * Minute));
+  Instant const t = t0_ + 30 * Day;
+  ephemeris->Prolong(t);
+
+  serialization::Ephemeris message;
+  ephemeris->WriteToMessage(&message);
+  EXPECT_EQ(message.trajectory_size(), message.subsystem_parent_size());
+  auto const ephemeris_read = Ephemeris<ICRS>::ReadFromMessage(message);
+  ephemeris_read->Prolong(t);
+
+  Position<ICRS> const earth_position =
+      solar_system_.trajectory(*ephemeris, "Earth").EvaluatePosition(t);
+  Position<ICRS> const probe_position =
+      earth_position +
+      Displacement<ICRS>({TerrestrialEquatorialRadius + 200 * Kilo(Metre),
+                          0 * Metre,
+                          0 * Metre});
+  EXPECT_EQ(ephemeris->ComputeGravitationalAccelerationOnMasslessBody(
+                probe_position, t),
+            ephemeris_read->ComputeGravitationalAccelerationOnMasslessBody(
+                probe_position, t));
+
+  serialization::Ephemeris second_message;
+  ephemeris_read->WriteToMessage(&second_message);
+  EXPECT_THAT(message, EqualsProto(second_message));
+}
+
+// The background prolongation advances the ephemeris ahead of the requested
+// times without changing the result.
+TEST_P(EphemerisTest, BackgroundProlongation) {
+  auto const foreground_ephemeris = solar_system_.MakeEphemeris(
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(),
+                                           /*step=*/10 * Minute));
+  auto const background_ephemeris = solar_system_.MakeEphemeris(
+      /*accuracy_parameters=*/{/*fitting_tolerance=*/5 * Milli(Metre),
+                               /*geopotential_tolerance=*/0x1p-24},
+      Ephemeris<ICRS>::FixedStepParameters(integrator(),
+                                           /*step=*/10 * Minute));
+  background_ephemeris->SetBackgroundProlongationHorizon(10 * Day);
+
+  Instant const t1 = t0_ + 1 * Day;
+  Instant const t2 = t0_ + 5 * Day;
+  background_ephemeris->Prolong(t1);
+  EXPECT_EQ(0, background_ephemeris->prolongation_statistics().immediate);
+  EXPECT_EQ(1, background_ephemeris->prolongation_statistics().blocking);
+  while (background_ephemeris->t_max() < t1 + 10 * Day) {
+    std::this_thread::yield();
+  }
+  background_ephemeris->Prolong(t2);
+  EXPECT_EQ(1, background_ephemeris->prolongation_statistics().immediate);
+  EXPECT_EQ(1, background_ephemeris->prolongation_statistics().blocking);
+
+  foreground_ephemeris->Prolong(t2);
+  for (std::string const& name : solar_system_.names()) {
+    EXPECT_EQ(solar_system_.trajectory(*foreground_ephemeris, name).
+                  EvaluateDegreesOfFreedom(t2),
+              solar_system_.trajectory(*background_ephemeris, name).
+                  EvaluateDegreesOfFreedom(t2)) << name;
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(
     AllEphemerisTests,
     EphemerisTest,
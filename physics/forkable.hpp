@@ -2,6 +2,7 @@
 #pragma once
 
 #include <deque>
+#include <functional>
 #include <optional>
 #include <map>
 #include <memory>
@@ -47,6 +48,20 @@ class Forkable;
 template<typename Tr4jectory>
 struct ForkableTraits;
 
+// A decoded copy of one of the sealed blocks of points which may precede the
+// timeline of a root, see |Forkable::sealed_block|.  [begin, end[ is a nonempty
+// range of points in an immutable object kept alive by |owner|.
+template<typename Tr4jectory>
+struct SealedBlock final {
+  using TimelineConstIterator =
+      typename ForkableTraits<Tr4jectory>::TimelineConstIterator;
+
+  std::int64_t index;
+  std::shared_ptr<void const> owner;
+  TimelineConstIterator begin;
+  TimelineConstIterator end;
+};
+
 // A template for iterating over the timeline of a Forkable object, taking forks
 // into account.
 template<typename Tr4jectory, typename It3rator>
@@ -89,10 +104,17 @@ class ForkableIterator {
   void CheckNormalizedIfEnd();
 
   // |ancestry_| is never empty.  |current_| is an iterator in the timeline
-  // for |ancestry_.front()|.  |current_| may be at end.
+  // for |ancestry_.front()|, unless |sealed_block_| is set.  |current_| may be
+  // at end.
   TimelineConstIterator current_;
   std::deque<not_null<Tr4jectory const*>> ancestry_;  // Pointers not owned.
 
+  // Set if |current_| is in a sealed block of |ancestry_.front()|, which is
+  // then a root.  |current_| is never at the end of the block.  The iterator
+  // keeps the block alive, so the references to its points remain valid as long
+  // as an iterator to the same block exists.
+  std::optional<SealedBlock<Tr4jectory>> sealed_block_;
+
   template<typename, typename>
   friend class Forkable;
 };
@@ -165,6 +187,26 @@ class Forkable {
   virtual bool timeline_empty() const = 0;
   virtual std::int64_t timeline_size() const = 0;
 
+  // The time at which this object is recorded as forked when its parent is
+  // serialized.  This object must not be a root.  The default is the fork
+  // time; subclasses whose fork point may lag behind the one requested by their
+  // clients may override this function.
+  virtual Instant serialized_fork_time() const;
+
+  // Subclasses may keep the earliest points of a root timeline out of the
+  // timeline, in immutable sealed blocks which precede it and which are only
+  // appended to, in increasing order of time.  Such subclasses must override
+  // the following functions, which must not modify this object.  The defaults
+  // describe a timeline without sealed blocks.
+
+  // The number of sealed blocks.
+  virtual std::int64_t sealed_blocks_size() const;
+  // The index of the first sealed block whose last time is at or after |time|,
+  // or |sealed_blocks_size()| if there is none.
+  virtual std::int64_t sealed_blocks_lower_bound(Instant const& time) const;
+  // Decodes the sealed block at |index|.
+  virtual SealedBlock<Tr4jectory> sealed_block(std::int64_t index) const;
+
  protected:
   // The API that subclasses may use to implement their public operations.
 
@@ -191,6 +233,21 @@ class Forkable {
   // pointer to this object.
   not_null<std::unique_ptr<Tr4jectory>> DetachForkWithCopiedBegin();
 
+  // This object must not be a root.  Moves its fork point back to
+  // |timeline_it|, which must be an iterator in the parent timeline at or
+  // before the current fork point.  The caller must have prepended to this
+  // object's timeline copies of the points of the parent timeline after
+  // |timeline_it| up to and including the current fork point, and
+  // |former_fork_point| must denote the copy of the current fork point.  The
+  // children which were forked at the current fork time with a position at
+  // |end()| are changed to be forked at |former_fork_point|.
+  void MoveForkPointBack(TimelineConstIterator const& timeline_it,
+                         TimelineConstIterator const& former_fork_point);
+
+  // Calls |action| on each child of this object, in the order of their fork
+  // times.  |action| must not add, remove or move any child.
+  void ForEachChild(std::function<void(Tr4jectory&)> const& action);
+
   // Deletes all forks for times (strictly) greater than |time|.  |time| must be
   // at or after the fork time of this trajectory, if any.
   void DeleteAllForksAfter(Instant const& time);
@@ -217,6 +274,19 @@ class Forkable {
   It3rator Wrap(not_null<Tr4jectory const*> ancestor,
                 TimelineConstIterator position_in_ancestor_timeline) const;
 
+  // Same as above, but |position_in_sealed_block| is an iterator in
+  // |sealed_block|, which must be a sealed block of |root|.  It must not be at
+  // the end of the block.
+  It3rator Wrap(not_null<Tr4jectory const*> root,
+                SealedBlock<Tr4jectory> sealed_block,
+                TimelineConstIterator position_in_sealed_block) const;
+
+  // Returns an iterator to the first point of |sealed_block| which is at or
+  // after |time|, or to its end if there is none.
+  static TimelineConstIterator SealedBlockLowerBound(
+      SealedBlock<Tr4jectory> const& sealed_block,
+      Instant const& time);
+
   // There may be several forks starting from the same time, hence the multimap.
   // A level of indirection is needed to avoid referencing an incomplete type in
   // CRTP.
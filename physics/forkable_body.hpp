@@ -2,6 +2,9 @@
 #pragma once
 
 #include <deque>
+#include <functional>
+#include <map>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -22,6 +25,15 @@ template<typename Tr4jectory, typename It3rator>
 bool ForkableIterator<Tr4jectory, It3rator>::operator==(
     It3rator const& right) const {
   DCHECK_EQ(trajectory(), right.trajectory());
+  if (sealed_block_.has_value() || right.sealed_block_.has_value()) {
+    // Two iterators may point in distinct decoded copies of the same block, so
+    // compare the times, which are unique.
+    return sealed_block_.has_value() && right.sealed_block_.has_value() &&
+           ancestry_ == right.ancestry_ &&
+           sealed_block_->index == right.sealed_block_->index &&
+           ForkableTraits<Tr4jectory>::time(current_) ==
+               ForkableTraits<Tr4jectory>::time(right.current_);
+  }
   return ancestry_ == right.ancestry_ && current_ == right.current_;
 }
 
@@ -34,6 +46,22 @@ bool ForkableIterator<Tr4jectory, It3rator>::operator!=(
 template<typename Tr4jectory, typename It3rator>
 It3rator& ForkableIterator<Tr4jectory, It3rator>::operator++() {
   CHECK(!ancestry_.empty());
+  if (sealed_block_.has_value()) {
+    // The sealed blocks precede all the forks.  At the end of the last block,
+    // continue with the timeline of the root.
+    if (++current_ == sealed_block_->end) {
+      not_null<Tr4jectory const*> const root = ancestry_.front();
+      std::int64_t const next_index = sealed_block_->index + 1;
+      if (next_index < root->sealed_blocks_size()) {
+        sealed_block_ = root->sealed_block(next_index);
+        current_ = sealed_block_->begin;
+      } else {
+        sealed_block_.reset();
+        current_ = root->timeline_begin();
+      }
+    }
+    return *that();
+  }
   CHECK(current_ != ancestry_.front()->timeline_end());
 
   // Check if there is a next child in the ancestry.
@@ -73,6 +101,24 @@ It3rator& ForkableIterator<Tr4jectory, It3rator>::operator--() {
   CHECK(!ancestry_.empty());
 
   not_null<Tr4jectory const*> ancestor = ancestry_.front();
+  if (sealed_block_.has_value()) {
+    if (current_ == sealed_block_->begin) {
+      CHECK_LT(0, sealed_block_->index) << "Decrementing the beginning";
+      sealed_block_ = ancestor->sealed_block(sealed_block_->index - 1);
+      current_ = sealed_block_->end;
+    }
+    --current_;
+    return *that();
+  }
+  if (current_ == ancestor->timeline_begin() &&
+      ancestor->parent_ == nullptr &&
+      ancestor->sealed_blocks_size() > 0) {
+    // At the beginning of the timeline of a root.  Continue with the last
+    // sealed block.
+    sealed_block_ = ancestor->sealed_block(ancestor->sealed_blocks_size() - 1);
+    current_ = std::prev(sealed_block_->end);
+    return *that();
+  }
   if (current_ == ancestor->timeline_begin()) {
     CHECK_NOTNULL(ancestor->parent_);
     // At the beginning of the first timeline.  Push the parent in front of the
@@ -100,6 +146,9 @@ ForkableIterator<Tr4jectory, It3rator>::current() const {
 template<typename Tr4jectory, typename It3rator>
 void ForkableIterator<Tr4jectory, It3rator>::NormalizeIfEnd() {
   CHECK(!ancestry_.empty());
+  if (sealed_block_.has_value()) {
+    return;
+  }
   if (current_ == ancestry_.front()->timeline_end() &&
       ancestry_.size() > 1) {
     ancestry_.erase(ancestry_.begin(), --ancestry_.end());
@@ -109,7 +158,8 @@ void ForkableIterator<Tr4jectory, It3rator>::NormalizeIfEnd() {
 
 template<typename Tr4jectory, typename It3rator>
 void ForkableIterator<Tr4jectory, It3rator>::CheckNormalizedIfEnd() {
-  CHECK(current_ != ancestry_.front()->timeline_end() ||
+  CHECK(sealed_block_.has_value() ||
+        current_ != ancestry_.front()->timeline_end() ||
         ancestry_.size() == 1);
 }
 
@@ -165,7 +215,12 @@ not_null<Tr4jectory*> Forkable<Tr4jectory, It3rator>::parent() {
 
 template<typename Tr4jectory, typename It3rator>
 It3rator Forkable<Tr4jectory, It3rator>::Begin() const {
-  not_null<Tr4jectory const*> ancestor = root();
+  not_null<Tr4jectory const*> const ancestor = root();
+  if (ancestor->sealed_blocks_size() > 0) {
+    auto sealed_block = ancestor->sealed_block(0);
+    auto const begin = sealed_block.begin;
+    return Wrap(ancestor, std::move(sealed_block), begin);
+  }
   return Wrap(ancestor, ancestor->timeline_begin());
 }
 
@@ -195,6 +250,15 @@ It3rator Forkable<Tr4jectory, It3rator>::Find(Instant const& time) const {
       iterator.current_ = ancestor->timeline_find(time);  // May be at end.
       break;
     }
+    // For a root, |time| may be in the sealed blocks that precede the timeline.
+    std::int64_t const index = ancestor->sealed_blocks_lower_bound(time);
+    if (index < ancestor->sealed_blocks_size()) {
+      auto sealed_block = ancestor->sealed_block(index);
+      auto const it = SealedBlockLowerBound(sealed_block, time);
+      if (ForkableTraits<Tr4jectory>::time(it) == time) {
+        return Wrap(ancestor, std::move(sealed_block), it);
+      }
+    }
     iterator.current_ = ancestor->timeline_end();
     ancestor = ancestor->parent_;
   } while (ancestor != nullptr);
@@ -264,6 +328,13 @@ It3rator Forkable<Tr4jectory, It3rator>::LowerBound(Instant const& time) const {
       }
       break;
     }
+    // For a root, |time| may be in the sealed blocks that precede the timeline.
+    std::int64_t const index = ancestor->sealed_blocks_lower_bound(time);
+    if (index < ancestor->sealed_blocks_size()) {
+      auto sealed_block = ancestor->sealed_block(index);
+      auto const it = SealedBlockLowerBound(sealed_block, time);
+      return Wrap(ancestor, std::move(sealed_block), it);
+    }
     fork_points.push_front(ancestor->position_in_parent_timeline_);
     iterator.current_ = ancestor->timeline_begin();
     ancestor = ancestor->parent_;
@@ -298,8 +369,11 @@ std::int64_t Forkable<Tr4jectory, It3rator>::Size() const {
   Tr4jectory const* parent = ancestor->parent_;
   while (parent != nullptr) {
     if (!parent->timeline_empty()) {
-      size += std::distance(parent->timeline_begin(),
-                            *ancestor->position_in_parent_timeline_) + 1;
+      // Counting from the end avoids walking the beginning of the timeline,
+      // which may be long or sealed.
+      size += parent->timeline_size() -
+              std::distance(*ancestor->position_in_parent_timeline_,
+                            parent->timeline_end()) + 1;
     }
     ancestor = parent;
     parent = ancestor->parent_;
@@ -315,6 +389,30 @@ bool Forkable<Tr4jectory, It3rator>::Empty() const {
   return timeline_empty() && parent_ == nullptr;
 }
 
+template<typename Tr4jectory, typename It3rator>
+Instant Forkable<Tr4jectory, It3rator>::serialized_fork_time() const {
+  CHECK(!is_root());
+  return (*position_in_parent_children_)->first;
+}
+
+template<typename Tr4jectory, typename It3rator>
+std::int64_t Forkable<Tr4jectory, It3rator>::sealed_blocks_size() const {
+  return 0;
+}
+
+template<typename Tr4jectory, typename It3rator>
+std::int64_t Forkable<Tr4jectory, It3rator>::sealed_blocks_lower_bound(
+    Instant const& time) const {
+  return 0;
+}
+
+template<typename Tr4jectory, typename It3rator>
+SealedBlock<Tr4jectory> Forkable<Tr4jectory, It3rator>::sealed_block(
+    std::int64_t const index) const {
+  LOG(FATAL) << "No sealed block " << index;
+  base::noreturn();
+}
+
 template<typename Tr4jectory, typename It3rator>
 not_null<Tr4jectory*> Forkable<Tr4jectory, It3rator>::NewFork(
     TimelineConstIterator const& timeline_it) {
@@ -398,6 +496,41 @@ Forkable<Tr4jectory, It3rator>::DetachForkWithCopiedBegin() {
   return std::move(owned_this);
 }
 
+template<typename Tr4jectory, typename It3rator>
+void Forkable<Tr4jectory, It3rator>::MoveForkPointBack(
+    TimelineConstIterator const& timeline_it,
+    TimelineConstIterator const& former_fork_point) {
+  CHECK(!is_root());
+  Instant const& time = ForkableTraits<Tr4jectory>::time(timeline_it);
+  CHECK_LE(time, (*position_in_parent_children_)->first)
+      << "MoveForkPointBack after the fork time";
+
+  // The children whose |position_in_parent_timeline_| was at |end()| are those
+  // whose fork time was not in this object's timeline.  The caller has ensured
+  // that now it is, so point them to the copy of the former fork point.
+  for (auto const& pair : children_) {
+    std::unique_ptr<Tr4jectory> const& child = pair.second;
+    if (child->position_in_parent_timeline_ == timeline_end()) {
+      child->position_in_parent_timeline_ = former_fork_point;
+    }
+  }
+
+  // Move this object to its new position among the children of its parent.
+  // This doesn't invalidate the iterators to the other children.
+  auto node = parent_->children_.extract(*position_in_parent_children_);
+  node.key() = time;
+  position_in_parent_children_ = parent_->children_.insert(std::move(node));
+  position_in_parent_timeline_ = timeline_it;
+}
+
+template<typename Tr4jectory, typename It3rator>
+void Forkable<Tr4jectory, It3rator>::ForEachChild(
+    std::function<void(Tr4jectory&)> const& action) {
+  for (auto const& pair : children_) {
+    action(*pair.second);
+  }
+}
+
 template<typename Tr4jectory, typename It3rator>
 void Forkable<Tr4jectory, It3rator>::DeleteAllForksAfter(Instant const& time) {
   // Get an iterator denoting the first entry with time > |time|.  Remove that
@@ -425,16 +558,25 @@ template<typename Tr4jectory, typename It3rator>
 void Forkable<Tr4jectory, It3rator>::WriteSubTreeToMessage(
     not_null<serialization::DiscreteTrajectory*> const message,
     std::vector<Tr4jectory*>& forks) const {
+  // The children are written in the order of their serialized fork times,
+  // which may differ from the order of |children_|.  The multimap preserves
+  // the order of the children having the same serialized fork time.
+  std::multimap<Instant, Tr4jectory*> serialized_children;
+  for (auto const& pair : children_) {
+    std::unique_ptr<Tr4jectory> const& child = pair.second;
+    serialized_children.emplace(child->serialized_fork_time(), child.get());
+  }
+
   std::optional<Instant> last_instant;
   serialization::DiscreteTrajectory::Litter* litter = nullptr;
-  for (auto const& pair : children_) {
+  for (auto const& pair : serialized_children) {
     Instant const& fork_time = pair.first;
-    std::unique_ptr<Tr4jectory> const& child = pair.second;
+    Tr4jectory* const child = pair.second;
 
     // Determine if this |child| needs to be serialized.  If so, record its
     // position in |fork_positions| and null out its pointer in |forks|.
     // Apologies for the O(N) search.
-    auto const it = std::find(forks.begin(), forks.end(), child.get());
+    auto const it = std::find(forks.begin(), forks.end(), child);
     if (it == forks.end()) {
       continue;
     } else {
@@ -499,6 +641,34 @@ It3rator Forkable<Tr4jectory, It3rator>::Wrap(
   base::noreturn();
 }
 
+template<typename Tr4jectory, typename It3rator>
+It3rator Forkable<Tr4jectory, It3rator>::Wrap(
+    not_null<Tr4jectory const*> const root,
+    SealedBlock<Tr4jectory> sealed_block,
+    TimelineConstIterator const position_in_sealed_block) const {
+  CHECK(root->is_root());
+  CHECK(position_in_sealed_block != sealed_block.end);
+  It3rator iterator = Wrap(root, root->timeline_begin());
+  iterator.sealed_block_ = std::move(sealed_block);
+  iterator.current_ = position_in_sealed_block;
+  return iterator;
+}
+
+template<typename Tr4jectory, typename It3rator>
+typename Forkable<Tr4jectory, It3rator>::TimelineConstIterator
+Forkable<Tr4jectory, It3rator>::SealedBlockLowerBound(
+    SealedBlock<Tr4jectory> const& sealed_block,
+    Instant const& time) {
+  // The iterators are not random-access, so a binary search would not be
+  // faster.
+  auto it = sealed_block.begin;
+  while (it != sealed_block.end &&
+         ForkableTraits<Tr4jectory>::time(it) < time) {
+    ++it;
+  }
+  return it;
+}
+
 }  // namespace internal_forkable
 }  // namespace physics
 }  // namespace principia
@@ -79,6 +79,17 @@ class Geopotential {
   Geopotential(not_null<OblateBody<Frame> const*> body,
                double tolerance);
 
+  // The equatorial axes of the surface frame of the body at some instant.
+  // They are only used by the tesseral harmonics, but computing them requires
+  // a rotation, so callers that evaluate the geopotential at many points at the
+  // same instant should compute them once.
+  struct EquatorialAxes final {
+    Vector<double, Frame> x̂;
+    Vector<double, Frame> ŷ;
+  };
+
+  EquatorialAxes EquatorialAxesAt(Instant const& t) const;
+
   Vector<Quotient<Acceleration, GravitationalParameter>, Frame>
   SphericalHarmonicsAcceleration(
       Instant const& t,
@@ -94,6 +105,16 @@ class Geopotential {
       Square<Length> const& r²,
       Exponentiation<Length, -3> const& one_over_r³) const;
 
+  // Same as above, but uses the given |axes|, which must have been obtained by
+  // |EquatorialAxesAt(t)|.
+  Vector<Quotient<Acceleration, GravitationalParameter>, Frame>
+  GeneralSphericalHarmonicsAcceleration(
+      EquatorialAxes const& axes,
+      Displacement<Frame> const& r,
+      Length const& r_norm,
+      Square<Length> const& r²,
+      Exponentiation<Length, -3> const& one_over_r³) const;
+
   std::vector<HarmonicDamping> const& degree_damping() const;
   HarmonicDamping const& sectoral_damping() const;
 
@@ -124,6 +145,16 @@ class Geopotential {
   template<typename>
   struct AllDegrees;
 
+  // If |axes| is null, the equatorial axes are computed at |t| if needed.
+  Vector<Quotient<Acceleration, GravitationalParameter>, Frame>
+  GeneralSphericalHarmonicsAcceleration(
+      Instant const& t,
+      EquatorialAxes const* axes,
+      Displacement<Frame> const& r,
+      Length const& r_norm,
+      Square<Length> const& r²,
+      Exponentiation<Length, -3> const& one_over_r³) const;
+
   // If z is a unit vector along the axis of rotation, and r a vector from the
   // center of |body_| to some point in space, the acceleration computed here
   // is:
@@ -149,6 +149,7 @@ template<int... degrees>
 struct Geopotential<Frame>::AllDegrees<std::integer_sequence<int, degrees...>> {
   static auto Acceleration(Geopotential<Frame> const& geopotential,
                            Instant const& t,
+                           EquatorialAxes const* axes,
                            Displacement<Frame> const& r,
                            Length const& r_norm,
                            Square<Length> const& r²,
@@ -396,6 +397,7 @@ template<int... degrees>
 auto Geopotential<Frame>::AllDegrees<std::integer_sequence<int, degrees...>>::
 Acceleration(Geopotential<Frame> const& geopotential,
              Instant const& t,
+             EquatorialAxes const* const axes,
              Displacement<Frame> const& r,
              Length const& r_norm,
              Square<Length> const& r²,
@@ -436,11 +438,13 @@ Acceleration(Geopotential<Frame> const& geopotential,
   if (is_zonal) {
     x̂ = body.biequatorial();
     ŷ = body.equatorial();
+  } else if (axes == nullptr) {
+    EquatorialAxes const axes_at_t = geopotential.EquatorialAxesAt(t);
+    x̂ = axes_at_t.x̂;
+    ŷ = axes_at_t.ŷ;
   } else {
-    auto const from_surface_frame =
-      body.template FromSurfaceFrame<SurfaceFrame>(t);
-    x̂ = from_surface_frame(x_);
-    ŷ = from_surface_frame(y_);
+    x̂ = axes->x̂;
+    ŷ = axes->ŷ;
   }
 
   Length const x = InnerProduct(r, x̂);
@@ -569,6 +573,18 @@ Geopotential<Frame>::Geopotential(not_null<OblateBody<Frame> const*> body,
   }
 }
 
+template<typename Frame>
+typename Geopotential<Frame>::EquatorialAxes
+Geopotential<Frame>::EquatorialAxesAt(Instant const& t) const {
+  if (body_->is_zonal()) {
+    // The rotation of the body is of no importance, see |AllDegrees|.
+    return {body_->biequatorial(), body_->equatorial()};
+  }
+  auto const from_surface_frame =
+      body_->template FromSurfaceFrame<SurfaceFrame>(t);
+  return {from_surface_frame(x_), from_surface_frame(y_)};
+}
+
 template<typename Frame>
 Vector<Quotient<Acceleration, GravitationalParameter>, Frame>
 Geopotential<Frame>::SphericalHarmonicsAcceleration(
@@ -584,12 +600,38 @@ Geopotential<Frame>::SphericalHarmonicsAcceleration(
 #define PRINCIPIA_CASE_SPHERICAL_HARMONICS(d)                                  \
   case (d):                                                                    \
     return AllDegrees<std::make_integer_sequence<int, (d + 1)>>::Acceleration( \
-        *this, t, r, r_norm, r², one_over_r³)
+        *this, t, axes, r, r_norm, r², one_over_r³)
+
+template<typename Frame>
+Vector<Quotient<Acceleration, GravitationalParameter>, Frame>
+Geopotential<Frame>::GeneralSphericalHarmonicsAcceleration(
+    Instant const& t,
+    Displacement<Frame> const& r,
+    Length const& r_norm,
+    Square<Length> const& r²,
+    Exponentiation<Length, -3> const& one_over_r³) const {
+  return GeneralSphericalHarmonicsAcceleration(
+      t, /*axes=*/nullptr, r, r_norm, r², one_over_r³);
+}
+
+template<typename Frame>
+Vector<Quotient<Acceleration, GravitationalParameter>, Frame>
+Geopotential<Frame>::GeneralSphericalHarmonicsAcceleration(
+    EquatorialAxes const& axes,
+    Displacement<Frame> const& r,
+    Length const& r_norm,
+    Square<Length> const& r²,
+    Exponentiation<Length, -3> const& one_over_r³) const {
+  // The time is only used to compute the axes, which we already have.
+  return GeneralSphericalHarmonicsAcceleration(
+      Instant(), &axes, r, r_norm, r², one_over_r³);
+}
 
 template<typename Frame>
 Vector<Quotient<Acceleration, GravitationalParameter>, Frame>
 Geopotential<Frame>::GeneralSphericalHarmonicsAcceleration(
     Instant const& t,
+    EquatorialAxes const* const axes,
     Displacement<Frame> const& r,
     Length const& r_norm,
     Square<Length> const& r²,
@@ -242,6 +242,22 @@ TEST_F(GeopotentialTest, C22S22) {
     EXPECT_THAT(acceleration.coordinates().z,
                 VanishesBefore(1 * Pow<-2>(Metre), 0));
   }
+
+  // Precomputing the equatorial axes doesn't change the result.
+  {
+    Instant const t = Instant() + 7 * Second;
+    Displacement<World> const r({30 * Metre, 40 * Metre, 50 * Metre});
+    auto const r² = r.Norm²();
+    auto const r_norm = Sqrt(r²);
+    auto const one_over_r³ = r_norm / (r² * r²);
+    EXPECT_EQ(GeneralSphericalHarmonicsAcceleration(geopotential, t, r),
+              geopotential.GeneralSphericalHarmonicsAcceleration(
+                  geopotential.EquatorialAxesAt(t),
+                  r,
+                  r_norm,
+                  r²,
+                  one_over_r³));
+  }
 }
 
 TEST_F(GeopotentialTest, J3) {
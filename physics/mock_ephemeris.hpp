@@ -17,10 +17,14 @@ template<typename Frame>
 class MockEphemeris : public Ephemeris<Frame> {
  public:
   using typename Ephemeris<Frame>::AdaptiveStepParameters;
+  using typename Ephemeris<Frame>::BodyPositionsCacheStatistics;
+  using typename Ephemeris<Frame>::EventFunction;
   using typename Ephemeris<Frame>::FixedStepParameters;
   using typename Ephemeris<Frame>::IntrinsicAcceleration;
   using typename Ephemeris<Frame>::IntrinsicAccelerations;
   using typename Ephemeris<Frame>::NewtonianMotionEquation;
+  using typename Ephemeris<Frame>::ProlongationStatistics;
+  using typename Ephemeris<Frame>::StateTransitionMatrix;
 
   MockEphemeris()
       : Ephemeris<Frame>(
@@ -40,6 +44,11 @@ class MockEphemeris : public Ephemeris<Frame> {
 
   MOCK_METHOD1_T(ForgetBefore, void(Instant const& t));
   MOCK_METHOD1_T(Prolong, void(Instant const& t));
+  MOCK_METHOD1_T(SetMassiveBodiesParallelism, void(int number_of_threads));
+  MOCK_METHOD1_T(SetBackgroundProlongationHorizon, void(Time const& horizon));
+  MOCK_CONST_METHOD0_T(body_positions_cache_statistics,
+                       BodyPositionsCacheStatistics());
+  MOCK_CONST_METHOD0_T(prolongation_statistics, ProlongationStatistics());
   MOCK_METHOD3_T(
       NewInstance,
       not_null<std::unique_ptr<
@@ -55,10 +64,51 @@ class MockEphemeris : public Ephemeris<Frame> {
              AdaptiveStepParameters const& parameters,
              std::int64_t max_ephemeris_steps,
              bool last_point_only));
+  MOCK_METHOD7_T(
+      FlowWithAdaptiveStep,
+      Status(not_null<DiscreteTrajectory<Frame>*> trajectory,
+             IntrinsicAcceleration intrinsic_acceleration,
+             Instant const& t,
+             AdaptiveStepParameters const& parameters,
+             std::int64_t max_ephemeris_steps,
+             bool last_point_only,
+             not_null<StateTransitionMatrix*> state_transition_matrix));
+  MOCK_METHOD8_T(
+      FlowWithAdaptiveStep,
+      Status(not_null<DiscreteTrajectory<Frame>*> trajectory,
+             IntrinsicAcceleration intrinsic_acceleration,
+             Instant const& t,
+             AdaptiveStepParameters const& parameters,
+             std::int64_t max_ephemeris_steps,
+             bool last_point_only,
+             std::vector<EventFunction> const& event_functions,
+             std::vector<not_null<DiscreteTrajectory<Frame>*>> const& events));
+  MOCK_METHOD8_T(
+      FlowEnsembleWithAdaptiveStep,
+      std::vector<Status>(
+          std::vector<not_null<DiscreteTrajectory<Frame>*>> const&
+              trajectories,
+          IntrinsicAccelerations const& intrinsic_accelerations,
+          Instant const& t,
+          AdaptiveStepParameters const& parameters,
+          std::int64_t max_ephemeris_steps,
+          bool last_point_only,
+          bool lockstep,
+          ThreadPool<void>* thread_pool));
   MOCK_METHOD2_T(
       FlowWithFixedStep,
       Status(Instant const& t,
              typename Integrator<NewtonianMotionEquation>::Instance& instance));
+  MOCK_METHOD3_T(
+      NewEnsembleInstance,
+      not_null<std::unique_ptr<EnsembleInstance<NewtonianMotionEquation>>>(
+          std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+          IntrinsicAccelerations const& intrinsic_accelerations,
+          FixedStepParameters const& parameters));
+  MOCK_METHOD2_T(
+      FlowEnsembleWithFixedStep,
+      Status(Instant const& t,
+             EnsembleInstance<NewtonianMotionEquation>& instance));
 
   MOCK_CONST_METHOD2_T(
       ComputeGravitationalAccelerationOnMasslessBody,
@@ -96,7 +96,8 @@ class SolarSystemFactory : not_constructible {
   template<typename Frame>
   static typename Ephemeris<Frame>::AccuracyParameters MakeAccuracyParameters(
       Length const& fitting_tolerance,
-      Accuracy const accuracy);
+      Accuracy const accuracy,
+      double hierarchical_approximation_tolerance = 0);
 
   // A solar system at the time of the launch of Простейший Спутник-1.
   static not_null<std::unique_ptr<SolarSystem<ICRS>>>
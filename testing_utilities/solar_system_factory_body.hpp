@@ -92,19 +92,23 @@ void SolarSystemFactory::AdjustAccuracy(
 
 template<typename Frame>
 typename Ephemeris<Frame>::AccuracyParameters
-SolarSystemFactory::MakeAccuracyParameters(Length const& fitting_tolerance,
-                                           Accuracy const accuracy) {
+SolarSystemFactory::MakeAccuracyParameters(
+    Length const& fitting_tolerance,
+    Accuracy const accuracy,
+    double const hierarchical_approximation_tolerance) {
   switch (accuracy) {
     case Accuracy::MajorBodiesOnly:
     case Accuracy::MinorAndMajorBodies:
     case Accuracy::AllBodiesAndDampedOblateness:
       return typename Ephemeris<Frame>::AccuracyParameters(
           fitting_tolerance,
-          /*geopotential_tolerance=*/0x1.0p-24);
+          /*geopotential_tolerance=*/0x1.0p-24,
+          hierarchical_approximation_tolerance);
     case Accuracy::AllBodiesAndFullOblateness:
       return typename Ephemeris<Frame>::AccuracyParameters(
           fitting_tolerance,
-          /*geopotential_tolerance=*/0.0);
+          /*geopotential_tolerance=*/0.0,
+          hierarchical_approximation_tolerance);
   }
   LOG(FATAL) << "Bad accuracy";
   base::noreturn();